@@ -0,0 +1,470 @@
+// benchmarks/bench_oeselect.cpp
+// Google Benchmark suite covering every predicate family.
+//
+// Inputs are tests/assets/9Q03.cif ("atoms:0") plus synthetic protein/water/
+// ligand systems of 10k, 100k, and 1M atoms. Synthetic systems use fixed
+// seeds, so results are comparable across commits:
+//
+//   oeselect_bench --benchmark_format=json --benchmark_out=before.json
+//   compare.py benchmarks before.json after.json   # from google/benchmark tools/
+
+#include <benchmark/benchmark.h>
+
+#include <oeselect/oeselect.h>
+#include <oeselect/Context.h>
+#include <oeselect/SpatialIndex.h>
+#include <oeselect/Tagger.h>
+#include <oechem.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace OESel;
+
+namespace {
+/// Residue templates for the synthetic protein: name plus atom names
+struct ResidueTemplate {
+    const char* name;
+    std::vector<const char*> atoms;
+};
+
+const std::vector<ResidueTemplate>& residue_templates() {
+    static const std::vector<ResidueTemplate> templates = {
+        {"ALA", {"N", "CA", "C", "O", "CB"}},
+        {"GLY", {"N", "CA", "C", "O"}},
+        {"SER", {"N", "CA", "C", "O", "CB", "OG"}},
+        {"LEU", {"N", "CA", "C", "O", "CB", "CG", "CD1", "CD2"}},
+        {"LYS", {"N", "CA", "C", "O", "CB", "CG", "CD", "CE", "NZ"}},
+        {"PHE", {"N", "CA", "C", "O", "CB", "CG", "CD1", "CD2", "CE1", "CE2", "CZ"}},
+    };
+    return templates;
+}
+
+/**
+ * Build a synthetic complex of about @p num_atoms atoms at protein density.
+ *
+ * 85% of the atoms are protein residues spread over chains A-Z, 15% are
+ * waters, and a 30-atom ligand sits at the centre of the box.
+ */
+std::unique_ptr<OEChem::OEGraphMol> make_system(const size_t num_atoms) {
+    auto mol = std::make_unique<OEChem::OEGraphMol>();
+    std::mt19937 rng(20240101);
+    // About one heavy atom per 10 cubic Angstroms
+    const float box = std::cbrt(static_cast<float>(num_atoms) * 10.0f);
+    std::uniform_real_distribution<float> centre(0.0f, box);
+    std::uniform_real_distribution<float> jitter(-2.0f, 2.0f);
+
+    auto add_atom = [&](const char* name, const unsigned int element, const char* resname,
+                        const int resnum, const char chain, const float* at) {
+        OEChem::OEAtomBase* atom = mol->NewAtom(element);
+        atom->SetName(name);
+        const float coords[3] = {at[0] + jitter(rng), at[1] + jitter(rng), at[2] + jitter(rng)};
+        mol->SetCoords(atom, coords);
+        OEChem::OEResidue res;
+        res.SetName(resname);
+        res.SetResidueNumber(resnum);
+        res.SetChainID(chain);
+        OEChem::OEAtomSetResidue(atom, res);
+    };
+
+    const size_t protein_atoms = num_atoms * 85 / 100;
+    size_t added = 0;
+    for (int r = 0; added < protein_atoms; ++r) {
+        const ResidueTemplate& tmpl = residue_templates()[static_cast<size_t>(r) % residue_templates().size()];
+        const float at[3] = {centre(rng), centre(rng), centre(rng)};
+        const char chain = static_cast<char>('A' + (r / 1000) % 26);
+        for (const char* name : tmpl.atoms) {
+            add_atom(name, name[0] == 'N' ? 7 : name[0] == 'O' ? 8 : 6, tmpl.name, r % 1000 + 1, chain, at);
+        }
+        added += tmpl.atoms.size();
+    }
+    for (int w = 1; added < num_atoms - 30; ++w, ++added) {
+        const float at[3] = {centre(rng), centre(rng), centre(rng)};
+        add_atom("O", 8, "HOH", w % 10000, 'W', at);
+    }
+    const float mid[3] = {box / 2, box / 2, box / 2};
+    for (int i = 0; i < 30; ++i) {
+        const std::string name = "C" + std::to_string(i + 1);
+        add_atom(name.c_str(), 6, "LIG", 1, 'L', mid);
+    }
+    return mol;
+}
+
+/**
+ * Molecule for a benchmark argument: 0 is tests/assets/9Q03.cif, anything
+ * else a synthetic system of that many atoms. Built once and cached.
+ */
+OEChem::OEGraphMol* get_system(benchmark::State& state) {
+    static std::map<int64_t, std::unique_ptr<OEChem::OEGraphMol>> systems;
+    const int64_t size = state.range(0);
+    auto it = systems.find(size);
+    if (it == systems.end()) {
+        std::unique_ptr<OEChem::OEGraphMol> mol;
+        if (size == 0) {
+            mol = std::make_unique<OEChem::OEGraphMol>();
+            OEChem::oemolistream ifs;
+            if (!ifs.open(OESELECT_BENCH_ASSET) || !OEChem::OEReadMolecule(ifs, *mol)) {
+                mol.reset();
+            }
+        } else {
+            mol = make_system(static_cast<size_t>(size));
+        }
+        it = systems.emplace(size, std::move(mol)).first;
+    }
+    if (!it->second) {
+        state.SkipWithError("Unable to read " OESELECT_BENCH_ASSET);
+        return nullptr;
+    }
+    state.counters["atoms"] = static_cast<double>(it->second->NumAtoms());
+    return it->second.get();
+}
+
+/// Systems every molecule benchmark runs on
+void Systems(benchmark::internal::Benchmark* bench) {
+    bench->ArgName("atoms")->Arg(0)->Arg(10000)->Arg(100000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+}
+
+/// Systems plus a radius second argument, in tenths of an Angstrom
+void SystemsAndRadii(benchmark::internal::Benchmark* bench) {
+    bench->ArgNames({"atoms", "radius_x10"})->Unit(benchmark::kMillisecond);
+    for (const int64_t atoms : {0, 10000, 100000, 1000000}) {
+        for (const int64_t radius : {30, 50, 80, 120}) {
+            bench->Args({atoms, radius});
+        }
+    }
+}
+
+/// Evaluate a selection in bulk on the benchmark's system
+void run_bulk(benchmark::State& state, const std::string& expr) {
+    OEChem::OEGraphMol* mol = get_system(state);
+    if (!mol) return;
+    const OESelection sele = OESelection::Parse(expr);
+    size_t matches = 0;
+    for (auto _ : state) {
+        const Bitset mask = sele.EvaluateMask(*mol);
+        matches = mask.Count();
+        benchmark::DoNotOptimize(matches);
+    }
+    state.counters["matches"] = static_cast<double>(matches);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * mol->NumAtoms());
+}
+
+const std::vector<std::string>& parse_expressions() {
+    static const std::vector<std::string> exprs = {
+        "name CA",
+        "protein and chain A and resi 10-50",
+        "name CA+CB+CG+N+C+O and not resn GLY+PRO",
+        "(ligand around 5 and protein) or (byres (ligand around 4) and not water)",
+        "heavy and (b > 30.0 or helix) and not (elem C xor elem N)",
+    };
+    return exprs;
+}
+
+// ---- Parsing ----
+
+void BM_Parse(benchmark::State& state) {
+    const std::string& expr = parse_expressions()[static_cast<size_t>(state.range(0))];
+    const bool cached = state.range(1) != 0;
+    const ParseCacheStats saved = OESelection::GetParseCacheStats();
+    OESelection::ClearParseCache();
+    OESelection::SetParseCacheCapacity(cached ? 1024 : 0);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(OESelection::Parse(expr));
+    }
+    OESelection::SetParseCacheCapacity(saved.capacity);
+    state.SetLabel(expr);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_Parse)->ArgNames({"expr", "cached"})->ArgsProduct({{0, 1, 2, 3, 4}, {0, 1}});
+
+// ---- Per-atom versus bulk evaluation ----
+
+const char* const kPropertyExpr = "name CA and chain A";
+
+void BM_PerAtomEvaluate(benchmark::State& state) {
+    OEChem::OEGraphMol* mol = get_system(state);
+    if (!mol) return;
+    const OESelection sele = OESelection::Parse(kPropertyExpr);
+    Context ctx(*mol, sele);
+    for (auto _ : state) {
+        size_t count = 0;
+        for (OESystem::OEIter<OEChem::OEAtomBase> atom = mol->GetAtoms(); atom; ++atom) {
+            count += sele.Root().Evaluate(ctx, *atom) ? 1 : 0;
+        }
+        benchmark::DoNotOptimize(count);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * mol->NumAtoms());
+}
+BENCHMARK(BM_PerAtomEvaluate)->Apply(Systems);
+
+void BM_OESelectOperator(benchmark::State& state) {
+    OEChem::OEGraphMol* mol = get_system(state);
+    if (!mol) return;
+    const OESelection sele = OESelection::Parse(kPropertyExpr);
+    for (auto _ : state) {
+        const OESelect select(*mol, sele);
+        size_t count = 0;
+        for (OESystem::OEIter<OEChem::OEAtomBase> atom = mol->GetAtoms(); atom; ++atom) {
+            count += select(*atom) ? 1 : 0;
+        }
+        benchmark::DoNotOptimize(count);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * mol->NumAtoms());
+}
+BENCHMARK(BM_OESelectOperator)->Apply(Systems);
+
+void BM_BulkEvaluate(benchmark::State& state) {
+    run_bulk(state, kPropertyExpr);
+}
+BENCHMARK(BM_BulkEvaluate)->Apply(Systems);
+
+void BM_NameList(benchmark::State& state) {
+    run_bulk(state, "name CA+CB+CG+N+C+O");
+}
+BENCHMARK(BM_NameList)->Apply(Systems);
+
+// ---- Components and the Tagger ----
+
+void BM_Components(benchmark::State& state) {
+    run_bulk(state, "protein or water or ligand");
+}
+BENCHMARK(BM_Components)->Apply(Systems);
+
+void BM_TaggerCold(benchmark::State& state) {
+    OEChem::OEGraphMol* mol = get_system(state);
+    if (!mol) return;
+    for (auto _ : state) {
+        state.PauseTiming();
+        OEChem::OEGraphMol copy(*mol);
+        state.ResumeTiming();
+        Tagger::TagMolecule(copy);
+        benchmark::DoNotOptimize(Tagger::IsTagged(copy));
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * mol->NumAtoms());
+}
+BENCHMARK(BM_TaggerCold)->Apply(Systems);
+
+void BM_TaggerWarm(benchmark::State& state) {
+    OEChem::OEGraphMol* mol = get_system(state);
+    if (!mol) return;
+    OEChem::OEGraphMol copy(*mol);
+    Tagger::TagMolecule(copy);
+    for (auto _ : state) {
+        Tagger::TagMolecule(copy);
+        benchmark::DoNotOptimize(Tagger::IsTagged(copy));
+    }
+}
+BENCHMARK(BM_TaggerWarm)->Apply(Systems);
+
+// ---- SpatialIndex ----
+
+void BM_SpatialIndexBuild(benchmark::State& state) {
+    OEChem::OEGraphMol* mol = get_system(state);
+    if (!mol) return;
+    const auto backend = static_cast<SpatialBackend>(state.range(1));
+    for (auto _ : state) {
+        const SpatialIndex index(*mol, backend, 8.0f);
+        benchmark::ClobberMemory();
+    }
+    state.SetLabel(backend == SpatialBackend::KD_TREE ? "kd-tree" : "cell-list");
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * mol->NumAtoms());
+}
+BENCHMARK(BM_SpatialIndexBuild)
+    ->ArgNames({"atoms", "backend"})
+    ->ArgsProduct({{0, 10000, 100000, 1000000},
+                   {static_cast<int64_t>(SpatialBackend::KD_TREE), static_cast<int64_t>(SpatialBackend::CELL_LIST)}})
+    ->Unit(benchmark::kMillisecond);
+
+void BM_SpatialIndexQuery(benchmark::State& state) {
+    OEChem::OEGraphMol* mol = get_system(state);
+    if (!mol) return;
+    const float radius = static_cast<float>(state.range(1)) / 10.0f;
+    const SpatialIndex index(*mol, SpatialBackend::AUTO, radius);
+    // Every hundredth atom stands in for a reference set
+    Bitset refs(mol->GetMaxAtomIdx());
+    for (OESystem::OEIter<OEChem::OEAtomBase> atom = mol->GetAtoms(); atom; ++atom) {
+        if (atom->GetIdx() % 100 == 0) {
+            refs.Set(atom->GetIdx());
+        }
+    }
+    Bitset out(mol->GetMaxAtomIdx());
+    for (auto _ : state) {
+        out.ResetAll();
+        index.MarkWithinRadius(refs, radius, out);
+        benchmark::DoNotOptimize(out.Words());
+    }
+    state.counters["matches"] = static_cast<double>(out.Count());
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * refs.Count()));
+}
+BENCHMARK(BM_SpatialIndexQuery)->Apply(SystemsAndRadii);
+
+void BM_SpatialIndexQueryPeriodic(benchmark::State& state) {
+    OEChem::OEGraphMol* mol = get_system(state);
+    if (!mol) return;
+    const float radius = static_cast<float>(state.range(1)) / 10.0f;
+    // Treat the bounding box as the periodic cell, as for a solvated MD box
+    float lo[3] = {INFINITY, INFINITY, INFINITY};
+    float hi[3] = {-INFINITY, -INFINITY, -INFINITY};
+    for (OESystem::OEIter<OEChem::OEAtomBase> atom = mol->GetAtoms(); atom; ++atom) {
+        float xyz[3];
+        mol->GetCoords(&*atom, xyz);
+        for (int d = 0; d < 3; ++d) {
+            lo[d] = std::min(lo[d], xyz[d]);
+            hi[d] = std::max(hi[d], xyz[d]);
+        }
+    }
+    const UnitCell cell = UnitCell::Orthorhombic(hi[0] - lo[0] + 1.0f, hi[1] - lo[1] + 1.0f, hi[2] - lo[2] + 1.0f);
+    const SpatialIndex index(*mol, SpatialBackend::AUTO, radius, cell);
+    Bitset refs(mol->GetMaxAtomIdx());
+    for (OESystem::OEIter<OEChem::OEAtomBase> atom = mol->GetAtoms(); atom; ++atom) {
+        if (atom->GetIdx() % 100 == 0) {
+            refs.Set(atom->GetIdx());
+        }
+    }
+    Bitset out(mol->GetMaxAtomIdx());
+    for (auto _ : state) {
+        out.ResetAll();
+        index.MarkWithinRadius(refs, radius, out);
+        benchmark::DoNotOptimize(out.Words());
+    }
+    state.counters["matches"] = static_cast<double>(out.Count());
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * refs.Count()));
+}
+BENCHMARK(BM_SpatialIndexQueryPeriodic)->Apply(SystemsAndRadii);
+
+// ---- Distance operators ----
+
+std::string radius_expr(const char* op, const benchmark::State& state) {
+    char expr[64];
+    std::snprintf(expr, sizeof(expr), "ligand %s %.1f", op, static_cast<double>(state.range(1)) / 10.0);
+    return expr;
+}
+
+void BM_Around(benchmark::State& state) {
+    run_bulk(state, radius_expr("around", state));
+}
+BENCHMARK(BM_Around)->Apply(SystemsAndRadii);
+
+void BM_Expand(benchmark::State& state) {
+    run_bulk(state, radius_expr("expand", state));
+}
+BENCHMARK(BM_Expand)->Apply(SystemsAndRadii);
+
+void BM_Beyond(benchmark::State& state) {
+    run_bulk(state, radius_expr("beyond", state));
+}
+BENCHMARK(BM_Beyond)->Apply(SystemsAndRadii);
+
+// ---- Expansion operators ----
+
+void BM_ByRes(benchmark::State& state) {
+    run_bulk(state, "byres (ligand around 8)");
+}
+BENCHMARK(BM_ByRes)->Apply(Systems);
+
+void BM_ByChain(benchmark::State& state) {
+    run_bulk(state, "bychain (ligand around 8)");
+}
+BENCHMARK(BM_ByChain)->Apply(Systems);
+
+// ---- Bond graph operators ----
+// Synthetic systems have no bonds, so only atoms:0 exercises the adjacency
+
+void BM_BondWalk(benchmark::State& state) {
+    run_bulk(state, "polarh or apolarh or organic");
+}
+BENCHMARK(BM_BondWalk)->Apply(Systems);
+
+void BM_Extend(benchmark::State& state) {
+    run_bulk(state, "bound_to metal or (ligand extend 3)");
+}
+BENCHMARK(BM_Extend)->Apply(Systems);
+
+// ---- Parallel evaluation ----
+
+/// Large systems plus a thread count second argument
+void SystemsAndThreads(benchmark::internal::Benchmark* bench) {
+    bench->ArgNames({"atoms", "threads"})->Unit(benchmark::kMillisecond)->UseRealTime();
+    for (const int64_t atoms : {100000, 1000000}) {
+        for (const int64_t threads : {1, 2, 4, 8}) {
+            bench->Args({atoms, threads});
+        }
+    }
+}
+
+/// Evaluate a selection on a threaded context; Reset() keeps the worker pool warm
+void run_threaded(benchmark::State& state, const std::string& expr) {
+    OEChem::OEGraphMol* mol = get_system(state);
+    if (!mol) return;
+    const OESelection sele = OESelection::Parse(expr);
+    Context ctx(*mol, sele);
+    ctx.SetNumThreads(static_cast<unsigned int>(state.range(1)));
+    size_t matches = 0;
+    for (auto _ : state) {
+        ctx.Reset(*mol);
+        Bitset mask(mol->GetMaxAtomIdx());
+        ctx.EvaluateSelection(mask);
+        matches = mask.Count();
+        benchmark::DoNotOptimize(matches);
+    }
+    state.counters["matches"] = static_cast<double>(matches);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * mol->NumAtoms());
+}
+
+void BM_ParallelScan(benchmark::State& state) {
+    run_threaded(state, "(name CA+CB or resi 100-5000) and not water");
+}
+BENCHMARK(BM_ParallelScan)->Apply(SystemsAndThreads);
+
+void BM_ParallelAround(benchmark::State& state) {
+    run_threaded(state, "byres (ligand around 8)");
+}
+BENCHMARK(BM_ParallelAround)->Apply(SystemsAndThreads);
+
+// ---- OEResidueSelector ----
+
+/// Selector over the first 2000 residues of the molecule, as in a pocket list
+OEResidueSelector make_pocket_selector(OEChem::OEMolBase& mol) {
+    std::set<Selector> pocket;
+    for (const Selector& selector : mol_to_selector_set(mol)) {
+        if (pocket.size() == 2000) break;
+        pocket.insert(selector);
+    }
+    return OEResidueSelector(pocket);
+}
+
+void BM_ResidueSelectorPerAtom(benchmark::State& state) {
+    OEChem::OEGraphMol* mol = get_system(state);
+    if (!mol) return;
+    const OEResidueSelector selector = make_pocket_selector(*mol);
+    for (auto _ : state) {
+        size_t count = 0;
+        for (OESystem::OEIter<OEChem::OEAtomBase> atom = mol->GetAtoms(); atom; ++atom) {
+            count += selector(*atom) ? 1 : 0;
+        }
+        benchmark::DoNotOptimize(count);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * mol->NumAtoms());
+}
+BENCHMARK(BM_ResidueSelectorPerAtom)->Apply(Systems);
+
+void BM_ResidueSelectorMask(benchmark::State& state) {
+    OEChem::OEGraphMol* mol = get_system(state);
+    if (!mol) return;
+    const OEResidueSelector selector = make_pocket_selector(*mol);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(selector.EvaluateMask(*mol));
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * mol->NumAtoms());
+}
+BENCHMARK(BM_ResidueSelectorMask)->Apply(Systems);
+}  // namespace
+
+BENCHMARK_MAIN();
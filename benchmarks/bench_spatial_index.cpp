@@ -0,0 +1,97 @@
+// benchmarks/bench_spatial_index.cpp
+// Compare SpatialIndex backends on a structure file (default: tests/assets/9Q03.cif).
+//
+// Usage: oeselect_spatial_bench [structure-file] [repetitions]
+
+#include <oeselect/Bitset.h>
+#include <oeselect/SpatialIndex.h>
+#include <oechem.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace OESel;
+
+namespace {
+/// Median wall time of @p reps runs of @p fn, in milliseconds
+double median_ms(const int reps, const std::function<void()>& fn) {
+    std::vector<double> times;
+    times.reserve(static_cast<size_t>(reps));
+    for (int i = 0; i < reps; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        fn();
+        const auto stop = std::chrono::steady_clock::now();
+        times.push_back(std::chrono::duration<double, std::milli>(stop - start).count());
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+const char* backend_name(const SpatialBackend backend) {
+    switch (backend) {
+        case SpatialBackend::AUTO: return "auto";
+        case SpatialBackend::KD_TREE: return "kd-tree";
+        case SpatialBackend::CELL_LIST: return "cell-list";
+    }
+    return "?";
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+    const std::string path = argc > 1 ? argv[1] : OESELECT_BENCH_ASSET;
+    const int reps = argc > 2 ? std::max(1, std::atoi(argv[2])) : 20;
+
+    OEChem::OEGraphMol mol;
+    OEChem::oemolistream ifs;
+    if (!ifs.open(path) || !OEChem::OEReadMolecule(ifs, mol)) {
+        std::fprintf(stderr, "Unable to read molecule from %s\n", path.c_str());
+        return 1;
+    }
+
+    // Every tenth atom stands in for a ligand/binding-site reference set
+    Bitset refs(mol.GetMaxAtomIdx());
+    std::vector<const OEChem::OEAtomBase*> ref_atoms;
+    for (OESystem::OEIter<OEChem::OEAtomBase> atom = mol.GetAtoms(); atom; ++atom) {
+        if (atom->GetIdx() % 10 == 0) {
+            refs.Set(atom->GetIdx());
+            ref_atoms.push_back(&*atom);
+        }
+    }
+
+    std::printf("%s: %u atoms, %zu reference atoms, median of %d runs\n\n",
+                path.c_str(), mol.NumAtoms(), ref_atoms.size(), reps);
+    std::printf("%-10s %7s %10s %14s %14s %8s\n",
+                "backend", "radius", "build ms", "per-atom ms", "batch ms", "matches");
+
+    for (const float radius : {3.0f, 4.0f, 5.0f, 8.0f, 12.0f}) {
+        for (const SpatialBackend backend : {SpatialBackend::KD_TREE, SpatialBackend::CELL_LIST}) {
+            const double build = median_ms(reps, [&] { SpatialIndex index(mol, backend, radius); });
+
+            const SpatialIndex index(mol, backend, radius);
+            size_t sink = 0;
+            const double per_atom = median_ms(reps, [&] {
+                for (const OEChem::OEAtomBase* atom : ref_atoms) {
+                    sink += index.FindWithinRadius(*atom, radius).size();
+                }
+            });
+
+            Bitset out(mol.GetMaxAtomIdx());
+            const double batch = median_ms(reps, [&] {
+                out.ResetAll();
+                index.MarkWithinRadius(refs, radius, out);
+            });
+
+            std::printf("%-10s %7.1f %10.3f %14.3f %14.3f %8zu\n",
+                        backend_name(backend), radius, build, per_atom, batch, out.Count());
+            (void)sink;
+        }
+        std::printf("%-10s %7.1f -> %s\n", "auto", radius,
+                    backend_name(SpatialIndex::ChooseBackend(mol.NumAtoms(), radius)));
+    }
+    return 0;
+}
@@ -0,0 +1,183 @@
+/**
+ * @file AtomTable.h
+ * @brief Columnar snapshot of per-atom properties for bulk evaluation.
+ *
+ * AtomTable reads every atom's residue and atom properties in a single
+ * pass over the molecule and stores them as contiguous arrays indexed by
+ * atom index, so bulk predicates can scan columns instead of calling
+ * OEChem accessors per atom.
+ */
+
+#ifndef OESELECT_ATOM_TABLE_H
+#define OESELECT_ATOM_TABLE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "oeselect/Bitset.h"
+
+namespace OEChem {
+class OEMolBase;
+}
+
+namespace OESel {
+
+class TableFileReader;
+class TableFileWriter;
+
+/// @brief Half-open run [begin, end) of consecutive atom indices.
+struct AtomRun {
+    std::uint32_t begin;  ///< First atom index in the run
+    std::uint32_t end;    ///< One past the last atom index in the run
+};
+
+/**
+ * @brief CSR map from dense group ids (residues or chains) to atom runs.
+ *
+ * Group g covers runs[offsets[g] .. offsets[g + 1]). Atoms of a residue
+ * or chain are usually stored consecutively, so most groups have a
+ * single run and the map costs a few bytes per group rather than per atom.
+ */
+struct GroupRuns {
+    std::vector<std::uint32_t> offsets{0};  ///< NumGroups() + 1 run offsets
+    std::vector<AtomRun> runs;              ///< Runs ordered by group, then atom index
+
+    /// @brief Number of groups.
+    [[nodiscard]] size_t NumGroups() const { return offsets.size() - 1; }
+
+    /**
+     * @brief Set the atoms of every group marked in @p groups.
+     * @param groups Bitset indexed by group id (NumGroups() bits).
+     * @param atoms Bitset indexed by atom index receiving the group atoms.
+     */
+    void Paint(const Bitset& groups, Bitset& atoms) const;
+};
+
+/**
+ * @brief Structure-of-arrays snapshot of atom properties.
+ *
+ * Every column has one entry per atom index up to the molecule's
+ * GetMaxAtomIdx(). Slots for deleted atom indices hold default values and
+ * must be masked out with Context::GetAtomMask().
+ *
+ * Residue and atom names are interned: the id columns index into
+ * ResidueNames() and AtomNames(), so a name pattern only needs to be
+ * matched once per distinct name.
+ *
+ * @note The table is a snapshot taken at construction time. Changes to
+ *       the molecule afterwards are not reflected.
+ */
+class AtomTable {
+public:
+    /**
+     * @brief Build the table in one pass over the molecule.
+     * @param mol The molecule to snapshot.
+     */
+    explicit AtomTable(const OEChem::OEMolBase& mol);
+
+    /// @brief Destructor.
+    ~AtomTable();
+
+    // Non-copyable (large snapshot owned by a Context)
+    AtomTable(const AtomTable&) = delete;
+    AtomTable& operator=(const AtomTable&) = delete;
+
+    /// @brief Number of rows (the molecule's GetMaxAtomIdx()).
+    [[nodiscard]] size_t Size() const;
+
+    /// @name Interned names
+    /// @{
+
+    /// @brief Distinct residue names, indexed by ResidueNameIds() values.
+    [[nodiscard]] const std::vector<std::string>& ResidueNames() const;
+
+    /// @brief Distinct atom names with ASCII spaces trimmed, indexed by AtomNameIds() values.
+    [[nodiscard]] const std::vector<std::string>& AtomNames() const;
+
+    /// @}
+
+    /// @name Columns
+    /// @{
+
+    /// @brief Interned residue name id per atom.
+    [[nodiscard]] const std::vector<std::uint32_t>& ResidueNameIds() const;
+
+    /// @brief Interned trimmed atom name id per atom.
+    [[nodiscard]] const std::vector<std::uint32_t>& AtomNameIds() const;
+
+    /// @brief Residue number per atom.
+    [[nodiscard]] const std::vector<int>& ResidueNumbers() const;
+
+    /// @brief Chain identifier per atom.
+    [[nodiscard]] const std::vector<char>& ChainIds() const;
+
+    /// @brief Residue insertion code per atom.
+    [[nodiscard]] const std::vector<char>& InsertCodes() const;
+
+    /// @brief PDB serial number per atom.
+    [[nodiscard]] const std::vector<int>& SerialNumbers() const;
+
+    /// @brief Alternate location identifier per atom.
+    [[nodiscard]] const std::vector<char>& AltLocations() const;
+
+    /// @brief B-factor per atom.
+    [[nodiscard]] const std::vector<float>& BFactors() const;
+
+    /// @brief Fragment number per atom.
+    [[nodiscard]] const std::vector<unsigned int>& FragmentNumbers() const;
+
+    /// @brief OESecondaryStructure flags per atom.
+    [[nodiscard]] const std::vector<int>& SecondaryStructure() const;
+
+    /// @brief Atomic number per atom.
+    [[nodiscard]] const std::vector<unsigned int>& AtomicNumbers() const;
+
+    /// @brief ComponentFlag bits per atom, classified once per distinct residue name.
+    [[nodiscard]] const std::vector<std::uint8_t>& ComponentFlags() const;
+
+    /// @}
+
+    /// @name Topology
+    /// Residues are identified by (chain, residue number, insertion code) and
+    /// chains by chain identifier. Both get dense ids in first-seen atom order;
+    /// slots for deleted atom indices hold kNoGroup.
+    /// @{
+
+    /// @brief Group id stored for deleted atom indices.
+    static constexpr std::uint32_t kNoGroup = UINT32_MAX;
+
+    /// @brief Dense residue id per atom.
+    [[nodiscard]] const std::vector<std::uint32_t>& ResidueGroups() const;
+
+    /// @brief Dense chain id per atom.
+    [[nodiscard]] const std::vector<std::uint32_t>& ChainGroups() const;
+
+    /// @brief Atom runs of each residue, indexed by ResidueGroups() values.
+    [[nodiscard]] const GroupRuns& ResidueRuns() const;
+
+    /// @brief Atom runs of each chain, indexed by ChainGroups() values.
+    [[nodiscard]] const GroupRuns& ChainRuns() const;
+
+    /// @}
+
+private:
+    friend class TableCache;
+
+    /// Empty table, filled by Read()
+    AtomTable();
+
+    /// Append every column to a table cache image
+    void Write(TableFileWriter& out) const;
+
+    /// Replace every column from a table cache image, validating sizes and ids
+    void Read(TableFileReader& in);
+
+    struct Impl;
+    std::unique_ptr<Impl> pimpl_;  ///< PIMPL containing column storage
+};
+
+}  // namespace OESel
+
+#endif  // OESELECT_ATOM_TABLE_H
@@ -0,0 +1,150 @@
+/**
+ * @file BatchEvaluator.h
+ * @brief Parallel evaluation of several selections over many molecules.
+ *
+ * BatchEvaluator runs a fixed set of selections against a batch or a
+ * stream of molecules on a work-stealing thread pool. Each worker keeps
+ * one reusable SelectionSet, so subexpressions shared between selections
+ * are evaluated once per molecule.
+ */
+
+#ifndef OESELECT_BATCH_EVALUATOR_H
+#define OESELECT_BATCH_EVALUATOR_H
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "oeselect/Bitset.h"
+#include "oeselect/Selection.h"
+
+namespace OEChem {
+class OEMolBase;
+class oemolistream;
+}
+
+namespace OESel {
+
+/**
+ * @brief Evaluates a set of selections across many molecules in parallel.
+ *
+ * Molecules are independent items on a work-stealing pool: every molecule
+ * is evaluated by exactly one worker, which runs all selections against it
+ * in turn. Results are returned in input order.
+ *
+ * @code
+ * std::vector<OESelection> selections = {
+ *     OESelection::Parse("ligand"),
+ *     OESelection::Parse("protein and (ligand around 4.5)")};
+ * BatchEvaluator batch(selections);
+ *
+ * oemolistream ifs("complexes.oeb");
+ * batch.Evaluate(ifs, [](size_t index, OEChem::OEMolBase& mol,
+ *                        const std::vector<Bitset>& masks) {
+ *     // masks[s] holds the atoms of mol matching selections[s]
+ * });
+ * @endcode
+ *
+ * @note Each molecule is tagged and read by a single worker at a time, but
+ *       the same molecule must not appear twice in one batch. One batch
+ *       runs at a time; concurrent calls on the same evaluator are
+ *       serialized.
+ */
+class BatchEvaluator {
+public:
+    /**
+     * @brief Callback receiving one molecule's results.
+     *
+     * Invoked on the calling thread in input order.
+     *
+     * @param index Position of the molecule in the input.
+     * @param mol The molecule.
+     * @param masks One mask per selection, sized to mol.GetMaxAtomIdx().
+     */
+    using MaskCallback = std::function<void(size_t index, OEChem::OEMolBase& mol,
+                                            const std::vector<Bitset>& masks)>;
+
+    /**
+     * @brief Create an evaluator and start its workers.
+     *
+     * @param selections Selections to apply to every molecule.
+     * @param num_threads Number of worker threads; 0 uses the hardware
+     *        concurrency, and 1 evaluates on the calling thread.
+     */
+    explicit BatchEvaluator(std::vector<OESelection> selections, unsigned int num_threads = 0);
+
+    /// @brief Destructor (joins the workers).
+    ~BatchEvaluator();
+
+    // Non-copyable (owns threads)
+    BatchEvaluator(const BatchEvaluator&) = delete;
+    BatchEvaluator& operator=(const BatchEvaluator&) = delete;
+
+    /// @brief Number of selections evaluated per molecule.
+    [[nodiscard]] size_t NumSelections() const;
+
+    /// @brief Number of worker threads.
+    [[nodiscard]] unsigned int NumThreads() const;
+
+    /**
+     * @brief Evaluate every selection against every molecule.
+     *
+     * @param mols Molecules to evaluate (must not be null).
+     * @return result[m][s] is the mask of selection s on molecule m.
+     * @throws SelectionError if evaluation fails.
+     */
+    [[nodiscard]] std::vector<std::vector<Bitset>> EvaluateMasks(const std::vector<OEChem::OEMolBase*>& mols);
+
+    /**
+     * @brief Count matching atoms for every selection and molecule.
+     *
+     * @param mols Molecules to evaluate (must not be null).
+     * @return result[m][s] is the number of atoms of molecule m matching selection s.
+     * @throws SelectionError if evaluation fails.
+     */
+    [[nodiscard]] std::vector<std::vector<unsigned int>> Count(const std::vector<OEChem::OEMolBase*>& mols);
+
+    /**
+     * @brief Count matching atoms for every selection over a molecule stream.
+     *
+     * @param ifs Stream to read until exhausted.
+     * @return result[m][s] is the number of atoms of the m-th molecule read
+     *         matching selection s.
+     * @throws SelectionError if evaluation fails.
+     */
+    [[nodiscard]] std::vector<std::vector<unsigned int>> Count(OEChem::oemolistream& ifs);
+
+    /**
+     * @brief Collect matching atom indices for every selection and molecule.
+     *
+     * @param mols Molecules to evaluate (must not be null).
+     * @return result[m][s] lists the atom indices of molecule m matching
+     *         selection s in ascending order.
+     * @throws SelectionError if evaluation fails.
+     */
+    [[nodiscard]] std::vector<std::vector<std::vector<unsigned int>>> Select(
+        const std::vector<OEChem::OEMolBase*>& mols);
+
+    /**
+     * @brief Evaluate a molecule stream chunk by chunk.
+     *
+     * Reads molecules on the calling thread into a bounded chunk, evaluates
+     * the chunk in parallel, and passes each molecule's masks to
+     * @p callback before the molecule is discarded, so memory stays
+     * bounded for streams of any length.
+     *
+     * @param ifs Stream to read until exhausted.
+     * @param callback Receives each molecule's masks in input order.
+     * @return Number of molecules read.
+     * @throws SelectionError if evaluation fails.
+     */
+    size_t Evaluate(OEChem::oemolistream& ifs, const MaskCallback& callback);
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> pimpl_;  ///< PIMPL containing the pool and worker contexts
+};
+
+}  // namespace OESel
+
+#endif  // OESELECT_BATCH_EVALUATOR_H
@@ -0,0 +1,167 @@
+/**
+ * @file Bitset.h
+ * @brief Packed atom bitset used for whole-molecule selection evaluation.
+ *
+ * Bitset stores one bit per atom index in 64-bit words so that logical
+ * operators can combine entire selections with word-wide bit operations.
+ */
+
+#ifndef OESELECT_BITSET_H
+#define OESELECT_BITSET_H
+
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace OESel {
+
+/**
+ * @brief Dense, fixed-size bitset indexed by atom index.
+ *
+ * A Bitset produced by selection evaluation is sized to the molecule's
+ * GetMaxAtomIdx(), so any atom's GetIdx() can be used directly as a bit
+ * position. Binary operators require both operands to have the same size.
+ *
+ * @code
+ * auto sele = OESelection::Parse("protein and not water");
+ * Bitset mask = sele.EvaluateMask(mol);
+ * for (OESystem::OEIter<OEChem::OEAtomBase> atom = mol.GetAtoms(); atom; ++atom) {
+ *     if (mask.Test(atom->GetIdx())) {
+ *         // Process matching atom
+ *     }
+ * }
+ * @endcode
+ */
+class Bitset {
+public:
+    /// @brief Storage word type
+    using Word = std::uint64_t;
+
+    /// @brief Number of bits per storage word
+    static constexpr size_t kWordBits = 64;
+
+    /// @brief Construct an empty bitset.
+    Bitset() = default;
+
+    /**
+     * @brief Construct a bitset with a fixed number of bits.
+     * @param size Number of bits.
+     * @param value Initial value for every bit.
+     */
+    explicit Bitset(size_t size, bool value = false);
+
+    /// @brief Number of bits in the set.
+    [[nodiscard]] size_t Size() const { return size_; }
+
+    /// @brief Number of storage words.
+    [[nodiscard]] size_t NumWords() const { return words_.size(); }
+
+    /**
+     * @brief Test a single bit.
+     * @param idx Bit position.
+     * @return true if the bit is set; false if unset or out of range.
+     */
+    [[nodiscard]] bool Test(const size_t idx) const {
+        return idx < size_ && (words_[idx / kWordBits] >> (idx % kWordBits) & 1U) != 0;
+    }
+
+    /**
+     * @brief Set a single bit.
+     * @param idx Bit position (must be less than Size()).
+     */
+    void Set(const size_t idx) { words_[idx / kWordBits] |= Word{1} << (idx % kWordBits); }
+
+    /**
+     * @brief Clear a single bit.
+     * @param idx Bit position (must be less than Size()).
+     */
+    void Reset(const size_t idx) { words_[idx / kWordBits] &= ~(Word{1} << (idx % kWordBits)); }
+
+    /**
+     * @brief Set a contiguous range of bits.
+     * @param begin First bit position (inclusive).
+     * @param end Last bit position (exclusive, at most Size()).
+     */
+    void SetRange(size_t begin, size_t end);
+
+    /// @brief Set every bit.
+    void SetAll();
+
+    /// @brief Clear every bit.
+    void ResetAll();
+
+    /// @brief Invert every bit.
+    void Flip();
+
+    /// @brief Number of set bits.
+    [[nodiscard]] size_t Count() const;
+
+    /// @brief Check whether any bit is set.
+    [[nodiscard]] bool Any() const;
+
+    /// @brief Check whether no bit is set.
+    [[nodiscard]] bool None() const { return !Any(); }
+
+    /// @brief Bitwise AND with another bitset of the same size.
+    Bitset& operator&=(const Bitset& other);
+
+    /// @brief Bitwise OR with another bitset of the same size.
+    Bitset& operator|=(const Bitset& other);
+
+    /// @brief Bitwise XOR with another bitset of the same size.
+    Bitset& operator^=(const Bitset& other);
+
+    /**
+     * @brief Clear every bit that is set in another bitset.
+     * @param other Bitset of the same size.
+     * @return Reference to this bitset.
+     */
+    Bitset& AndNot(const Bitset& other);
+
+    /// @brief Equality comparison.
+    bool operator==(const Bitset& other) const;
+
+    /// @brief Inequality comparison.
+    bool operator!=(const Bitset& other) const { return !(*this == other); }
+
+    /**
+     * @brief Collect positions of set bits in ascending order.
+     * @return Vector of set bit positions.
+     */
+    [[nodiscard]] std::vector<unsigned int> ToIndices() const;
+
+    /**
+     * @brief Call @p visit with the position of every set bit in ascending order.
+     * @param visit Callable taking a size_t bit position.
+     */
+    template <typename Visitor>
+    void ForEachSet(Visitor&& visit) const {
+        for (size_t w = 0; w < words_.size(); ++w) {
+            Word bits = words_[w];
+            while (bits != 0) {
+                // Isolate and strip the lowest set bit
+                const Word low = bits & (~bits + 1);
+                visit(w * kWordBits + static_cast<size_t>(std::bitset<kWordBits>(low - 1).count()));
+                bits ^= low;
+            }
+        }
+    }
+
+    /// @brief Access the underlying storage words (const).
+    [[nodiscard]] const Word* Words() const { return words_.data(); }
+
+    /// @brief Access the underlying storage words (mutable).
+    Word* Words() { return words_.data(); }
+
+private:
+    /// @brief Clear padding bits past Size() in the last word.
+    void ClearTail();
+
+    std::vector<Word> words_;
+    size_t size_ = 0;
+};
+
+}  // namespace OESel
+
+#endif  // OESELECT_BITSET_H
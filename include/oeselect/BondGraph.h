@@ -0,0 +1,112 @@
+/**
+ * @file BondGraph.h
+ * @brief Compressed bond adjacency for bond-walking predicates.
+ *
+ * BondGraph reads every bond once and stores the neighbours of each atom
+ * contiguously (compressed sparse rows), so predicates that inspect bonded
+ * atoms scan flat arrays instead of iterating OEChem bond lists per atom.
+ */
+
+#ifndef OESELECT_BOND_GRAPH_H
+#define OESELECT_BOND_GRAPH_H
+
+#include <cstdint>
+#include <vector>
+
+#include "oeselect/Bitset.h"
+
+namespace OEChem {
+class OEMolBase;
+}
+
+namespace OESel {
+
+class TableFileReader;
+class TableFileWriter;
+
+/**
+ * @brief CSR adjacency of a molecule's bond graph.
+ *
+ * The neighbours of atom i are Neighbors()[Offsets()[i] .. Offsets()[i + 1]),
+ * with their atomic numbers stored alongside in NeighborAtomicNumbers().
+ * Rows cover every atom index up to the molecule's GetMaxAtomIdx(); rows
+ * for deleted atom indices are empty.
+ *
+ * @note The graph is a snapshot taken at construction time. Changes to
+ *       the molecule's bonds afterwards are not reflected.
+ */
+class BondGraph {
+public:
+    /**
+     * @brief Build the adjacency in one pass over the molecule's bonds.
+     * @param mol The molecule to snapshot.
+     */
+    explicit BondGraph(const OEChem::OEMolBase& mol);
+
+    // Non-copyable (snapshot owned by a Context)
+    BondGraph(const BondGraph&) = delete;
+    BondGraph& operator=(const BondGraph&) = delete;
+
+    /// @brief Number of rows (the molecule's GetMaxAtomIdx()).
+    [[nodiscard]] size_t Size() const { return atomic_numbers_.size(); }
+
+    /// @brief Size() + 1 row offsets into Neighbors().
+    [[nodiscard]] const std::vector<std::uint32_t>& Offsets() const { return offsets_; }
+
+    /// @brief Bonded atom indices, grouped by atom.
+    [[nodiscard]] const std::vector<std::uint32_t>& Neighbors() const { return neighbors_; }
+
+    /// @brief Atomic number of each Neighbors() entry.
+    [[nodiscard]] const std::vector<std::uint8_t>& NeighborAtomicNumbers() const {
+        return neighbor_atomic_numbers_;
+    }
+
+    /// @brief Atomic number per atom (0 for deleted atom indices).
+    [[nodiscard]] const std::vector<std::uint8_t>& AtomicNumbers() const { return atomic_numbers_; }
+
+    /// @brief Number of bonds of atom @p idx.
+    [[nodiscard]] std::uint32_t Degree(const size_t idx) const { return offsets_[idx + 1] - offsets_[idx]; }
+
+    /**
+     * @brief Whether atom @p idx is bonded to an atom satisfying a test.
+     * @param idx Atom index; atoms outside the snapshot have no neighbours.
+     * @param test Callable taking a neighbour's atomic number.
+     * @return true if any neighbour's atomic number passes @p test.
+     */
+    template <typename Test>
+    [[nodiscard]] bool AnyNeighbor(const size_t idx, Test&& test) const {
+        if (idx >= Size()) return false;
+        for (std::uint32_t k = offsets_[idx]; k < offsets_[idx + 1]; ++k) {
+            if (test(static_cast<unsigned int>(neighbor_atomic_numbers_[k]))) return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Set the bonded neighbours of every atom in @p atoms.
+     * @param atoms Bitset of source atoms, sized to Size().
+     * @param out Bitset receiving the neighbours, sized to Size().
+     */
+    void MarkNeighbors(const Bitset& atoms, Bitset& out) const;
+
+private:
+    friend class TableCache;
+
+    /// Empty graph, filled by Read()
+    BondGraph() = default;
+
+    /// Append the adjacency to a table cache image
+    void Write(TableFileWriter& out) const;
+
+    /// Replace the adjacency from a table cache image, validating offsets and indices
+    void Read(TableFileReader& in);
+
+    std::vector<std::uint32_t> offsets_;
+    std::vector<std::uint32_t> neighbors_;
+    std::vector<std::uint8_t> neighbor_atomic_numbers_;
+    std::vector<std::uint8_t> atomic_numbers_;
+};
+
+}  // namespace OESel
+
+#endif  // OESELECT_BOND_GRAPH_H
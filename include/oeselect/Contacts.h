@@ -0,0 +1,100 @@
+/**
+ * @file Contacts.h
+ * @brief Atom pairs in contact between two selections.
+ *
+ * Where the around predicate answers "is this atom near the reference?",
+ * FindContacts() reports which pairs are in contact and how far apart
+ * they are, as flat arrays suitable for interaction fingerprints.
+ */
+
+#ifndef OESELECT_CONTACTS_H
+#define OESELECT_CONTACTS_H
+
+#include <cstddef>
+#include <vector>
+
+#include "oeselect/Selection.h"
+
+namespace OEChem {
+class OEMolBase;
+}
+
+namespace OESel {
+
+/**
+ * @brief Granularity of a contact search.
+ */
+enum class ContactLevel {
+    ATOM,    ///< One entry per atom pair within the cutoff
+    RESIDUE  ///< One entry per residue pair: its closest atom pair
+};
+
+/**
+ * @brief Contact pairs as a structure of arrays.
+ *
+ * Entry k pairs atom First()[k] of the first selection with atom
+ * Second()[k] of the second at squared distance DistanceSq()[k].
+ */
+class ContactList {
+public:
+    /// @brief Atom indices from the first selection.
+    [[nodiscard]] const std::vector<unsigned int>& First() const { return first_; }
+
+    /// @brief Atom indices from the second selection.
+    [[nodiscard]] const std::vector<unsigned int>& Second() const { return second_; }
+
+    /// @brief Squared distances in square Angstroms.
+    [[nodiscard]] const std::vector<float>& DistanceSq() const { return distance_sq_; }
+
+    /// @brief Number of contacts.
+    [[nodiscard]] size_t Size() const { return first_.size(); }
+
+    /// @brief Whether there are no contacts.
+    [[nodiscard]] bool Empty() const { return first_.empty(); }
+
+private:
+    friend ContactList FindContacts(OEChem::OEMolBase&, const OESelection&, const OESelection&,
+                                    float, ContactLevel);
+
+    std::vector<unsigned int> first_;
+    std::vector<unsigned int> second_;
+    std::vector<float> distance_sq_;
+};
+
+/**
+ * @brief Find the atom pairs of two selections closer than a cutoff.
+ *
+ * Both selections are evaluated in one pass (see SelectionSet), and pairs
+ * are collected in a single batch over the molecule's spatial index
+ * without any per-pair allocation. Entries are ordered by first atom
+ * index, then second atom index. An atom in both selections is never
+ * paired with itself, but two such atoms appear in both orders.
+ *
+ * With ContactLevel::RESIDUE, atom pairs are grouped by the residues of
+ * their two atoms and each residue pair is reported once, by its closest
+ * atom pair, in the order its first contact was found.
+ *
+ * @code
+ * auto ligand = OESelection::Parse("ligand");
+ * auto pocket = OESelection::Parse("protein");
+ * ContactList contacts = FindContacts(mol, ligand, pocket, 4.0f, ContactLevel::RESIDUE);
+ * for (size_t k = 0; k < contacts.Size(); ++k) {
+ *     // contacts.First()[k] touches contacts.Second()[k]
+ * }
+ * @endcode
+ *
+ * @param mol The molecule to search.
+ * @param first Selection supplying First() atoms.
+ * @param second Selection supplying Second() atoms.
+ * @param cutoff Maximum distance in Angstroms (exclusive).
+ * @param level Report every atom pair or one pair per residue pair.
+ * @return Contacts as parallel arrays.
+ * @throws SelectionError if evaluation fails or the cutoff is negative or not finite.
+ */
+[[nodiscard]] ContactList FindContacts(OEChem::OEMolBase& mol, const OESelection& first,
+                                       const OESelection& second, float cutoff,
+                                       ContactLevel level = ContactLevel::ATOM);
+
+}  // namespace OESel
+
+#endif  // OESELECT_CONTACTS_H
@@ -9,10 +9,15 @@
 #ifndef OESELECT_CONTEXT_H
 #define OESELECT_CONTEXT_H
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
 #include <memory>
 #include <string>
-#include <unordered_set>
-#include <vector>
+
+#include "oeselect/SelectionResult.h"
+#include "oeselect/UnitCell.h"
 
 namespace OEChem {
 class OEMolBase;
@@ -21,7 +26,12 @@ class OEAtomBase;
 
 namespace OESel {
 
+class AtomTable;
+class Bitset;
+class BondGraph;
+class EvaluationProfile;
 class OESelection;
+class Predicate;
 class SpatialIndex;
 
 /**
@@ -30,10 +40,22 @@ class SpatialIndex;
  * Context maintains shared state during predicate evaluation, including:
  * - Reference to the molecule being evaluated
  * - Spatial index for distance queries (lazily initialized)
- * - Caches for residue, chain, and distance-based selections
+ * - Columnar atom property snapshot (lazily initialized)
+ * - Bond adjacency (lazily initialized)
+ * - Result caches for residue, chain, and distance-based selections
+ *
+ * Result caches are indexed by the slot OESelection assigns to each
+ * predicate, so equivalent predicates share cached results.
  *
- * Caches use string keys derived from predicate canonical forms to ensure
- * equivalent predicates share cached results.
+ * For very large systems, SetNumThreads() spreads the work inside each
+ * bulk step over worker threads. Tree traversal and every cache lookup
+ * stay on the calling thread, so cache hits take no locks; workers only
+ * fill disjoint chunks of a node's output from tables built beforehand.
+ *
+ * For trajectories, UpdateCoordinates() moves the context to a new frame:
+ * the spatial index is refitted and only coordinate-dependent results are
+ * dropped, while topology-derived state such as the atom table and
+ * residue or chain expansions of non-distance selections is kept.
  *
  * @note Context is non-copyable as it holds mutable caches.
  */
@@ -54,6 +76,18 @@ public:
     Context(const Context&) = delete;
     Context& operator=(const Context&) = delete;
 
+    /**
+     * @brief Rebind the context to another molecule.
+     *
+     * Drops every per-molecule cache (spatial index, atom table, bond
+     * graph, result masks) while keeping the selection, the per-slot
+     * tables, the unit cell, and the thread setting, so one context can be
+     * reused across a stream of molecules.
+     *
+     * @param mol The molecule to evaluate against next.
+     */
+    void Reset(OEChem::OEMolBase& mol);
+
     /// @brief Access the molecule (mutable).
     OEChem::OEMolBase& Mol();
 
@@ -67,90 +101,393 @@ public:
      * @brief Get or create the spatial index.
      *
      * The spatial index is created lazily on first access. It provides
-     * efficient radius queries for distance-based predicates.
+     * efficient radius queries for distance-based predicates. Its backend
+     * is chosen automatically from the atom count and the largest radius
+     * used by the selection's around/expand/beyond predicates.
      *
      * @return Reference to the spatial index.
      */
     SpatialIndex& GetSpatialIndex();
 
-    /// @name Residue Cache
-    /// Cache for byres predicate results.
-    /// @{
+    /**
+     * @brief Get the bitset of atoms present in the molecule.
+     *
+     * The mask is sized to the molecule's GetMaxAtomIdx() and built lazily
+     * on first access. Bulk predicates use it to complement selections
+     * without setting bits for deleted atom indices.
+     *
+     * @return Bitset with one bit set per existing atom.
+     */
+    const Bitset& GetAtomMask();
 
     /**
-     * @brief Get cached atom indices for a residue-based selection.
-     * @param key Cache key (typically predicate canonical form).
-     * @return Set of atom indices in matching residues.
+     * @brief Get or create the columnar atom property snapshot.
+     *
+     * The table is built lazily in one pass over the molecule on first
+     * access. Bulk leaf predicates scan its columns instead of calling
+     * OEChem accessors per atom.
+     *
+     * @return Reference to the atom table.
      */
-    const std::unordered_set<unsigned int>& GetResidueAtoms(const std::string& key);
+    const AtomTable& GetAtomTable();
 
     /**
-     * @brief Store atom indices for a residue-based selection.
-     * @param key Cache key.
-     * @param atoms Set of atom indices.
+     * @brief Get or create the bond adjacency.
+     *
+     * The graph is built lazily in one pass over the molecule's bonds on
+     * first access. Bond-walking predicates (polarh, apolarh, organic,
+     * bound_to, extend) read neighbours from it instead of iterating
+     * OEChem bond lists per atom.
+     *
+     * @return Reference to the bond graph.
+     */
+    const BondGraph& GetBondGraph();
+
+    /**
+     * @brief Install prebuilt atom and bond snapshots for the current molecule.
+     *
+     * Used by TableCache::Load() to skip the passes over the molecule. A null
+     * pointer leaves that snapshot to be built lazily. Cached predicate
+     * results are discarded. Reset() drops both snapshots.
+     *
+     * @param table Atom table built from the current molecule, or null.
+     * @param bonds Bond graph built from the current molecule, or null.
+     * @throws SelectionError if a snapshot does not cover GetMaxAtomIdx() atoms.
      */
-    void SetResidueAtoms(const std::string& key, std::unordered_set<unsigned int> atoms);
+    void SetTables(std::unique_ptr<AtomTable> table, std::unique_ptr<BondGraph> bonds);
 
     /**
-     * @brief Check if residue cache contains a key.
-     * @param key Cache key to check.
-     * @return true if the cache contains this key.
+     * @brief Set the periodic box for distance predicates.
+     *
+     * With a periodic cell, around, expand, and beyond measure the distance
+     * to the nearest periodic image of each atom. Changing the cell drops
+     * the spatial index and the cached results of coordinate-dependent
+     * predicates; setting the current cell again does nothing.
+     *
+     * @param cell Unit cell, or a default-constructed UnitCell for none.
      */
-    [[nodiscard]] bool HasResidueCache(const std::string& key) const;
+    void SetUnitCell(const UnitCell& cell);
+
+    /// @brief Periodic box used by distance predicates.
+    [[nodiscard]] const UnitCell& GetUnitCell() const;
+
+    /**
+     * @brief Bind a stored result to a name for `%name` in selections.
+     *
+     * Replaces an existing binding of the same name and discards cached
+     * predicate results. Bindings are kept across Reset(); a result whose
+     * Size() no longer matches the molecule is rejected when used.
+     *
+     * @param name Set name: a letter or underscore, then letters, digits, or underscores.
+     * @param result Stored result sized to the molecule's GetMaxAtomIdx().
+     * @throws SelectionError if @p name is not a valid set name.
+     */
+    void SetNamedSet(const std::string& name, OESelectionResult result);
+
+    /**
+     * @brief Remove a named set binding.
+     * @param name Set name.
+     * @return true if the name was bound.
+     */
+    bool RemoveNamedSet(const std::string& name);
+
+    /// @brief Remove every named set binding.
+    void ClearNamedSets();
+
+    /**
+     * @brief Result bound to a name.
+     * @param name Set name.
+     * @return The bound result.
+     * @throws SelectionError if @p name is unbound or its result does not
+     *         cover GetMaxAtomIdx() atoms.
+     */
+    [[nodiscard]] const OESelectionResult& GetNamedSet(const std::string& name) const;
+
+    /// @brief Every named set binding, ordered by name.
+    [[nodiscard]] const std::map<std::string, OESelectionResult>& GetNamedSets() const;
+
+    /**
+     * @brief Move the molecule to new coordinates for the same atoms.
+     *
+     * Writes @p xyz to the molecule, refits the spatial index if it has
+     * been built, and invalidates cached results of every predicate whose
+     * subtree contains around, expand, or beyond. Other caches are kept.
+     *
+     * @param xyz Coordinates indexed by atom index: 3 * GetMaxAtomIdx()
+     *        floats in the layout of OEMolBase::GetCoords(float*).
+     */
+    void UpdateCoordinates(const float* xyz);
+
+    /**
+     * @brief Resynchronize with coordinates already changed on the molecule.
+     *
+     * Same as UpdateCoordinates(const float*) for callers that have
+     * modified the molecule directly, e.g. by activating another conformer.
+     */
+    void UpdateCoordinates();
+
+    /**
+     * @brief Reuse skin-padded neighbor lists for distance predicates across frames.
+     *
+     * With a skin, around, expand, and beyond record every reference-target
+     * pair closer than radius + @p skin when they are first evaluated. On
+     * later frames only those pairs are re-measured, and the spatial index
+     * is neither refitted nor queried, until some atom has moved more than
+     * skin / 2 since the list was built or the reference atoms change; the
+     * list is then rebuilt. Results are identical to evaluating without a
+     * skin. The setting is kept across Reset().
+     *
+     * A skin of 0.5 to 2 Angstroms suits MD trajectories saved every few
+     * picoseconds; a larger skin holds the list longer but re-measures more
+     * pairs per frame.
+     *
+     * @param skin Padding in Angstroms; 0 (the default) queries the spatial
+     *        index on every evaluation.
+     * @throws SelectionError if @p skin is negative or not finite.
+     */
+    void SetVerletSkin(float skin);
+
+    /// @brief Neighbor list padding in Angstroms; 0 when disabled.
+    [[nodiscard]] float GetVerletSkin() const;
+
+    /// @brief Number of neighbor lists built since construction.
+    [[nodiscard]] std::uint64_t NumNeighborListBuilds() const;
+
+    /**
+     * @brief Mark every atom within radius of a reference atom.
+     *
+     * Called by distance predicates. Equivalent to
+     * GetSpatialIndex().MarkWithinRadius(), answered from @p owner's
+     * neighbor list while a Verlet skin is set (see SetVerletSkin()).
+     *
+     * @param owner Distance predicate owning the neighbor list.
+     * @param refs Reference atoms.
+     * @param radius Maximum distance in Angstroms (exclusive).
+     * @param out Bitset receiving matching atom indices; existing bits are kept.
+     */
+    void MarkWithinRadius(const Predicate& owner, const Bitset& refs, float radius, Bitset& out);
+
+    /**
+     * @brief Mark the atoms of a domain within radius of a reference atom.
+     *
+     * Like the overload above, but only atoms in @p domain can be marked.
+     * When either side is at most half the molecule, a cell list is built
+     * over just the smaller of @p refs and @p domain and the other side's
+     * atoms are binned against it, so indexing cost follows the atoms the
+     * query can touch rather than the molecule. Up to eight such indexes
+     * are kept, keyed by their atoms, and refitted after
+     * UpdateCoordinates(). With a Verlet skin, several threads, or two
+     * large sides the full index answers instead.
+     *
+     * @param owner Distance predicate owning the neighbor list.
+     * @param refs Reference atoms.
+     * @param radius Maximum distance in Angstroms (exclusive).
+     * @param domain Atoms that may be marked.
+     * @param out Bitset receiving matching atom indices; existing bits are kept.
+     */
+    void MarkWithinRadius(const Predicate& owner, const Bitset& refs, float radius, const Bitset& domain,
+                          Bitset& out);
+
+    /// @brief Number of domain-restricted spatial indexes built since construction.
+    [[nodiscard]] std::uint64_t NumDomainIndexBuilds() const;
+
+    /**
+     * @brief Check whether a predicate's result depends on atom coordinates.
+     *
+     * @param pred Predicate from the selection tree.
+     * @return true if the predicate's subtree contains around, expand, or
+     *         beyond, or if the predicate has no cache slot.
+     */
+    [[nodiscard]] bool UsesCoordinates(const Predicate& pred) const;
+
+    /**
+     * @brief Keep results of coordinate-independent subtrees across frames.
+     *
+     * When enabled, EvaluateSubtree() caches the mask of every predicate
+     * that does not depend on coordinates, so evaluating the same
+     * selection after UpdateCoordinates() recomputes only the distance
+     * parts. Disabled by default, since a single evaluation gains nothing
+     * from the extra masks.
+     *
+     * @param share true to cache coordinate-independent results.
+     */
+    void SetShareStaticResults(bool share);
+
+    /**
+     * @brief Evaluate a subtree in bulk, reusing shared static results.
+     *
+     * Equivalent to pred.EvaluateAll(*this, out) unless static result
+     * sharing is enabled (see SetShareStaticResults()). Predicates call
+     * this for their children.
+     *
+     * @param pred Predicate from the selection tree.
+     * @param out Cleared bitset sized to the molecule's GetMaxAtomIdx().
+     */
+    void EvaluateSubtree(const Predicate& pred, Bitset& out);
+
+    /**
+     * @brief Evaluate a subtree whose result is only needed inside a domain.
+     *
+     * Called by AND for its later conjuncts with the atoms still matching.
+     * Distance predicates then index and search only those atoms (see
+     * Predicate::EvaluateWithin()); every other node evaluates as in
+     * EvaluateSubtree().
+     *
+     * @param pred Predicate from the selection tree.
+     * @param domain Atoms whose membership must be exact.
+     * @param out Cleared bitset sized to the molecule's GetMaxAtomIdx();
+     *        bits outside @p domain are unspecified on return.
+     */
+    void EvaluateSubtreeWithin(const Predicate& pred, const Bitset& domain, Bitset& out);
+
+    /**
+     * @brief Evaluate the whole bound selection in bulk.
+     *
+     * Runs the selection's compiled program (OESelection::GetProgram()).
+     * While profiling or sharing static results the tree is walked through
+     * EvaluateSubtree() instead, so that every node is recorded or cached.
+     *
+     * @param out Cleared bitset sized to the molecule's GetMaxAtomIdx().
+     */
+    void EvaluateSelection(Bitset& out);
+
+    /**
+     * @brief Borrow scratch bitsets owned by the context.
+     *
+     * Storage is kept across calls and molecules and reallocated only when
+     * the requested size changes. Used as the register file of compiled
+     * selection programs.
+     *
+     * @param count Number of bitsets needed.
+     * @param size Bits per bitset.
+     * @return Pointer to @p count bitsets with unspecified contents, valid
+     *         until the next call.
+     */
+    Bitset* GetScratchMasks(size_t count, size_t size);
+
+    /// @name Parallel Evaluation
+    /// Opt-in data parallelism within one molecule for systems of millions
+    /// of atoms: column scans, residue and chain expansion, spatial index
+    /// binning, and distance queries are split over worker threads.
+    /// @{
+
+    /// @brief Atom indices per parallel chunk: 8 bitset words, one cache line.
+    static constexpr size_t kChunkAtoms = 512;
+
+    /// @brief Smallest atom index range split across threads; smaller ones run inline.
+    static constexpr size_t kParallelMinAtoms = 65536;
+
+    /**
+     * @brief Set the number of threads used to evaluate one molecule.
+     *
+     * Workers are started on the first bulk step large enough to use them
+     * and kept until the thread count changes. Results are identical for
+     * every thread count. The setting is kept across Reset().
+     *
+     * @param num_threads Threads to use; 1 (the default) evaluates on the
+     *        calling thread, and 0 uses the hardware concurrency.
+     */
+    void SetNumThreads(unsigned int num_threads);
+
+    /// @brief Number of threads used to evaluate one molecule.
+    [[nodiscard]] unsigned int GetNumThreads() const;
+
+    /**
+     * @brief Run a loop body over chunks of an atom index range.
+     *
+     * Ranges of at least kParallelMinAtoms indices are split into chunks
+     * whose bounds are multiples of kChunkAtoms and run on the worker
+     * threads; otherwise @p body is called once with the whole range on
+     * the calling thread. Because chunks never share a bitset word, a body
+     * may set bits of its own [begin, end) in a shared Bitset without
+     * synchronization. Bodies must not call Context methods; fetch tables
+     * and indexes before the loop.
+     *
+     * @param count Number of atom indices to cover, from 0.
+     * @param body Called with a chunk [begin, end) and the id of the worker
+     *        running it, below GetNumThreads().
+     */
+    void ForEachChunk(size_t count, const std::function<void(size_t begin, size_t end, unsigned int worker)>& body);
 
     /// @}
 
-    /// @name Chain Cache
-    /// Cache for bychain predicate results.
+    /// @name Profiling
+    /// Opt-in per-node statistics for EvaluateSubtree() calls. When
+    /// disabled, the only cost is one branch per subtree evaluation.
     /// @{
 
     /**
-     * @brief Get cached atom indices for a chain-based selection.
-     * @param key Cache key.
-     * @return Set of atom indices in matching chains.
+     * @brief Enable or disable profiling.
+     *
+     * Enabling starts from empty statistics. Statistics accumulate across
+     * Reset(), so one context can profile a stream of molecules.
+     *
+     * @param enabled true to record statistics.
      */
-    const std::unordered_set<unsigned int>& GetChainAtoms(const std::string& key);
+    void SetProfiling(bool enabled);
+
+    /// @brief Whether profiling is enabled.
+    [[nodiscard]] bool IsProfiling() const;
 
     /**
-     * @brief Store atom indices for a chain-based selection.
-     * @param key Cache key.
-     * @param atoms Set of atom indices.
+     * @brief Statistics recorded so far, annotated onto the evaluated tree.
+     * @return Profile of OESelection::Root(); empty if profiling is disabled.
      */
-    void SetChainAtoms(const std::string& key, std::unordered_set<unsigned int> atoms);
+    [[nodiscard]] EvaluationProfile GetProfile() const;
 
     /**
-     * @brief Check if chain cache contains a key.
-     * @param key Cache key to check.
-     * @return true if the cache contains this key.
+     * @brief Record one spatial index query for the node being evaluated.
+     *
+     * Called by distance predicates; does nothing unless profiling.
      */
-    [[nodiscard]] bool HasChainCache(const std::string& key) const;
+    void CountSpatialQuery();
 
     /// @}
 
-    /// @name Distance Cache
-    /// Cache for around/beyond predicate results.
+    /// @name Result Cache
+    /// Cache for whole-molecule masks computed by byres, bychain, and
+    /// distance predicates, indexed by the predicate's cache slot.
     /// @{
 
     /**
-     * @brief Get cached atom mask for distance-based selection.
-     * @param key Cache key.
-     * @return Boolean mask indexed by atom index.
+     * @brief Get the cached mask for a predicate.
+     *
+     * Lookups for numbered predicates index a flat per-slot table, so a hit
+     * costs O(1) without hashing or allocation.
+     *
+     * @param pred Predicate owning the cache entry.
+     * @return Cached mask, or nullptr if none has been stored yet.
      */
-    const std::vector<bool>& GetAroundCache(const std::string& key);
+    [[nodiscard]] const Bitset* GetCachedMask(const Predicate& pred) const;
 
     /**
-     * @brief Store atom mask for distance-based selection.
-     * @param key Cache key.
-     * @param cache Boolean mask.
+     * @brief Store the mask computed by a predicate.
+     * @param pred Predicate owning the cache entry.
+     * @param mask Mask sized to the molecule's GetMaxAtomIdx().
+     * @return Reference to the stored mask.
+     */
+    const Bitset& SetCachedMask(const Predicate& pred, Bitset mask);
+
+    /**
+     * @brief Get the cached final result of a predicate.
+     *
+     * A second entry per slot, for predicates whose own result differs
+     * from the mask they share with other node types under one cache key
+     * (around keeps the shared within-radius mask in the first entry and
+     * that mask minus its reference atoms here). It is cleared together
+     * with the shared mask.
+     *
+     * @param pred Predicate owning the cache entry.
+     * @return Cached result, or nullptr if none has been stored or @p pred is unnumbered.
      */
-    void SetAroundCache(const std::string& key, std::vector<bool> cache);
+    [[nodiscard]] const Bitset* GetCachedResult(const Predicate& pred) const;
 
     /**
-     * @brief Check if distance cache contains a key.
-     * @param key Cache key to check.
-     * @return true if the cache contains this key.
+     * @brief Store the final result of a predicate; ignored for unnumbered predicates.
+     * @param pred Predicate owning the cache entry.
+     * @param mask Mask sized to the molecule's GetMaxAtomIdx().
      */
-    [[nodiscard]] bool HasAroundCache(const std::string& key) const;
+    void SetCachedResult(const Predicate& pred, Bitset mask);
 
     /// @}
 
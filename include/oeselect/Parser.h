@@ -42,10 +42,14 @@
  * - `<selection> around <radius>` - Atoms within radius, excluding reference
  * - `<selection> expand <radius>` - Atoms within radius, including reference
  * - `<selection> beyond <radius>` - Atoms outside radius of selection
+ * - `nearest <k> <selection> to <reference>` - The k selection atoms closest to reference
+ * - `nearest <k> byres <selection> to <reference>` - The k closest residues, whole
  *
  * @subsection expansion Expansion Operators
  * - `byres <selection>` - Expand to complete residues
  * - `bychain <selection>` - Expand to complete chains
+ * - `bound_to <selection>` - Atoms bonded to selection
+ * - `<selection> extend <bonds>` - Selection plus atoms within that many bonds
  *
  * @subsection logical Logical Operators
  * - `and` - Intersection (higher precedence than or)
@@ -57,6 +61,10 @@
  * - `all` - All atoms
  * - `none` - No atoms
  *
+ * @subsection namedset Named Sets
+ * - `%name` - Atoms of a stored OESelectionResult bound under that name
+ *   (see Context::SetNamedSet() and OESelect::SetNamedSet())
+ *
  * @subsection macro Hierarchical Macro Syntax
  * - `//chain/resi/name` - Hierarchical selection (empty components are wildcards)
  *
@@ -68,6 +76,7 @@
 #define OESELECT_PARSER_H
 
 #include <string>
+#include <vector>
 
 #include "oeselect/Predicate.h"
 
@@ -90,6 +99,36 @@ namespace OESel {
  */
 Predicate::Ptr parse_selection(const std::string& sele);
 
+/**
+ * @brief Rewrite a parsed predicate tree into an equivalent, cheaper one.
+ *
+ * Applied by OESelection after parsing. The rewrite:
+ * - shares identical subtrees as a single node (hash-consing by canonical form)
+ * - flattens nested AND/OR into their parent
+ * - folds `not not X` to X, `not all`/`not none` to constants
+ * - drops `all` from AND and `none` from OR/XOR, and collapses AND with
+ *   `none` or OR with `all` to the constant
+ * - removes duplicate AND/OR children
+ * - orders AND/OR children by estimated cost, cheapest first
+ *
+ * The result matches the same atoms as the input.
+ *
+ * @param root Root of the parsed tree (not modified).
+ * @return Root of the optimized tree.
+ */
+Predicate::Ptr optimize_selection(const Predicate::Ptr& root);
+
+/**
+ * @brief Optimize several parsed trees together.
+ *
+ * Same rewrite as optimize_selection(), but identical subtrees are shared
+ * across all of @p roots, not only within one tree.
+ *
+ * @param roots Roots of the parsed trees (not modified).
+ * @return Optimized roots, in the order of @p roots.
+ */
+std::vector<Predicate::Ptr> optimize_selections(const std::vector<Predicate::Ptr>& roots);
+
 }  // namespace OESel
 
 #endif  // OESELECT_PARSER_H
@@ -19,6 +19,7 @@ class OEAtomBase;
 
 namespace OESel {
 
+class Bitset;
 class Context;
 
 /**
@@ -80,7 +81,15 @@ enum class PredicateType {
 
     // Constants
     ALL_MATCH,  ///< Always matches (used for 'all' keyword and empty selections)
-    NO_MATCH    ///< Never matches (used for 'none' keyword)
+    NO_MATCH,   ///< Never matches (used for 'none' keyword)
+
+    // Appended types; new values go last so existing ones keep their numbers
+    LIPID,      ///< Membrane lipids and sterols
+    GLYCAN,     ///< Carbohydrate residues
+    BOUND_TO,   ///< Atoms bonded to selection
+    EXTEND,     ///< Selection grown along bonds
+    NAMED_SET,  ///< Members of an OESelectionResult bound by name
+    NEAREST     ///< Candidate atoms or residues nearest to selection
 };
 
 /**
@@ -97,6 +106,9 @@ public:
     /// @brief Shared pointer type for predicate ownership
     using Ptr = std::shared_ptr<Predicate>;
 
+    /// @brief Slot value of a predicate that has not been numbered
+    static constexpr unsigned int kNoSlot = ~0U;
+
     virtual ~Predicate() = default;
 
     /**
@@ -110,6 +122,34 @@ public:
      */
     virtual bool Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const = 0;
 
+    /**
+     * @brief Evaluate this predicate for every atom in the context molecule.
+     *
+     * Sets the bit of each matching atom in @p out, which must be sized to
+     * the molecule's GetMaxAtomIdx() and cleared on entry. The default
+     * implementation calls Evaluate() once per atom; composite and cached
+     * predicates override it to operate on whole bitsets at once.
+     *
+     * @param ctx Evaluation context containing molecule and caches.
+     * @param out Bitset receiving the matching atoms.
+     */
+    virtual void EvaluateAll(Context& ctx, Bitset& out) const;
+
+    /**
+     * @brief Evaluate this predicate for the atoms of a domain.
+     *
+     * Like EvaluateAll(), but only membership of atoms in @p domain has to
+     * be exact; bits outside it are unspecified. AND passes its later
+     * conjuncts the atoms still matching, so distance predicates can
+     * search just those atoms. The default implementation calls
+     * EvaluateAll().
+     *
+     * @param ctx Evaluation context containing molecule and caches.
+     * @param domain Atoms whose membership must be exact.
+     * @param out Bitset receiving the matching atoms.
+     */
+    virtual void EvaluateWithin(Context& ctx, const Bitset& domain, Bitset& out) const;
+
     /**
      * @brief Get canonical string representation of this predicate.
      *
@@ -135,6 +175,40 @@ public:
      * @return Vector of child predicate pointers.
      */
     [[nodiscard]] virtual std::vector<Ptr> Children() const { return {}; }
+
+    /**
+     * @brief Get the key identifying this predicate's cached result.
+     *
+     * Predicates with equal keys produce interchangeable cache entries and
+     * are assigned the same cache slot. The default is the canonical form;
+     * distance predicates share one key per reference and radius.
+     *
+     * @return Cache key string.
+     */
+    [[nodiscard]] virtual std::string CacheKey() const { return ToCanonical(); }
+
+    /**
+     * @brief Get the cache slot assigned when the owning selection was built.
+     *
+     * Slots are dense integers in [0, OESelection::NumSlots()); predicates
+     * with equal CacheKey() share a slot. Context indexes its result caches
+     * by slot.
+     *
+     * @return Slot number, or kNoSlot if the predicate was never numbered.
+     */
+    [[nodiscard]] unsigned int Slot() const { return slot_; }
+
+    /**
+     * @brief Assign the cache slot.
+     *
+     * Called by OESelection while numbering a freshly parsed tree.
+     *
+     * @param slot Slot number.
+     */
+    void SetSlot(const unsigned int slot) { slot_ = slot; }
+
+private:
+    unsigned int slot_ = kNoSlot;
 };
 
 }  // namespace OESel
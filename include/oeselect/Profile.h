@@ -0,0 +1,88 @@
+/**
+ * @file Profile.h
+ * @brief Per-node evaluation statistics for selections ("explain analyze").
+ *
+ * When profiling is enabled on a Context (or an OESelect), every bulk
+ * evaluation of a predicate node records its call count, wall time,
+ * result-cache hits and misses, selectivity, and spatial index queries.
+ * The result is reported as an annotated copy of the evaluated tree.
+ */
+
+#ifndef OESELECT_PROFILE_H
+#define OESELECT_PROFILE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "oeselect/Predicate.h"
+
+namespace OESel {
+
+/**
+ * @brief Statistics recorded for one node of an evaluated selection tree.
+ *
+ * Counters accumulate over every evaluation made while profiling was
+ * enabled, including evaluations on other molecules after Context::Reset().
+ */
+struct NodeProfile {
+    std::string label;                   ///< The node's ToCanonical() form
+    PredicateType type = PredicateType::ALL_MATCH;  ///< The node's predicate type
+    unsigned int depth = 0;              ///< Depth in the tree (root is 0)
+    std::uint64_t evaluations = 0;       ///< Bulk evaluations of the node
+    double seconds = 0.0;                ///< Wall time including children
+    double self_seconds = 0.0;           ///< Wall time excluding children
+    std::uint64_t cache_hits = 0;        ///< Result-cache lookups that found a mask
+    std::uint64_t cache_misses = 0;      ///< Result-cache lookups that found nothing
+    std::uint64_t atoms_evaluated = 0;   ///< Atoms in the molecule, summed over evaluations
+    std::uint64_t atoms_matched = 0;     ///< Matching atoms, summed over evaluations
+    std::uint64_t spatial_queries = 0;   ///< Batch spatial index queries issued by the node
+
+    /// @brief Fraction of evaluated atoms that matched (0 if never evaluated).
+    [[nodiscard]] double Selectivity() const {
+        return atoms_evaluated == 0 ? 0.0 : static_cast<double>(atoms_matched) / static_cast<double>(atoms_evaluated);
+    }
+};
+
+/**
+ * @brief Annotated evaluation tree produced by a profiling run.
+ *
+ * Nodes are listed in pre-order over the optimized tree that was actually
+ * evaluated (OESelection::Root()). Equivalent subexpressions are shared
+ * in that tree, so a shared node appears at each of its positions with
+ * the same combined statistics.
+ *
+ * @code
+ * OESelect sel(mol, "protein and (ligand around 5)");
+ * sel.SetProfiling(true);
+ * sel.GetMask();
+ * std::cout << sel.GetProfile().ToString();
+ * @endcode
+ */
+class EvaluationProfile {
+public:
+    /// @brief Empty profile.
+    EvaluationProfile() = default;
+
+    /**
+     * @brief Construct from pre-ordered node statistics.
+     * @param nodes Nodes in pre-order with depths set.
+     */
+    explicit EvaluationProfile(std::vector<NodeProfile> nodes) : nodes_(std::move(nodes)) {}
+
+    /// @brief Node statistics in pre-order.
+    [[nodiscard]] const std::vector<NodeProfile>& Nodes() const { return nodes_; }
+
+    /**
+     * @brief Render the tree with one indented line of statistics per node.
+     * @return Multi-line report, empty if there are no nodes.
+     */
+    [[nodiscard]] std::string ToString() const;
+
+private:
+    std::vector<NodeProfile> nodes_;
+};
+
+}  // namespace OESel
+
+#endif  // OESELECT_PROFILE_H
@@ -0,0 +1,116 @@
+/**
+ * @file Program.h
+ * @brief Flat, non-recursive evaluator compiled from a selection tree.
+ *
+ * An OESelection compiles its optimized predicate tree once, when it is
+ * built, into a contiguous array of bitset instructions. Logical nodes
+ * become inline word-wide operations on a small register file, with
+ * conditional jumps that skip the rest of an AND once nothing is left or
+ * the rest of an OR once every atom matches. Every other node (name and
+ * property tests, components, distance and expansion predicates) becomes
+ * a single mask-producing load that runs the predicate's bulk kernel.
+ * Distance conjuncts of an AND load only within the atoms still matching,
+ * so their spatial search covers just those atoms.
+ */
+
+#ifndef OESELECT_PROGRAM_H
+#define OESELECT_PROGRAM_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace OESel {
+
+class Bitset;
+class Context;
+class Predicate;
+
+/**
+ * @brief Operation performed by one program instruction.
+ *
+ * Registers hold one bit per atom index; register 0 is the output mask.
+ */
+enum class OpCode : std::uint8_t {
+    LOAD,          ///< dst = bulk result of a leaf predicate
+    LOAD_WITHIN,   ///< dst = result of a leaf predicate, exact only for atoms in src
+    LOAD_ALL,      ///< dst = every atom of the molecule
+    CLEAR,         ///< dst = no atoms
+    AND,           ///< dst &= src
+    OR,            ///< dst |= src
+    AND_NOT,       ///< dst &= ~src
+    NOT,           ///< dst = every atom not in dst
+    XOR_ACCUM,     ///< aux |= dst & src, then dst |= src
+    JUMP_IF_NONE,  ///< Continue at target if dst is empty
+    JUMP_IF_ALL    ///< Continue at target if dst holds every atom
+};
+
+/**
+ * @brief One instruction of a compiled selection program.
+ */
+struct Instruction {
+    OpCode op = OpCode::CLEAR;
+    std::uint16_t dst = 0;              ///< Destination (or tested) register
+    std::uint16_t src = 0;              ///< Source register
+    std::uint16_t aux = 0;              ///< Second destination (XOR_ACCUM)
+    std::uint32_t target = 0;           ///< Jump destination (instruction index)
+    const Predicate* pred = nullptr;    ///< Leaf evaluated by LOAD and LOAD_WITHIN
+};
+
+/**
+ * @brief Compiled, contiguous form of a predicate tree for bulk evaluation.
+ *
+ * The program holds raw pointers into the tree it was compiled from, so
+ * the tree must outlive it; OESelection keeps both together. Running a
+ * program produces exactly the mask Predicate::EvaluateAll() would.
+ *
+ * @code
+ * auto sele = OESelection::Parse("protein and not (resn HOH or name H*)");
+ * std::cout << sele.GetProgram().ToString();
+ * @endcode
+ */
+class SelectionProgram {
+public:
+    /// @brief Empty program; Run() leaves the output unchanged.
+    SelectionProgram() = default;
+
+    /**
+     * @brief Compile a predicate tree.
+     * @param root Root of the (optimized) tree to compile.
+     * @return Program evaluating @p root.
+     */
+    [[nodiscard]] static SelectionProgram Compile(const Predicate& root);
+
+    /**
+     * @brief Evaluate the program for every atom in the context molecule.
+     *
+     * Leaves are evaluated through Context::EvaluateSubtree() (or
+     * Context::EvaluateSubtreeWithin() for LOAD_WITHIN), so result caches
+     * are honored. Scratch registers come from the context and are
+     * reused across calls.
+     *
+     * @param ctx Evaluation context bound to the molecule.
+     * @param out Bitset sized to the molecule's GetMaxAtomIdx() and cleared on entry.
+     */
+    void Run(Context& ctx, Bitset& out) const;
+
+    /// @brief Instructions in execution order.
+    [[nodiscard]] const std::vector<Instruction>& Instructions() const { return code_; }
+
+    /// @brief Number of registers used, including the output register.
+    [[nodiscard]] unsigned int NumRegisters() const { return num_registers_; }
+
+    /**
+     * @brief Disassemble the program, one instruction per line.
+     * @return Listing such as "0: load r0, protein".
+     */
+    [[nodiscard]] std::string ToString() const;
+
+private:
+    std::vector<Instruction> code_;
+    unsigned int num_registers_ = 1;
+};
+
+}  // namespace OESel
+
+#endif  // OESELECT_PROGRAM_H
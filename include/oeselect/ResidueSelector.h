@@ -10,11 +10,15 @@
 #ifndef OESELECT_RESIDUESELECTOR_H
 #define OESELECT_RESIDUESELECTOR_H
 
+#include <cstdint>
 #include <set>
 #include <string>
+#include <vector>
 
 #include <oechem.h>
 
+#include "oeselect/Bitset.h"
+
 namespace OESel {
 
 class OESelection;
@@ -91,6 +95,10 @@ struct Selector {
  * Accepts a selector string (comma/semicolon/newline-separated) or a set
  * of Selector objects. Compatible with OpenEye's predicate interface.
  *
+ * Selectors are encoded once at construction into sorted 64-bit keys
+ * (residue number, interned name, chain, insertion code), so testing an
+ * atom is a binary search over integers with no string allocation.
+ *
  * @code
  * OEResidueSelector sel("ALA:123: :A,GLY:124: :A");
  * for (auto atom = mol.GetAtoms(sel); atom; ++atom) {
@@ -125,6 +133,17 @@ public:
      */
     bool operator()(const OEChem::OEAtomBase& atom) const override;
 
+    /**
+     * @brief Evaluate the selector against every atom of a molecule.
+     *
+     * Uses the molecule's residue columns, so each residue is matched once
+     * rather than once per atom.
+     *
+     * @param mol The molecule to evaluate.
+     * @return Bitset sized to mol.GetMaxAtomIdx() with matching atoms set.
+     */
+    [[nodiscard]] Bitset EvaluateMask(const OEChem::OEMolBase& mol) const;
+
     /**
      * @brief Create a copy for OpenEye compatibility.
      * @return New instance (caller takes ownership).
@@ -133,7 +152,10 @@ public:
     CreateCopy() const override;
 
 private:
-    std::set<Selector> selectors_;
+    void Encode(const std::set<Selector>& selectors);
+
+    std::vector<std::string> names_;   ///< Distinct selector residue names, sorted
+    std::vector<std::uint64_t> keys_;  ///< Sorted encoded selector keys
 };
 
 // ============================================================================
@@ -10,13 +10,33 @@
 #ifndef OESELECT_SELECTION_H
 #define OESELECT_SELECTION_H
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <vector>
 
+#include "oeselect/Bitset.h"
 #include "oeselect/Predicate.h"
+#include "oeselect/Program.h"
+
+namespace OEChem {
+class OEMolBase;
+class OEMCMolBase;
+}
 
 namespace OESel {
 
+/**
+ * @brief Counters describing the OESelection::Parse() cache.
+ */
+struct ParseCacheStats {
+    std::uint64_t hits = 0;    ///< Parse() calls served from the cache
+    std::uint64_t misses = 0;  ///< Parse() calls that ran the parser
+    size_t size = 0;           ///< Selections currently cached
+    size_t capacity = 0;       ///< Maximum number of cached selections (0 = disabled)
+};
+
 /**
  * @brief Immutable, thread-safe parsed selection.
  *
@@ -42,6 +62,11 @@ public:
     /**
      * @brief Parse a selection string into an OESelection.
      *
+     * Results are kept in a bounded, thread-safe LRU cache keyed by the
+     * exact selection string, so repeated calls with the same string share
+     * one immutable predicate tree instead of re-running the parser.
+     * Strings that fail to parse are not cached.
+     *
      * @param sele PyMOL-style selection string.
      * @return Parsed selection object.
      * @throws SelectionError if parsing fails.
@@ -50,6 +75,23 @@ public:
      */
     static OESelection Parse(const std::string& sele);
 
+    /**
+     * @brief Set the maximum number of selections kept by the Parse() cache.
+     *
+     * Shrinking the cache evicts least recently used entries. The default
+     * capacity is 1024. The cache of merged selection sets (see
+     * SelectionSet) is resized with it.
+     *
+     * @param capacity Maximum number of cached selections; 0 disables caching.
+     */
+    static void SetParseCacheCapacity(size_t capacity);
+
+    /// @brief Remove every cached selection and merged set, and reset the hit and miss counters.
+    static void ClearParseCache();
+
+    /// @brief Current Parse() cache counters.
+    [[nodiscard]] static ParseCacheStats GetParseCacheStats();
+
     /**
      * @brief Default constructor creates an empty selection.
      *
@@ -57,7 +99,7 @@ public:
      */
     OESelection();
 
-    /// @brief Copy constructor.
+    /// @brief Copy constructor (shares the immutable predicate tree).
     OESelection(const OESelection& other);
 
     /// @brief Move constructor.
@@ -96,11 +138,51 @@ public:
     /**
      * @brief Access the root predicate for direct evaluation.
      *
+     * This is the optimized tree (see optimize_selection()): shared
+     * subtrees, flattened AND/OR, folded constants, and cost-ordered
+     * children. Its ToCanonical() may therefore differ from the
+     * selection's own ToCanonical(), which reflects the parsed input.
+     *
      * @return Reference to the root predicate.
      * @note Prefer using OESelect for atom evaluation.
      */
     [[nodiscard]] const Predicate& Root() const;
 
+    /**
+     * @brief Access the compiled form of Root().
+     *
+     * The optimized tree is compiled once, when the selection is built, into
+     * a flat instruction array that bulk evaluation runs instead of walking
+     * the tree (see SelectionProgram).
+     *
+     * @return Program evaluating Root().
+     */
+    [[nodiscard]] const SelectionProgram& GetProgram() const;
+
+    /**
+     * @brief Get the number of distinct cache slots in the predicate tree.
+     *
+     * Every predicate is assigned a slot when the selection is built, with
+     * canonically identical subtrees sharing one slot. Context sizes its
+     * result caches to this count.
+     *
+     * @return Number of slots.
+     */
+    [[nodiscard]] unsigned int NumSlots() const;
+
+    /**
+     * @brief Evaluate the selection for every atom of a molecule at once.
+     *
+     * Runs the compiled program in bulk mode, combining child results
+     * with word-wide bit operations instead of evaluating each atom
+     * through the tree.
+     *
+     * @param mol The molecule to evaluate against.
+     * @return Bitset sized to mol.GetMaxAtomIdx() with matching atoms set.
+     * @throws SelectionError if evaluation fails.
+     */
+    [[nodiscard]] Bitset EvaluateMask(OEChem::OEMolBase& mol) const;
+
     /**
      * @brief Check if this is an empty selection.
      *
@@ -112,13 +194,51 @@ public:
     [[nodiscard]] bool IsEmpty() const;
 
 private:
-    /// @brief Private constructor from root predicate.
-    explicit OESelection(Predicate::Ptr root);
-
     struct Impl;
-    std::unique_ptr<Impl> pimpl_;  ///< PIMPL for binary compatibility
+    friend class SelectionSet;
+
+    /// @brief Private constructor from the parsed text and its root predicate.
+    OESelection(std::string text, Predicate::Ptr root);
+
+    /**
+     * @brief Build one selection whose root groups the merged trees of several selections.
+     *
+     * Every selection is parsed again from its text, so the result owns all
+     * of its nodes and can number them independently, and the trees are
+     * optimized together so identical subtrees are shared between them.
+     * The root is an OR whose i-th child is the optimized tree of
+     * selections[i]. Results are cached by the list of texts next to the
+     * Parse() cache, so merging the same selections again does not reparse.
+     *
+     * @param selections Selections to merge.
+     * @return Merged selection.
+     */
+    static OESelection Merge(const std::vector<OESelection>& selections);
+
+    /// @brief Private constructor sharing an existing tree (parse cache hits).
+    explicit OESelection(std::shared_ptr<const Impl> impl);
+
+    std::shared_ptr<const Impl> pimpl_;  ///< Immutable PIMPL shared by copies and the parse cache
 };
 
+/**
+ * @brief Evaluate a selection against every conformer of a molecule.
+ *
+ * Runs one evaluation context over all conformers. Coordinate-independent
+ * sub-results (component tags, residue and chain expansions, property
+ * matches) are computed once and shared; only the around, expand, and
+ * beyond parts and the predicates above them are recomputed for each
+ * conformer after refitting the spatial index. The molecule's active
+ * conformer is restored before returning.
+ *
+ * @param mol Multi-conformer molecule to evaluate.
+ * @param sele Selection to apply.
+ * @return One mask per conformer in GetConfs() order, each sized to
+ *         mol.GetMaxAtomIdx().
+ * @throws SelectionError if evaluation fails.
+ */
+[[nodiscard]] std::vector<Bitset> EvaluateConformers(OEChem::OEMCMolBase& mol, const OESelection& sele);
+
 }  // namespace OESel
 
 #endif  // OESELECT_SELECTION_H
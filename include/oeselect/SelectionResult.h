@@ -0,0 +1,263 @@
+/**
+ * @file SelectionResult.h
+ * @brief Compressed, combinable selection results.
+ *
+ * OESelectionResult stores the atoms a selection matched in a compressed
+ * bitmap, so results can be kept across frames or queries, combined with
+ * set algebra without re-evaluating selections, and bound back into new
+ * selections as named sets (see Context::SetNamedSet()).
+ */
+
+#ifndef OESELECT_SELECTION_RESULT_H
+#define OESELECT_SELECTION_RESULT_H
+
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <oechem.h>
+
+#include "oeselect/Bitset.h"
+
+namespace OESel {
+
+/**
+ * @brief Compressed set of atom indices with set algebra.
+ *
+ * Atom indices are split into chunks of 65536. Each non-empty chunk is
+ * stored in whichever of three containers is smallest: a sorted array of
+ * members (sparse selections such as "name CA"), a run list of
+ * [first, last] pairs (whole residues and chains, which PDB ordering keeps
+ * contiguous), or an 8 KiB bitmap (dense, scattered selections). Set
+ * operations decode a chunk pair into a bitmap, combine it word by word,
+ * and re-encode, so the encoding of a result depends only on its members.
+ *
+ * Like Bitset, a result has a fixed Size() (the molecule's GetMaxAtomIdx())
+ * and binary operators expect operands of the same size; members of the
+ * other operand at or past Size() are ignored.
+ *
+ * @code
+ * OESelect site(mol, "byres (ligand around 5)");
+ * OESelectionResult before(site.GetMask());
+ * // ... move to another frame ...
+ * OESelectionResult after(site.GetMask());
+ * OESelectionResult left = before;
+ * left.AndNot(after);  // atoms that left the site
+ * @endcode
+ */
+class OESelectionResult {
+public:
+    /// @brief Construct an empty result over zero atoms.
+    OESelectionResult() = default;
+
+    /**
+     * @brief Construct an empty result.
+     * @param size Number of atom indices covered.
+     */
+    explicit OESelectionResult(size_t size);
+
+    /**
+     * @brief Compress a dense mask.
+     * @param mask Mask sized to the molecule's GetMaxAtomIdx().
+     */
+    explicit OESelectionResult(const Bitset& mask);
+
+    /**
+     * @brief Build a result from atom indices in any order.
+     * @param size Number of atom indices covered.
+     * @param indices Member atom indices; duplicates are allowed.
+     * @throws SelectionError if an index is not less than @p size.
+     */
+    [[nodiscard]] static OESelectionResult FromIndices(size_t size, const std::vector<unsigned int>& indices);
+
+    /// @brief Number of atom indices covered.
+    [[nodiscard]] size_t Size() const { return size_; }
+
+    /// @brief Number of member atoms.
+    [[nodiscard]] size_t Count() const;
+
+    /// @brief Check whether there is any member.
+    [[nodiscard]] bool Any() const { return !containers_.empty(); }
+
+    /// @brief Check whether there are no members.
+    [[nodiscard]] bool None() const { return containers_.empty(); }
+
+    /**
+     * @brief Test one atom index.
+     * @param idx Atom index.
+     * @return true if @p idx is a member; false if not or out of range.
+     */
+    [[nodiscard]] bool Contains(size_t idx) const;
+
+    /// @brief Intersection with another result of the same size.
+    OESelectionResult& operator&=(const OESelectionResult& other);
+
+    /// @brief Union with another result of the same size.
+    OESelectionResult& operator|=(const OESelectionResult& other);
+
+    /// @brief Symmetric difference with another result of the same size.
+    OESelectionResult& operator^=(const OESelectionResult& other);
+
+    /**
+     * @brief Remove every member of another result.
+     * @param other Result of the same size.
+     * @return Reference to this result.
+     */
+    OESelectionResult& AndNot(const OESelectionResult& other);
+
+    /// @brief Equality comparison (same size and members).
+    bool operator==(const OESelectionResult& other) const;
+
+    /// @brief Inequality comparison.
+    bool operator!=(const OESelectionResult& other) const { return !(*this == other); }
+
+    /**
+     * @brief Collect member atom indices in ascending order.
+     * @return Vector of member indices.
+     */
+    [[nodiscard]] std::vector<unsigned int> ToIndices() const;
+
+    /**
+     * @brief Expand to a dense mask.
+     * @return Bitset of Size() bits with the members set.
+     */
+    [[nodiscard]] Bitset ToBitset() const;
+
+    /**
+     * @brief Set every member in a dense mask.
+     * @param out Bitset receiving the members; members at or past its Size() are skipped.
+     */
+    void Paint(Bitset& out) const;
+
+    /// @brief Bytes held by the compressed containers.
+    [[nodiscard]] size_t MemoryUsage() const;
+
+    /**
+     * @brief Call @p visit with every member atom index in ascending order.
+     * @param visit Callable taking a size_t atom index.
+     */
+    template <typename Visitor>
+    void ForEach(Visitor&& visit) const {
+        for (const Container& c : containers_) {
+            const size_t base = size_t{c.key} << kChunkBits;
+            switch (c.kind) {
+                case Kind::ARRAY:
+                    for (const std::uint16_t value : c.values) {
+                        visit(base + value);
+                    }
+                    break;
+                case Kind::RUNS:
+                    for (size_t i = 0; i < c.values.size(); i += 2) {
+                        for (size_t value = c.values[i]; value <= c.values[i + 1]; ++value) {
+                            visit(base + value);
+                        }
+                    }
+                    break;
+                case Kind::BITMAP:
+                    for (size_t w = 0; w < c.words.size(); ++w) {
+                        Bitset::Word bits = c.words[w];
+                        while (bits != 0) {
+                            // Isolate and strip the lowest set bit
+                            const Bitset::Word low = bits & (~bits + 1);
+                            visit(base + w * Bitset::kWordBits +
+                                  static_cast<size_t>(std::bitset<Bitset::kWordBits>(low - 1).count()));
+                            bits ^= low;
+                        }
+                    }
+                    break;
+            }
+        }
+    }
+
+private:
+    /// Atom indices per chunk, as a power of two
+    static constexpr unsigned int kChunkBits = 16;
+    /// Storage words of a bitmap container
+    static constexpr size_t kChunkWords = (size_t{1} << kChunkBits) / Bitset::kWordBits;
+
+    /// Container encodings, chosen per chunk by encoded size
+    enum class Kind : std::uint8_t { ARRAY, RUNS, BITMAP };
+
+    /// Members of one non-empty chunk
+    struct Container {
+        std::uint32_t key = 0;               ///< Chunk number (atom index >> kChunkBits)
+        Kind kind = Kind::ARRAY;             ///< Encoding of this chunk
+        std::uint32_t count = 0;             ///< Number of members
+        std::vector<std::uint16_t> values;   ///< ARRAY: sorted members; RUNS: [first, last] pairs
+        std::vector<Bitset::Word> words;     ///< BITMAP: kChunkWords words
+
+        bool operator==(const Container& other) const {
+            return key == other.key && kind == other.kind && count == other.count && values == other.values &&
+                   words == other.words;
+        }
+    };
+
+    /// Word-wise combination used by the binary operators
+    enum class Op : std::uint8_t { AND, OR, XOR, AND_NOT };
+
+    void Combine(const OESelectionResult& other, Op op);
+
+    /// OR the members of @p c into a chunk of kChunkWords words
+    static void Decode(const Container& c, Bitset::Word* words);
+
+    /// Append the chunk held in @p words (kChunkWords words) if it has members
+    void AppendChunk(std::uint32_t key, const Bitset::Word* words);
+
+    std::vector<Container> containers_;  ///< Non-empty chunks in ascending key order
+    size_t size_ = 0;
+};
+
+/// @brief Intersection of two results.
+inline OESelectionResult operator&(OESelectionResult a, const OESelectionResult& b) { return a &= b; }
+
+/// @brief Union of two results.
+inline OESelectionResult operator|(OESelectionResult a, const OESelectionResult& b) { return a |= b; }
+
+/// @brief Symmetric difference of two results.
+inline OESelectionResult operator^(OESelectionResult a, const OESelectionResult& b) { return a ^= b; }
+
+/**
+ * @brief OpenEye atom predicate matching the members of a stored result.
+ *
+ * The result is shared between copies, so CreateCopy() is cheap.
+ *
+ * @code
+ * OEInSelectionResult in_site(site_result);
+ * for (OESystem::OEIter<OEChem::OEAtomBase> atom = mol.GetAtoms(in_site); atom; ++atom) {
+ *     // ...
+ * }
+ * @endcode
+ */
+class OEInSelectionResult : public OESystem::OEUnaryPredicate<OEChem::OEAtomBase> {
+public:
+    /**
+     * @brief Construct from a result.
+     * @param result Result whose members match.
+     */
+    explicit OEInSelectionResult(OESelectionResult result);
+
+    /**
+     * @brief Test if an atom is a member of the result.
+     * @param atom The atom to test.
+     * @return true if the atom's index is a member.
+     */
+    bool operator()(const OEChem::OEAtomBase& atom) const override;
+
+    /**
+     * @brief Create a copy for OpenEye compatibility.
+     * @return New instance sharing the result (caller takes ownership).
+     */
+    [[nodiscard]] OESystem::OEUnaryFunction<OEChem::OEAtomBase, bool>* CreateCopy() const override;
+
+    /// @brief The result tested by this predicate.
+    [[nodiscard]] const OESelectionResult& GetResult() const { return *result_; }
+
+private:
+    std::shared_ptr<const OESelectionResult> result_;
+};
+
+}  // namespace OESel
+
+#endif  // OESELECT_SELECTION_RESULT_H
@@ -0,0 +1,148 @@
+/**
+ * @file SelectionSet.h
+ * @brief Fused evaluation of many selections against one molecule.
+ *
+ * A SelectionSet merges the predicate trees of its selections into one
+ * graph with shared subexpressions and evaluates all of them through a
+ * single context, so the atom table, component tags, spatial index, and
+ * every common subresult are computed once per molecule instead of once
+ * per selection.
+ */
+
+#ifndef OESELECT_SELECTION_SET_H
+#define OESELECT_SELECTION_SET_H
+
+#include <memory>
+#include <vector>
+
+#include "oeselect/Bitset.h"
+#include "oeselect/Selection.h"
+
+namespace OEChem {
+class OEMolBase;
+}
+
+namespace OESel {
+
+class Context;
+
+/**
+ * @brief Evaluates a fixed list of selections against a molecule in one pass.
+ *
+ * Identical subtrees are shared across selections: "ligand" in
+ * "ligand around 4" and "byres (ligand around 5)" is evaluated once, and
+ * "ligand around 4" in two selections reuses one distance query.
+ *
+ * @code
+ * SelectionSet features({
+ *     OESelection::Parse("protein"),
+ *     OESelection::Parse("ligand around 4"),
+ *     OESelection::Parse("byres (ligand around 5)"),
+ *     OESelection::Parse("backbone and chain A")});
+ * std::vector<Bitset> masks = features.EvaluateMasks(mol);
+ * // masks[i] holds the atoms matching the i-th selection
+ * @endcode
+ *
+ * @note A set reuses one evaluation context across calls, so a single
+ *       instance must not be used by several threads at once. Copies share
+ *       the merged tree and get their own context.
+ */
+class SelectionSet {
+public:
+    /**
+     * @brief Merge selections into one set.
+     * @param selections Selections to evaluate, in output order.
+     */
+    explicit SelectionSet(const std::vector<OESelection>& selections);
+
+    /// @brief Copy constructor (shares the merged tree, not the context).
+    SelectionSet(const SelectionSet& other);
+
+    /// @brief Copy assignment operator.
+    SelectionSet& operator=(const SelectionSet& other);
+
+    /// @brief Move constructor.
+    SelectionSet(SelectionSet&& other) noexcept;
+
+    /// @brief Move assignment operator.
+    SelectionSet& operator=(SelectionSet&& other) noexcept;
+
+    /// @brief Destructor.
+    ~SelectionSet();
+
+    /// @brief Number of selections in the set.
+    [[nodiscard]] size_t Size() const;
+
+    /**
+     * @brief Access one of the selections the set was built from.
+     * @param index Position in the constructor's list.
+     * @return The selection.
+     * @throws SelectionError if @p index is out of range.
+     */
+    [[nodiscard]] const OESelection& GetSelection(size_t index) const;
+
+    /**
+     * @brief Access the merged selection evaluated by the set.
+     *
+     * Its root is an OR whose i-th child is the optimized tree of the i-th
+     * selection; NumSlots() counts the distinct subexpressions of the set.
+     *
+     * @return Merged selection.
+     */
+    [[nodiscard]] const OESelection& GetMergedSelection() const;
+
+    /**
+     * @brief Evaluate every selection against a molecule.
+     *
+     * @param mol The molecule to evaluate.
+     * @param masks Receives one mask per selection, sized to
+     *        mol.GetMaxAtomIdx(); existing storage is reused.
+     * @throws SelectionError if evaluation fails.
+     */
+    void EvaluateMasks(OEChem::OEMolBase& mol, std::vector<Bitset>& masks);
+
+    /**
+     * @brief Evaluate every selection against a molecule.
+     * @param mol The molecule to evaluate.
+     * @return One mask per selection, sized to mol.GetMaxAtomIdx().
+     * @throws SelectionError if evaluation fails.
+     */
+    [[nodiscard]] std::vector<Bitset> EvaluateMasks(OEChem::OEMolBase& mol);
+
+    /**
+     * @brief Count matching atoms for every selection.
+     * @param mol The molecule to evaluate.
+     * @return result[i] is the number of atoms matching the i-th selection.
+     * @throws SelectionError if evaluation fails.
+     */
+    [[nodiscard]] std::vector<unsigned int> Count(OEChem::OEMolBase& mol);
+
+    /**
+     * @brief Collect matching atom indices for every selection.
+     * @param mol The molecule to evaluate.
+     * @return result[i] lists the atom indices matching the i-th selection
+     *         in ascending order.
+     * @throws SelectionError if evaluation fails.
+     */
+    [[nodiscard]] std::vector<std::vector<unsigned int>> Select(OEChem::OEMolBase& mol);
+
+    /**
+     * @brief Access the context the last evaluation ran in.
+     *
+     * Lets a caller reuse the atom table, bond graph, and spatial index the
+     * evaluation built for the same molecule instead of building its own.
+     * The context is rebound by the next EvaluateMasks() call.
+     *
+     * @return The evaluation context.
+     * @throws SelectionError if the set has not been evaluated yet.
+     */
+    [[nodiscard]] Context& GetContext();
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> pimpl_;  ///< PIMPL containing the merged tree and the context
+};
+
+}  // namespace OESel
+
+#endif  // OESELECT_SELECTION_SET_H
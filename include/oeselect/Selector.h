@@ -14,7 +14,10 @@
 
 #include <oechem.h>
 
+#include "oeselect/Profile.h"
 #include "oeselect/Selection.h"
+#include "oeselect/SelectionResult.h"
+#include "oeselect/UnitCell.h"
 
 namespace OESel {
 
@@ -41,6 +44,19 @@ namespace OESel {
  * }
  * @endcode
  *
+ * Copies, including the ones OEChem makes through CreateCopy() for every
+ * GetAtoms(), OECount(), or OESubsetMol() call, share one reference-counted
+ * evaluation snapshot: whichever member of the family computes the mask
+ * first publishes it, and the others read it instead of re-evaluating.
+ * While a selector has copies, or a copy has published since, every member
+ * checks the shared mask against a fingerprint of the molecule's atom and
+ * bond counts and coordinates at each GetMask() and at the start of each
+ * pass of operator() calls, and re-evaluates when it differs (SetCoords(),
+ * added atoms). A selector without copies computes its mask once. Edits
+ * that keep the counts and coordinates, such as renames or residue changes,
+ * are not detected; construct a new selector after them. SetFrame(),
+ * SetUnitCell(), or SetProfiling() give a selector private results.
+ *
  * @note The selector maintains internal caches for efficient repeated
  *       evaluation. For best performance, reuse the same OESelect instance.
  */
@@ -65,10 +81,10 @@ public:
      */
     OESelect(OEChem::OEMolBase& mol, const std::string& sele);
 
-    /// @brief Copy constructor (creates new evaluation context).
+    /// @brief Copy constructor (new evaluation context, shared evaluation snapshot).
     OESelect(const OESelect& other);
 
-    /// @brief Copy assignment operator.
+    /// @brief Copy assignment operator (shares @p other's evaluation snapshot).
     OESelect& operator=(const OESelect& other);
 
     /// @brief Destructor.
@@ -78,7 +94,8 @@ public:
      * @brief Evaluate predicate for an atom.
      *
      * Implements the OEUnaryPredicate interface. Returns true if the
-     * atom matches the selection criteria.
+     * atom matches the selection criteria. The whole molecule is evaluated
+     * in bulk on the first call, and later calls read the cached mask.
      *
      * @param atom The atom to evaluate.
      * @return true if the atom matches the selection.
@@ -89,7 +106,8 @@ public:
      * @brief Create a copy for OpenEye compatibility.
      *
      * Required by OEUnaryFunction interface. Returns a dynamically
-     * allocated copy that the caller must delete.
+     * allocated copy that the caller must delete. The copy shares this
+     * selector's evaluation snapshot, so it does not evaluate again.
      *
      * @return New OESelect instance (caller takes ownership).
      */
@@ -109,6 +127,116 @@ public:
      */
     [[nodiscard]] const OEChem::OEMolBase& GetMol() const;
 
+    /**
+     * @brief Access the bulk evaluation mask for the bound molecule.
+     *
+     * The mask is computed on first use and shared by subsequent calls to
+     * operator(); see the class notes for when it is recomputed.
+     *
+     * @return Bitset indexed by atom index with matching atoms set.
+     */
+    [[nodiscard]] const Bitset& GetMask() const;
+
+    /**
+     * @brief Compressed copy of the bulk evaluation mask.
+     *
+     * Use this to keep a result past the selector's lifetime or the
+     * current frame, combine it with other results, or bind it into
+     * another selection with SetNamedSet().
+     *
+     * @return Result with the matching atoms as members.
+     */
+    [[nodiscard]] OESelectionResult GetResult() const;
+
+    /**
+     * @brief Bind a stored result to `%name` in this selector's selection.
+     *
+     * Discards the cached mask. Copies, including those made by
+     * CreateCopy(), keep the bindings.
+     *
+     * @param name Set name: a letter or underscore, then letters, digits, or underscores.
+     * @param result Result sized to the molecule's GetMaxAtomIdx().
+     * @throws SelectionError if @p name is not a valid set name.
+     */
+    void SetNamedSet(const std::string& name, const OESelectionResult& result);
+
+    /**
+     * @brief Move the bound molecule to a new frame.
+     *
+     * Writes the coordinates to the molecule and discards the cached
+     * mask. The evaluation context is kept, so topology-derived caches
+     * survive and only distance-dependent results are recomputed on the
+     * next evaluation. Use this to step one selector through a trajectory
+     * instead of constructing a new OESelect per frame.
+     *
+     * @param xyz Coordinates indexed by atom index: 3 * GetMaxAtomIdx()
+     *        floats in the layout of OEMolBase::GetCoords(float*).
+     */
+    void SetFrame(const float* xyz);
+
+    /**
+     * @brief Set the periodic box for distance predicates.
+     *
+     * Distances are measured to the nearest periodic image, so a solvated
+     * box need not be replicated to find neighbours across its faces.
+     * Discards the cached mask when the cell changes. Copies, including
+     * those made by CreateCopy(), keep the cell.
+     *
+     * @param cell Unit cell, or a default-constructed UnitCell for none.
+     */
+    void SetUnitCell(const UnitCell& cell);
+
+    /// @brief Periodic box used by distance predicates.
+    [[nodiscard]] const UnitCell& GetUnitCell() const;
+
+    /**
+     * @brief Set the number of threads that evaluate the mask.
+     *
+     * Only molecules of at least Context::kParallelMinAtoms atoms are
+     * split across threads; the mask is the same for every thread count,
+     * so the cached mask is kept. Copies keep the setting.
+     *
+     * @param num_threads Threads to use; 1 (the default) evaluates on the
+     *        calling thread, and 0 uses the hardware concurrency.
+     */
+    void SetNumThreads(unsigned int num_threads);
+
+    /// @brief Number of threads that evaluate the mask.
+    [[nodiscard]] unsigned int GetNumThreads() const;
+
+    /**
+     * @brief Reuse skin-padded neighbor lists for distance predicates across frames.
+     *
+     * With a skin, SetFrame() re-measures only the pairs found within
+     * radius + @p skin when the list was last built, instead of querying
+     * the spatial index, until an atom has moved more than skin / 2 (see
+     * Context::SetVerletSkin()). The mask is the same with or without a
+     * skin, so the cached mask is kept. Copies keep the setting.
+     *
+     * @param skin Padding in Angstroms; 0 (the default) disables the lists.
+     * @throws SelectionError if @p skin is negative or not finite.
+     */
+    void SetVerletSkin(float skin);
+
+    /// @brief Neighbor list padding in Angstroms; 0 when disabled.
+    [[nodiscard]] float GetVerletSkin() const;
+
+    /**
+     * @brief Enable or disable per-node profiling.
+     *
+     * Discards the cached mask, so the next evaluation is measured.
+     * Statistics accumulate across frames until profiling is re-enabled.
+     *
+     * @param enabled true to record statistics.
+     */
+    void SetProfiling(bool enabled);
+
+    /**
+     * @brief Statistics recorded while profiling.
+     * @return Annotated evaluation tree; empty if profiling is disabled.
+     */
+    [[nodiscard]] EvaluationProfile GetProfile() const;
+
 private:
     struct Impl;
     std::unique_ptr<Impl> pimpl_;  ///< PIMPL for binary compatibility
@@ -1,18 +1,21 @@
 /**
  * @file SpatialIndex.h
- * @brief K-d tree spatial index for efficient distance queries.
+ * @brief Spatial index for efficient distance queries.
  *
- * SpatialIndex provides O(log n) radius queries for distance-based
- * predicates (around, expand, beyond). It uses nanoflann for the
- * underlying k-d tree implementation.
+ * SpatialIndex provides radius queries for distance-based predicates
+ * (around, expand, beyond) and k-nearest queries for nearest. It is
+ * backed either by a nanoflann k-d tree or by a uniform-grid cell list.
  */
 
 #ifndef OESELECT_SPATIAL_INDEX_H
 #define OESELECT_SPATIAL_INDEX_H
 
+#include <cstdint>
 #include <memory>
 #include <vector>
 
+#include "oeselect/UnitCell.h"
+
 namespace OEChem {
 class OEMolBase;
 class OEAtomBase;
@@ -20,31 +23,87 @@ class OEAtomBase;
 
 namespace OESel {
 
+class Bitset;
+class Context;
+class WorkStealingPool;
+
 /**
- * @brief K-d tree based spatial index for efficient distance queries.
+ * @brief Data structure backing a SpatialIndex.
+ */
+enum class SpatialBackend {
+    AUTO,       ///< Choose from the atom count and cutoff (see SpatialIndex::ChooseBackend())
+    KD_TREE,    ///< nanoflann k-d tree: O(n log n) build, suits any radius
+    CELL_LIST   ///< Uniform grid with cell size equal to the cutoff: O(n) build, suits short cutoffs
+};
+
+/**
+ * @brief Spatial index for efficient distance queries.
+ *
+ * This class indexes 3D atom coordinates to enable fast radius queries.
+ * It is used internally by distance predicates (around, expand, beyond)
+ * to find atoms within a given distance. Both backends return the same
+ * atoms for every query; they differ only in build and query cost.
  *
- * This class builds a 3D k-d tree from atom coordinates to enable fast
- * radius queries. It is used internally by distance predicates (around,
- * expand, beyond) to find atoms within a given distance.
+ * The index is built on construction from the molecule's current
+ * coordinates. When the same atoms move (for example between trajectory
+ * frames), call UpdateCoordinates() to refit it instead of building a new
+ * index.
  *
- * The index is built once on construction and is immutable. If the
- * molecule coordinates change, a new index must be created.
+ * With a periodic UnitCell, every query measures minimum-image distances:
+ * an atom matches if any of its periodic images is within the radius.
+ *
+ * An index owned by a Context with several threads (see
+ * Context::SetNumThreads()) also bins atoms and runs MarkWithinRadius()
+ * on the context's workers.
  *
  * @note The index stores atom positions at construction time. If molecule
- *       coordinates are modified after index creation, queries will use
- *       stale coordinate data.
+ *       coordinates are modified without UpdateCoordinates(), queries will
+ *       use stale coordinate data.
  */
 class SpatialIndex {
 public:
+    /// @brief Minimum atom count for which AUTO picks the cell list.
+    static constexpr size_t kCellListMinAtoms = 2000;
+
+    /// @brief Largest cutoff in Angstroms for which AUTO picks the cell list.
+    static constexpr float kCellListMaxCutoff = 8.0f;
+
     /**
      * @brief Construct spatial index from molecule coordinates.
      *
-     * Builds a k-d tree from all atom positions in the molecule.
-     * Construction is O(n log n) where n is the number of atoms.
+     * The k-d tree is built in O(n log n) and the cell list in O(n), where
+     * n is the number of atoms.
+     *
+     * @param mol The molecule to index.
+     * @param backend Data structure to build (default: k-d tree).
+     * @param cutoff Largest radius expected in queries, in Angstroms. Sets
+     *        the cell-list cell size and drives the AUTO choice; 0 if unknown.
+     * @param cell Periodic box for minimum-image queries (default: none).
+     */
+    explicit SpatialIndex(OEChem::OEMolBase& mol,
+                          SpatialBackend backend = SpatialBackend::KD_TREE,
+                          float cutoff = 0.0f,
+                          const UnitCell& cell = UnitCell());
+
+    /**
+     * @brief Construct spatial index over a subset of a molecule's atoms.
+     *
+     * Only atoms set in @p atoms are indexed, so queries return only those
+     * atoms and the build cost scales with the subset rather than the
+     * molecule. Context builds these for distance predicates whose
+     * surrounding selection restricts the atoms they can match.
      *
      * @param mol The molecule to index.
+     * @param atoms Bitset of atom indices to index.
+     * @param backend Data structure to build (default: k-d tree).
+     * @param cutoff Largest radius expected in queries, in Angstroms; 0 if unknown.
+     * @param cell Periodic box for minimum-image queries (default: none).
      */
-    explicit SpatialIndex(OEChem::OEMolBase& mol);
+    SpatialIndex(OEChem::OEMolBase& mol,
+                 const Bitset& atoms,
+                 SpatialBackend backend = SpatialBackend::KD_TREE,
+                 float cutoff = 0.0f,
+                 const UnitCell& cell = UnitCell());
 
     /// @brief Destructor.
     ~SpatialIndex();
@@ -53,6 +112,19 @@ public:
     SpatialIndex(const SpatialIndex&) = delete;
     SpatialIndex& operator=(const SpatialIndex&) = delete;
 
+    /**
+     * @brief Refit the index to new coordinates for the same atoms.
+     *
+     * The cell list re-bins atoms into its existing grid while they all
+     * still fall inside it, and recomputes the grid otherwise. The k-d tree
+     * is rebuilt over the updated points. Storage from the previous build
+     * is reused in both cases.
+     *
+     * @param xyz Coordinates indexed by atom index: 3 * GetMaxAtomIdx()
+     *        floats in the layout of OEMolBase::GetCoords(float*).
+     */
+    void UpdateCoordinates(const float* xyz);
+
     /**
      * @brief Find all atoms within radius of a point.
      *
@@ -63,7 +135,8 @@ public:
      * @param y Y coordinate of query point.
      * @param z Z coordinate of query point.
      * @param radius Maximum distance in Angstroms.
-     * @return Vector of atom indices within the radius.
+     * @return Vector of atom indices within the radius; in ascending order
+     *         when the index is periodic.
      */
     [[nodiscard]] std::vector<unsigned int> FindWithinRadius(float x, float y, float z, float radius) const;
 
@@ -78,6 +151,142 @@ public:
      */
     [[nodiscard]] std::vector<unsigned int> FindWithinRadius(const OEChem::OEAtomBase& atom, float radius) const;
 
+    /**
+     * @brief Mark every atom within radius of any reference atom.
+     *
+     * Equivalent to calling FindWithinRadius() for each reference atom and
+     * setting the bits of all results, but done in one batch over a uniform
+     * grid (the cell list itself, or a temporary grid with cells
+     * @p radius wide for the k-d tree backend): each occupied reference
+     * cell is tested only against the cells within reach with vectorized
+     * squared-distance checks, and cells whose atoms are all marked
+     * already are skipped. Scratch storage is allocated once per call
+     * rather than per reference atom.
+     *
+     * @param refs Bitset of reference atom indices.
+     * @param radius Maximum distance in Angstroms (exclusive).
+     * @param out Bitset receiving matching atom indices; existing bits are kept.
+     */
+    void MarkWithinRadius(const Bitset& refs, float radius, Bitset& out) const;
+
+    /**
+     * @brief Mark every indexed atom within radius of any query atom.
+     *
+     * Unlike MarkWithinRadius(), the query atoms need not be indexed: their
+     * positions are read from @p xyz and binned into the index's grid, so a
+     * subset index over a few candidate atoms can be searched from a large
+     * reference set without indexing it.
+     *
+     * @param xyz Coordinates indexed by atom index: 3 * GetMaxAtomIdx()
+     *        floats in the layout of OEMolBase::GetCoords(float*).
+     * @param queries Bitset of query atom indices.
+     * @param radius Maximum distance in Angstroms (exclusive).
+     * @param out Bitset receiving matching indexed atom indices; existing bits are kept.
+     */
+    void MarkIndexedNear(const float* xyz, const Bitset& queries, float radius, Bitset& out) const;
+
+    /**
+     * @brief Mark every query atom within radius of any indexed atom.
+     *
+     * The converse of MarkIndexedNear(): a subset index over a few reference
+     * atoms tests many unindexed candidates, and each cell of candidates
+     * stops scanning once all of them have matched.
+     *
+     * @param xyz Coordinates indexed by atom index, as for MarkIndexedNear().
+     * @param queries Bitset of query atom indices.
+     * @param radius Maximum distance in Angstroms (exclusive).
+     * @param out Bitset receiving matching query atom indices; existing bits are kept.
+     */
+    void MarkNearIndexed(const float* xyz, const Bitset& queries, float radius, Bitset& out) const;
+
+    /**
+     * @brief Collect every (reference, target) atom pair closer than radius.
+     *
+     * Pairs are found in one batch over a uniform grid, as in
+     * MarkWithinRadius(), and appended to the three arrays in ascending
+     * order of reference index, then target index. An atom is never paired
+     * with itself, and under periodic boundaries each pair is reported once
+     * at its minimum-image distance. Storage grows only by amortized appends to the output
+     * arrays and to scratch buffers reused across reference atoms.
+     *
+     * @param refs Bitset of reference atom indices.
+     * @param targets Bitset of target atom indices.
+     * @param radius Maximum distance in Angstroms (exclusive).
+     * @param first Receives the reference atom index of each pair.
+     * @param second Receives the target atom index of each pair.
+     * @param distance_sq Receives the squared distance of each pair.
+     */
+    void FindPairs(const Bitset& refs, const Bitset& targets, float radius,
+                   std::vector<unsigned int>& first, std::vector<unsigned int>& second,
+                   std::vector<float>& distance_sq) const;
+
+    /**
+     * @brief Find the candidate atoms closest to any reference atom.
+     *
+     * A candidate's distance is its minimum over all reference atoms (the
+     * minimum-image distance under periodic boundaries). The search builds
+     * a temporary k-d tree over the candidates and runs one k-nearest query
+     * per reference atom (per periodic image of it, when periodic); the k
+     * global nearest are then picked from the union of those results, which
+     * always contains them. Each query keeps every candidate tied with its
+     * k-th nearest, so ties resolve by atom index rather than tree order. The cost is independent of any cutoff, so the
+     * backend chosen for radius queries does not matter.
+     *
+     * Results are appended in ascending order of distance, ties broken by
+     * atom index. Atoms with non-finite coordinates are skipped.
+     *
+     * @param refs Bitset of reference atom indices.
+     * @param candidates Bitset of candidate atom indices.
+     * @param k Maximum number of candidates to return.
+     * @param nearest Receives up to @p k candidate atom indices.
+     * @param distance_sq Receives the squared distance of each returned candidate.
+     */
+    void FindNearest(const Bitset& refs, const Bitset& candidates, size_t k,
+                     std::vector<unsigned int>& nearest, std::vector<float>& distance_sq) const;
+
+    /**
+     * @brief Find the candidate groups (e.g. residues) closest to any reference atom.
+     *
+     * A group's distance is that of its nearest candidate atom. The search
+     * ranks candidate atoms as FindNearest() does, doubling k over one
+     * temporary k-d tree until the ranking reaches @p count distinct groups
+     * or covers every candidate.
+     *
+     * @param refs Bitset of reference atom indices.
+     * @param candidates Bitset of candidate atom indices.
+     * @param groups Group of each atom, indexed by atom index; atoms past its end are skipped.
+     * @param count Maximum number of groups to return.
+     * @param nearest Receives the nearest atom of each of up to @p count groups, nearest first.
+     * @param distance_sq Receives the squared distance of each returned atom.
+     */
+    void FindNearestGroups(const Bitset& refs, const Bitset& candidates, const std::vector<std::uint32_t>& groups,
+                           size_t count, std::vector<unsigned int>& nearest, std::vector<float>& distance_sq) const;
+
+    /**
+     * @brief Pick the backend AUTO resolves to.
+     *
+     * Chooses the cell list for systems of at least kCellListMinAtoms atoms
+     * queried with a known cutoff of at most kCellListMaxCutoff, where
+     * binning beats tree construction and traversal; otherwise the k-d tree.
+     *
+     * @param num_atoms Number of atoms to index.
+     * @param max_radius Largest query radius, or 0 if unknown.
+     * @return KD_TREE or CELL_LIST.
+     */
+    [[nodiscard]] static SpatialBackend ChooseBackend(size_t num_atoms, float max_radius);
+
+    /**
+     * @brief Get the backend in use.
+     * @return KD_TREE or CELL_LIST (never AUTO).
+     */
+    [[nodiscard]] SpatialBackend Backend() const;
+
+    /**
+     * @brief Get the periodic box queries are measured in.
+     * @return Unit cell; non-periodic unless one was given on construction.
+     */
+    [[nodiscard]] const UnitCell& GetUnitCell() const;
+
     /**
      * @brief Get the number of atoms in the index.
      * @return Number of indexed atoms.
@@ -85,8 +294,17 @@ public:
     [[nodiscard]] size_t Size() const;
 
 private:
+    friend class Context;
+
+    /// Construct for a Context, building and querying on @p pool when not null
+    SpatialIndex(OEChem::OEMolBase& mol, SpatialBackend backend, float cutoff, const UnitCell& cell,
+                 WorkStealingPool* pool);
+
+    /// Switch the workers used by later builds and queries (null to run inline)
+    void SetPool(WorkStealingPool* pool);
+
     struct Impl;
-    std::unique_ptr<Impl> pimpl_;  ///< PIMPL containing k-d tree
+    std::unique_ptr<Impl> pimpl_;  ///< PIMPL containing the backend structure
 };
 
 }  // namespace OESel
@@ -0,0 +1,165 @@
+/**
+ * @file StreamFilter.h
+ * @brief Pipelined selection filtering of multi-molecule streams.
+ *
+ * StreamFilter applies one selection to every molecule of a stream while
+ * overlapping the three stages of the job: a reader thread parses
+ * molecules, worker threads evaluate the selection with their own
+ * reusable Context, and the calling thread writes results in input order.
+ */
+
+#ifndef OESELECT_STREAM_FILTER_H
+#define OESELECT_STREAM_FILTER_H
+
+#include <functional>
+#include <iosfwd>
+#include <memory>
+
+#include "oeselect/Bitset.h"
+#include "oeselect/Selection.h"
+
+namespace OEChem {
+class OEMolBase;
+class oemolistream;
+class oemolostream;
+}
+
+namespace OESel {
+
+/// @brief Text record written per molecule by StreamFilter::Run(ifs, output, out).
+enum class FilterOutput {
+    COUNT,    ///< "index<TAB>title<TAB>count" with the number of selected atoms
+    INDICES,  ///< "index<TAB>title<TAB>i,j,k" with the selected atom indices
+};
+
+/// @brief Totals for one StreamFilter run.
+struct StreamFilterStats {
+    size_t molecules_read = 0;     ///< Molecules taken from the source
+    size_t molecules_written = 0;  ///< Records or molecules emitted
+    size_t atoms_selected = 0;     ///< Selected atoms summed over all molecules
+};
+
+/**
+ * @brief Streams molecules through a selection on a pipeline of threads.
+ *
+ * At most QueueDepth() molecules are in flight at once: the reader blocks
+ * until the writer has released a molecule, so memory stays bounded for
+ * streams of any size. Molecule storage and worker contexts are reused,
+ * and results always reach the writer in input order.
+ *
+ * @code
+ * StreamFilter filter(OESelection::Parse("ligand or (ligand around 5)"));
+ * oemolistream ifs("complexes.oeb.gz");
+ * oemolostream ofs("pockets.oeb.gz");
+ * const StreamFilterStats stats = filter.Run(ifs, ofs);
+ * @endcode
+ *
+ * @note One run at a time; a StreamFilter must not be used from two
+ *       threads concurrently.
+ */
+class StreamFilter {
+public:
+    /**
+     * @brief Reads the next molecule.
+     *
+     * Called on the reader thread with a cleared molecule to fill.
+     *
+     * @return false when the stream is exhausted.
+     */
+    using MoleculeSource = std::function<bool(OEChem::OEMolBase& mol)>;
+
+    /**
+     * @brief Receives one molecule's result.
+     *
+     * Invoked on the calling thread in input order. The molecule and mask
+     * are only valid during the call.
+     *
+     * @param index Position of the molecule in the input.
+     * @param mol The molecule.
+     * @param mask Selected atoms, sized to mol.GetMaxAtomIdx().
+     */
+    using ResultCallback = std::function<void(size_t index, OEChem::OEMolBase& mol, const Bitset& mask)>;
+
+    /**
+     * @brief Create a filter.
+     *
+     * @param sele Selection applied to every molecule.
+     * @param num_threads Evaluation threads; 0 uses the hardware
+     *        concurrency, and 1 reads, evaluates, and writes on the
+     *        calling thread.
+     * @param queue_depth Molecules in flight; 0 picks four per thread.
+     */
+    explicit StreamFilter(OESelection sele, unsigned int num_threads = 0, size_t queue_depth = 0);
+
+    /// @brief Destructor.
+    ~StreamFilter();
+
+    // Non-copyable (owns worker contexts)
+    StreamFilter(const StreamFilter&) = delete;
+    StreamFilter& operator=(const StreamFilter&) = delete;
+
+    /// @brief The selection applied to every molecule.
+    [[nodiscard]] const OESelection& GetSelection() const;
+
+    /// @brief Number of evaluation threads.
+    [[nodiscard]] unsigned int NumThreads() const;
+
+    /// @brief Maximum number of molecules in flight.
+    [[nodiscard]] size_t QueueDepth() const;
+
+    /**
+     * @brief Filter a molecule source, passing every result to a callback.
+     *
+     * @param source Supplies molecules until it returns false.
+     * @param callback Receives each molecule's mask in input order.
+     * @return Totals; molecules_written counts callback invocations.
+     * @throws SelectionError if evaluation fails. Exceptions thrown by
+     *         @p source or @p callback stop the run and are rethrown.
+     */
+    StreamFilterStats Run(const MoleculeSource& source, const ResultCallback& callback);
+
+    /**
+     * @brief Write the selected atoms of every molecule to a stream.
+     *
+     * Subsets are built on the worker threads with OESubsetMol and keep
+     * the input molecule's title.
+     *
+     * @param ifs Stream to read until exhausted.
+     * @param ofs Stream receiving one subset per molecule.
+     * @param keep_empty Also write molecules with no selected atoms.
+     * @return Totals; molecules_written counts molecules written.
+     * @throws SelectionError if evaluation fails.
+     */
+    StreamFilterStats Run(OEChem::oemolistream& ifs, OEChem::oemolostream& ofs, bool keep_empty = false);
+
+    /**
+     * @brief Write one text record per molecule instead of structures.
+     *
+     * @param ifs Stream to read until exhausted.
+     * @param output Record format.
+     * @param out Text stream receiving one line per molecule.
+     * @return Totals; molecules_written counts lines written.
+     * @throws SelectionError if evaluation fails.
+     */
+    StreamFilterStats Run(OEChem::oemolistream& ifs, FilterOutput output, std::ostream& out);
+
+    /**
+     * @brief Format one text record as written by Run(ifs, output, out).
+     *
+     * @param out Text stream receiving the line.
+     * @param output Record format.
+     * @param index Position of the molecule in the input.
+     * @param mol The molecule (its title is written).
+     * @param mask Selected atoms.
+     */
+    static void WriteRecord(std::ostream& out, FilterOutput output, size_t index, const OEChem::OEMolBase& mol,
+                            const Bitset& mask);
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> pimpl_;  ///< PIMPL containing the selection and worker contexts
+};
+
+}  // namespace OESel
+
+#endif  // OESELECT_STREAM_FILTER_H
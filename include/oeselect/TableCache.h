@@ -0,0 +1,113 @@
+/**
+ * @file TableCache.h
+ * @brief Persisted atom tables for structures that are evaluated repeatedly.
+ *
+ * Building the atom table and bond graph costs one pass over the molecule
+ * through OEChem accessors. For a structure that is loaded many times
+ * (a large complex screened against many selections, one process per
+ * query), TableCache writes both snapshots to a sidecar file once and maps
+ * them back on later runs instead of walking the molecule again.
+ */
+
+#ifndef OESELECT_TABLE_CACHE_H
+#define OESELECT_TABLE_CACHE_H
+
+#include <cstdint>
+#include <string>
+
+namespace OEChem {
+class OEMolBase;
+}
+
+namespace OESel {
+
+class Context;
+
+/**
+ * @brief Save and load a Context's atom table and bond graph.
+ *
+ * The file is a versioned, position-independent image: a header carrying
+ * a format version, a byte-order mark, a content key, and the
+ * Tagger::ResidueClassDigest() the component flags were computed under,
+ * followed by the table columns as aligned, length-prefixed arrays. Load()
+ * maps the file and rejects it if any of these, or the atom count,
+ * disagree with the molecule, so a stale sidecar, or one saved under
+ * different residue class registrations, falls back to building the tables.
+ *
+ * The spatial index is not stored: it depends on the selection's radii
+ * and the unit cell, and rebuilding it is a linear pass over the
+ * coordinates rather than over OEChem objects.
+ *
+ * Example:
+ * @code
+ * Context ctx(mol, sele);
+ * const std::uint64_t key = TableCache::FileKey("complex.pdb");
+ * if (!TableCache::Load(ctx, "complex.oesel", key)) {
+ *     TableCache::Save(ctx, "complex.oesel", key);
+ * }
+ * @endcode
+ */
+class TableCache {
+public:
+    /// @brief Current file format version.
+    static constexpr std::uint32_t kVersion = 2;
+
+    /**
+     * @brief Content key of the structure file a molecule was read from.
+     *
+     * A 64-bit FNV-1a hash over the file's bytes, read through the same
+     * mapping Load() uses. This is the cheap default: hashing the file
+     * costs far less than the OEChem pass the cache exists to skip.
+     * Callers that already identify the structure (a database id, a
+     * digest from their own pipeline) may pass that instead.
+     *
+     * @param path Structure file the molecule is read from.
+     * @return The content key.
+     * @throws SelectionError if the file cannot be read.
+     */
+    [[nodiscard]] static std::uint64_t FileKey(const std::string& path);
+
+    /**
+     * @brief Content key of every atom and bond property the tables read.
+     *
+     * A 64-bit FNV-1a hash over atom indices, atomic numbers, atom names,
+     * residue fields, and bond endpoints. Computing it walks every atom,
+     * residue, and bond through OEChem, about as costly as building the
+     * tables, so use it only for molecules with no source file or other
+     * identifier; prefer FileKey() or a caller-supplied key otherwise.
+     *
+     * @param mol The molecule to hash.
+     * @return The content key.
+     */
+    [[nodiscard]] static std::uint64_t Key(const OEChem::OEMolBase& mol);
+
+    /**
+     * @brief Write the context's atom table and bond graph to @p path.
+     *
+     * Builds either snapshot first if the context has not needed it yet.
+     *
+     * @param ctx Context bound to the molecule.
+     * @param path Output file path, overwritten if it exists.
+     * @param key Content key stored in the header, usually FileKey() of the structure file.
+     * @throws SelectionError if the file cannot be written.
+     */
+    static void Save(Context& ctx, const std::string& path, std::uint64_t key);
+
+    /**
+     * @brief Install the atom table and bond graph stored in @p path.
+     *
+     * @param ctx Context bound to the molecule the file was saved from.
+     * @param path Sidecar file path.
+     * @param key Expected content key.
+     * @return true if the tables were installed; false if the file is
+     *         missing, from another format version or byte order, has a
+     *         different key, residue class digest, or atom count, or is
+     *         corrupt. The context is
+     *         unchanged on false.
+     */
+    static bool Load(Context& ctx, const std::string& path, std::uint64_t key);
+};
+
+}  // namespace OESel
+
+#endif  // OESELECT_TABLE_CACHE_H
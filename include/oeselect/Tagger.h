@@ -3,14 +3,16 @@
  * @brief Molecular component classification and tagging.
  *
  * The Tagger class provides automatic classification of atoms into molecular
- * components (protein, ligand, water, etc.) based on residue names. Tags are
- * stored as atom data and cached on the molecule.
+ * components (protein, ligand, water, etc.) based on residue names. Selection
+ * evaluation reads the classification from AtomTable::ComponentFlags();
+ * TagMolecule() additionally persists it as atom data on the molecule.
  */
 
 #ifndef OESELECT_TAGGER_H
 #define OESELECT_TAGGER_H
 
 #include <cstdint>
+#include <string>
 
 namespace OEChem {
 class OEMolBase;
@@ -24,6 +26,7 @@ namespace OESel {
  *
  * Each flag represents a molecular component type. Flags can be combined
  * using bitwise operators for atoms that belong to multiple categories.
+ * All flags fit in the low eight bits.
  */
 enum class ComponentFlag : uint32_t {
     NONE     = 0,       ///< No component assignment
@@ -33,6 +36,8 @@ enum class ComponentFlag : uint32_t {
     COFACTOR = 1 << 3,  ///< Enzyme cofactors (NAD, FAD, etc.)
     NUCLEIC  = 1 << 4,  ///< Nucleic acid residues
     WATER    = 1 << 5,  ///< Water molecules (HOH, WAT, etc.)
+    LIPID    = 1 << 6,  ///< Membrane lipids and sterols (POPC, CHL1, etc.)
+    GLYCAN   = 1 << 7,  ///< Carbohydrate residues (NAG, MAN, etc.)
 };
 
 /**
@@ -61,14 +66,77 @@ inline ComponentFlag operator&(ComponentFlag a, ComponentFlag b) {
  * @brief Utility for tagging molecules with component classifications.
  *
  * Tagger analyzes residue names to classify atoms into component types.
- * Classification is performed once per molecule and cached using OEMolBase
- * generic data. Subsequent calls to TagMolecule() are no-ops.
+ * ClassifyResidueName() is a pure, allocation-free lookup. TagMolecule() is
+ * an opt-in for callers who want the flags stored on the molecule as
+ * OEMolBase generic data; selection evaluation never modifies the molecule.
  *
  * @note Classification is based on residue names and may not be accurate
  *       for non-standard naming conventions.
  */
 class Tagger {
 public:
+    /**
+     * @brief Classify a residue name.
+     *
+     * Surrounding whitespace is ignored. Names not in the built-in tables
+     * classify as LIGAND.
+     *
+     * @param resname The residue name.
+     * @return The component flag for the residue.
+     */
+    static ComponentFlag ClassifyResidueName(const char* resname);
+
+    /**
+     * @brief Register or override the classification of a residue name.
+     *
+     * Registrations apply process-wide to molecules evaluated afterwards
+     * and take precedence over the built-in tables. They are frozen into
+     * the same perfect hash table as the built-in names on the next
+     * classification, so lookups stay allocation-free.
+     *
+     * @param name Residue name of 1 to 4 characters (surrounding whitespace ignored).
+     * @param flag Component flags for the residue.
+     * @throws SelectionError if the name is too long, the flag is NONE, or
+     *         1024 residue classes are already registered.
+     */
+    static void RegisterResidueClass(const std::string& name, ComponentFlag flag);
+
+    /**
+     * @brief Register residue classes from a text file.
+     *
+     * Each line holds a residue name and a component keyword (protein,
+     * ligand, solvent, cofactor, nucleic, water, lipid, glycan), separated
+     * by whitespace. Text after '#' is ignored. The file is validated in
+     * full before any entry is registered.
+     *
+     * @code
+     * # In-house residues
+     * POPC  lipid
+     * NAG   glycan
+     * XCP   protein   # custom cap
+     * @endcode
+     *
+     * @param path File to read.
+     * @throws SelectionError if the file cannot be read, a line is malformed,
+     *         or the file would take the registry past 1024 residue classes.
+     */
+    static void LoadResidueClasses(const std::string& path);
+
+    /// @brief Remove all registered residue classes, restoring the built-in tables.
+    static void ClearResidueClasses();
+
+    /**
+     * @brief Digest of the residue classes registered in this process.
+     *
+     * Equal for equal sets of registrations regardless of the order they
+     * were made in, and 0 when only the built-in tables are in effect.
+     * Persisted tables that carry component flags record it so a file
+     * saved under different registrations is not reused.
+     *
+     * @return 64-bit digest of the registrations.
+     */
+    [[nodiscard]] static std::uint64_t ResidueClassDigest();
+
     /**
      * @brief Tag all atoms in a molecule with component flags.
      *
@@ -0,0 +1,82 @@
+/**
+ * @file UnitCell.h
+ * @brief Periodic simulation box for minimum-image distance queries.
+ */
+
+#ifndef OESELECT_UNIT_CELL_H
+#define OESELECT_UNIT_CELL_H
+
+#include <cmath>
+
+#include "oeselect/Error.h"
+
+namespace OESel {
+
+/**
+ * @brief Periodic box of a simulation system.
+ *
+ * A default-constructed cell is non-periodic. With a periodic cell,
+ * distance selections (around, expand, beyond) measure the distance to
+ * the nearest periodic image of each atom, so solvent across a box face
+ * is found without replicating the system.
+ *
+ * Only orthorhombic boxes are supported. Coordinates may lie anywhere;
+ * they are wrapped into the box when indexed.
+ *
+ * @code
+ * OESelect waters(mol, "water around 3.5");
+ * waters.SetUnitCell(UnitCell::Orthorhombic(62.0f, 62.0f, 62.0f));
+ * @endcode
+ */
+class UnitCell {
+public:
+    /// @brief Construct a non-periodic cell.
+    UnitCell() = default;
+
+    /**
+     * @brief Construct an orthorhombic cell.
+     * @param a Box length along x in Angstroms.
+     * @param b Box length along y in Angstroms.
+     * @param c Box length along z in Angstroms.
+     * @return Periodic cell with the given edge lengths.
+     * @throws SelectionError if a length is not positive and finite.
+     */
+    [[nodiscard]] static UnitCell Orthorhombic(const float a, const float b, const float c) {
+        for (const float length : {a, b, c}) {
+            if (!std::isfinite(length) || !(length > 0.0f)) {
+                throw SelectionError("Unit cell lengths must be positive and finite");
+            }
+        }
+        UnitCell cell;
+        cell.lengths_[0] = a;
+        cell.lengths_[1] = b;
+        cell.lengths_[2] = c;
+        return cell;
+    }
+
+    /// @brief Whether distances are measured between periodic images.
+    [[nodiscard]] bool IsPeriodic() const { return lengths_[0] > 0.0f; }
+
+    /**
+     * @brief Box length along one axis.
+     * @param axis 0, 1, or 2 for x, y, or z.
+     * @return Length in Angstroms, or 0 for a non-periodic cell.
+     */
+    [[nodiscard]] float Length(const int axis) const { return lengths_[axis]; }
+
+    /// @brief Whether two cells describe the same box.
+    bool operator==(const UnitCell& other) const {
+        return lengths_[0] == other.lengths_[0] && lengths_[1] == other.lengths_[1] &&
+               lengths_[2] == other.lengths_[2];
+    }
+
+    /// @brief Whether two cells describe different boxes.
+    bool operator!=(const UnitCell& other) const { return !(*this == other); }
+
+private:
+    float lengths_[3] = {0.0f, 0.0f, 0.0f};
+};
+
+}  // namespace OESel
+
+#endif  // OESELECT_UNIT_CELL_H
@@ -33,22 +33,40 @@
 namespace OESel {
 
 // Forward declarations
+class AtomTable;
+class BatchEvaluator;
+class Bitset;
 class OESelection;
 class OESelect;
+class OESelectionResult;
 class Context;
 class Predicate;
+class StreamFilter;
+class TableCache;
 class Tagger;
 
 }  // namespace OESel
 
 #include "oeselect/Error.h"
+#include "oeselect/AtomTable.h"
+#include "oeselect/BondGraph.h"
+#include "oeselect/Bitset.h"
 #include "oeselect/Predicate.h"
 #include "oeselect/Selection.h"
+#include "oeselect/SelectionSet.h"
+#include "oeselect/SelectionResult.h"
+#include "oeselect/Contacts.h"
+#include "oeselect/UnitCell.h"
+#include "oeselect/Program.h"
 #include "oeselect/Selector.h"
 #include "oeselect/Context.h"
+#include "oeselect/Profile.h"
 #include "oeselect/Parser.h"
 #include "oeselect/Tagger.h"
 #include "oeselect/ResidueSelector.h"
 #include "oeselect/CustomPredicates.h"
+#include "oeselect/BatchEvaluator.h"
+#include "oeselect/StreamFilter.h"
+#include "oeselect/TableCache.h"
 
 #endif  // OESELECT_OESELECT_H
@@ -10,10 +10,14 @@
 #define OESELECT_PREDICATES_ATOM_PROPERTY_PREDICATES_H
 
 #include "oeselect/Predicate.h"
+#include <memory>
 #include <string>
+#include <vector>
 
 namespace OESel {
 
+class GlobMatcher;
+
 /**
  * @brief Matches atoms by residue name.
  *
@@ -32,13 +36,23 @@ public:
      */
     explicit ResnPredicate(std::string pattern);
 
+    /**
+     * @brief Construct a predicate matching any of several patterns.
+     * @param patterns Residue names or glob patterns (at least one).
+     */
+    explicit ResnPredicate(std::vector<std::string> patterns);
+
+    /// @brief Patterns in the order given.
+    [[nodiscard]] const std::vector<std::string>& Patterns() const { return patterns_; }
+
     bool Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const override;
+    void EvaluateAll(Context& ctx, Bitset& out) const override;
     [[nodiscard]] std::string ToCanonical() const override;
     [[nodiscard]] PredicateType Type() const override { return PredicateType::RESN; }
 
 private:
-    std::string pattern_;
-    bool has_wildcard_;
+    std::vector<std::string> patterns_;
+    std::shared_ptr<const GlobMatcher> matcher_;
 };
 
 /**
@@ -72,6 +86,7 @@ public:
     ResiPredicate(int start, int end);
 
     bool Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const override;
+    void EvaluateAll(Context& ctx, Bitset& out) const override;
     [[nodiscard]] std::string ToCanonical() const override;
     [[nodiscard]] PredicateType Type() const override { return PredicateType::RESI; }
 
@@ -99,6 +114,7 @@ public:
     explicit ChainPredicate(std::string chain_id);
 
     bool Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const override;
+    void EvaluateAll(Context& ctx, Bitset& out) const override;
     [[nodiscard]] std::string ToCanonical() const override;
     [[nodiscard]] PredicateType Type() const override { return PredicateType::CHAIN; }
 
@@ -126,6 +142,7 @@ public:
     explicit ElemPredicate(const std::string& element);
 
     bool Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const override;
+    void EvaluateAll(Context& ctx, Bitset& out) const override;
     [[nodiscard]] std::string ToCanonical() const override;
     [[nodiscard]] PredicateType Type() const override { return PredicateType::ELEM; }
 
@@ -166,6 +183,7 @@ public:
     IndexPredicate(unsigned int start, unsigned int end);
 
     bool Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const override;
+    void EvaluateAll(Context& ctx, Bitset& out) const override;
     [[nodiscard]] std::string ToCanonical() const override;
     [[nodiscard]] PredicateType Type() const override { return PredicateType::INDEX; }
 
@@ -207,6 +225,7 @@ public:
     IdPredicate(int start, int end);
 
     bool Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const override;
+    void EvaluateAll(Context& ctx, Bitset& out) const override;
     [[nodiscard]] std::string ToCanonical() const override;
     [[nodiscard]] PredicateType Type() const override { return PredicateType::ID; }
 
@@ -234,6 +253,7 @@ public:
     explicit AltPredicate(std::string alt_id);
 
     bool Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const override;
+    void EvaluateAll(Context& ctx, Bitset& out) const override;
     [[nodiscard]] std::string ToCanonical() const override;
     [[nodiscard]] PredicateType Type() const override { return PredicateType::ALT; }
 
@@ -274,6 +294,7 @@ public:
     BFactorPredicate(float start, float end);
 
     bool Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const override;
+    void EvaluateAll(Context& ctx, Bitset& out) const override;
     [[nodiscard]] std::string ToCanonical() const override;
     [[nodiscard]] PredicateType Type() const override { return PredicateType::B_FACTOR; }
 
@@ -315,6 +336,7 @@ public:
     FragmentPredicate(unsigned int start, unsigned int end);
 
     bool Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const override;
+    void EvaluateAll(Context& ctx, Bitset& out) const override;
     [[nodiscard]] std::string ToCanonical() const override;
     [[nodiscard]] PredicateType Type() const override { return PredicateType::FRAGMENT; }
 
@@ -47,6 +47,7 @@ public:
 class PolarHydrogenPredicate : public Predicate {
 public:
     bool Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const override;
+    void EvaluateAll(Context& ctx, Bitset& out) const override;
     [[nodiscard]] std::string ToCanonical() const override { return "polar_hydrogen"; }
     [[nodiscard]] PredicateType Type() const override { return PredicateType::POLAR_HYDROGEN; }
 };
@@ -60,6 +61,7 @@ public:
 class NonpolarHydrogenPredicate : public Predicate {
 public:
     bool Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const override;
+    void EvaluateAll(Context& ctx, Bitset& out) const override;
     [[nodiscard]] std::string ToCanonical() const override { return "nonpolar_hydrogen"; }
     [[nodiscard]] PredicateType Type() const override { return PredicateType::NONPOLAR_HYDROGEN; }
 };
@@ -3,7 +3,7 @@
  * @brief Molecular component predicates (protein, ligand, water, etc.).
  *
  * These predicates classify atoms based on their molecular context,
- * using the Tagger system for residue-based classification.
+ * using the Tagger residue classification stored in the AtomTable.
  */
 
 #ifndef OESELECT_PREDICATES_COMPONENT_PREDICATES_H
@@ -22,6 +22,7 @@ namespace OESel {
 class ProteinPredicate : public Predicate {
 public:
     bool Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const override;
+    void EvaluateAll(Context& ctx, Bitset& out) const override;
     [[nodiscard]] std::string ToCanonical() const override { return "protein"; }
     [[nodiscard]] PredicateType Type() const override { return PredicateType::PROTEIN; }
 };
@@ -36,6 +37,7 @@ public:
 class LigandPredicate : public Predicate {
 public:
     bool Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const override;
+    void EvaluateAll(Context& ctx, Bitset& out) const override;
     [[nodiscard]] std::string ToCanonical() const override { return "ligand"; }
     [[nodiscard]] PredicateType Type() const override { return PredicateType::LIGAND; }
 };
@@ -48,6 +50,7 @@ public:
 class WaterPredicate : public Predicate {
 public:
     bool Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const override;
+    void EvaluateAll(Context& ctx, Bitset& out) const override;
     [[nodiscard]] std::string ToCanonical() const override { return "water"; }
     [[nodiscard]] PredicateType Type() const override { return PredicateType::WATER; }
 };
@@ -61,10 +64,41 @@ public:
 class SolventPredicate : public Predicate {
 public:
     bool Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const override;
+    void EvaluateAll(Context& ctx, Bitset& out) const override;
     [[nodiscard]] std::string ToCanonical() const override { return "solvent"; }
     [[nodiscard]] PredicateType Type() const override { return PredicateType::SOLVENT; }
 };
 
+/**
+ * @brief Matches atoms in lipid residues.
+ *
+ * Recognizes common membrane lipids and sterols (POPC, POPE, DPPC, CHL1,
+ * CLR, ...) plus any residue registered with Tagger::RegisterResidueClass()
+ * as ComponentFlag::LIPID.
+ */
+class LipidPredicate : public Predicate {
+public:
+    bool Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const override;
+    void EvaluateAll(Context& ctx, Bitset& out) const override;
+    [[nodiscard]] std::string ToCanonical() const override { return "lipid"; }
+    [[nodiscard]] PredicateType Type() const override { return PredicateType::LIPID; }
+};
+
+/**
+ * @brief Matches atoms in carbohydrate residues.
+ *
+ * Recognizes common monosaccharide codes (NAG, MAN, BMA, GAL, FUC, SIA, ...)
+ * plus any residue registered with Tagger::RegisterResidueClass() as
+ * ComponentFlag::GLYCAN.
+ */
+class GlycanPredicate : public Predicate {
+public:
+    bool Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const override;
+    void EvaluateAll(Context& ctx, Bitset& out) const override;
+    [[nodiscard]] std::string ToCanonical() const override { return "glycan"; }
+    [[nodiscard]] PredicateType Type() const override { return PredicateType::GLYCAN; }
+};
+
 /**
  * @brief Matches atoms in organic molecules.
  *
@@ -74,6 +108,7 @@ public:
 class OrganicPredicate : public Predicate {
 public:
     bool Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const override;
+    void EvaluateAll(Context& ctx, Bitset& out) const override;
     [[nodiscard]] std::string ToCanonical() const override { return "organic"; }
     [[nodiscard]] PredicateType Type() const override { return PredicateType::ORGANIC; }
 };
@@ -4,6 +4,7 @@
  *
  * These predicates select atoms based on spatial proximity to a reference
  * selection. They use a k-d tree spatial index for efficient queries.
+ * NearestPredicate ranks atoms by distance instead of applying a cutoff.
  */
 
 #ifndef OESELECT_PREDICATES_DISTANCE_PREDICATES_H
@@ -35,16 +36,22 @@ public:
     AroundPredicate(float radius, Ptr reference);
 
     bool Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const override;
+    void EvaluateAll(Context& ctx, Bitset& out) const override;
+    void EvaluateWithin(Context& ctx, const Bitset& domain, Bitset& out) const override;
     [[nodiscard]] std::string ToCanonical() const override;
+    [[nodiscard]] std::string CacheKey() const override;
     [[nodiscard]] PredicateType Type() const override { return PredicateType::AROUND; }
     [[nodiscard]] std::vector<Ptr> Children() const override { return {reference_}; }
 
+    /// @brief Distance threshold in Angstroms.
+    [[nodiscard]] float Radius() const { return radius_; }
+
 private:
     float radius_;
     Ptr reference_;
 
-    /// Compute and cache the boolean mask of nearby atoms
-    const std::vector<bool>& GetAroundMask(Context& ctx) const;
+    /// Compute and cache the mask of nearby atoms
+    const Bitset& GetAroundMask(Context& ctx) const;
 };
 
 /**
@@ -69,16 +76,22 @@ public:
     ExpandPredicate(float radius, Ptr reference);
 
     bool Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const override;
+    void EvaluateAll(Context& ctx, Bitset& out) const override;
+    void EvaluateWithin(Context& ctx, const Bitset& domain, Bitset& out) const override;
     [[nodiscard]] std::string ToCanonical() const override;
+    [[nodiscard]] std::string CacheKey() const override;
     [[nodiscard]] PredicateType Type() const override { return PredicateType::EXPAND; }
     [[nodiscard]] std::vector<Ptr> Children() const override { return {reference_}; }
 
+    /// @brief Distance threshold in Angstroms.
+    [[nodiscard]] float Radius() const { return radius_; }
+
 private:
     float radius_;
     Ptr reference_;
 
-    /// Compute and cache the boolean mask (shared with AroundPredicate)
-    const std::vector<bool>& GetAroundMask(Context& ctx) const;
+    /// Compute and cache the mask of nearby atoms (shared with AroundPredicate)
+    const Bitset& GetAroundMask(Context& ctx) const;
 };
 
 /**
@@ -103,16 +116,72 @@ public:
     BeyondPredicate(float radius, Ptr reference);
 
     bool Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const override;
+    void EvaluateAll(Context& ctx, Bitset& out) const override;
+    void EvaluateWithin(Context& ctx, const Bitset& domain, Bitset& out) const override;
     [[nodiscard]] std::string ToCanonical() const override;
+    [[nodiscard]] std::string CacheKey() const override;
     [[nodiscard]] PredicateType Type() const override { return PredicateType::BEYOND; }
     [[nodiscard]] std::vector<Ptr> Children() const override { return {reference_}; }
 
+    /// @brief Distance threshold in Angstroms.
+    [[nodiscard]] float Radius() const { return radius_; }
+
 private:
     float radius_;
     Ptr reference_;
 
     /// Compute and cache the around mask (inverted for beyond logic)
-    const std::vector<bool>& GetAroundMask(Context& ctx) const;
+    const Bitset& GetAroundMask(Context& ctx) const;
+};
+
+/**
+ * @brief Selects the candidate atoms (or residues) nearest to a reference selection.
+ *
+ * Candidates are ranked by their distance to the closest reference atom,
+ * ties broken by atom index, and the first Count() are matched. Reference
+ * atoms are never candidates. In residue mode, residues are ranked by
+ * their closest candidate atom and every atom of the first Count()
+ * residues is matched. Fewer are matched when fewer candidates exist.
+ *
+ * @code
+ * // Selection: nearest 20 water to ligand
+ * // Matches the 20 water atoms closest to any ligand atom
+ * // Selection: nearest 5 byres water to ligand
+ * // Matches the 5 water molecules closest to the ligand
+ * @endcode
+ */
+class NearestPredicate : public Predicate {
+public:
+    /**
+     * @brief Construct nearest predicate.
+     * @param count Positive number of atoms or residues to match.
+     * @param by_residue Rank whole residues instead of atoms.
+     * @param candidates Selection the matched atoms are drawn from.
+     * @param reference Reference selection for distance calculation.
+     * @throws SelectionError if @p count is zero.
+     */
+    NearestPredicate(unsigned int count, bool by_residue, Ptr candidates, Ptr reference);
+
+    bool Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const override;
+    void EvaluateAll(Context& ctx, Bitset& out) const override;
+    [[nodiscard]] std::string ToCanonical() const override;
+    [[nodiscard]] PredicateType Type() const override { return PredicateType::NEAREST; }
+    [[nodiscard]] std::vector<Ptr> Children() const override { return {candidates_, reference_}; }
+
+    /// @brief Number of atoms or residues matched.
+    [[nodiscard]] unsigned int Count() const { return count_; }
+
+    /// @brief Whether whole residues are ranked.
+    [[nodiscard]] bool ByResidue() const { return by_residue_; }
+
+private:
+    unsigned int count_;
+    bool by_residue_;
+    Ptr candidates_;
+    Ptr reference_;
+
+    /// Compute and cache the mask of matched atoms
+    const Bitset& GetNearestMask(Context& ctx) const;
 };
 
 }  // namespace OESel
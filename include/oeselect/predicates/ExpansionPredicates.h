@@ -1,16 +1,16 @@
 /**
  * @file ExpansionPredicates.h
- * @brief Selection expansion predicates (byres, bychain).
+ * @brief Selection expansion predicates (byres, bychain, bound_to, extend).
  *
  * These predicates expand a selection to include complete structural
- * units (residues or chains) containing any matching atoms.
+ * units (residues or chains) containing any matching atoms, or atoms
+ * reachable from matching atoms through the bond graph.
  */
 
 #ifndef OESELECT_PREDICATES_EXPANSION_PREDICATES_H
 #define OESELECT_PREDICATES_EXPANSION_PREDICATES_H
 
 #include "oeselect/Predicate.h"
-#include <unordered_set>
 
 namespace OESel {
 
@@ -35,6 +35,7 @@ public:
     explicit ByResPredicate(Ptr child);
 
     bool Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const override;
+    void EvaluateAll(Context& ctx, Bitset& out) const override;
     [[nodiscard]] std::string ToCanonical() const override;
     [[nodiscard]] PredicateType Type() const override { return PredicateType::BY_RES; }
     [[nodiscard]] std::vector<Ptr> Children() const override { return {child_}; }
@@ -42,8 +43,8 @@ public:
 private:
     Ptr child_;
 
-    /// Get cached set of atom indices in matching residues
-    const std::unordered_set<unsigned int>& GetMatchingResidues(Context& ctx) const;
+    /// Get cached mask of atoms in matching residues
+    const Bitset& GetMatchingResidues(Context& ctx) const;
 };
 
 /**
@@ -67,6 +68,7 @@ public:
     explicit ByChainPredicate(Ptr child);
 
     bool Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const override;
+    void EvaluateAll(Context& ctx, Bitset& out) const override;
     [[nodiscard]] std::string ToCanonical() const override;
     [[nodiscard]] PredicateType Type() const override { return PredicateType::BY_CHAIN; }
     [[nodiscard]] std::vector<Ptr> Children() const override { return {child_}; }
@@ -74,8 +76,79 @@ public:
 private:
     Ptr child_;
 
-    /// Get cached set of atom indices in matching chains
-    const std::unordered_set<unsigned int>& GetMatchingChainAtoms(Context& ctx) const;
+    /// Get cached mask of atoms in matching chains
+    const Bitset& GetMatchingChainAtoms(Context& ctx) const;
+};
+
+/**
+ * @brief Selects atoms bonded to the child selection.
+ *
+ * Matches every atom directly bonded to at least one atom matching the
+ * child selection. Child atoms are included only if they are bonded to
+ * another child atom.
+ *
+ * @code
+ * // Selection: bound_to metal
+ * // Selects the atoms coordinating a metal by a bond
+ * @endcode
+ */
+class BoundToPredicate : public Predicate {
+public:
+    /**
+     * @brief Construct bonded neighbour predicate.
+     * @param child Selection whose neighbours are selected.
+     */
+    explicit BoundToPredicate(Ptr child);
+
+    bool Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const override;
+    void EvaluateAll(Context& ctx, Bitset& out) const override;
+    [[nodiscard]] std::string ToCanonical() const override;
+    [[nodiscard]] PredicateType Type() const override { return PredicateType::BOUND_TO; }
+    [[nodiscard]] std::vector<Ptr> Children() const override { return {child_}; }
+
+private:
+    Ptr child_;
+
+    /// Get cached mask of atoms bonded to the child selection
+    const Bitset& GetBondedAtoms(Context& ctx) const;
+};
+
+/**
+ * @brief Grows the child selection along bonds.
+ *
+ * Matches the child selection plus every atom within the given number of
+ * bonds of it, found by a breadth-first search over the bond graph that
+ * stops early once no new atoms are reached.
+ *
+ * @code
+ * // Selection: ligand extend 2
+ * // Selects the ligand and atoms up to two bonds away (e.g. covalent attachments)
+ * @endcode
+ */
+class ExtendPredicate : public Predicate {
+public:
+    /**
+     * @brief Construct bond extension predicate.
+     * @param bonds Number of bonds to extend by.
+     * @param child Selection to extend.
+     */
+    ExtendPredicate(unsigned int bonds, Ptr child);
+
+    bool Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const override;
+    void EvaluateAll(Context& ctx, Bitset& out) const override;
+    [[nodiscard]] std::string ToCanonical() const override;
+    [[nodiscard]] PredicateType Type() const override { return PredicateType::EXTEND; }
+    [[nodiscard]] std::vector<Ptr> Children() const override { return {child_}; }
+
+    /// @brief Get the number of bonds the selection is extended by.
+    [[nodiscard]] unsigned int Bonds() const { return bonds_; }
+
+private:
+    unsigned int bonds_;
+    Ptr child_;
+
+    /// Get cached mask of atoms within bonds_ bonds of the child selection
+    const Bitset& GetExtendedAtoms(Context& ctx) const;
 };
 
 }  // namespace OESel
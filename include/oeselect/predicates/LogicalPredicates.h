@@ -18,6 +18,7 @@ namespace OESel {
  * @brief Logical AND predicate - all children must match.
  *
  * Evaluates children in order and short-circuits on first false result.
+ * Bulk evaluation intersects child bitsets and stops once nothing remains.
  * An empty AND predicate matches all atoms.
  */
 class AndPredicate : public Predicate {
@@ -29,6 +30,7 @@ public:
     explicit AndPredicate(std::vector<Ptr> children);
 
     bool Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const override;
+    void EvaluateAll(Context& ctx, Bitset& out) const override;
     [[nodiscard]] std::string ToCanonical() const override;
     [[nodiscard]] PredicateType Type() const override { return PredicateType::AND; }
     [[nodiscard]] std::vector<Ptr> Children() const override { return children_; }
@@ -41,6 +43,7 @@ private:
  * @brief Logical OR predicate - any child must match.
  *
  * Evaluates children in order and short-circuits on first true result.
+ * Bulk evaluation takes the union of child bitsets.
  * An empty OR predicate matches no atoms.
  */
 class OrPredicate : public Predicate {
@@ -52,6 +55,8 @@ public:
     explicit OrPredicate(std::vector<Ptr> children);
 
     bool Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const override;
+    void EvaluateAll(Context& ctx, Bitset& out) const override;
+    void EvaluateWithin(Context& ctx, const Bitset& domain, Bitset& out) const override;
     [[nodiscard]] std::string ToCanonical() const override;
     [[nodiscard]] PredicateType Type() const override { return PredicateType::OR; }
     [[nodiscard]] std::vector<Ptr> Children() const override { return children_; }
@@ -74,6 +79,8 @@ public:
     explicit NotPredicate(Ptr child);
 
     bool Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const override;
+    void EvaluateAll(Context& ctx, Bitset& out) const override;
+    void EvaluateWithin(Context& ctx, const Bitset& domain, Bitset& out) const override;
     [[nodiscard]] std::string ToCanonical() const override;
     [[nodiscard]] PredicateType Type() const override { return PredicateType::NOT; }
     [[nodiscard]] std::vector<Ptr> Children() const override { return {child_}; }
@@ -97,6 +104,7 @@ public:
     explicit XOrPredicate(std::vector<Ptr> children);
 
     bool Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const override;
+    void EvaluateAll(Context& ctx, Bitset& out) const override;
     [[nodiscard]] std::string ToCanonical() const override;
     [[nodiscard]] PredicateType Type() const override { return PredicateType::XOR; }
     [[nodiscard]] std::vector<Ptr> Children() const override { return children_; }
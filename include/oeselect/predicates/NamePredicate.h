@@ -9,10 +9,14 @@
 #define OESELECT_PREDICATES_NAME_PREDICATE_H
 
 #include "oeselect/Predicate.h"
+#include <memory>
 #include <string>
+#include <vector>
 
 namespace OESel {
 
+class GlobMatcher;
+
 /**
  * @brief Matches atoms by name with optional glob patterns.
  *
@@ -27,7 +31,13 @@ namespace OESel {
  * // Wildcard patterns
  * NamePredicate("C*")   // Matches CA, CB, CG, etc.
  * NamePredicate("?G")   // Matches CG, OG, etc.
+ *
+ * // Several patterns compiled into one matcher
+ * NamePredicate({"CA", "CB", "C*"})
  * @endcode
+ *
+ * Patterns are compiled once at construction. Bulk evaluation matches
+ * each distinct interned atom name once and then scans the id column.
  */
 class NamePredicate : public Predicate {
 public:
@@ -37,13 +47,23 @@ public:
      */
     explicit NamePredicate(std::string pattern);
 
+    /**
+     * @brief Construct a predicate matching any of several patterns.
+     * @param patterns Atom names or glob patterns (at least one).
+     */
+    explicit NamePredicate(std::vector<std::string> patterns);
+
+    /// @brief Patterns in the order given.
+    [[nodiscard]] const std::vector<std::string>& Patterns() const { return patterns_; }
+
     bool Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const override;
+    void EvaluateAll(Context& ctx, Bitset& out) const override;
     [[nodiscard]] std::string ToCanonical() const override;
     [[nodiscard]] PredicateType Type() const override { return PredicateType::NAME; }
 
 private:
-    std::string pattern_;    ///< Name pattern (may contain wildcards)
-    bool has_wildcard_;      ///< True if pattern contains * or ?
+    std::vector<std::string> patterns_;           ///< Name patterns (may contain wildcards)
+    std::shared_ptr<const GlobMatcher> matcher_;  ///< Patterns compiled for matching
 };
 
 }  // namespace OESel
@@ -0,0 +1,54 @@
+/**
+ * @file NamedSetPredicate.h
+ * @brief Predicate matching a stored result bound to a name.
+ *
+ * Lets a parsed selection refer to an OESelectionResult computed earlier,
+ * e.g. a binding site stored from a previous frame.
+ */
+
+#ifndef OESELECT_PREDICATES_NAMED_SET_PREDICATE_H
+#define OESELECT_PREDICATES_NAMED_SET_PREDICATE_H
+
+#include "oeselect/Predicate.h"
+#include <string>
+
+namespace OESel {
+
+/**
+ * @brief Matches the members of a named set bound on the context.
+ *
+ * The set is looked up at evaluation time, so one parsed selection can be
+ * evaluated against different bindings (see Context::SetNamedSet()). The
+ * lookup is resolved to a mask once per context and cached.
+ *
+ * @code
+ * // Selection: %site and not water
+ * // Selection: byres (%site around 4)
+ * @endcode
+ */
+class NamedSetPredicate : public Predicate {
+public:
+    /**
+     * @brief Construct named set predicate.
+     * @param name Set name without the leading '%'.
+     */
+    explicit NamedSetPredicate(std::string name);
+
+    /// @brief Set name without the leading '%'.
+    [[nodiscard]] const std::string& Name() const { return name_; }
+
+    bool Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const override;
+    void EvaluateAll(Context& ctx, Bitset& out) const override;
+    [[nodiscard]] std::string ToCanonical() const override;
+    [[nodiscard]] PredicateType Type() const override { return PredicateType::NAMED_SET; }
+
+private:
+    std::string name_;
+
+    /// Get cached mask of the bound set's atoms still present in the molecule
+    const Bitset& GetMatchingAtoms(Context& ctx) const;
+};
+
+}  // namespace OESel
+
+#endif  // OESELECT_PREDICATES_NAMED_SET_PREDICATE_H
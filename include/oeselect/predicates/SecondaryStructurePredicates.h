@@ -22,6 +22,7 @@ namespace OESel {
 class HelixPredicate : public Predicate {
 public:
     bool Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const override;
+    void EvaluateAll(Context& ctx, Bitset& out) const override;
     [[nodiscard]] std::string ToCanonical() const override { return "helix"; }
     [[nodiscard]] PredicateType Type() const override { return PredicateType::HELIX; }
 };
@@ -34,6 +35,7 @@ public:
 class SheetPredicate : public Predicate {
 public:
     bool Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const override;
+    void EvaluateAll(Context& ctx, Bitset& out) const override;
     [[nodiscard]] std::string ToCanonical() const override { return "sheet"; }
     [[nodiscard]] PredicateType Type() const override { return PredicateType::SHEET; }
 };
@@ -46,6 +48,7 @@ public:
 class TurnPredicate : public Predicate {
 public:
     bool Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const override;
+    void EvaluateAll(Context& ctx, Bitset& out) const override;
     [[nodiscard]] std::string ToCanonical() const override { return "turn"; }
     [[nodiscard]] PredicateType Type() const override { return PredicateType::TURN; }
 };
@@ -59,6 +62,7 @@ public:
 class LoopPredicate : public Predicate {
 public:
     bool Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const override;
+    void EvaluateAll(Context& ctx, Bitset& out) const override;
     [[nodiscard]] std::string ToCanonical() const override { return "loop"; }
     [[nodiscard]] PredicateType Type() const override { return PredicateType::LOOP; }
 };
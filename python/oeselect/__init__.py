@@ -74,6 +74,8 @@ Distance-based:
 Expansion:
     - byres <selection>: Expand to complete residues
     - bychain <selection>: Expand to complete chains
+    - bound_to <selection>: Atoms bonded to selection
+    - <selection> extend <bonds>: Selection plus atoms within that many bonds
 
 Logical operators:
     - and / &: Logical AND
@@ -93,13 +95,16 @@ Hierarchical macro syntax:
     - //chain/resi/name: e.g., //A/100/CA
 """
 
+import functools
 import hashlib
 import importlib.machinery
 import importlib.util
+import json
 import os
 import re
 import shutil
 import sys
+import time
 import warnings
 from importlib import metadata
 from pathlib import Path
@@ -111,6 +116,11 @@ __version_info__ = (1, 3, 8)
 _OPENEYE_COMPAT_PRELOAD_PATHS: list[str] = []
 _OPENEYE_COMPAT_EXTENSION_DIR: Path | None = None
 
+# Bump when the recorded import state changes shape or meaning
+_IMPORT_STATE_VERSION = 1
+_IMPORT_TIMINGS: dict[str, float] = {}
+_IMPORT_MODE = "cold"
+
 
 def _user_cache_root():
     """Return the per-user cache root for OpenEye compatibility aliases."""
@@ -120,6 +130,7 @@ def _user_cache_root():
     return Path.home() / ".cache" / "oeselect"
 
 
+@functools.lru_cache(maxsize=None)
 def _runtime_openeye_version():
     """Return the installed OpenEye toolkit distribution version if available."""
     try:
@@ -152,8 +163,8 @@ def _runtime_shared_library_names(lib_names):
     ]
 
 
-def _find_openeye_runtime_lib_dir(expected_libs=()):
-    """Find the OpenEye runtime library directory without importing oechem."""
+def _openeye_search_locations():
+    """Return the openeye package directories without importing openeye."""
     search_locations = []
     openeye_module = sys.modules.get("openeye")
     openeye_path = getattr(openeye_module, "__path__", None)
@@ -170,7 +181,12 @@ def _find_openeye_runtime_lib_dir(expected_libs=()):
             and openeye_spec.submodule_search_locations is not None
         ):
             search_locations.extend(openeye_spec.submodule_search_locations)
+    return search_locations
+
 
+def _find_openeye_runtime_lib_dir(expected_libs=()):
+    """Find the OpenEye runtime library directory without importing oechem."""
+    search_locations = _openeye_search_locations()
     expected_libs = set(_runtime_shared_library_names(expected_libs or ()))
     fallback_dir = None
     for package_root in search_locations:
@@ -358,7 +374,11 @@ def _copy_if_stale(source_path, target_path):
 
 
 def _copy_package_shared_sidecars(pkg_dir, cache_dir, extension_path):
-    """Copy package-local shared library sidecars needed by cached extension."""
+    """Copy package-local shared library sidecars needed by cached extension.
+
+    Returns the source paths that were mirrored into the cache.
+    """
+    copied = []
     for candidate in Path(pkg_dir).iterdir():
         name = candidate.name
         if not candidate.is_file() or candidate == extension_path:
@@ -371,36 +391,53 @@ def _copy_package_shared_sidecars(pkg_dir, cache_dir, extension_path):
         ):
             continue
         _copy_if_stale(candidate, cache_dir / name)
+        copied.append(str(candidate))
+    return copied
 
 
 def _load_cached_extension_if_needed():
-    """Load _oeselect from the cache when OpenEye aliases live there."""
+    """Load _oeselect from the cache when OpenEye aliases live there.
+
+    Returns ``(cached_extension_path, source_paths)`` when the extension was
+    loaded from the cache, where ``source_paths`` are the package files the
+    cached copies mirror, or ``None`` when the packaged extension is used.
+    """
     cache_dir = _OPENEYE_COMPAT_EXTENSION_DIR
     if cache_dir is None:
-        return
+        return None
 
     module_name = f"{__name__}._oeselect"
     if module_name in sys.modules:
-        return
+        return None
 
     pkg_dir = os.path.dirname(__file__)
     extension_path = _find_extension_module_path(pkg_dir)
     if extension_path is None:
-        return
+        return None
 
     cached_extension_path = cache_dir / extension_path.name
     try:
         cache_dir.mkdir(parents=True, exist_ok=True)
         _copy_if_stale(extension_path, cached_extension_path)
-        _copy_package_shared_sidecars(pkg_dir, cache_dir, extension_path)
+        sidecars = _copy_package_shared_sidecars(pkg_dir, cache_dir, extension_path)
     except OSError as exc:
         raise ImportError(
             f"Could not prepare cached oeselect extension in {cache_dir}: {exc}"
         ) from exc
 
-    spec = importlib.util.spec_from_file_location(module_name, cached_extension_path)
+    _exec_extension_module(cached_extension_path)
+    return str(cached_extension_path), [str(extension_path), *sidecars]
+
+
+def _exec_extension_module(extension_path):
+    """Import the _oeselect extension from an explicit file path."""
+    module_name = f"{__name__}._oeselect"
+    if module_name in sys.modules:
+        return
+
+    spec = importlib.util.spec_from_file_location(module_name, extension_path)
     if spec is None or spec.loader is None:
-        raise ImportError(f"Could not create import spec for {cached_extension_path}")
+        raise ImportError(f"Could not create import spec for {extension_path}")
 
     module = importlib.util.module_from_spec(spec)
     sys.modules[module_name] = module
@@ -425,32 +462,33 @@ def _preload_shared_libs():
     library directory (which can contain 70+ unrelated shared objects)
     would pollute the global symbol namespace and cause segfaults in
     unrelated C extensions such as ``_sqlite3``.
+
+    Returns the library paths passed to the dynamic loader.
     """
-    import ctypes
     import sys
     if sys.platform not in ('linux', 'darwin'):
-        return
+        return []
 
     try:
         from . import _build_info
     except ImportError:
-        return
+        return []
 
     if getattr(_build_info, 'OPENEYE_LIBRARY_TYPE', 'STATIC') != 'SHARED':
-        return
+        return []
 
     expected_libs = _runtime_shared_library_names(
         getattr(_build_info, 'OPENEYE_EXPECTED_LIBS', [])
     )
     if not expected_libs:
-        return
+        return []
 
     oe_lib_dir = _find_openeye_runtime_lib_dir(expected_libs)
     if oe_lib_dir is None:
-        return
+        return []
 
     if not os.path.isdir(oe_lib_dir):
-        return
+        return []
 
     paths = _OPENEYE_COMPAT_PRELOAD_PATHS
     if not paths:
@@ -460,12 +498,9 @@ def _preload_shared_libs():
             if os.path.exists(os.path.join(oe_lib_dir, lib_name))
         ]
 
-    for path in paths:
-        if os.path.exists(path) or os.path.islink(path):
-            try:
-                ctypes.CDLL(path, mode=ctypes.RTLD_GLOBAL)
-            except OSError:
-                pass
+    paths = [path for path in paths if os.path.exists(path) or os.path.islink(path)]
+    _load_shared_libs(paths, global_symbols=True)
+    return paths
 
 
 def _preload_bundled_libs():
@@ -480,17 +515,23 @@ def _preload_bundled_libs():
     Libraries may have inter-dependencies, so we do multiple passes
     until no new libraries can be loaded. Libraries are loaded without
     ``RTLD_GLOBAL`` to avoid polluting the global symbol namespace.
+
+    Returns ``(loaded, libs_dirs)``: the libraries that loaded, in load
+    order, and every candidate ``.libs`` directory that was checked.
     """
     import sys
     if sys.platform != 'linux':
-        return
+        return [], []
 
     import ctypes
+    loaded = []
+    libs_dirs = []
     pkg_name = __name__
     pkg_dir = os.path.dirname(os.path.abspath(__file__))
     site_dir = os.path.dirname(pkg_dir)
     for libs_name in (f'{pkg_name}.libs', f'.{pkg_name}.libs'):
         libs_dir = os.path.join(site_dir, libs_name)
+        libs_dirs.append(libs_dir)
         if not os.path.isdir(libs_dir):
             continue
         remaining = [
@@ -503,30 +544,48 @@ def _preload_bundled_libs():
             for lib_path in remaining:
                 try:
                     ctypes.CDLL(lib_path)
+                    loaded.append(lib_path)
                 except OSError:
                     failed.append(lib_path)
             if len(failed) == len(remaining):
                 break
             remaining = failed
+    return loaded, libs_dirs
 
 
-def _check_openeye_version():
-    """Check that the OpenEye version matches what was used at build time."""
+def _load_shared_libs(paths, global_symbols=False):
+    """Load shared libraries in order, skipping any the loader rejects."""
+    import ctypes
+    mode = ctypes.RTLD_GLOBAL if global_symbols else ctypes.DEFAULT_MODE
+    for path in paths:
+        try:
+            ctypes.CDLL(path, mode=mode)
+        except OSError:
+            pass
+
+
+def _check_openeye_version(runtime_version=None):
+    """Check that the OpenEye version matches what was used at build time.
+
+    Returns the runtime version that was compared, or ``None`` when no
+    check applies.
+    """
     try:
         from . import _build_info
     except ImportError:
         # Build info not available (development install)
-        return
+        return None
 
     # Only check if using shared/dynamic linking
     if getattr(_build_info, 'OPENEYE_LIBRARY_TYPE', 'STATIC') != 'SHARED':
-        return
+        return None
 
     build_version = getattr(_build_info, 'OPENEYE_BUILD_VERSION', None)
     if not build_version:
-        return
+        return None
 
-    runtime_version = _runtime_openeye_version()
+    if runtime_version is None:
+        runtime_version = _runtime_openeye_version()
     if runtime_version == "unknown":
         warnings.warn(
             "openeye-toolkits package not found. "
@@ -534,7 +593,7 @@ def _check_openeye_version():
             "Install with: pip install openeye-toolkits",
             ImportWarning
         )
-        return
+        return runtime_version
 
     build_parts = build_version.split('.')[:2]
     runtime_parts = runtime_version.split('.')[:2]
@@ -546,23 +605,197 @@ def _check_openeye_version():
             f"matches the version used to build oeselect.",
             RuntimeWarning
         )
+    return runtime_version
 
 
-# Prepare compatibility aliases before loading the C extension
-_ensure_library_compat()
+def _import_cache_mode():
+    """Return the import state cache mode from ``OESELECT_IMPORT_CACHE``.
+
+    ``0``/``off`` disables the cache, ``refresh`` rescans and rewrites it,
+    and anything else (the default) uses it when it validates.
+    """
+    value = os.environ.get("OESELECT_IMPORT_CACHE", "").strip().lower()
+    if value in ("0", "off", "false", "no"):
+        return "off"
+    if value == "refresh":
+        return "refresh"
+    return "on"
+
+
+def _import_state_path():
+    """Return the import state file for this package, interpreter, and path."""
+    key_data = "\n".join(
+        [
+            os.path.realpath(os.path.dirname(__file__)),
+            __version__,
+            sys.version,
+            sys.platform,
+            *_extension_suffixes(),
+            *sys.path,
+        ]
+    )
+    digest = hashlib.sha256(key_data.encode("utf-8")).hexdigest()[:16]
+    return _user_cache_root() / "import-state" / f"{digest}.json"
 
-# Preload OpenEye shared libraries (needed on Linux where RUNPATH may not
-# include the OpenEye library directory after auditwheel repair)
-_preload_shared_libs()
 
-# Preload auditwheel-bundled libraries from .libs directory
-_preload_bundled_libs()
+def _file_signature(path):
+    """Return ``[mtime_ns, size]`` of a path (following symlinks), or None."""
+    try:
+        stat = os.stat(path)
+    except OSError:
+        return None
+    return [stat.st_mtime_ns, stat.st_size]
 
-# Load the extension from the alias cache when $ORIGIN must see cached aliases
-_load_cached_extension_if_needed()
 
-# Check OpenEye version on import
-_check_openeye_version()
+def _read_import_state(state_path):
+    """Return the recorded import state if every watched file is unchanged."""
+    try:
+        state = json.loads(state_path.read_text())
+    except (OSError, ValueError):
+        return None
+    if not isinstance(state, dict) or state.get("version") != _IMPORT_STATE_VERSION:
+        return None
+    watched = state.get("files")
+    if not isinstance(watched, dict):
+        return None
+    for path, signature in watched.items():
+        if _file_signature(path) != signature:
+            return None
+    return state
+
+
+def _write_import_state(state_path, state, watched_paths):
+    """Record the import state with signatures of the files it depends on."""
+    state = dict(state)
+    state["version"] = _IMPORT_STATE_VERSION
+    state["files"] = {path: _file_signature(path) for path in sorted(set(watched_paths))}
+    partial_path = state_path.with_name(f"{state_path.name}.{os.getpid()}.partial")
+    try:
+        state_path.parent.mkdir(parents=True, exist_ok=True)
+        partial_path.write_text(json.dumps(state, indent=1))
+        os.replace(partial_path, state_path)
+    except OSError:
+        # The cache only saves work; an unwritable cache home is not an error
+        try:
+            partial_path.unlink()
+        except OSError:
+            pass
+
+
+def _timed(phase, func, *args):
+    """Call ``func`` and record its wall time under ``phase``."""
+    start = time.perf_counter()
+    try:
+        return func(*args)
+    finally:
+        _IMPORT_TIMINGS[phase] = time.perf_counter() - start
+
+
+def _prepare_extension_cold():
+    """Scan, alias, preload, and load the extension; return the state to record.
+
+    Returns ``(state, watched_paths)`` where ``state`` replays this import
+    without any directory scans and ``watched_paths`` are the files and
+    directories whose change invalidates it.
+    """
+    pkg_dir = os.path.realpath(os.path.dirname(__file__))
+    watched = [os.path.realpath(__file__), os.path.join(pkg_dir, "_build_info.py")]
+
+    # Prepare compatibility aliases before loading the C extension
+    _timed("compat", _ensure_library_compat)
+
+    # Preload OpenEye shared libraries (needed on Linux where RUNPATH may not
+    # include the OpenEye library directory after auditwheel repair)
+    preload = _timed("preload", _preload_shared_libs)
+
+    # Preload auditwheel-bundled libraries from .libs directory
+    bundled, libs_dirs = _timed("bundled", _preload_bundled_libs)
+
+    # Load the extension from the alias cache when $ORIGIN must see cached aliases
+    cached = _timed("extension", _load_cached_extension_if_needed)
+
+    # Check OpenEye version on import
+    runtime_version = _timed("version", _check_openeye_version)
+
+    # An OpenEye upgrade rewrites the package and its runtime directory
+    for location in _openeye_search_locations():
+        watched.extend([location, os.path.join(location, "__init__.py")])
+        for root, _, _ in os.walk(os.path.join(location, "libs")):
+            watched.append(root)
+    watched.extend(preload)
+    watched.extend(libs_dirs)
+    watched.extend(bundled)
+    if cached is not None:
+        watched.append(cached[0])
+        watched.extend(cached[1])
+
+    state = {
+        "preload": preload,
+        "bundled": bundled,
+        "extension": cached[0] if cached is not None else None,
+        "runtime_version": runtime_version,
+    }
+    return state, watched
+
+
+def _prepare_extension_warm(state):
+    """Replay a recorded import: load libraries and the extension directly."""
+    _timed("preload", _load_shared_libs, state["preload"], True)
+    _timed("bundled", _load_shared_libs, state["bundled"])
+    if state["extension"] is not None:
+        _timed("extension", _exec_extension_module, Path(state["extension"]))
+    _timed("version", _check_openeye_version, state["runtime_version"])
+
+
+def _prepare_extension():
+    """Get the C extension ready to import, reusing recorded state if valid.
+
+    A cold import scans the OpenEye installation, creates compatibility
+    aliases, and records what it did. A warm import whose recorded file
+    signatures still match skips the scans and copies and goes straight to
+    loading libraries and the extension. See ``OESELECT_IMPORT_CACHE``.
+    """
+    global _IMPORT_MODE
+    mode = _import_cache_mode()
+    if mode == "off":
+        _IMPORT_MODE = "off"
+        _prepare_extension_cold()
+        return
+
+    state_path = _timed("state", _import_state_path)
+    state = _read_import_state(state_path) if mode == "on" else None
+    if state is not None:
+        try:
+            _prepare_extension_warm(state)
+            _IMPORT_MODE = "warm"
+            return
+        except Exception:
+            # Stale in a way the signatures missed: fall back to a full scan
+            pass
+
+    _IMPORT_MODE = "cold"
+    state, watched = _prepare_extension_cold()
+    _timed("record", _write_import_state, state_path, state, watched)
+
+
+def import_timings():
+    """Return how the last ``import oeselect`` spent its time.
+
+    :returns: Dictionary with ``"mode"`` (``"warm"`` when a recorded import
+        state was replayed, ``"cold"`` after a full scan, ``"off"`` when
+        ``OESELECT_IMPORT_CACHE=0``) and the wall time in seconds of each
+        phase that ran (``compat``, ``preload``, ``bundled``, ``extension``,
+        ``version``, ``state``, ``record``, ``bindings``, ``total``).
+
+    Set ``OESELECT_IMPORT_TIMING=1`` to print the same breakdown to stderr
+    on import.
+    """
+    return {"mode": _IMPORT_MODE, **_IMPORT_TIMINGS}
+
+
+_IMPORT_START = time.perf_counter()
+_prepare_extension()
+_BINDINGS_START = time.perf_counter()
 
 from .oeselect import (
     OESelection,
@@ -571,18 +804,36 @@ from .oeselect import (
     OEResidueSelector as _CppOEResidueSelector,
     OEHasResidueName as _CppOEHasResidueName,
     OEHasAtomNameAdvanced as _CppOEHasAtomNameAdvanced,
+    OEInSelectionResult as _CppOEInSelectionResult,
+    OESelectionResult,
+    ResultIndexBuffer,
+    ResultMaskBuffer,
     EvaluateSelection,
     CountSelection,
+    SelectIndexBuffer,
+    SelectMaskBuffer,
+    EvaluateConformers,
+    BatchEvaluator as _CppBatchEvaluator,
+    SelectionSet as _CppSelectionSet,
+    EvaluationProfile,
+    UnitCell,
+    NodeProfile,
+    Tagger,
     parse_selector_set,
     mol_to_selector_set,
     str_selector_set,
     get_selector_string,
     select,
     count,
+    select_array,
+    select_mask,
+    find_contacts,
     parse,
     selector_set as _cpp_selector_set,
 )
 
+_IMPORT_TIMINGS["bindings"] = time.perf_counter() - _BINDINGS_START
+
 
 def _get_openeye_atom_predicate_base():
     """Load the OpenEye atom predicate base only when a predicate is instantiated."""
@@ -667,8 +918,15 @@ class OESelect:
         return iter(self._mol.GetAtoms(self))
 
     def CreateCopy(self):
-        """Create a copy for OpenEye compatibility."""
-        copy = OESelect(self._mol, self._cpp_select.GetSelection())
+        """Create a copy for OpenEye compatibility.
+
+        The copy shares this selector's computed mask, so the OpenEye calls
+        that copy a predicate do not re-evaluate the selection.
+        """
+        copy = OESelect.__new__(OESelect)
+        _get_openeye_atom_predicate_base().__init__(copy)
+        copy._mol = self._mol
+        copy._cpp_select = _CppOESelect(self._cpp_select)
         return copy.__disown__()
 
     @property
@@ -676,10 +934,223 @@ class OESelect:
         """Access the underlying OESelection object."""
         return self._cpp_select.GetSelection()
 
+    def SetProfiling(self, enabled):
+        """Enable or disable per-node profiling of subsequent evaluations.
+
+        Changing the setting discards the cached mask so that the next
+        evaluation is recorded.
+
+        :param enabled: True to start recording, False to stop and discard statistics.
+        """
+        self._cpp_select.SetProfiling(enabled)
+
+    def GetProfile(self):
+        """Return the statistics recorded while profiling was enabled.
+
+        :returns: An EvaluationProfile; ``str()`` renders the annotated tree.
+        """
+        return self._cpp_select.GetProfile()
+
+    def SetUnitCell(self, cell):
+        """Set the periodic box used by around, expand, and beyond.
+
+        Distances are then measured to the nearest periodic image, so
+        neighbours across a box face are found without replicating the system.
+
+        :param cell: A UnitCell, box lengths ``(a, b, c)`` in Angstroms for an
+            orthorhombic box, or None to disable periodic boundaries.
+        """
+        if cell is None:
+            cell = UnitCell()
+        elif not isinstance(cell, UnitCell):
+            cell = UnitCell.Orthorhombic(*(float(length) for length in cell))
+        self._cpp_select.SetUnitCell(cell)
+
+    def GetUnitCell(self):
+        """Return the periodic box used by distance selections.
+
+        :returns: A UnitCell; ``IsPeriodic()`` is False when none is set.
+        """
+        return self._cpp_select.GetUnitCell()
+
+    def SetNumThreads(self, num_threads):
+        """Set the number of threads that evaluate the selection.
+
+        Only very large systems are split across threads; results are the
+        same for every thread count.
+
+        :param num_threads: Threads to use; 1 (the default) evaluates on the
+            calling thread, and 0 uses all hardware threads.
+        """
+        if num_threads < 0:
+            raise ValueError("num_threads must be non-negative")
+        self._cpp_select.SetNumThreads(num_threads)
+
+    def GetNumThreads(self):
+        """Return the number of threads that evaluate the selection.
+
+        :returns: The resolved thread count.
+        """
+        return self._cpp_select.GetNumThreads()
+
+    def GetResult(self):
+        """Return the matching atoms as a compressed, combinable result.
+
+        Results support ``&``, ``|``, ``^``, and ``-``, can be kept across
+        frames, and can be bound into other selections with SetNamedSet().
+
+        :returns: An OESelectionResult sized to ``mol.GetMaxAtomIdx()``.
+        """
+        return self._cpp_select.GetResult()
+
+    def SetNamedSet(self, name, result):
+        """Bind a stored result to ``%name`` in this selection.
+
+        Discards the cached mask. Copies made for OpenEye calls keep the binding.
+
+        :param name: Set name: a letter or underscore, then letters, digits, or underscores.
+        :param result: An OESelectionResult sized to ``mol.GetMaxAtomIdx()``.
+        :raises SelectionError: If the name is not a valid set name.
+
+        Example::
+
+            site = OESelect(mol, "byres (ligand around 5)").GetResult()
+            pred = OESelect(mol, "%site and name CA")
+            pred.SetNamedSet("site", site)
+        """
+        self._cpp_select.SetNamedSet(name, result)
+
     def __repr__(self):
         return f"OESelect('{self._cpp_select.GetSelection().ToCanonical()}')"
 
 
+class SelectionSet:
+    """Evaluate many selections against one molecule in a single pass.
+
+    The selections are merged into one tree with shared subexpressions, so
+    the atom table, component tags, spatial index, and common subresults
+    such as ``ligand`` or ``ligand around 4`` are computed once per molecule.
+    The Python GIL is released during evaluation.
+
+    :param selections: Selection strings or OESelection objects.
+
+    Example::
+
+        from oeselect import SelectionSet
+
+        features = SelectionSet(["protein", "ligand around 4", "byres (ligand around 5)"])
+        counts = features.Count(mol)
+        # counts[i] is the number of atoms matching the i-th selection
+    """
+
+    def __init__(self, selections):
+        parsed = [
+            sele if isinstance(sele, OESelection) else OESelection.Parse(str(sele))
+            for sele in selections
+        ]
+        self._cpp_set = _CppSelectionSet(parsed)
+
+    def __len__(self):
+        return self._cpp_set.Size()
+
+    def GetSelection(self, index):
+        """Return the index-th selection of the set."""
+        return self._cpp_set.GetSelection(index)
+
+    def Count(self, mol):
+        """Count matching atoms for every selection.
+
+        :param mol: An OpenEye OEMolBase object.
+        :returns: List with one count per selection.
+        """
+        return list(self._cpp_set.Count(mol))
+
+    def Select(self, mol):
+        """Collect matching atom indices for every selection.
+
+        :param mol: An OpenEye OEMolBase object.
+        :returns: List with one sorted index list per selection.
+        """
+        return [list(indices) for indices in self._cpp_set.Select(mol)]
+
+    def EvaluateMasks(self, mol):
+        """Evaluate every selection as a bitset.
+
+        :param mol: An OpenEye OEMolBase object.
+        :returns: List with one Bitset per selection.
+        """
+        return list(self._cpp_set.EvaluateMasks(mol))
+
+    def __repr__(self):
+        return f"SelectionSet(selections={len(self)})"
+
+
+class BatchEvaluator:
+    """Evaluate several selections over many molecules in parallel.
+
+    Molecules are spread across a pool of native worker threads, and the
+    Python GIL is released while a batch runs.
+
+    :param selections: Selection strings or OESelection objects.
+    :param num_threads: Number of worker threads; 0 uses every hardware thread.
+
+    Example::
+
+        from openeye import oechem
+        from oeselect import BatchEvaluator
+
+        batch = BatchEvaluator(["ligand", "protein and (ligand around 4.5)"])
+        counts = batch.Count(oechem.oemolistream("complexes.oeb"))
+        # counts[m][s] is the number of atoms of molecule m matching selection s
+    """
+
+    def __init__(self, selections, num_threads=0):
+        parsed = [
+            sele if isinstance(sele, OESelection) else OESelection.Parse(str(sele))
+            for sele in selections
+        ]
+        self._cpp_batch = _CppBatchEvaluator(parsed, num_threads)
+
+    def NumSelections(self):
+        """Number of selections evaluated per molecule."""
+        return self._cpp_batch.NumSelections()
+
+    def NumThreads(self):
+        """Number of worker threads."""
+        return self._cpp_batch.NumThreads()
+
+    def Count(self, mols):
+        """Count matching atoms for every selection and molecule.
+
+        :param mols: Sequence of OEMolBase objects, or an oemolistream read until exhausted.
+        :returns: List with one list of per-selection counts per molecule.
+        """
+        from openeye import oechem
+
+        if not isinstance(mols, oechem.oemolistream):
+            mols = list(mols)
+        return [list(counts) for counts in self._cpp_batch.Count(mols)]
+
+    def Select(self, mols):
+        """Collect matching atom indices for every selection and molecule.
+
+        :param mols: Sequence of OEMolBase objects.
+        :returns: List with one list of per-selection index lists per molecule.
+        """
+        return [[list(indices) for indices in per_mol] for per_mol in self._cpp_batch.Select(list(mols))]
+
+    def EvaluateMasks(self, mols):
+        """Evaluate every selection against every molecule as bitsets.
+
+        :param mols: Sequence of OEMolBase objects.
+        :returns: List with one list of per-selection Bitset objects per molecule.
+        """
+        return [list(masks) for masks in self._cpp_batch.EvaluateMasks(list(mols))]
+
+    def __repr__(self):
+        return f"BatchEvaluator(selections={self.NumSelections()}, threads={self.NumThreads()})"
+
+
 def selector_set(*args):
     """Create a set of Selector objects.
 
@@ -733,6 +1204,14 @@ class OEResidueSelector:
         """
         return self._cpp_selector(atom)
 
+    def EvaluateMask(self, mol):
+        """Evaluate the selector against every atom of a molecule at once.
+
+        :param mol: An OpenEye OEMolBase object.
+        :returns: Bitset indexed by atom index with matching atoms set.
+        """
+        return self._cpp_selector.EvaluateMask(mol)
+
     def CreateCopy(self):
         """Create a copy for OpenEye compatibility."""
         copy = OEResidueSelector.__new__(OEResidueSelector)
@@ -812,6 +1291,47 @@ class OEHasAtomNameAdvanced:
         copy = OEHasAtomNameAdvanced(self._atom_name, self._case_sensitive, self._whitespace)
         return copy.__disown__()
 
+
+class OEInSelectionResult:
+    """Match atoms that are members of a stored OESelectionResult.
+
+    :param result: The OESelectionResult whose members match.
+
+    Example::
+
+        site = OESelect(mol, "byres (ligand around 5)").GetResult()
+        num = oechem.OECount(mol, OEInSelectionResult(site))
+    """
+
+    _openeye_predicate_type = None
+
+    def __new__(cls, *args, **kwargs):
+        if cls is OEInSelectionResult:
+            predicate_cls = _get_lazy_openeye_predicate_type(cls)
+            return predicate_cls.__new__(predicate_cls)
+        return super().__new__(cls)
+
+    def __init__(self, result):
+        _get_openeye_atom_predicate_base().__init__(self)
+        self._cpp_pred = _CppOEInSelectionResult(result)
+
+    def __call__(self, atom):
+        return self._cpp_pred(atom)
+
+    def GetResult(self):
+        """Return the result tested by this predicate."""
+        return self._cpp_pred.GetResult()
+
+    def CreateCopy(self):
+        """Create a copy for OpenEye compatibility.
+
+        The copy shares this predicate's result rather than copying it.
+        """
+        copy = OEInSelectionResult.__new__(OEInSelectionResult)
+        _get_openeye_atom_predicate_base().__init__(copy)
+        copy._cpp_pred = _CppOEInSelectionResult(self._cpp_pred)
+        return copy.__disown__()
+
 # Import PredicateType enum values
 from .oeselect import (
     PredicateType_AND,
@@ -851,6 +1371,12 @@ from .oeselect import (
     PredicateType_LOOP,
     PredicateType_ALL_MATCH,
     PredicateType_NO_MATCH,
+    PredicateType_LIPID,
+    PredicateType_GLYCAN,
+    PredicateType_BOUND_TO,
+    PredicateType_EXTEND,
+    PredicateType_NAMED_SET,
+    PredicateType_NEAREST,
 )
 
 # Create a namespace for PredicateType enum
@@ -893,6 +1419,38 @@ class PredicateType:
     Loop = PredicateType_LOOP
     True_ = PredicateType_ALL_MATCH
     False_ = PredicateType_NO_MATCH
+    Nearest = PredicateType_NEAREST
+    NamedSet = PredicateType_NAMED_SET
+    BoundTo = PredicateType_BOUND_TO
+    Extend = PredicateType_EXTEND
+    Lipid = PredicateType_LIPID
+    Glycan = PredicateType_GLYCAN
+
+# Import ComponentFlag enum values
+from .oeselect import (
+    ComponentFlag_NONE,
+    ComponentFlag_PROTEIN,
+    ComponentFlag_LIGAND,
+    ComponentFlag_SOLVENT,
+    ComponentFlag_COFACTOR,
+    ComponentFlag_NUCLEIC,
+    ComponentFlag_WATER,
+    ComponentFlag_LIPID,
+    ComponentFlag_GLYCAN,
+)
+
+# Create a namespace for ComponentFlag enum
+class ComponentFlag:
+    """Enum-like class for residue component classes (see ``Tagger.RegisterResidueClass``)."""
+    None_ = ComponentFlag_NONE
+    Protein = ComponentFlag_PROTEIN
+    Ligand = ComponentFlag_LIGAND
+    Solvent = ComponentFlag_SOLVENT
+    Cofactor = ComponentFlag_COFACTOR
+    Nucleic = ComponentFlag_NUCLEIC
+    Water = ComponentFlag_WATER
+    Lipid = ComponentFlag_LIPID
+    Glycan = ComponentFlag_GLYCAN
 
 __all__ = [
     "__version__",
@@ -903,15 +1461,44 @@ __all__ = [
     "OEResidueSelector",
     "OEHasResidueName",
     "OEHasAtomNameAdvanced",
+    "OEInSelectionResult",
+    "OESelectionResult",
     "PredicateType",
+    "ComponentFlag",
+    "Tagger",
     "EvaluateSelection",
     "CountSelection",
+    "SelectIndexBuffer",
+    "SelectMaskBuffer",
+    "ResultIndexBuffer",
+    "ResultMaskBuffer",
+    "EvaluateConformers",
+    "BatchEvaluator",
+    "SelectionSet",
+    "EvaluationProfile",
+    "UnitCell",
+    "NodeProfile",
     "select",
     "count",
+    "select_array",
+    "select_mask",
+    "find_contacts",
     "parse",
     "parse_selector_set",
     "str_selector_set",
     "selector_set",
     "mol_to_selector_set",
     "get_selector_string",
+    "import_timings",
 ]
+
+_IMPORT_TIMINGS["total"] = time.perf_counter() - _IMPORT_START
+if os.environ.get("OESELECT_IMPORT_TIMING", "").strip() not in ("", "0"):
+    print(
+        f"oeselect: {_IMPORT_MODE} import, "
+        + ", ".join(
+            f"{phase} {seconds * 1000.0:.1f} ms"
+            for phase, seconds in _IMPORT_TIMINGS.items()
+        ),
+        file=sys.stderr,
+    )
@@ -0,0 +1,322 @@
+/**
+ * @file AtomTable.cpp
+ * @brief Columnar atom property snapshot implementation.
+ */
+
+#include "oeselect/AtomTable.h"
+#include "oeselect/Tagger.h"
+#include "table_file.h"
+
+#include <oechem.h>
+#include <algorithm>
+#include <array>
+#include <unordered_map>
+
+namespace OESel {
+
+namespace {
+std::string trim_ascii_spaces(const std::string& value) {
+    const auto start = value.find_first_not_of(' ');
+    if (start == std::string::npos) {
+        return "";
+    }
+    const auto end = value.find_last_not_of(' ');
+    return value.substr(start, end - start + 1);
+}
+
+/// Assigns dense ids to distinct strings in first-seen order
+class StringInterner {
+public:
+    explicit StringInterner(std::vector<std::string>& values) : values_(values) {}
+
+    std::uint32_t Intern(const std::string& value) {
+        const auto [it, inserted] = ids_.try_emplace(value, static_cast<std::uint32_t>(values_.size()));
+        if (inserted) {
+            values_.push_back(value);
+        }
+        return it->second;
+    }
+
+private:
+    std::vector<std::string>& values_;
+    std::unordered_map<std::string, std::uint32_t> ids_;
+};
+
+/// Pack the fields identifying a residue into one hashable key
+std::uint64_t residue_key(const char chain_id, const int residue_number, const char insert_code) {
+    return static_cast<std::uint64_t>(static_cast<unsigned char>(chain_id)) << 40 |
+           static_cast<std::uint64_t>(static_cast<unsigned char>(insert_code)) << 32 |
+           static_cast<std::uint32_t>(residue_number);
+}
+
+/// Build the CSR run map for per-atom group ids in ascending atom order
+GroupRuns build_group_runs(const std::vector<std::uint32_t>& groups, const size_t num_groups) {
+    constexpr std::uint32_t kNone = AtomTable::kNoGroup;
+    GroupRuns result;
+    result.offsets.assign(num_groups + 1, 0);
+
+    // First pass: count the runs of each group
+    std::vector<std::uint32_t> last_end(num_groups, kNone);
+    for (std::uint32_t idx = 0; idx < groups.size(); ++idx) {
+        const std::uint32_t g = groups[idx];
+        if (g == kNone) {
+            continue;
+        }
+        if (last_end[g] != idx) {
+            ++result.offsets[g + 1];
+        }
+        last_end[g] = idx + 1;
+    }
+    for (size_t g = 0; g < num_groups; ++g) {
+        result.offsets[g + 1] += result.offsets[g];
+    }
+
+    // Second pass: fill the runs, extending a group's last run while atoms stay consecutive
+    result.runs.resize(result.offsets.back());
+    std::vector<std::uint32_t> cursor(result.offsets.begin(), result.offsets.end() - 1);
+    std::fill(last_end.begin(), last_end.end(), kNone);
+    for (std::uint32_t idx = 0; idx < groups.size(); ++idx) {
+        const std::uint32_t g = groups[idx];
+        if (g == kNone) {
+            continue;
+        }
+        if (last_end[g] == idx) {
+            result.runs[cursor[g] - 1].end = idx + 1;
+        } else {
+            result.runs[cursor[g]++] = {idx, idx + 1};
+        }
+        last_end[g] = idx + 1;
+    }
+    return result;
+}
+}  // namespace
+
+void GroupRuns::Paint(const Bitset& groups, Bitset& atoms) const {
+    groups.ForEachSet([&](const size_t g) {
+        for (std::uint32_t r = offsets[g]; r < offsets[g + 1]; ++r) {
+            atoms.SetRange(runs[r].begin, runs[r].end);
+        }
+    });
+}
+
+/// PIMPL containing the column arrays
+struct AtomTable::Impl {
+    size_t size = 0;
+
+    std::vector<std::string> residue_names;
+    std::vector<std::string> atom_names;
+
+    std::vector<std::uint32_t> residue_name_ids;
+    std::vector<std::uint32_t> atom_name_ids;
+    std::vector<int> residue_numbers;
+    std::vector<char> chain_ids;
+    std::vector<char> insert_codes;
+    std::vector<int> serial_numbers;
+    std::vector<char> alt_locations;
+    std::vector<float> bfactors;
+    std::vector<unsigned int> fragment_numbers;
+    std::vector<int> secondary_structure;
+    std::vector<unsigned int> atomic_numbers;
+    std::vector<std::uint8_t> component_flags;
+
+    std::vector<std::uint32_t> residue_groups;
+    std::vector<std::uint32_t> chain_groups;
+    GroupRuns residue_runs;
+    GroupRuns chain_runs;
+
+    Impl() = default;
+
+    explicit Impl(const OEChem::OEMolBase& mol)
+        : size(mol.GetMaxAtomIdx())
+        , residue_name_ids(size, 0)
+        , atom_name_ids(size, 0)
+        , residue_numbers(size, 0)
+        , chain_ids(size, ' ')
+        , insert_codes(size, ' ')
+        , serial_numbers(size, 0)
+        , alt_locations(size, ' ')
+        , bfactors(size, 0.0f)
+        , fragment_numbers(size, 0)
+        , secondary_structure(size, 0)
+        , atomic_numbers(size, 0)
+        , component_flags(size, 0)
+        , residue_groups(size, kNoGroup)
+        , chain_groups(size, kNoGroup) {
+        StringInterner residue_interner(residue_names);
+        StringInterner atom_interner(atom_names);
+        std::unordered_map<std::uint64_t, std::uint32_t> residue_ids;
+        std::array<std::uint32_t, 256> chain_ids_by_char;
+        chain_ids_by_char.fill(kNoGroup);
+        std::uint32_t num_chains = 0;
+        std::vector<std::uint8_t> flags_by_residue_name;
+
+        for (OESystem::OEIter atom = mol.GetAtoms(); atom; ++atom) {
+            const unsigned int idx = atom->GetIdx();
+            // One residue lookup per atom for all residue-derived columns
+            const OEChem::OEResidue& res = OEChem::OEAtomGetResidue(&*atom);
+
+            // Classify each distinct residue name once
+            residue_name_ids[idx] = residue_interner.Intern(res.GetName());
+            if (residue_name_ids[idx] == flags_by_residue_name.size()) {
+                flags_by_residue_name.push_back(static_cast<std::uint8_t>(
+                    Tagger::ClassifyResidueName(residue_names.back().c_str())));
+            }
+            component_flags[idx] = flags_by_residue_name[residue_name_ids[idx]];
+            atom_name_ids[idx] = atom_interner.Intern(trim_ascii_spaces(atom->GetName()));
+            residue_numbers[idx] = res.GetResidueNumber();
+            chain_ids[idx] = res.GetChainID();
+            insert_codes[idx] = res.GetInsertCode();
+            serial_numbers[idx] = res.GetSerialNumber();
+            alt_locations[idx] = res.GetAlternateLocation();
+            bfactors[idx] = static_cast<float>(res.GetBFactor());
+            fragment_numbers[idx] = res.GetFragmentNumber();
+            secondary_structure[idx] = res.GetSecondaryStructure();
+            atomic_numbers[idx] = atom->GetAtomicNum();
+
+            residue_groups[idx] = residue_ids.try_emplace(
+                residue_key(chain_ids[idx], residue_numbers[idx], insert_codes[idx]),
+                static_cast<std::uint32_t>(residue_ids.size())).first->second;
+            std::uint32_t& chain = chain_ids_by_char[static_cast<unsigned char>(chain_ids[idx])];
+            if (chain == kNoGroup) {
+                chain = num_chains++;
+            }
+            chain_groups[idx] = chain;
+        }
+
+        residue_runs = build_group_runs(residue_groups, residue_ids.size());
+        chain_runs = build_group_runs(chain_groups, num_chains);
+    }
+};
+
+AtomTable::AtomTable(const OEChem::OEMolBase& mol)
+    : pimpl_(std::make_unique<Impl>(mol)) {}
+
+AtomTable::AtomTable()
+    : pimpl_(std::make_unique<Impl>()) {}
+
+namespace {
+/// Write a run map as its offset and run columns
+void write_runs(TableFileWriter& out, const GroupRuns& runs) {
+    out.Column(runs.offsets);
+    out.Column(runs.runs);
+}
+
+/// Read a run map, checking that offsets ascend and runs stay within @p size atoms
+void read_runs(TableFileReader& in, GroupRuns& runs, const size_t size) {
+    in.Column(runs.offsets);
+    in.Column(runs.runs);
+    if (runs.offsets.empty() || runs.offsets.front() != 0 || runs.offsets.back() != runs.runs.size() ||
+        !std::is_sorted(runs.offsets.begin(), runs.offsets.end())) {
+        throw SelectionError("Table cache group runs are corrupt");
+    }
+    for (const AtomRun& run : runs.runs) {
+        if (run.begin >= run.end || run.end > size) {
+            throw SelectionError("Table cache group runs are corrupt");
+        }
+    }
+}
+
+/// Check that a per-atom column has one row per atom and ids below @p limit
+void check_ids(const std::vector<std::uint32_t>& ids, const size_t size, const size_t limit, const bool allow_none) {
+    if (ids.size() != size) {
+        throw SelectionError("Table cache column has the wrong length");
+    }
+    for (const std::uint32_t id : ids) {
+        if (id >= limit && !(allow_none && id == AtomTable::kNoGroup)) {
+            throw SelectionError("Table cache column holds an out-of-range id");
+        }
+    }
+}
+}  // namespace
+
+void AtomTable::Write(TableFileWriter& out) const {
+    const Impl& t = *pimpl_;
+    out.Column(std::vector<std::uint64_t>{t.size});
+    out.Strings(t.residue_names);
+    out.Strings(t.atom_names);
+    out.Column(t.residue_name_ids);
+    out.Column(t.atom_name_ids);
+    out.Column(t.residue_numbers);
+    out.Column(t.chain_ids);
+    out.Column(t.insert_codes);
+    out.Column(t.serial_numbers);
+    out.Column(t.alt_locations);
+    out.Column(t.bfactors);
+    out.Column(t.fragment_numbers);
+    out.Column(t.secondary_structure);
+    out.Column(t.atomic_numbers);
+    out.Column(t.component_flags);
+    out.Column(t.residue_groups);
+    out.Column(t.chain_groups);
+    write_runs(out, t.residue_runs);
+    write_runs(out, t.chain_runs);
+}
+
+void AtomTable::Read(TableFileReader& in) {
+    Impl& t = *pimpl_;
+    std::vector<std::uint64_t> size;
+    in.Column(size);
+    if (size.size() != 1) {
+        throw SelectionError("Table cache header is corrupt");
+    }
+    t.size = static_cast<size_t>(size[0]);
+    in.Strings(t.residue_names);
+    in.Strings(t.atom_names);
+    in.Column(t.residue_name_ids);
+    in.Column(t.atom_name_ids);
+    in.Column(t.residue_numbers);
+    in.Column(t.chain_ids);
+    in.Column(t.insert_codes);
+    in.Column(t.serial_numbers);
+    in.Column(t.alt_locations);
+    in.Column(t.bfactors);
+    in.Column(t.fragment_numbers);
+    in.Column(t.secondary_structure);
+    in.Column(t.atomic_numbers);
+    in.Column(t.component_flags);
+    in.Column(t.residue_groups);
+    in.Column(t.chain_groups);
+    read_runs(in, t.residue_runs, t.size);
+    read_runs(in, t.chain_runs, t.size);
+
+    // Predicates index names and runs by these ids without further checks
+    check_ids(t.residue_name_ids, t.size, t.residue_names.size(), false);
+    check_ids(t.atom_name_ids, t.size, t.atom_names.size(), false);
+    check_ids(t.residue_groups, t.size, t.residue_runs.NumGroups(), true);
+    check_ids(t.chain_groups, t.size, t.chain_runs.NumGroups(), true);
+    for (const size_t length : {t.residue_numbers.size(), t.chain_ids.size(), t.insert_codes.size(),
+                                t.serial_numbers.size(), t.alt_locations.size(), t.bfactors.size(),
+                                t.fragment_numbers.size(), t.secondary_structure.size(),
+                                t.atomic_numbers.size(), t.component_flags.size()}) {
+        if (length != t.size) {
+            throw SelectionError("Table cache column has the wrong length");
+        }
+    }
+}
+
+AtomTable::~AtomTable() = default;
+
+size_t AtomTable::Size() const { return pimpl_->size; }
+
+const std::vector<std::string>& AtomTable::ResidueNames() const { return pimpl_->residue_names; }
+const std::vector<std::string>& AtomTable::AtomNames() const { return pimpl_->atom_names; }
+
+const std::vector<std::uint32_t>& AtomTable::ResidueNameIds() const { return pimpl_->residue_name_ids; }
+const std::vector<std::uint32_t>& AtomTable::AtomNameIds() const { return pimpl_->atom_name_ids; }
+const std::vector<int>& AtomTable::ResidueNumbers() const { return pimpl_->residue_numbers; }
+const std::vector<char>& AtomTable::ChainIds() const { return pimpl_->chain_ids; }
+const std::vector<char>& AtomTable::InsertCodes() const { return pimpl_->insert_codes; }
+const std::vector<int>& AtomTable::SerialNumbers() const { return pimpl_->serial_numbers; }
+const std::vector<char>& AtomTable::AltLocations() const { return pimpl_->alt_locations; }
+const std::vector<float>& AtomTable::BFactors() const { return pimpl_->bfactors; }
+const std::vector<unsigned int>& AtomTable::FragmentNumbers() const { return pimpl_->fragment_numbers; }
+const std::vector<int>& AtomTable::SecondaryStructure() const { return pimpl_->secondary_structure; }
+const std::vector<unsigned int>& AtomTable::AtomicNumbers() const { return pimpl_->atomic_numbers; }
+const std::vector<std::uint8_t>& AtomTable::ComponentFlags() const { return pimpl_->component_flags; }
+
+const std::vector<std::uint32_t>& AtomTable::ResidueGroups() const { return pimpl_->residue_groups; }
+const std::vector<std::uint32_t>& AtomTable::ChainGroups() const { return pimpl_->chain_groups; }
+const GroupRuns& AtomTable::ResidueRuns() const { return pimpl_->residue_runs; }
+const GroupRuns& AtomTable::ChainRuns() const { return pimpl_->chain_runs; }
+
+}  // namespace OESel
@@ -0,0 +1,152 @@
+/**
+ * @file BatchEvaluator.cpp
+ * @brief Parallel multi-molecule evaluation implementation.
+ */
+
+#include "oeselect/BatchEvaluator.h"
+#include "oeselect/SelectionSet.h"
+#include "thread_pool.h"
+
+#include <oechem.h>
+
+namespace OESel {
+
+namespace {
+/// Molecules read per worker before a stream chunk is evaluated
+constexpr size_t kStreamChunkPerThread = 64;
+}  // namespace
+
+/// PIMPL containing the selections, the pool, and per-worker state
+struct BatchEvaluator::Impl {
+    /// Reusable state owned by one worker thread
+    struct Worker {
+        SelectionSet set;           ///< Shares the merged tree, owns this worker's context
+        std::vector<Bitset> masks;  ///< Scratch results for the current molecule
+    };
+
+    /// Receives one molecule's masks on the worker that computed them
+    using Consumer = std::function<void(size_t index, std::vector<Bitset>& masks)>;
+
+    std::vector<OESelection> selections;
+    WorkStealingPool pool;
+    std::vector<Worker> workers;
+
+    Impl(std::vector<OESelection> s, const unsigned int num_threads)
+        : selections(std::move(s)), pool(num_threads) {
+        const SelectionSet prototype(selections);
+        workers.reserve(pool.NumWorkers());
+        for (unsigned int w = 0; w < pool.NumWorkers(); ++w) {
+            workers.push_back(Worker{prototype, {}});
+        }
+    }
+
+    /// Evaluate every selection on mols[0 .. count) in parallel
+    void Run(OEChem::OEMolBase* const* mols, const size_t count, const Consumer& consume) {
+        pool.ParallelFor(count, [&](const size_t index, const unsigned int w) {
+            Worker& worker = workers[w];
+            worker.set.EvaluateMasks(*mols[index], worker.masks);
+            consume(index, worker.masks);
+        });
+    }
+};
+
+BatchEvaluator::BatchEvaluator(std::vector<OESelection> selections, const unsigned int num_threads)
+    : pimpl_(std::make_unique<Impl>(std::move(selections), num_threads)) {}
+
+BatchEvaluator::~BatchEvaluator() = default;
+
+size_t BatchEvaluator::NumSelections() const {
+    return pimpl_->selections.size();
+}
+
+unsigned int BatchEvaluator::NumThreads() const {
+    return pimpl_->pool.NumWorkers();
+}
+
+std::vector<std::vector<Bitset>> BatchEvaluator::EvaluateMasks(const std::vector<OEChem::OEMolBase*>& mols) {
+    std::vector<std::vector<Bitset>> result(mols.size());
+    pimpl_->Run(mols.data(), mols.size(), [&](const size_t index, std::vector<Bitset>& masks) {
+        result[index] = std::move(masks);
+    });
+    return result;
+}
+
+std::vector<std::vector<unsigned int>> BatchEvaluator::Count(const std::vector<OEChem::OEMolBase*>& mols) {
+    std::vector<std::vector<unsigned int>> result(mols.size());
+    pimpl_->Run(mols.data(), mols.size(), [&](const size_t index, std::vector<Bitset>& masks) {
+        std::vector<unsigned int>& counts = result[index];
+        counts.reserve(masks.size());
+        for (const Bitset& mask : masks) {
+            counts.push_back(static_cast<unsigned int>(mask.Count()));
+        }
+    });
+    return result;
+}
+
+std::vector<std::vector<unsigned int>> BatchEvaluator::Count(OEChem::oemolistream& ifs) {
+    std::vector<std::vector<unsigned int>> result;
+    Evaluate(ifs, [&](size_t, OEChem::OEMolBase&, const std::vector<Bitset>& masks) {
+        std::vector<unsigned int>& counts = result.emplace_back();
+        counts.reserve(masks.size());
+        for (const Bitset& mask : masks) {
+            counts.push_back(static_cast<unsigned int>(mask.Count()));
+        }
+    });
+    return result;
+}
+
+std::vector<std::vector<std::vector<unsigned int>>> BatchEvaluator::Select(
+        const std::vector<OEChem::OEMolBase*>& mols) {
+    std::vector<std::vector<std::vector<unsigned int>>> result(mols.size());
+    pimpl_->Run(mols.data(), mols.size(), [&](const size_t index, std::vector<Bitset>& masks) {
+        std::vector<std::vector<unsigned int>>& indices = result[index];
+        indices.reserve(masks.size());
+        for (const Bitset& mask : masks) {
+            indices.push_back(mask.ToIndices());
+        }
+    });
+    return result;
+}
+
+size_t BatchEvaluator::Evaluate(OEChem::oemolistream& ifs, const MaskCallback& callback) {
+    const size_t chunk_size = kStreamChunkPerThread * pimpl_->pool.NumWorkers();
+    // Molecule storage is reused from chunk to chunk
+    std::vector<std::unique_ptr<OEChem::OEGraphMol>> chunk;
+    std::vector<OEChem::OEMolBase*> mols;
+    std::vector<std::vector<Bitset>> results;
+
+    size_t total = 0;
+    for (;;) {
+        mols.clear();
+        while (mols.size() < chunk_size) {
+            if (mols.size() == chunk.size()) {
+                chunk.push_back(std::make_unique<OEChem::OEGraphMol>());
+            }
+            OEChem::OEGraphMol& mol = *chunk[mols.size()];
+            mol.Clear();
+            if (!OEChem::OEReadMolecule(ifs, mol)) {
+                break;
+            }
+            mols.push_back(&mol);
+        }
+        if (mols.empty()) {
+            break;
+        }
+
+        results.resize(mols.size());
+        pimpl_->Run(mols.data(), mols.size(), [&](const size_t index, std::vector<Bitset>& masks) {
+            results[index] = std::move(masks);
+        });
+        for (size_t m = 0; m < mols.size(); ++m) {
+            callback(total + m, *mols[m], results[m]);
+        }
+        total += mols.size();
+
+        if (mols.size() < chunk_size) {
+            break;
+        }
+    }
+    return total;
+}
+
+}  // namespace OESel
@@ -0,0 +1,117 @@
+/**
+ * @file Bitset.cpp
+ * @brief Packed atom bitset implementation.
+ */
+
+#include "oeselect/Bitset.h"
+
+#include <algorithm>
+#include <bitset>
+
+namespace OESel {
+
+Bitset::Bitset(const size_t size, const bool value)
+    : words_((size + kWordBits - 1) / kWordBits, value ? ~Word{0} : Word{0})
+    , size_(size) {
+    ClearTail();
+}
+
+void Bitset::SetRange(const size_t begin, const size_t end) {
+    if (begin >= end) {
+        return;
+    }
+    const size_t first_word = begin / kWordBits;
+    const size_t last_word = (end - 1) / kWordBits;
+    const Word first_mask = ~Word{0} << (begin % kWordBits);
+    const Word last_mask = ~Word{0} >> (kWordBits - 1 - (end - 1) % kWordBits);
+    if (first_word == last_word) {
+        words_[first_word] |= first_mask & last_mask;
+        return;
+    }
+    words_[first_word] |= first_mask;
+    std::fill(words_.begin() + static_cast<std::ptrdiff_t>(first_word + 1),
+              words_.begin() + static_cast<std::ptrdiff_t>(last_word), ~Word{0});
+    words_[last_word] |= last_mask;
+}
+
+void Bitset::SetAll() {
+    std::fill(words_.begin(), words_.end(), ~Word{0});
+    ClearTail();
+}
+
+void Bitset::ResetAll() {
+    std::fill(words_.begin(), words_.end(), Word{0});
+}
+
+void Bitset::Flip() {
+    for (Word& w : words_) {
+        w = ~w;
+    }
+    ClearTail();
+}
+
+size_t Bitset::Count() const {
+    size_t count = 0;
+    for (const Word w : words_) {
+        count += std::bitset<kWordBits>(w).count();
+    }
+    return count;
+}
+
+bool Bitset::Any() const {
+    return std::any_of(words_.begin(), words_.end(), [](const Word w) { return w != 0; });
+}
+
+Bitset& Bitset::operator&=(const Bitset& other) {
+    const size_t n = std::min(words_.size(), other.words_.size());
+    for (size_t i = 0; i < n; ++i) {
+        words_[i] &= other.words_[i];
+    }
+    std::fill(words_.begin() + static_cast<std::ptrdiff_t>(n), words_.end(), Word{0});
+    return *this;
+}
+
+Bitset& Bitset::operator|=(const Bitset& other) {
+    const size_t n = std::min(words_.size(), other.words_.size());
+    for (size_t i = 0; i < n; ++i) {
+        words_[i] |= other.words_[i];
+    }
+    ClearTail();
+    return *this;
+}
+
+Bitset& Bitset::operator^=(const Bitset& other) {
+    const size_t n = std::min(words_.size(), other.words_.size());
+    for (size_t i = 0; i < n; ++i) {
+        words_[i] ^= other.words_[i];
+    }
+    ClearTail();
+    return *this;
+}
+
+Bitset& Bitset::AndNot(const Bitset& other) {
+    const size_t n = std::min(words_.size(), other.words_.size());
+    for (size_t i = 0; i < n; ++i) {
+        words_[i] &= ~other.words_[i];
+    }
+    return *this;
+}
+
+bool Bitset::operator==(const Bitset& other) const {
+    return size_ == other.size_ && words_ == other.words_;
+}
+
+std::vector<unsigned int> Bitset::ToIndices() const {
+    std::vector<unsigned int> result;
+    result.reserve(Count());
+    ForEachSet([&](const size_t idx) { result.push_back(static_cast<unsigned int>(idx)); });
+    return result;
+}
+
+void Bitset::ClearTail() {
+    if (const size_t tail = size_ % kWordBits; tail != 0 && !words_.empty()) {
+        words_.back() &= (Word{1} << tail) - 1;
+    }
+}
+
+}  // namespace OESel
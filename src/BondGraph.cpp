@@ -0,0 +1,74 @@
+/**
+ * @file BondGraph.cpp
+ * @brief Compressed bond adjacency implementation.
+ */
+
+#include "oeselect/BondGraph.h"
+#include "table_file.h"
+
+#include <oechem.h>
+#include <algorithm>
+
+namespace OESel {
+
+BondGraph::BondGraph(const OEChem::OEMolBase& mol)
+    : offsets_(static_cast<size_t>(mol.GetMaxAtomIdx()) + 1, 0)
+    , atomic_numbers_(mol.GetMaxAtomIdx(), 0) {
+    for (OESystem::OEIter atom = mol.GetAtoms(); atom; ++atom) {
+        atomic_numbers_[atom->GetIdx()] = static_cast<std::uint8_t>(atom->GetAtomicNum());
+    }
+
+    // First pass: count the degree of each atom, shifted by one for the prefix sum
+    for (OESystem::OEIter bond = mol.GetBonds(); bond; ++bond) {
+        ++offsets_[bond->GetBgn()->GetIdx() + 1];
+        ++offsets_[bond->GetEnd()->GetIdx() + 1];
+    }
+    for (size_t i = 1; i < offsets_.size(); ++i) {
+        offsets_[i] += offsets_[i - 1];
+    }
+
+    // Second pass: fill each row from its start offset
+    neighbors_.resize(offsets_.back());
+    neighbor_atomic_numbers_.resize(offsets_.back());
+    std::vector<std::uint32_t> fill(offsets_.begin(), offsets_.end() - 1);
+    for (OESystem::OEIter bond = mol.GetBonds(); bond; ++bond) {
+        const unsigned int bgn = bond->GetBgn()->GetIdx();
+        const unsigned int end = bond->GetEnd()->GetIdx();
+        neighbors_[fill[bgn]] = end;
+        neighbor_atomic_numbers_[fill[bgn]++] = atomic_numbers_[end];
+        neighbors_[fill[end]] = bgn;
+        neighbor_atomic_numbers_[fill[end]++] = atomic_numbers_[bgn];
+    }
+}
+
+void BondGraph::MarkNeighbors(const Bitset& atoms, Bitset& out) const {
+    atoms.ForEachSet([&](const size_t idx) {
+        if (idx >= Size()) return;
+        for (std::uint32_t k = offsets_[idx]; k < offsets_[idx + 1]; ++k) {
+            out.Set(neighbors_[k]);
+        }
+    });
+}
+
+void BondGraph::Write(TableFileWriter& out) const {
+    out.Column(offsets_);
+    out.Column(neighbors_);
+    out.Column(neighbor_atomic_numbers_);
+    out.Column(atomic_numbers_);
+}
+
+void BondGraph::Read(TableFileReader& in) {
+    in.Column(offsets_);
+    in.Column(neighbors_);
+    in.Column(neighbor_atomic_numbers_);
+    in.Column(atomic_numbers_);
+    if (offsets_.size() != atomic_numbers_.size() + 1 || offsets_.front() != 0 ||
+        offsets_.back() != neighbors_.size() || neighbor_atomic_numbers_.size() != neighbors_.size() ||
+        !std::is_sorted(offsets_.begin(), offsets_.end()) ||
+        std::any_of(neighbors_.begin(), neighbors_.end(),
+                    [this](const std::uint32_t n) { return n >= atomic_numbers_.size(); })) {
+        throw SelectionError("Table cache bond graph is corrupt");
+    }
+}
+
+}  // namespace OESel
@@ -0,0 +1,91 @@
+/**
+ * @file Contacts.cpp
+ * @brief Contact pair search implementation.
+ */
+
+#include "oeselect/Contacts.h"
+#include "oeselect/AtomTable.h"
+#include "oeselect/Bitset.h"
+#include "oeselect/Context.h"
+#include "oeselect/Error.h"
+#include "oeselect/SelectionSet.h"
+#include "oeselect/SpatialIndex.h"
+
+#include <oechem.h>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace OESel {
+
+ContactList FindContacts(OEChem::OEMolBase& mol, const OESelection& first, const OESelection& second,
+                         const float cutoff, const ContactLevel level) {
+    if (!std::isfinite(cutoff) || cutoff < 0.0f) {
+        throw SelectionError("Contact cutoff must be non-negative and finite");
+    }
+
+    // The merged tree is cached, and both selections evaluate in one context
+    SelectionSet set({first, second});
+    std::vector<Bitset> masks;
+    set.EvaluateMasks(mol, masks);
+    Context& ctx = set.GetContext();
+
+    ContactList contacts;
+    if (cutoff == 0.0f || masks[0].None() || masks[1].None()) {
+        return contacts;
+    }
+    // Reuse the index distance predicates built; otherwise collect over a grid without a k-d tree
+    const OESelection& merged = set.GetMergedSelection();
+    std::unique_ptr<SpatialIndex> grid;
+    if (!merged.ContainsPredicate(PredicateType::AROUND) && !merged.ContainsPredicate(PredicateType::EXPAND) &&
+        !merged.ContainsPredicate(PredicateType::BEYOND)) {
+        grid = std::make_unique<SpatialIndex>(mol, SpatialBackend::CELL_LIST, cutoff);
+    }
+    const SpatialIndex& index = grid ? *grid : ctx.GetSpatialIndex();
+    index.FindPairs(masks[0], masks[1], cutoff, contacts.first_, contacts.second_, contacts.distance_sq_);
+
+    if (level == ContactLevel::RESIDUE && !contacts.Empty()) {
+        // Sort (residue pair, entry) keys so each residue pair's entries are adjacent, first found first
+        const std::vector<std::uint32_t>& residues = ctx.GetAtomTable().ResidueGroups();
+        std::vector<std::pair<std::uint64_t, size_t>> order(contacts.Size());
+        for (size_t k = 0; k < contacts.Size(); ++k) {
+            order[k] = {static_cast<std::uint64_t>(residues[contacts.first_[k]]) << 32 | residues[contacts.second_[k]],
+                        k};
+        }
+        std::sort(order.begin(), order.end());
+
+        // Reduce each run to (its first entry, its closest entry) in the front of the same array
+        size_t kept = 0;
+        for (size_t run = 0; run < order.size();) {
+            const size_t first = order[run].second;
+            size_t best = first;
+            size_t next = run + 1;
+            for (; next < order.size() && order[next].first == order[run].first; ++next) {
+                if (contacts.distance_sq_[order[next].second] < contacts.distance_sq_[best]) {
+                    best = order[next].second;
+                }
+            }
+            order[kept++] = {first, best};
+            run = next;
+        }
+
+        // Restore discovery order and compact; entry kept never reads a slot an earlier one wrote
+        std::sort(order.begin(), order.begin() + static_cast<std::ptrdiff_t>(kept));
+        for (size_t slot = 0; slot < kept; ++slot) {
+            const size_t k = order[slot].second;
+            contacts.first_[slot] = contacts.first_[k];
+            contacts.second_[slot] = contacts.second_[k];
+            contacts.distance_sq_[slot] = contacts.distance_sq_[k];
+        }
+        contacts.first_.resize(kept);
+        contacts.second_.resize(kept);
+        contacts.distance_sq_.resize(kept);
+    }
+    return contacts;
+}
+
+}  // namespace OESel
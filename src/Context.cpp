@@ -4,79 +4,725 @@
  */
 
 #include "oeselect/Context.h"
+#include "oeselect/AtomTable.h"
+#include "oeselect/Bitset.h"
+#include "oeselect/BondGraph.h"
+#include "oeselect/Error.h"
+#include "oeselect/Predicate.h"
+#include "oeselect/Profile.h"
+#include "oeselect/Program.h"
 #include "oeselect/Selection.h"
 #include "oeselect/SpatialIndex.h"
+#include "oeselect/predicates/DistancePredicates.h"
+#include "thread_pool.h"
+#include "verlet_list.h"
 
 #include <oechem.h>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
 namespace OESel {
 
+namespace {
+/// Counters accumulated for one predicate node while profiling
+struct NodeStats {
+    std::uint64_t evaluations = 0;
+    double seconds = 0.0;
+    std::uint64_t cache_hits = 0;
+    std::uint64_t cache_misses = 0;
+    std::uint64_t atoms_evaluated = 0;
+    std::uint64_t atoms_matched = 0;
+    std::uint64_t spatial_queries = 0;
+};
+
+/// Profiling state; only allocated while profiling is enabled
+struct Profiler {
+    std::unordered_map<const Predicate*, NodeStats> stats;
+    std::vector<const Predicate*> active;  ///< Nodes currently being evaluated, innermost last
+};
+
+/// Cell list over the atoms of one restricted distance query
+struct DomainIndex {
+    Bitset atoms;
+    float radius = 0.0f;  ///< Cutoff the cells were sized to
+    std::unique_ptr<SpatialIndex> index;
+    bool stale = false;  ///< Not yet refitted to the current frame
+};
+
+/// Domain indexes kept per context; a selection rarely has more distance nodes
+constexpr size_t kMaxDomainIndexes = 8;
+
+/// Bits of a slot_cached entry
+constexpr char kMaskCached = 1;
+constexpr char kResultCached = 2;
+}  // namespace
+
 /// PIMPL containing molecule reference, selection, and caches
 struct Context::Impl {
-    OEChem::OEMolBase& mol;
+    OEChem::OEMolBase* mol;
     const OESelection& sele;
     std::unique_ptr<SpatialIndex> spatial_index;
+    UnitCell cell;  ///< Kept across Reset()
+    std::map<std::string, OESelectionResult> named_sets;  ///< Kept across Reset()
+    unsigned int num_threads = 1;            ///< Kept across Reset()
+    std::unique_ptr<WorkStealingPool> pool;  ///< Started on first parallel step
+    std::unique_ptr<Bitset> atom_mask;
+    std::unique_ptr<AtomTable> atom_table;
+    std::unique_ptr<BondGraph> bond_graph;
+
+    // Result masks indexed by predicate cache slot
+    std::vector<Bitset> slot_masks;
+    std::vector<Bitset> slot_results;  ///< Entries of SetCachedResult(), beside the slot's shared mask
+    std::vector<char> slot_cached;     ///< kMaskCached and kResultCached bits; zero clears both
+    std::vector<char> slot_uses_coordinates;  ///< Slot's subtree contains a distance predicate
+    bool share_static_results = false;
+
+    // Fallback for predicates evaluated outside a numbered selection tree
+    std::unordered_map<const Predicate*, Bitset> unslotted_masks;
+
+    // Verlet skin mode: candidate pair lists reused across frames
+    float verlet_skin = 0.0f;  ///< Kept across Reset(); 0 disables the lists
+    std::unordered_map<const Predicate*, VerletList> verlet_lists;
+    FrameCoords frame;   ///< Coordinates of the current frame; null until a list needs them
+    bool index_stale = false;  ///< Spatial index not yet refitted to frame
+    std::vector<std::pair<const std::vector<float>*, float>> displacements;  ///< Per build frame, this frame
+    std::uint64_t neighbor_list_builds = 0;
 
-    // Caches keyed by predicate canonical form
-    std::unordered_map<std::string, std::unordered_set<unsigned int>> residue_cache;
-    std::unordered_map<std::string, std::unordered_set<unsigned int>> chain_cache;
-    std::unordered_map<std::string, std::vector<bool>> around_cache;
+    // Indexes over the atom subsets distance predicates are restricted to, most recent first
+    std::vector<DomainIndex> domain_indexes;
+    std::uint64_t domain_index_builds = 0;
 
-    Impl(OEChem::OEMolBase& m, const OESelection& s) : mol(m), sele(s) {}
+    std::unique_ptr<Profiler> profiler;  ///< Null unless profiling
+    std::vector<Bitset> scratch;         ///< Register file for compiled programs
+
+    Impl(OEChem::OEMolBase& m, const OESelection& s);
+
+    /// Refit the spatial index and drop cached masks that depend on coordinates
+    void RefreshCoordinates(const float* xyz);
+
+    /// Drop cached masks that depend on coordinates
+    void InvalidateCoordinateResults();
+
+    /// Coordinates of the current frame, read from the molecule on first use
+    const FrameCoords& CurrentFrame();
+
+    /// Largest displacement since @p since, computed once per frame
+    float DisplacementSince(const FrameCoords& since);
+
+    /// Forget every pair list and the frames they were built on
+    void ClearVerletLists();
+
+    /// Cell list over @p atoms, built on first use and refitted after coordinate updates
+    const SpatialIndex& GetDomainIndex(const Bitset& atoms, float radius);
+
+    /// Worker pool for a step over @p count atom indices, or null to run inline
+    WorkStealingPool* Pool(size_t count);
 };
 
+namespace {
+/// Whether predicate type reads atom coordinates
+bool is_distance_predicate(const PredicateType type) {
+    return type == PredicateType::AROUND || type == PredicateType::EXPAND ||
+           type == PredicateType::BEYOND || type == PredicateType::NEAREST;
+}
+
+/**
+ * @brief Flag the cache slots whose result depends on atom coordinates.
+ * @param pred Root of subtree to scan.
+ * @param flags Per-slot flags, sized to the selection's slot count.
+ * @return true if the subtree contains a distance predicate.
+ */
+bool mark_coordinate_slots(const Predicate& pred, std::vector<char>& flags) {
+    bool uses = is_distance_predicate(pred.Type());
+    for (const auto& child : pred.Children()) {
+        uses |= mark_coordinate_slots(*child, flags);
+    }
+    if (uses && pred.Slot() < flags.size()) {
+        flags[pred.Slot()] = 1;
+    }
+    return uses;
+}
+}  // namespace
+
+Context::Impl::Impl(OEChem::OEMolBase& m, const OESelection& s)
+    : mol(&m)
+    , sele(s)
+    , slot_masks(s.NumSlots())
+    , slot_results(s.NumSlots())
+    , slot_cached(s.NumSlots(), 0)
+    , slot_uses_coordinates(s.NumSlots(), 0) {
+    mark_coordinate_slots(s.Root(), slot_uses_coordinates);
+}
+
+void Context::Impl::RefreshCoordinates(const float* xyz) {
+    if (verlet_skin > 0.0f) {
+        // Pair lists answer most frames, so the index is refitted only when one is rebuilt
+        frame = std::make_shared<const std::vector<float>>(xyz, xyz + size_t{mol->GetMaxAtomIdx()} * 3);
+        displacements.clear();
+        index_stale = spatial_index != nullptr;
+    } else {
+        if (spatial_index) {
+            spatial_index->UpdateCoordinates(xyz);
+        }
+        // Domain indexes refit from the frame on their next query
+        frame.reset();
+    }
+    for (DomainIndex& domain : domain_indexes) {
+        domain.stale = true;
+    }
+    InvalidateCoordinateResults();
+}
+
+const FrameCoords& Context::Impl::CurrentFrame() {
+    if (!frame) {
+        auto xyz = std::make_shared<std::vector<float>>(size_t{mol->GetMaxAtomIdx()} * 3);
+        mol->GetCoords(xyz->data());
+        frame = std::move(xyz);
+    }
+    return frame;
+}
+
+float Context::Impl::DisplacementSince(const FrameCoords& since) {
+    for (const auto& [coords, displacement] : displacements) {
+        if (coords == since.get()) return displacement;
+    }
+    const float displacement = max_displacement(*since, *CurrentFrame(), cell);
+    displacements.emplace_back(since.get(), displacement);
+    return displacement;
+}
+
+void Context::Impl::ClearVerletLists() {
+    verlet_lists.clear();
+    frame.reset();
+    displacements.clear();
+}
+
+const SpatialIndex& Context::Impl::GetDomainIndex(const Bitset& atoms, const float radius) {
+    // Cells sized to one cutoff are too coarse or too fine for another, so the radius is part of the key
+    const auto hit = std::find_if(domain_indexes.begin(), domain_indexes.end(), [&](const DomainIndex& domain) {
+        return domain.radius == radius && domain.atoms == atoms;
+    });
+    if (hit != domain_indexes.end()) {
+        std::rotate(domain_indexes.begin(), hit, hit + 1);
+    } else {
+        if (domain_indexes.size() == kMaxDomainIndexes) {
+            domain_indexes.pop_back();
+        }
+        DomainIndex domain;
+        domain.atoms = atoms;
+        domain.radius = radius;
+        domain.index = std::make_unique<SpatialIndex>(*mol, atoms, SpatialBackend::CELL_LIST, radius, cell);
+        domain_indexes.insert(domain_indexes.begin(), std::move(domain));
+        ++domain_index_builds;
+    }
+    DomainIndex& domain = domain_indexes.front();
+    if (domain.stale) {
+        domain.index->UpdateCoordinates(CurrentFrame()->data());
+        domain.stale = false;
+    }
+    return *domain.index;
+}
+
+void Context::Impl::InvalidateCoordinateResults() {
+    for (size_t slot = 0; slot < slot_cached.size(); ++slot) {
+        if (slot_uses_coordinates[slot]) {
+            slot_cached[slot] = 0;
+        }
+    }
+    // Unnumbered predicates carry no dependency information
+    unslotted_masks.clear();
+}
+
+WorkStealingPool* Context::Impl::Pool(const size_t count) {
+    if (num_threads <= 1 || count < kParallelMinAtoms) {
+        return nullptr;
+    }
+    if (!pool) {
+        pool = std::make_unique<WorkStealingPool>(num_threads);
+    }
+    return pool.get();
+}
+
 Context::Context(OEChem::OEMolBase& mol, const OESelection& sele)
     : pimpl_(std::make_unique<Impl>(mol, sele)) {}
 
 Context::~Context() = default;
 
-OEChem::OEMolBase& Context::Mol() { return pimpl_->mol; }
-const OEChem::OEMolBase& Context::Mol() const { return pimpl_->mol; }
+OEChem::OEMolBase& Context::Mol() { return *pimpl_->mol; }
+const OEChem::OEMolBase& Context::Mol() const { return *pimpl_->mol; }
 const OESelection& Context::Sele() const { return pimpl_->sele; }
 
+namespace {
+/// Largest radius used by any distance predicate in the tree
+float max_distance_radius(const Predicate& pred) {
+    float radius = 0.0f;
+    switch (pred.Type()) {
+        case PredicateType::AROUND:
+            radius = static_cast<const AroundPredicate&>(pred).Radius();
+            break;
+        case PredicateType::EXPAND:
+            radius = static_cast<const ExpandPredicate&>(pred).Radius();
+            break;
+        case PredicateType::BEYOND:
+            radius = static_cast<const BeyondPredicate&>(pred).Radius();
+            break;
+        default:
+            break;
+    }
+    for (const auto& child : pred.Children()) {
+        radius = std::max(radius, max_distance_radius(*child));
+    }
+    return radius;
+}
+}  // namespace
+
 SpatialIndex& Context::GetSpatialIndex() {
     // Lazy initialization - only create when needed
     if (!pimpl_->spatial_index) {
-        pimpl_->spatial_index = std::make_unique<SpatialIndex>(pimpl_->mol);
+        const OESelection& sele = pimpl_->sele;
+        float cutoff = 0.0f;
+        if (sele.ContainsPredicate(PredicateType::AROUND) ||
+            sele.ContainsPredicate(PredicateType::EXPAND) ||
+            sele.ContainsPredicate(PredicateType::BEYOND)) {
+            cutoff = max_distance_radius(sele.Root()) + pimpl_->verlet_skin;
+        }
+        // Constructed here rather than with make_unique: the pooled constructor is private
+        pimpl_->spatial_index.reset(new SpatialIndex(*pimpl_->mol, SpatialBackend::AUTO, cutoff, pimpl_->cell,
+                                                     pimpl_->Pool(pimpl_->mol->NumAtoms())));
+        pimpl_->index_stale = false;
+    } else if (pimpl_->index_stale) {
+        pimpl_->spatial_index->UpdateCoordinates(pimpl_->CurrentFrame()->data());
+        pimpl_->index_stale = false;
     }
     return *pimpl_->spatial_index;
 }
 
-const std::unordered_set<unsigned int>& Context::GetResidueAtoms(const std::string& key) {
-    return pimpl_->residue_cache[key];
+const Bitset& Context::GetAtomMask() {
+    if (!pimpl_->atom_mask) {
+        auto mask = std::make_unique<Bitset>(pimpl_->mol->GetMaxAtomIdx());
+        for (OESystem::OEIter atom = pimpl_->mol->GetAtoms(); atom; ++atom) {
+            mask->Set(atom->GetIdx());
+        }
+        pimpl_->atom_mask = std::move(mask);
+    }
+    return *pimpl_->atom_mask;
 }
 
-void Context::SetResidueAtoms(const std::string& key, std::unordered_set<unsigned int> atoms) {
-    pimpl_->residue_cache[key] = std::move(atoms);
+const AtomTable& Context::GetAtomTable() {
+    if (!pimpl_->atom_table) {
+        pimpl_->atom_table = std::make_unique<AtomTable>(*pimpl_->mol);
+    }
+    return *pimpl_->atom_table;
 }
 
-bool Context::HasResidueCache(const std::string& key) const {
-    return pimpl_->residue_cache.find(key) != pimpl_->residue_cache.end();
+const BondGraph& Context::GetBondGraph() {
+    if (!pimpl_->bond_graph) {
+        pimpl_->bond_graph = std::make_unique<BondGraph>(*pimpl_->mol);
+    }
+    return *pimpl_->bond_graph;
 }
 
-const std::unordered_set<unsigned int>& Context::GetChainAtoms(const std::string& key) {
-    return pimpl_->chain_cache[key];
+void Context::SetTables(std::unique_ptr<AtomTable> table, std::unique_ptr<BondGraph> bonds) {
+    const size_t size = pimpl_->mol->GetMaxAtomIdx();
+    if ((table && table->Size() != size) || (bonds && bonds->Size() != size)) {
+        throw SelectionError("Atom snapshot does not match the molecule");
+    }
+    if (table) pimpl_->atom_table = std::move(table);
+    if (bonds) pimpl_->bond_graph = std::move(bonds);
+    std::fill(pimpl_->slot_cached.begin(), pimpl_->slot_cached.end(), 0);
+    pimpl_->unslotted_masks.clear();
 }
 
-void Context::SetChainAtoms(const std::string& key, std::unordered_set<unsigned int> atoms) {
-    pimpl_->chain_cache[key] = std::move(atoms);
+void Context::Reset(OEChem::OEMolBase& mol) {
+    pimpl_->mol = &mol;
+    pimpl_->spatial_index.reset();
+    pimpl_->index_stale = false;
+    pimpl_->domain_indexes.clear();
+    pimpl_->ClearVerletLists();
+    pimpl_->atom_mask.reset();
+    pimpl_->atom_table.reset();
+    pimpl_->bond_graph.reset();
+    std::fill(pimpl_->slot_cached.begin(), pimpl_->slot_cached.end(), 0);
+    pimpl_->unslotted_masks.clear();
 }
 
-bool Context::HasChainCache(const std::string& key) const {
-    return pimpl_->chain_cache.find(key) != pimpl_->chain_cache.end();
+void Context::SetUnitCell(const UnitCell& cell) {
+    if (cell == pimpl_->cell) return;
+    pimpl_->cell = cell;
+    // The index is rebuilt for the new box on next use
+    pimpl_->spatial_index.reset();
+    pimpl_->index_stale = false;
+    pimpl_->domain_indexes.clear();
+    pimpl_->ClearVerletLists();
+    pimpl_->InvalidateCoordinateResults();
 }
 
-const std::vector<bool>& Context::GetAroundCache(const std::string& key) {
-    return pimpl_->around_cache[key];
+const UnitCell& Context::GetUnitCell() const {
+    return pimpl_->cell;
 }
 
-void Context::SetAroundCache(const std::string& key, std::vector<bool> cache) {
-    pimpl_->around_cache[key] = std::move(cache);
+void Context::SetNamedSet(const std::string& name, OESelectionResult result) {
+    const bool valid = !name.empty() && !std::isdigit(static_cast<unsigned char>(name[0])) &&
+                       std::all_of(name.begin(), name.end(), [](const char c) {
+                           return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+                       });
+    if (!valid) {
+        throw SelectionError("Invalid named set name: '" + name + "'");
+    }
+    pimpl_->named_sets[name] = std::move(result);
+    std::fill(pimpl_->slot_cached.begin(), pimpl_->slot_cached.end(), 0);
+    pimpl_->unslotted_masks.clear();
 }
 
-bool Context::HasAroundCache(const std::string& key) const {
-    return pimpl_->around_cache.find(key) != pimpl_->around_cache.end();
+bool Context::RemoveNamedSet(const std::string& name) {
+    if (pimpl_->named_sets.erase(name) == 0) return false;
+    std::fill(pimpl_->slot_cached.begin(), pimpl_->slot_cached.end(), 0);
+    pimpl_->unslotted_masks.clear();
+    return true;
+}
+
+void Context::ClearNamedSets() {
+    if (pimpl_->named_sets.empty()) return;
+    pimpl_->named_sets.clear();
+    std::fill(pimpl_->slot_cached.begin(), pimpl_->slot_cached.end(), 0);
+    pimpl_->unslotted_masks.clear();
+}
+
+const OESelectionResult& Context::GetNamedSet(const std::string& name) const {
+    const auto it = pimpl_->named_sets.find(name);
+    if (it == pimpl_->named_sets.end()) {
+        throw SelectionError("Unknown named set: %" + name);
+    }
+    if (it->second.Size() != pimpl_->mol->GetMaxAtomIdx()) {
+        throw SelectionError("Named set %" + name + " covers " + std::to_string(it->second.Size()) +
+                             " atoms but the molecule has " + std::to_string(pimpl_->mol->GetMaxAtomIdx()));
+    }
+    return it->second;
+}
+
+const std::map<std::string, OESelectionResult>& Context::GetNamedSets() const {
+    return pimpl_->named_sets;
+}
+
+void Context::SetNumThreads(const unsigned int num_threads) {
+    const unsigned int resolved = num_threads != 0 ? num_threads : std::max(1U, std::thread::hardware_concurrency());
+    if (resolved == pimpl_->num_threads) return;
+    pimpl_->num_threads = resolved;
+    pimpl_->pool.reset();
+    if (pimpl_->spatial_index) {
+        pimpl_->spatial_index->SetPool(pimpl_->Pool(pimpl_->spatial_index->Size()));
+    }
+}
+
+unsigned int Context::GetNumThreads() const {
+    return pimpl_->num_threads;
+}
+
+void Context::SetVerletSkin(const float skin) {
+    if (!std::isfinite(skin) || skin < 0.0f) {
+        throw SelectionError("Verlet skin must be non-negative and finite");
+    }
+    if (skin == pimpl_->verlet_skin) return;
+    pimpl_->verlet_skin = skin;
+    // The cell-list cutoff includes the skin
+    pimpl_->spatial_index.reset();
+    pimpl_->index_stale = false;
+    pimpl_->ClearVerletLists();
+}
+
+float Context::GetVerletSkin() const {
+    return pimpl_->verlet_skin;
+}
+
+std::uint64_t Context::NumNeighborListBuilds() const {
+    return pimpl_->neighbor_list_builds;
+}
+
+void Context::MarkWithinRadius(const Predicate& owner, const Bitset& refs, const float radius, Bitset& out) {
+    const float skin = pimpl_->verlet_skin;
+    if (!(skin > 0.0f)) {
+        GetSpatialIndex().MarkWithinRadius(refs, radius, out);
+        CountSpatialQuery();
+        return;
+    }
+
+    VerletList& list = pimpl_->verlet_lists[&owner];
+    const float displacement = list.Frame() ? pimpl_->DisplacementSince(list.Frame()) : 0.0f;
+    if (!list.Covers(refs, radius, skin, displacement)) {
+        const SpatialIndex& index = GetSpatialIndex();
+        list.Build(index, refs, GetAtomMask(), radius, skin, pimpl_->CurrentFrame());
+        ++pimpl_->neighbor_list_builds;
+        CountSpatialQuery();
+    }
+    list.Mark(pimpl_->CurrentFrame()->data(), pimpl_->cell, out);
+}
+
+void Context::MarkWithinRadius(const Predicate& owner, const Bitset& refs, const float radius, const Bitset& domain,
+                               Bitset& out) {
+    const size_t num_refs = refs.Count();
+    const size_t num_domain = domain.Count();
+    // Neighbor lists and the pooled full index already serve their cases; a
+    // subset index pays off only when one side is a small part of the molecule
+    if (pimpl_->verlet_skin > 0.0f || pimpl_->Pool(pimpl_->mol->NumAtoms()) ||
+        std::min(num_refs, num_domain) > pimpl_->mol->NumAtoms() / 2) {
+        Bitset near(out.Size());
+        MarkWithinRadius(owner, refs, radius, near);
+        near &= domain;
+        out |= near;
+        return;
+    }
+
+    if (num_refs == 0 || num_domain == 0) return;
+
+    // Index the smaller side and stream the other side's atoms through it
+    const float* xyz = pimpl_->CurrentFrame()->data();
+    if (num_refs <= num_domain) {
+        pimpl_->GetDomainIndex(refs, radius).MarkNearIndexed(xyz, domain, radius, out);
+    } else {
+        pimpl_->GetDomainIndex(domain, radius).MarkIndexedNear(xyz, refs, radius, out);
+    }
+    CountSpatialQuery();
+}
+
+std::uint64_t Context::NumDomainIndexBuilds() const {
+    return pimpl_->domain_index_builds;
+}
+
+void Context::ForEachChunk(const size_t count,
+                           const std::function<void(size_t begin, size_t end, unsigned int worker)>& body) {
+    WorkStealingPool* pool = pimpl_->Pool(count);
+    if (!pool) {
+        if (count > 0) {
+            body(0, count, 0);
+        }
+        return;
+    }
+    const size_t num_chunks = (count + kChunkAtoms - 1) / kChunkAtoms;
+    pool->ParallelFor(num_chunks, [&](const size_t chunk, const unsigned int worker) {
+        body(chunk * kChunkAtoms, std::min(count, (chunk + 1) * kChunkAtoms), worker);
+    });
+}
+
+void Context::UpdateCoordinates(const float* xyz) {
+    pimpl_->mol->SetCoords(xyz);
+    pimpl_->RefreshCoordinates(xyz);
+}
+
+void Context::UpdateCoordinates() {
+    std::vector<float> xyz(static_cast<size_t>(pimpl_->mol->GetMaxAtomIdx()) * 3);
+    pimpl_->mol->GetCoords(xyz.data());
+    pimpl_->RefreshCoordinates(xyz.data());
+}
+
+bool Context::UsesCoordinates(const Predicate& pred) const {
+    const unsigned int slot = pred.Slot();
+    return slot >= pimpl_->slot_uses_coordinates.size() || pimpl_->slot_uses_coordinates[slot];
+}
+
+void Context::SetShareStaticResults(const bool share) {
+    pimpl_->share_static_results = share;
+}
+
+namespace {
+/// EvaluateSubtree() without profiling
+void evaluate_subtree(Context& ctx, const bool share_static_results, const Predicate& pred, Bitset& out) {
+    if (!share_static_results || ctx.UsesCoordinates(pred)) {
+        pred.EvaluateAll(ctx, out);
+        return;
+    }
+    // Static predicates cache their own result, which survives coordinate updates
+    if (const Bitset* cached = ctx.GetCachedMask(pred)) {
+        out |= *cached;
+        return;
+    }
+    pred.EvaluateAll(ctx, out);
+    ctx.SetCachedMask(pred, out);
+}
+
+/// EvaluateSubtreeWithin() without profiling
+void evaluate_subtree_within(Context& ctx, const bool share_static_results, const Predicate& pred,
+                             const Bitset& domain, Bitset& out) {
+    if (ctx.UsesCoordinates(pred)) {
+        pred.EvaluateWithin(ctx, domain, out);
+        return;
+    }
+    evaluate_subtree(ctx, share_static_results, pred, out);
+}
+
+/// Keeps the profiler's active-node stack balanced when evaluation throws
+class ActiveNodeGuard {
+public:
+    ActiveNodeGuard(Profiler& profiler, const Predicate& pred) : profiler_(profiler) {
+        profiler_.active.push_back(&pred);
+    }
+    ~ActiveNodeGuard() { profiler_.active.pop_back(); }
+
+    ActiveNodeGuard(const ActiveNodeGuard&) = delete;
+    ActiveNodeGuard& operator=(const ActiveNodeGuard&) = delete;
+
+private:
+    Profiler& profiler_;
+};
+
+/// Append the profile of @p pred and its subtree in pre-order
+void collect_profile(const Predicate& pred, const unsigned int depth, const Profiler& profiler,
+                     std::vector<NodeProfile>& nodes) {
+    NodeProfile node;
+    node.label = pred.ToCanonical();
+    node.type = pred.Type();
+    node.depth = depth;
+    if (const auto it = profiler.stats.find(&pred); it != profiler.stats.end()) {
+        const NodeStats& stats = it->second;
+        node.evaluations = stats.evaluations;
+        node.seconds = stats.seconds;
+        node.cache_hits = stats.cache_hits;
+        node.cache_misses = stats.cache_misses;
+        node.atoms_evaluated = stats.atoms_evaluated;
+        node.atoms_matched = stats.atoms_matched;
+        node.spatial_queries = stats.spatial_queries;
+    }
+
+    double child_seconds = 0.0;
+    for (const auto& child : pred.Children()) {
+        if (const auto it = profiler.stats.find(child.get()); it != profiler.stats.end()) {
+            child_seconds += it->second.seconds;
+        }
+    }
+    // Shared children may also have been timed under other parents
+    node.self_seconds = std::max(0.0, node.seconds - child_seconds);
+
+    nodes.push_back(std::move(node));
+    for (const auto& child : pred.Children()) {
+        collect_profile(*child, depth + 1, profiler, nodes);
+    }
+}
+}  // namespace
+
+void Context::EvaluateSubtree(const Predicate& pred, Bitset& out) {
+    Profiler* profiler = pimpl_->profiler.get();
+    if (!profiler) {
+        evaluate_subtree(*this, pimpl_->share_static_results, pred, out);
+        return;
+    }
+
+    NodeStats& stats = profiler->stats[&pred];
+    const size_t matched_before = out.Count();
+    const auto start = std::chrono::steady_clock::now();
+    {
+        const ActiveNodeGuard guard(*profiler, pred);
+        evaluate_subtree(*this, pimpl_->share_static_results, pred, out);
+    }
+    stats.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    ++stats.evaluations;
+    stats.atoms_evaluated += pimpl_->mol->NumAtoms();
+    stats.atoms_matched += out.Count() - matched_before;
+}
+
+void Context::EvaluateSubtreeWithin(const Predicate& pred, const Bitset& domain, Bitset& out) {
+    Profiler* profiler = pimpl_->profiler.get();
+    if (!profiler) {
+        evaluate_subtree_within(*this, pimpl_->share_static_results, pred, domain, out);
+        return;
+    }
+
+    NodeStats& stats = profiler->stats[&pred];
+    const size_t matched_before = out.Count();
+    const auto start = std::chrono::steady_clock::now();
+    {
+        const ActiveNodeGuard guard(*profiler, pred);
+        evaluate_subtree_within(*this, pimpl_->share_static_results, pred, domain, out);
+    }
+    stats.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    ++stats.evaluations;
+    stats.atoms_evaluated += domain.Count();
+    stats.atoms_matched += out.Count() - matched_before;
+}
+
+void Context::EvaluateSelection(Bitset& out) {
+    if (pimpl_->profiler || pimpl_->share_static_results) {
+        EvaluateSubtree(pimpl_->sele.Root(), out);
+        return;
+    }
+    pimpl_->sele.GetProgram().Run(*this, out);
+}
+
+Bitset* Context::GetScratchMasks(const size_t count, const size_t size) {
+    std::vector<Bitset>& scratch = pimpl_->scratch;
+    if (scratch.size() < count) {
+        scratch.resize(count);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        if (scratch[i].Size() != size) {
+            scratch[i] = Bitset(size);
+        }
+    }
+    return scratch.data();
+}
+
+void Context::SetProfiling(const bool enabled) {
+    pimpl_->profiler = enabled ? std::make_unique<Profiler>() : nullptr;
+}
+
+bool Context::IsProfiling() const {
+    return pimpl_->profiler != nullptr;
+}
+
+EvaluationProfile Context::GetProfile() const {
+    if (!pimpl_->profiler) {
+        return {};
+    }
+    std::vector<NodeProfile> nodes;
+    collect_profile(pimpl_->sele.Root(), 0, *pimpl_->profiler, nodes);
+    return EvaluationProfile(std::move(nodes));
+}
+
+void Context::CountSpatialQuery() {
+    if (Profiler* profiler = pimpl_->profiler.get(); profiler && !profiler->active.empty()) {
+        ++profiler->stats[profiler->active.back()].spatial_queries;
+    }
+}
+
+const Bitset* Context::GetCachedMask(const Predicate& pred) const {
+    const Bitset* cached = nullptr;
+    if (const unsigned int slot = pred.Slot(); slot < pimpl_->slot_masks.size()) {
+        cached = (pimpl_->slot_cached[slot] & kMaskCached) ? &pimpl_->slot_masks[slot] : nullptr;
+    } else if (const auto it = pimpl_->unslotted_masks.find(&pred); it != pimpl_->unslotted_masks.end()) {
+        cached = &it->second;
+    }
+    if (Profiler* profiler = pimpl_->profiler.get()) {
+        NodeStats& stats = profiler->stats[&pred];
+        ++(cached ? stats.cache_hits : stats.cache_misses);
+    }
+    return cached;
+}
+
+const Bitset& Context::SetCachedMask(const Predicate& pred, Bitset mask) {
+    if (const unsigned int slot = pred.Slot(); slot < pimpl_->slot_masks.size()) {
+        pimpl_->slot_masks[slot] = std::move(mask);
+        pimpl_->slot_cached[slot] |= kMaskCached;
+        return pimpl_->slot_masks[slot];
+    }
+    return pimpl_->unslotted_masks[&pred] = std::move(mask);
+}
+
+const Bitset* Context::GetCachedResult(const Predicate& pred) const {
+    const unsigned int slot = pred.Slot();
+    if (slot >= pimpl_->slot_results.size()) return nullptr;
+    return (pimpl_->slot_cached[slot] & kResultCached) ? &pimpl_->slot_results[slot] : nullptr;
+}
+
+void Context::SetCachedResult(const Predicate& pred, Bitset mask) {
+    // Unnumbered predicates keep only the shared entry
+    if (const unsigned int slot = pred.Slot(); slot < pimpl_->slot_results.size()) {
+        pimpl_->slot_results[slot] = std::move(mask);
+        pimpl_->slot_cached[slot] |= kResultCached;
+    }
 }
 
 }  // namespace OESel
@@ -8,6 +8,8 @@
  */
 
 #include "oeselect/Parser.h"
+#include "oeselect/Bitset.h"
+#include "oeselect/Context.h"
 #include "oeselect/Error.h"
 #include "oeselect/predicates/NamePredicate.h"
 #include "oeselect/predicates/LogicalPredicates.h"
@@ -17,12 +19,16 @@
 #include "oeselect/predicates/DistancePredicates.h"
 #include "oeselect/predicates/ExpansionPredicates.h"
 #include "oeselect/predicates/SecondaryStructurePredicates.h"
+#include "oeselect/predicates/NamedSetPredicate.h"
 
 #include <tao/pegtl.hpp>
+#include <algorithm>
 #include <cmath>
 #include <limits>
 #include <stack>
 #include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace pegtl = tao::pegtl;
 
@@ -80,6 +86,8 @@ struct kw_backbone : pegtl::sor<TAO_PEGTL_ISTRING("backbone"), TAO_PEGTL_ISTRING
 struct kw_sidechain : pegtl::sor<TAO_PEGTL_ISTRING("sidechain"), TAO_PEGTL_ISTRING("sc")> {};
 struct kw_metal : pegtl::sor<TAO_PEGTL_ISTRING("metals"), TAO_PEGTL_ISTRING("metal")> {};
 struct kw_capping : pegtl::sor<TAO_PEGTL_ISTRING("capping"), TAO_PEGTL_ISTRING("caps")> {};
+struct kw_lipid : pegtl::sor<TAO_PEGTL_ISTRING("lipids"), TAO_PEGTL_ISTRING("lipid")> {};
+struct kw_glycan : pegtl::sor<TAO_PEGTL_ISTRING("glycans"), TAO_PEGTL_ISTRING("glycan")> {};
 
 // Atom type keywords (order matters for disambiguation)
 struct kw_heavy : TAO_PEGTL_ISTRING("heavy") {};
@@ -114,6 +122,10 @@ struct kw_expand : TAO_PEGTL_ISTRING("expand") {};
 struct kw_beyond : TAO_PEGTL_ISTRING("beyond") {};
 struct kw_byres : TAO_PEGTL_ISTRING("byres") {};
 struct kw_bychain : TAO_PEGTL_ISTRING("bychain") {};
+struct kw_bound_to : TAO_PEGTL_ISTRING("bound_to") {};
+struct kw_extend : TAO_PEGTL_ISTRING("extend") {};
+struct kw_nearest : TAO_PEGTL_ISTRING("nearest") {};
+struct kw_to : TAO_PEGTL_ISTRING("to") {};
 
 // Secondary structure keywords
 struct kw_helix : TAO_PEGTL_ISTRING("helix") {};
@@ -177,6 +189,8 @@ struct backbone_spec : kw_backbone {};
 struct sidechain_spec : kw_sidechain {};
 struct metal_spec : kw_metal {};
 struct capping_spec : kw_capping {};
+struct lipid_spec : kw_lipid {};
+struct glycan_spec : kw_glycan {};
 
 struct heavy_spec : kw_heavy {};
 struct polar_hydrogen_spec : kw_polar_hydrogen {};
@@ -191,6 +205,13 @@ struct loop_spec : kw_loop {};
 struct all_spec : kw_all {};
 struct none_spec : kw_none {};
 
+// Named set: %name refers to a result bound with Context::SetNamedSet()
+struct named_set_name : pegtl::seq<
+    pegtl::sor<pegtl::alpha, pegtl::one<'_'>>,
+    pegtl::star<pegtl::sor<pegtl::alnum, pegtl::one<'_'>>>
+> {};
+struct named_set_spec : pegtl::seq<pegtl::one<'%'>, named_set_name> {};
+
 // Hierarchical macro: //chain/resi/name
 struct macro_prefix : pegtl::string<'/', '/'> {};
 struct macro_chain : pegtl::opt<chain_id> {};
@@ -227,13 +248,17 @@ struct expand_suffix : pegtl::seq<kw_expand, ws_required, float_num> {};
 struct beyond_suffix : pegtl::seq<kw_beyond, ws_required, float_num> {};
 struct distance_suffix : pegtl::sor<expand_suffix, around_suffix, beyond_suffix> {};
 
+// Bond graph extension suffix (infix syntax: <selection> extend <bonds>)
+struct extend_count : number {};
+struct extend_suffix : pegtl::seq<kw_extend, ws_required, extend_count> {};
+
 // All specifiers (order matters - longer matches first)
 struct specifier : pegtl::sor<
-    macro_spec,
+    macro_spec, named_set_spec,
     name_spec, resn_spec, resi_spec, chain_spec, elem_spec, index_spec,
     id_spec, alt_spec, b_spec, frag_spec,
     protein_spec, ligand_spec, water_spec, solvent_spec, organic_spec,
-    backbone_spec, sidechain_spec, metal_spec, capping_spec,
+    backbone_spec, sidechain_spec, metal_spec, capping_spec, lipid_spec, glycan_spec,
     helix_spec, sheet_spec, turn_spec, loop_spec,
     heavy_spec, polar_hydrogen_spec, nonpolar_hydrogen_spec, hydrogen_spec,
     all_spec, none_spec
@@ -241,8 +266,11 @@ struct specifier : pegtl::sor<
 
 struct primary : pegtl::sor<paren_expr, specifier> {};
 
-// Distance expression: primary optionally followed by a distance suffix
-struct distance_expr : pegtl::seq<primary, pegtl::opt<pegtl::seq<ws_required, distance_suffix>>> {};
+// Distance expression: primary optionally followed by a distance or extend suffix
+struct distance_expr : pegtl::seq<
+    primary,
+    pegtl::opt<pegtl::seq<ws_required, pegtl::sor<distance_suffix, extend_suffix>>>
+> {};
 
 // Operator markers for action tracking
 struct not_op : kw_not {};
@@ -256,12 +284,26 @@ struct not_expr;
 // Expansion operators as prefix on not_expr
 struct byres_expr : pegtl::seq<kw_byres, ws_required, not_expr> {};
 struct bychain_expr : pegtl::seq<kw_bychain, ws_required, not_expr> {};
+struct bound_to_expr : pegtl::seq<kw_bound_to, ws_required, not_expr> {};
+
+// k-nearest operator: nearest <count> [byres] <candidates> to <reference>
+struct nearest_count : number {};
+struct nearest_byres : kw_byres {};
+struct nearest_head : pegtl::seq<
+    kw_nearest, ws_required, nearest_count,
+    pegtl::opt<pegtl::seq<ws_required, nearest_byres>>
+> {};
+struct nearest_expr : pegtl::seq<
+    nearest_head, ws_required, not_expr, ws_required, kw_to, ws_required, not_expr
+> {};
 
 // Expression grammar with precedence
 struct not_expr : pegtl::sor<
     pegtl::seq<not_op, ws_required, not_expr>,
     byres_expr,
     bychain_expr,
+    bound_to_expr,
+    nearest_expr,
     distance_expr
 > {};
 
@@ -280,7 +322,8 @@ struct xor_expr : pegtl::seq<
     pegtl::star<pegtl::seq<ws_required, xor_op, ws_required, or_expr>>
 > {};
 
-struct expression : xor_expr {};
+// Wraps xor_expr rather than deriving from it, so that the XOR action runs
+struct expression : pegtl::seq<xor_expr> {};
 struct selection : pegtl::seq<ws, expression, ws, pegtl::eof> {};
 
 }  // namespace Grammar
@@ -315,6 +358,16 @@ struct ParserState {
     // Distance predicate state
     float current_radius = 0.0f;
 
+    // Bond count for extend
+    unsigned int current_bonds = 0;
+
+    // Count and residue flag of each open nearest operator (innermost last)
+    struct NearestHead {
+        unsigned int count = 0;
+        bool by_residue = false;
+    };
+    std::vector<NearestHead> nearest_heads;
+
     // Hierarchical macro state
     std::string macro_chain;
     int macro_resi = -1;
@@ -366,6 +419,7 @@ struct ParserState {
 class TruePredicateImpl : public Predicate {
 public:
     bool Evaluate(Context&, const OEChem::OEAtomBase&) const override { return true; }
+    void EvaluateAll(Context& ctx, Bitset& out) const override { out |= ctx.GetAtomMask(); }
     [[nodiscard]] std::string ToCanonical() const override { return "all"; }
     [[nodiscard]] PredicateType Type() const override { return PredicateType::ALL_MATCH; }
 };
@@ -374,6 +428,7 @@ public:
 class FalsePredicateImpl : public Predicate {
 public:
     bool Evaluate(Context&, const OEChem::OEAtomBase&) const override { return false; }
+    void EvaluateAll(Context&, Bitset&) const override {}
     [[nodiscard]] std::string ToCanonical() const override { return "none"; }
     [[nodiscard]] PredicateType Type() const override { return PredicateType::NO_MATCH; }
 };
@@ -813,6 +868,22 @@ struct Action<Grammar::capping_spec> {
     }
 };
 
+template<>
+struct Action<Grammar::lipid_spec> {
+    template<typename ActionInput>
+    static void apply(const ActionInput&, ParserState& state) {
+        state.PushOperand(std::make_shared<LipidPredicate>());
+    }
+};
+
+template<>
+struct Action<Grammar::glycan_spec> {
+    template<typename ActionInput>
+    static void apply(const ActionInput&, ParserState& state) {
+        state.PushOperand(std::make_shared<GlycanPredicate>());
+    }
+};
+
 // Atom type specifiers
 template<>
 struct Action<Grammar::heavy_spec> {
@@ -896,6 +967,14 @@ struct Action<Grammar::none_spec> {
     }
 };
 
+template<>
+struct Action<Grammar::named_set_name> {
+    template<typename ActionInput>
+    static void apply(const ActionInput& in, ParserState& state) {
+        state.PushOperand(std::make_shared<NamedSetPredicate>(in.string()));
+    }
+};
+
 // Hierarchical macro actions
 template<>
 struct Action<Grammar::macro_prefix> {
@@ -1007,6 +1086,54 @@ struct Action<Grammar::beyond_suffix> {
     }
 };
 
+// Bond count for the extend suffix
+template<>
+struct Action<Grammar::extend_count> {
+    template<typename ActionInput>
+    static void apply(const ActionInput& in, ParserState& state) {
+        state.current_bonds = static_cast<unsigned int>(parse_int_token(in.string()));
+    }
+};
+
+template<>
+struct Action<Grammar::extend_suffix> {
+    template<typename ActionInput>
+    static void apply(const ActionInput&, ParserState& state) {
+        auto child = state.PopOperand();
+        state.PushOperand(std::make_shared<ExtendPredicate>(state.current_bonds, std::move(child)));
+    }
+};
+
+// k-nearest operator
+template<>
+struct Action<Grammar::nearest_count> {
+    template<typename ActionInput>
+    static void apply(const ActionInput& in, ParserState& state) {
+        state.nearest_heads.push_back({static_cast<unsigned int>(parse_int_token(in.string())), false});
+    }
+};
+
+template<>
+struct Action<Grammar::nearest_byres> {
+    template<typename ActionInput>
+    static void apply(const ActionInput&, ParserState& state) {
+        state.nearest_heads.back().by_residue = true;
+    }
+};
+
+template<>
+struct Action<Grammar::nearest_expr> {
+    template<typename ActionInput>
+    static void apply(const ActionInput&, ParserState& state) {
+        auto reference = state.PopOperand();
+        auto candidates = state.PopOperand();
+        const ParserState::NearestHead head = state.nearest_heads.back();
+        state.nearest_heads.pop_back();
+        state.PushOperand(std::make_shared<NearestPredicate>(head.count, head.by_residue, std::move(candidates),
+                                                             std::move(reference)));
+    }
+};
+
 // Expansion operators (prefix on not_expr)
 template<>
 struct Action<Grammar::byres_expr> {
@@ -1026,6 +1153,15 @@ struct Action<Grammar::bychain_expr> {
     }
 };
 
+template<>
+struct Action<Grammar::bound_to_expr> {
+    template<typename ActionInput>
+    static void apply(const ActionInput&, ParserState& state) {
+        auto child = state.PopOperand();
+        state.PushOperand(std::make_shared<BoundToPredicate>(std::move(child)));
+    }
+};
+
 // Parentheses - context management
 template<>
 struct Action<Grammar::open_paren> {
@@ -1185,4 +1321,269 @@ Predicate::Ptr parse_selection(const std::string& sele) {
     return state.GetResult();
 }
 
+// ============================================================================
+// Optimizer
+// ============================================================================
+
+namespace {
+/// Relative per-atom evaluation cost used to order AND/OR children
+int estimate_cost(const Predicate& pred) {
+    int children_cost = 0;
+    for (const auto& child : pred.Children()) {
+        children_cost += estimate_cost(*child);
+    }
+
+    switch (pred.Type()) {
+        case PredicateType::ALL_MATCH:
+        case PredicateType::NO_MATCH:
+            return 0;
+
+        // Single column or atom property lookups
+        case PredicateType::NAME:
+        case PredicateType::RESN:
+        case PredicateType::RESI:
+        case PredicateType::CHAIN:
+        case PredicateType::ELEM:
+        case PredicateType::INDEX:
+        case PredicateType::ID:
+        case PredicateType::ALT:
+        case PredicateType::B_FACTOR:
+        case PredicateType::FRAGMENT:
+        case PredicateType::SECONDARY_STRUCTURE:
+        case PredicateType::NAMED_SET:
+        case PredicateType::HELIX:
+        case PredicateType::SHEET:
+        case PredicateType::TURN:
+        case PredicateType::LOOP:
+        case PredicateType::HEAVY:
+        case PredicateType::HYDROGEN:
+            return 1;
+
+        // Walk the atom's bonds
+        case PredicateType::POLAR_HYDROGEN:
+        case PredicateType::NONPOLAR_HYDROGEN:
+            return 2;
+
+        // Residue classification through the Tagger
+        case PredicateType::PROTEIN:
+        case PredicateType::LIGAND:
+        case PredicateType::WATER:
+        case PredicateType::SOLVENT:
+        case PredicateType::ORGANIC:
+        case PredicateType::BACKBONE:
+        case PredicateType::METAL:
+        case PredicateType::CAPPING:
+        case PredicateType::LIPID:
+        case PredicateType::GLYCAN:
+            return 4;
+
+        // Whole-molecule passes over child results
+        case PredicateType::BY_RES:
+        case PredicateType::BY_CHAIN:
+        case PredicateType::BOUND_TO:
+        case PredicateType::EXTEND:
+            return 16 + children_cost;
+
+        // Spatial index construction and radius or k-nearest queries
+        case PredicateType::AROUND:
+        case PredicateType::EXPAND:
+        case PredicateType::BEYOND:
+        case PredicateType::NEAREST:
+            return 64 + children_cost;
+
+        case PredicateType::AND:
+        case PredicateType::OR:
+        case PredicateType::NOT:
+        case PredicateType::XOR:
+            return 1 + children_cost;
+    }
+    return 1 + children_cost;
+}
+
+/// Bottom-up rewriter sharing nodes by canonical form
+class TreeOptimizer {
+public:
+    Predicate::Ptr Optimize(const Predicate::Ptr& pred) {
+        std::vector<Predicate::Ptr> children;
+        for (const auto& child : pred->Children()) {
+            children.push_back(Optimize(child));
+        }
+
+        switch (pred->Type()) {
+            case PredicateType::NOT:
+                return OptimizeNot(children[0]);
+            case PredicateType::AND:
+            case PredicateType::OR:
+                return OptimizeAssociative(pred->Type(), std::move(children));
+            case PredicateType::XOR:
+                return OptimizeXor(std::move(children));
+            case PredicateType::BY_RES:
+                return Intern(std::make_shared<ByResPredicate>(children[0]));
+            case PredicateType::BY_CHAIN:
+                return Intern(std::make_shared<ByChainPredicate>(children[0]));
+            case PredicateType::BOUND_TO:
+                return Intern(std::make_shared<BoundToPredicate>(children[0]));
+            case PredicateType::EXTEND:
+                return Intern(std::make_shared<ExtendPredicate>(
+                    static_cast<const ExtendPredicate&>(*pred).Bonds(), children[0]));
+            case PredicateType::AROUND:
+                return Intern(std::make_shared<AroundPredicate>(
+                    static_cast<const AroundPredicate&>(*pred).Radius(), children[0]));
+            case PredicateType::EXPAND:
+                return Intern(std::make_shared<ExpandPredicate>(
+                    static_cast<const ExpandPredicate&>(*pred).Radius(), children[0]));
+            case PredicateType::BEYOND:
+                return Intern(std::make_shared<BeyondPredicate>(
+                    static_cast<const BeyondPredicate&>(*pred).Radius(), children[0]));
+            case PredicateType::NEAREST: {
+                const auto& nearest = static_cast<const NearestPredicate&>(*pred);
+                return Intern(std::make_shared<NearestPredicate>(nearest.Count(), nearest.ByResidue(), children[0],
+                                                                 children[1]));
+            }
+            default:
+                // Leaf predicates are immutable and can be shared as-is
+                return Intern(pred);
+        }
+    }
+
+private:
+    std::unordered_map<std::string, Predicate::Ptr> nodes_;
+
+    /// Return the existing node with the same canonical form, or register this one
+    Predicate::Ptr Intern(Predicate::Ptr pred) {
+        const auto [it, inserted] = nodes_.try_emplace(pred->ToCanonical(), pred);
+        return it->second;
+    }
+
+    Predicate::Ptr Constant(const bool value) {
+        if (value) {
+            return Intern(std::make_shared<TruePredicateImpl>());
+        }
+        return Intern(std::make_shared<FalsePredicateImpl>());
+    }
+
+    Predicate::Ptr OptimizeNot(const Predicate::Ptr& child) {
+        switch (child->Type()) {
+            case PredicateType::NOT:
+                return child->Children()[0];
+            case PredicateType::ALL_MATCH:
+                return Constant(false);
+            case PredicateType::NO_MATCH:
+                return Constant(true);
+            default:
+                return Intern(std::make_shared<NotPredicate>(child));
+        }
+    }
+
+    Predicate::Ptr OptimizeAssociative(const PredicateType type, std::vector<Predicate::Ptr> children) {
+        const bool is_and = type == PredicateType::AND;
+        const PredicateType identity = is_and ? PredicateType::ALL_MATCH : PredicateType::NO_MATCH;
+        const PredicateType absorbing = is_and ? PredicateType::NO_MATCH : PredicateType::ALL_MATCH;
+
+        // Children are already optimized, so nested AND/OR are themselves flat
+        std::vector<Predicate::Ptr> flat;
+        for (const auto& child : children) {
+            if (child->Type() == type) {
+                const auto grandchildren = child->Children();
+                flat.insert(flat.end(), grandchildren.begin(), grandchildren.end());
+            } else {
+                flat.push_back(child);
+            }
+        }
+
+        std::vector<Predicate::Ptr> kept;
+        std::unordered_set<const Predicate*> seen;
+        for (const auto& child : flat) {
+            if (child->Type() == absorbing) {
+                return Constant(!is_and);
+            }
+            // Interned nodes compare equal by pointer
+            if (child->Type() != identity && seen.insert(child.get()).second) {
+                kept.push_back(child);
+            }
+        }
+
+        if (!is_and) {
+            FuseLeaves<NamePredicate>(PredicateType::NAME, kept);
+            FuseLeaves<ResnPredicate>(PredicateType::RESN, kept);
+        }
+
+        if (kept.empty()) {
+            return Constant(is_and);
+        }
+        if (kept.size() == 1) {
+            return kept[0];
+        }
+
+        std::stable_sort(kept.begin(), kept.end(), [](const auto& a, const auto& b) {
+            return estimate_cost(*a) < estimate_cost(*b);
+        });
+
+        if (is_and) {
+            return Intern(std::make_shared<AndPredicate>(std::move(kept)));
+        }
+        return Intern(std::make_shared<OrPredicate>(std::move(kept)));
+    }
+
+    /// Merge the name-pattern leaves of an OR into one compiled multi-pattern leaf
+    template<typename Leaf>
+    void FuseLeaves(const PredicateType type, std::vector<Predicate::Ptr>& children) {
+        std::vector<std::string> patterns;
+        size_t matched = 0;
+        for (const auto& child : children) {
+            if (child->Type() == type) {
+                const auto& leaf_patterns = static_cast<const Leaf&>(*child).Patterns();
+                patterns.insert(patterns.end(), leaf_patterns.begin(), leaf_patterns.end());
+                ++matched;
+            }
+        }
+        if (matched < 2) {
+            return;
+        }
+
+        // The fused leaf takes the place of the first one
+        Predicate::Ptr fused = Intern(std::make_shared<Leaf>(std::move(patterns)));
+        std::vector<Predicate::Ptr> result;
+        for (auto& child : children) {
+            if (child->Type() != type) {
+                result.push_back(std::move(child));
+            } else if (fused) {
+                result.push_back(std::move(fused));
+            }
+        }
+        children = std::move(result);
+    }
+
+    Predicate::Ptr OptimizeXor(std::vector<Predicate::Ptr> children) {
+        // XOR is "exactly one child matches": not associative, but children
+        // that never match cannot change the count
+        children.erase(std::remove_if(children.begin(), children.end(), [](const auto& child) {
+            return child->Type() == PredicateType::NO_MATCH;
+        }), children.end());
+
+        if (children.empty()) {
+            return Constant(false);
+        }
+        if (children.size() == 1) {
+            return children[0];
+        }
+        return Intern(std::make_shared<XOrPredicate>(std::move(children)));
+    }
+};
+}  // namespace
+
+Predicate::Ptr optimize_selection(const Predicate::Ptr& root) {
+    return TreeOptimizer().Optimize(root);
+}
+
+std::vector<Predicate::Ptr> optimize_selections(const std::vector<Predicate::Ptr>& roots) {
+    TreeOptimizer optimizer;
+    std::vector<Predicate::Ptr> result;
+    result.reserve(roots.size());
+    for (const auto& root : roots) {
+        result.push_back(optimizer.Optimize(root));
+    }
+    return result;
+}
+
 }  // namespace OESel
@@ -11,9 +11,13 @@
  * - Distance predicates (around, expand, beyond)
  * - Expansion predicates (byres, bychain)
  * - Secondary structure predicates
+ * - Named set predicates
  */
 
 #include "oeselect/Predicate.h"
+#include "oeselect/AtomTable.h"
+#include "oeselect/Bitset.h"
+#include "oeselect/BondGraph.h"
 #include "oeselect/Error.h"
 #include "oeselect/predicates/NamePredicate.h"
 #include "oeselect/predicates/LogicalPredicates.h"
@@ -23,10 +27,12 @@
 #include "oeselect/predicates/DistancePredicates.h"
 #include "oeselect/predicates/ExpansionPredicates.h"
 #include "oeselect/predicates/SecondaryStructurePredicates.h"
+#include "oeselect/predicates/NamedSetPredicate.h"
 #include "oeselect/Context.h"
 #include "oeselect/Tagger.h"
 #include "oeselect/SpatialIndex.h"
 #include "glob_match.h"
+#include "range_kernels.h"
 
 #include <oechem.h>
 #include <algorithm>
@@ -34,48 +40,157 @@
 #include <iomanip>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <utility>
 
 namespace OESel {
 
 namespace {
-std::string trim_ascii_spaces(std::string value) {
+std::string_view trim_ascii_spaces(const std::string_view value) {
     const auto start = value.find_first_not_of(' ');
-    if (start == std::string::npos) {
-        return "";
+    if (start == std::string_view::npos) {
+        return {};
     }
     const auto end = value.find_last_not_of(' ');
     return value.substr(start, end - start + 1);
 }
 
-bool is_backbone_atom_name(const std::string& name) {
+bool is_backbone_atom_name(const std::string_view name) {
     return name == "N" || name == "CA" || name == "C" || name == "O";
 }
 
+/// Patterns in the parser's multi-value form ("CA+CB")
+std::string join_patterns(const std::vector<std::string>& patterns) {
+    std::string result;
+    for (size_t i = 0; i < patterns.size(); ++i) {
+        if (i > 0) {
+            result += '+';
+        }
+        result += patterns[i];
+    }
+    return result;
+}
+
 void validate_distance_radius(const float radius) {
     if (!std::isfinite(radius) || radius < 0.0f) {
         throw SelectionError("Distance radius must be non-negative and finite");
     }
 }
+
+/// Compare a value using a predicate's Op (EQ, LT, LE, GT, GE, RANGE)
+template<typename Op, typename T>
+bool compare_value(const Op op, const T value, const T first, const T last) {
+    switch (op) {
+        case Op::EQ:    return value == first;
+        case Op::LT:    return value < first;
+        case Op::LE:    return value <= first;
+        case Op::GT:    return value > first;
+        case Op::GE:    return value >= first;
+        case Op::RANGE: return value >= first && value <= last;
+    }
+    return false;
+}
+
+void run_compare_kernel(const int* values, const size_t count, const kernels::CompareOp op,
+                        const int first, const int last, Bitset::Word* words) {
+    kernels::compare_int(values, count, op, first, last, words);
+}
+
+void run_compare_kernel(const unsigned int* values, const size_t count, const kernels::CompareOp op,
+                        const unsigned int first, const unsigned int last, Bitset::Word* words) {
+    kernels::compare_uint(values, count, op, first, last, words);
+}
+
+void run_compare_kernel(const float* values, const size_t count, const kernels::CompareOp op,
+                        const float first, const float last, Bitset::Word* words) {
+    kernels::compare_float(values, count, op, first, last, words);
+}
+
+/// Set bits for rows of an atom table column that satisfy a comparison (vectorized)
+template<typename Op, typename T>
+void scan_compare(Context& ctx, const std::vector<T>& column, const Op op, const T first, const T last,
+                  Bitset& out) {
+    const kernels::CompareOp compare = kernels::to_compare_op(op);
+    ctx.ForEachChunk(std::min(column.size(), out.Size()), [&](const size_t begin, const size_t end, unsigned int) {
+        run_compare_kernel(column.data() + begin, end - begin, compare, first, last,
+                           out.Words() + begin / Bitset::kWordBits);
+    });
+}
+
+/// Set bits for rows of an atom table column equal to a value
+template<typename T>
+void scan_equal(Context& ctx, const std::vector<T>& column, const T value, Bitset& out) {
+    ctx.ForEachChunk(column.size(), [&](const size_t begin, const size_t end, unsigned int) {
+        for (size_t i = begin; i < end; ++i) {
+            if (column[i] == value) {
+                out.Set(i);
+            }
+        }
+    });
+}
+
+/// Set bits for rows whose interned name id matches a compiled pattern set
+void scan_interned(
+    Context& ctx,
+    const std::vector<std::string>& names,
+    const std::vector<std::uint32_t>& ids,
+    const GlobMatcher& matcher,
+    Bitset& out) {
+    // Match each distinct name once, then scan the id column
+    std::vector<char> matches(names.size(), 0);
+    bool any = false;
+    for (size_t i = 0; i < names.size(); ++i) {
+        matches[i] = matcher.Matches(names[i]);
+        any = any || matches[i];
+    }
+    if (!any) {
+        return;
+    }
+    ctx.ForEachChunk(ids.size(), [&](const size_t begin, const size_t end, unsigned int) {
+        for (size_t i = begin; i < end; ++i) {
+            if (matches[ids[i]]) {
+                out.Set(i);
+            }
+        }
+    });
+}
 }  // namespace
 
+// Predicate base implementation
+
+void Predicate::EvaluateAll(Context& ctx, Bitset& out) const {
+    for (OESystem::OEIter atom = ctx.Mol().GetAtoms(); atom; ++atom) {
+        if (Evaluate(ctx, *atom)) {
+            out.Set(atom->GetIdx());
+        }
+    }
+}
+
+void Predicate::EvaluateWithin(Context& ctx, const Bitset& /*domain*/, Bitset& out) const {
+    EvaluateAll(ctx, out);
+}
+
 // NamePredicate implementation
 
 NamePredicate::NamePredicate(std::string pattern)
-    : pattern_(std::move(pattern))
-    , has_wildcard_(pattern_.find('*') != std::string::npos ||
-                    pattern_.find('?') != std::string::npos) {}
+    : NamePredicate(std::vector<std::string>{std::move(pattern)}) {}
+
+NamePredicate::NamePredicate(std::vector<std::string> patterns)
+    : patterns_(std::move(patterns))
+    , matcher_(std::make_shared<GlobMatcher>(patterns_)) {}
 
 bool NamePredicate::Evaluate(Context&, const OEChem::OEAtomBase& atom) const {
-    std::string name = trim_ascii_spaces(atom.GetName());
+    return matcher_->Matches(trim_ascii_spaces(atom.GetName()));
+}
 
-    if (has_wildcard_) {
-        return match_glob(pattern_, name);
-    }
-    return name == pattern_;
+void NamePredicate::EvaluateAll(Context& ctx, Bitset& out) const {
+    const AtomTable& table = ctx.GetAtomTable();
+    scan_interned(ctx, table.AtomNames(), table.AtomNameIds(), *matcher_, out);
+    out &= ctx.GetAtomMask();
 }
 
 std::string NamePredicate::ToCanonical() const {
-    return "name " + pattern_;
+    return "name " + join_patterns(patterns_);
 }
 
 // AndPredicate implementation
@@ -92,6 +207,21 @@ bool AndPredicate::Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const
     return true;
 }
 
+void AndPredicate::EvaluateAll(Context& ctx, Bitset& out) const {
+    if (children_.empty()) {
+        out |= ctx.GetAtomMask();
+        return;
+    }
+    ctx.EvaluateSubtree(*children_[0], out);
+    Bitset child_mask(out.Size());
+    for (size_t i = 1; i < children_.size() && out.Any(); ++i) {
+        // Later conjuncts only need to be exact for the atoms still matching
+        child_mask.ResetAll();
+        ctx.EvaluateSubtreeWithin(*children_[i], out, child_mask);
+        out &= child_mask;
+    }
+}
+
 std::string AndPredicate::ToCanonical() const {
     if (children_.empty()) return "all";
     if (children_.size() == 1) return children_[0]->ToCanonical();
@@ -123,6 +253,24 @@ bool OrPredicate::Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const {
     return false;
 }
 
+void OrPredicate::EvaluateAll(Context& ctx, Bitset& out) const {
+    Bitset child_mask(out.Size());
+    for (const auto& child : children_) {
+        child_mask.ResetAll();
+        ctx.EvaluateSubtree(*child, child_mask);
+        out |= child_mask;
+    }
+}
+
+void OrPredicate::EvaluateWithin(Context& ctx, const Bitset& domain, Bitset& out) const {
+    Bitset child_mask(out.Size());
+    for (const auto& child : children_) {
+        child_mask.ResetAll();
+        ctx.EvaluateSubtreeWithin(*child, domain, child_mask);
+        out |= child_mask;
+    }
+}
+
 std::string OrPredicate::ToCanonical() const {
     if (children_.empty()) return "none";
     if (children_.size() == 1) return children_[0]->ToCanonical();
@@ -148,6 +296,24 @@ bool NotPredicate::Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const
     return !child_->Evaluate(ctx, atom);
 }
 
+void NotPredicate::EvaluateAll(Context& ctx, Bitset& out) const {
+    Bitset child_mask(out.Size());
+    ctx.EvaluateSubtree(*child_, child_mask);
+    // Complement against atoms that exist, not every index below GetMaxAtomIdx()
+    out |= ctx.GetAtomMask();
+    out.AndNot(child_mask);
+}
+
+void NotPredicate::EvaluateWithin(Context& ctx, const Bitset& domain, Bitset& out) const {
+    Bitset child_mask(out.Size());
+    ctx.EvaluateSubtreeWithin(*child_, domain, child_mask);
+    // The child is exact only inside the domain, so the complement is taken there
+    Bitset result = domain;
+    result &= ctx.GetAtomMask();
+    result.AndNot(child_mask);
+    out |= result;
+}
+
 std::string NotPredicate::ToCanonical() const {
     return "not " + child_->ToCanonical();
 }
@@ -168,6 +334,21 @@ bool XOrPredicate::Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const
     return match_count == 1;
 }
 
+void XOrPredicate::EvaluateAll(Context& ctx, Bitset& out) const {
+    // Track atoms matched by at least one child and by more than one child
+    Bitset child_mask(out.Size());
+    Bitset multiple(out.Size());
+    for (const auto& child : children_) {
+        child_mask.ResetAll();
+        ctx.EvaluateSubtree(*child, child_mask);
+        Bitset overlap = child_mask;
+        overlap &= out;
+        multiple |= overlap;
+        out |= child_mask;
+    }
+    out.AndNot(multiple);
+}
+
 std::string XOrPredicate::ToCanonical() const {
     if (children_.size() < 2) {
         return children_.empty() ? "none" : children_[0]->ToCanonical();
@@ -189,22 +370,25 @@ std::string XOrPredicate::ToCanonical() const {
 // ResnPredicate implementation
 
 ResnPredicate::ResnPredicate(std::string pattern)
-    : pattern_(std::move(pattern))
-    , has_wildcard_(pattern_.find('*') != std::string::npos ||
-                    pattern_.find('?') != std::string::npos) {}
+    : ResnPredicate(std::vector<std::string>{std::move(pattern)}) {}
+
+ResnPredicate::ResnPredicate(std::vector<std::string> patterns)
+    : patterns_(std::move(patterns))
+    , matcher_(std::make_shared<GlobMatcher>(patterns_)) {}
 
 bool ResnPredicate::Evaluate(Context&, const OEChem::OEAtomBase& atom) const {
     const OEChem::OEResidue& res = OEChem::OEAtomGetResidue(&atom);
+    return matcher_->Matches(res.GetName());
+}
 
-    const std::string resn = res.GetName();
-    if (has_wildcard_) {
-        return match_glob(pattern_, resn);
-    }
-    return resn == pattern_;
+void ResnPredicate::EvaluateAll(Context& ctx, Bitset& out) const {
+    const AtomTable& table = ctx.GetAtomTable();
+    scan_interned(ctx, table.ResidueNames(), table.ResidueNameIds(), *matcher_, out);
+    out &= ctx.GetAtomMask();
 }
 
 std::string ResnPredicate::ToCanonical() const {
-    return "resn " + pattern_;
+    return "resn " + join_patterns(patterns_);
 }
 
 // ResiPredicate implementation
@@ -218,16 +402,12 @@ ResiPredicate::ResiPredicate(const int start, const int end)
 bool ResiPredicate::Evaluate(Context&, const OEChem::OEAtomBase& atom) const {
     const OEChem::OEResidue& res = OEChem::OEAtomGetResidue(&atom);
 
-    const int resi = res.GetResidueNumber();
-    switch (op_) {
-        case Op::EQ:    return resi == value_;
-        case Op::LT:    return resi < value_;
-        case Op::LE:    return resi <= value_;
-        case Op::GT:    return resi > value_;
-        case Op::GE:    return resi >= value_;
-        case Op::RANGE: return resi >= value_ && resi <= end_value_;
-    }
-    return false;  // Should never reach here
+    return compare_value(op_, res.GetResidueNumber(), value_, end_value_);
+}
+
+void ResiPredicate::EvaluateAll(Context& ctx, Bitset& out) const {
+    scan_compare(ctx, ctx.GetAtomTable().ResidueNumbers(), op_, value_, end_value_, out);
+    out &= ctx.GetAtomMask();
 }
 
 std::string ResiPredicate::ToCanonical() const {
@@ -254,6 +434,14 @@ bool ChainPredicate::Evaluate(Context&, const OEChem::OEAtomBase& atom) const {
     return chain_id_.size() == 1 && chain == chain_id_[0];
 }
 
+void ChainPredicate::EvaluateAll(Context& ctx, Bitset& out) const {
+    if (chain_id_.size() != 1) {
+        return;
+    }
+    scan_equal(ctx, ctx.GetAtomTable().ChainIds(), chain_id_[0], out);
+    out &= ctx.GetAtomMask();
+}
+
 std::string ChainPredicate::ToCanonical() const {
     return "chain " + chain_id_;
 }
@@ -281,6 +469,11 @@ bool ElemPredicate::Evaluate(Context&, const OEChem::OEAtomBase& atom) const {
     return atom.GetAtomicNum() == static_cast<int>(atomic_num_);
 }
 
+void ElemPredicate::EvaluateAll(Context& ctx, Bitset& out) const {
+    scan_equal(ctx, ctx.GetAtomTable().AtomicNumbers(), atomic_num_, out);
+    out &= ctx.GetAtomMask();
+}
+
 std::string ElemPredicate::ToCanonical() const {
     return "elem " + element_;
 }
@@ -294,16 +487,25 @@ IndexPredicate::IndexPredicate(const unsigned int start, const unsigned int end)
     : value_(start), end_value_(end), op_(Op::RANGE) {}
 
 bool IndexPredicate::Evaluate(Context&, const OEChem::OEAtomBase& atom) const {
-    const unsigned int idx = atom.GetIdx();
+    return compare_value(op_, atom.GetIdx(), value_, end_value_);
+}
+
+void IndexPredicate::EvaluateAll(Context& ctx, Bitset& out) const {
+    // The atom index is the bit position, so every operator is a contiguous bit range
+    const size_t size = out.Size();
+    const size_t value = value_;
+    size_t begin = 0;
+    size_t end = 0;
     switch (op_) {
-        case Op::EQ:    return idx == value_;
-        case Op::LT:    return idx < value_;
-        case Op::LE:    return idx <= value_;
-        case Op::GT:    return idx > value_;
-        case Op::GE:    return idx >= value_;
-        case Op::RANGE: return idx >= value_ && idx <= end_value_;
+        case Op::EQ:    begin = value; end = value + 1; break;
+        case Op::LT:    begin = 0; end = value; break;
+        case Op::LE:    begin = 0; end = value + 1; break;
+        case Op::GT:    begin = value + 1; end = size; break;
+        case Op::GE:    begin = value; end = size; break;
+        case Op::RANGE: begin = value; end = static_cast<size_t>(end_value_) + 1; break;
     }
-    return false;
+    out.SetRange(std::min(begin, size), std::min(end, size));
+    out &= ctx.GetAtomMask();
 }
 
 std::string IndexPredicate::ToCanonical() const {
@@ -328,16 +530,12 @@ IdPredicate::IdPredicate(const int start, const int end)
 
 bool IdPredicate::Evaluate(Context&, const OEChem::OEAtomBase& atom) const {
     const OEChem::OEResidue& res = OEChem::OEAtomGetResidue(&atom);
-    const int serial = res.GetSerialNumber();
-    switch (op_) {
-        case Op::EQ:    return serial == value_;
-        case Op::LT:    return serial < value_;
-        case Op::LE:    return serial <= value_;
-        case Op::GT:    return serial > value_;
-        case Op::GE:    return serial >= value_;
-        case Op::RANGE: return serial >= value_ && serial <= end_value_;
-    }
-    return false;
+    return compare_value(op_, res.GetSerialNumber(), value_, end_value_);
+}
+
+void IdPredicate::EvaluateAll(Context& ctx, Bitset& out) const {
+    scan_compare(ctx, ctx.GetAtomTable().SerialNumbers(), op_, value_, end_value_, out);
+    out &= ctx.GetAtomMask();
 }
 
 std::string IdPredicate::ToCanonical() const {
@@ -363,6 +561,14 @@ bool AltPredicate::Evaluate(Context&, const OEChem::OEAtomBase& atom) const {
     return alt_id_.size() == 1 && alt == alt_id_[0];
 }
 
+void AltPredicate::EvaluateAll(Context& ctx, Bitset& out) const {
+    if (alt_id_.size() != 1) {
+        return;
+    }
+    scan_equal(ctx, ctx.GetAtomTable().AltLocations(), alt_id_[0], out);
+    out &= ctx.GetAtomMask();
+}
+
 std::string AltPredicate::ToCanonical() const {
     return "alt " + alt_id_;
 }
@@ -394,16 +600,12 @@ BFactorPredicate::BFactorPredicate(const float start, const float end)
 
 bool BFactorPredicate::Evaluate(Context&, const OEChem::OEAtomBase& atom) const {
     const OEChem::OEResidue& res = OEChem::OEAtomGetResidue(&atom);
-    const float bfactor = static_cast<float>(res.GetBFactor());
-    switch (op_) {
-        case Op::EQ:    return bfactor == value_;
-        case Op::LT:    return bfactor < value_;
-        case Op::LE:    return bfactor <= value_;
-        case Op::GT:    return bfactor > value_;
-        case Op::GE:    return bfactor >= value_;
-        case Op::RANGE: return bfactor >= value_ && bfactor <= end_value_;
-    }
-    return false;
+    return compare_value(op_, static_cast<float>(res.GetBFactor()), value_, end_value_);
+}
+
+void BFactorPredicate::EvaluateAll(Context& ctx, Bitset& out) const {
+    scan_compare(ctx, ctx.GetAtomTable().BFactors(), op_, value_, end_value_, out);
+    out &= ctx.GetAtomMask();
 }
 
 std::string BFactorPredicate::ToCanonical() const {
@@ -428,16 +630,12 @@ FragmentPredicate::FragmentPredicate(const unsigned int start, const unsigned in
 
 bool FragmentPredicate::Evaluate(Context&, const OEChem::OEAtomBase& atom) const {
     const OEChem::OEResidue& res = OEChem::OEAtomGetResidue(&atom);
-    const unsigned int frag = res.GetFragmentNumber();
-    switch (op_) {
-        case Op::EQ:    return frag == value_;
-        case Op::LT:    return frag < value_;
-        case Op::LE:    return frag <= value_;
-        case Op::GT:    return frag > value_;
-        case Op::GE:    return frag >= value_;
-        case Op::RANGE: return frag >= value_ && frag <= end_value_;
-    }
-    return false;
+    return compare_value(op_, res.GetFragmentNumber(), value_, end_value_);
+}
+
+void FragmentPredicate::EvaluateAll(Context& ctx, Bitset& out) const {
+    scan_compare(ctx, ctx.GetAtomTable().FragmentNumbers(), op_, value_, end_value_, out);
+    out &= ctx.GetAtomMask();
 }
 
 std::string FragmentPredicate::ToCanonical() const {
@@ -452,63 +650,122 @@ std::string FragmentPredicate::ToCanonical() const {
     return "frag " + std::to_string(value_);
 }
 
+namespace {
+/// Test an atom's component flags from the context's atom table
+bool has_component(Context& ctx, const OEChem::OEAtomBase& atom, const ComponentFlag flags) {
+    return (ctx.GetAtomTable().ComponentFlags()[atom.GetIdx()] & static_cast<std::uint32_t>(flags)) != 0;
+}
+
+/// Set bits for atoms whose component flags intersect a mask
+void scan_components(Context& ctx, const ComponentFlag flags, Bitset& out) {
+    const auto& column = ctx.GetAtomTable().ComponentFlags();
+    const auto mask = static_cast<std::uint8_t>(flags);
+    ctx.ForEachChunk(column.size(), [&](const size_t begin, const size_t end, unsigned int) {
+        for (size_t i = begin; i < end; ++i) {
+            if ((column[i] & mask) != 0) {
+                out.Set(i);
+            }
+        }
+    });
+    out &= ctx.GetAtomMask();
+}
+}  // namespace
+
 // ProteinPredicate implementation
 
 bool ProteinPredicate::Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const {
-    Tagger::TagMolecule(ctx.Mol());
-    return Tagger::HasComponent(atom, ComponentFlag::PROTEIN);
+    return has_component(ctx, atom, ComponentFlag::PROTEIN);
+}
+
+void ProteinPredicate::EvaluateAll(Context& ctx, Bitset& out) const {
+    scan_components(ctx, ComponentFlag::PROTEIN, out);
 }
 
 // LigandPredicate implementation
 
 bool LigandPredicate::Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const {
-    Tagger::TagMolecule(ctx.Mol());
-    return Tagger::HasComponent(atom, ComponentFlag::LIGAND);
+    return has_component(ctx, atom, ComponentFlag::LIGAND);
+}
+
+void LigandPredicate::EvaluateAll(Context& ctx, Bitset& out) const {
+    scan_components(ctx, ComponentFlag::LIGAND, out);
 }
 
 // WaterPredicate implementation
 
 bool WaterPredicate::Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const {
-    Tagger::TagMolecule(ctx.Mol());
-    return Tagger::HasComponent(atom, ComponentFlag::WATER);
+    return has_component(ctx, atom, ComponentFlag::WATER);
+}
+
+void WaterPredicate::EvaluateAll(Context& ctx, Bitset& out) const {
+    scan_components(ctx, ComponentFlag::WATER, out);
 }
 
 // SolventPredicate implementation - matches Water OR Solvent
 
 bool SolventPredicate::Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const {
-    Tagger::TagMolecule(ctx.Mol());
-    return Tagger::HasComponent(atom, ComponentFlag::WATER) ||
-           Tagger::HasComponent(atom, ComponentFlag::SOLVENT);
+    return has_component(ctx, atom, ComponentFlag::WATER | ComponentFlag::SOLVENT);
+}
+
+void SolventPredicate::EvaluateAll(Context& ctx, Bitset& out) const {
+    scan_components(ctx, ComponentFlag::WATER | ComponentFlag::SOLVENT, out);
+}
+
+// LipidPredicate implementation
+
+bool LipidPredicate::Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const {
+    return has_component(ctx, atom, ComponentFlag::LIPID);
+}
+
+void LipidPredicate::EvaluateAll(Context& ctx, Bitset& out) const {
+    scan_components(ctx, ComponentFlag::LIPID, out);
+}
+
+// GlycanPredicate implementation
+
+bool GlycanPredicate::Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const {
+    return has_component(ctx, atom, ComponentFlag::GLYCAN);
+}
+
+void GlycanPredicate::EvaluateAll(Context& ctx, Bitset& out) const {
+    scan_components(ctx, ComponentFlag::GLYCAN, out);
 }
 
 // OrganicPredicate implementation - C-containing, not protein/nucleic
 
+namespace {
+bool is_carbon(const unsigned int atomic_num) { return atomic_num == 6; }
+}  // namespace
+
 bool OrganicPredicate::Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const {
     // Check if atom is carbon or bonded to carbon (i.e., in organic molecule)
-    if (atom.GetAtomicNum() != 6) {  // Not carbon itself
-        // Check if bonded to carbon
-        bool bonded_to_carbon = false;
-        for (OESystem::OEIter bond = atom.GetBonds(); bond; ++bond) {
-            if (const auto* nbr = bond->GetNbr(&atom); nbr->GetAtomicNum() == 6) {
-                bonded_to_carbon = true;
-                break;
-            }
-        }
-        if (!bonded_to_carbon) return false;
+    if (atom.GetAtomicNum() != 6 && !ctx.GetBondGraph().AnyNeighbor(atom.GetIdx(), is_carbon)) {
+        return false;
     }
 
-    Tagger::TagMolecule(ctx.Mol());
     // Exclude protein and nucleic
-    if (Tagger::HasComponent(atom, ComponentFlag::PROTEIN)) return false;
-    if (Tagger::HasComponent(atom, ComponentFlag::NUCLEIC)) return false;
-    return true;
+    return !has_component(ctx, atom, ComponentFlag::PROTEIN | ComponentFlag::NUCLEIC);
+}
+
+void OrganicPredicate::EvaluateAll(Context& ctx, Bitset& out) const {
+    const BondGraph& graph = ctx.GetBondGraph();
+    const auto& elements = graph.AtomicNumbers();
+    const auto& components = ctx.GetAtomTable().ComponentFlags();
+    const auto excluded = static_cast<std::uint8_t>(ComponentFlag::PROTEIN | ComponentFlag::NUCLEIC);
+    // Deleted atom indices have atomic number 0 and no bonds, so never match
+    ctx.ForEachChunk(graph.Size(), [&](const size_t begin, const size_t end, unsigned int) {
+        for (size_t i = begin; i < end; ++i) {
+            if ((components[i] & excluded) == 0 && (elements[i] == 6 || graph.AnyNeighbor(i, is_carbon))) {
+                out.Set(i);
+            }
+        }
+    });
 }
 
 // BackbonePredicate implementation - N, CA, C, O in protein
 
 bool BackbonePredicate::Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const {
-    Tagger::TagMolecule(ctx.Mol());
-    if (!Tagger::HasComponent(atom, ComponentFlag::PROTEIN)) return false;
+    if (!has_component(ctx, atom, ComponentFlag::PROTEIN)) return false;
 
     return is_backbone_atom_name(trim_ascii_spaces(atom.GetName()));
 }
@@ -516,10 +773,9 @@ bool BackbonePredicate::Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) c
 // SidechainPredicate implementation - protein atoms that are not backbone
 
 bool SidechainPredicate::Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const {
-    Tagger::TagMolecule(ctx.Mol());
-    if (!Tagger::HasComponent(atom, ComponentFlag::PROTEIN)) return false;
+    if (!has_component(ctx, atom, ComponentFlag::PROTEIN)) return false;
 
-    const std::string name = trim_ascii_spaces(atom.GetName());
+    const std::string_view name = trim_ascii_spaces(atom.GetName());
     // Exclude backbone atoms
     if (is_backbone_atom_name(name)) return false;
     // Also exclude OXT (terminal oxygen)
@@ -561,34 +817,46 @@ bool HydrogenPredicate::Evaluate(Context&, const OEChem::OEAtomBase& atom) const
     return atom.GetAtomicNum() == 1;
 }
 
+namespace {
+bool is_polar_element(const unsigned int atomic_num) {
+    return atomic_num == 7 || atomic_num == 8 || atomic_num == 16;
+}
+
+/// Set bits for hydrogens bonded to an atom whose atomic number passes a test
+template <typename Test>
+void scan_bonded_hydrogens(Context& ctx, Test test, Bitset& out) {
+    const BondGraph& graph = ctx.GetBondGraph();
+    const auto& elements = graph.AtomicNumbers();
+    ctx.ForEachChunk(graph.Size(), [&](const size_t begin, const size_t end, unsigned int) {
+        for (size_t i = begin; i < end; ++i) {
+            if (elements[i] == 1 && graph.AnyNeighbor(i, test)) {
+                out.Set(i);
+            }
+        }
+    });
+}
+}  // namespace
+
 // PolarHydrogenPredicate implementation - H bonded to N(7), O(8), or S(16)
 
-bool PolarHydrogenPredicate::Evaluate(Context&, const OEChem::OEAtomBase& atom) const {
+bool PolarHydrogenPredicate::Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const {
     if (atom.GetAtomicNum() != 1) return false;  // Must be hydrogen
+    return ctx.GetBondGraph().AnyNeighbor(atom.GetIdx(), is_polar_element);
+}
 
-    // Check what this hydrogen is bonded to
-    for (OESystem::OEIter bond = atom.GetBonds(); bond; ++bond) {
-        const OEChem::OEAtomBase* nbr = bond->GetNbr(&atom);
-        if (const auto nbr_atomic_num = static_cast<int>(nbr->GetAtomicNum());
-            nbr_atomic_num == 7 || nbr_atomic_num == 8 || nbr_atomic_num == 16) {
-            return true;  // Bonded to N, O, or S
-        }
-    }
-    return false;
+void PolarHydrogenPredicate::EvaluateAll(Context& ctx, Bitset& out) const {
+    scan_bonded_hydrogens(ctx, is_polar_element, out);
 }
 
 // NonpolarHydrogenPredicate implementation - H bonded to carbon
 
-bool NonpolarHydrogenPredicate::Evaluate(Context&, const OEChem::OEAtomBase& atom) const {
+bool NonpolarHydrogenPredicate::Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const {
     if (atom.GetAtomicNum() != 1) return false;  // Must be hydrogen
+    return ctx.GetBondGraph().AnyNeighbor(atom.GetIdx(), is_carbon);
+}
 
-    for (OESystem::OEIter bond = atom.GetBonds(); bond; ++bond) {
-        const OEChem::OEAtomBase* nbr = bond->GetNbr(&atom);
-        if (static_cast<int>(nbr->GetAtomicNum()) == 6) {
-            return true;
-        }
-    }
-    return false;
+void NonpolarHydrogenPredicate::EvaluateAll(Context& ctx, Bitset& out) const {
+    scan_bonded_hydrogens(ctx, is_carbon, out);
 }
 
 // ============================================================================
@@ -617,32 +885,56 @@ std::string distance_cache_key(const float radius, const Predicate& reference) {
     return "around_" + format_radius(radius) + "_" + reference.ToCanonical();
 }
 
-const std::vector<bool>& get_distance_mask(
+/// Compute (or fetch from the owner's cache slot) the mask of atoms within radius of reference
+const Bitset& get_distance_mask(
     Context& ctx,
+    const Predicate& owner,
     const float radius,
-    const Predicate& reference) {
-    const std::string cache_key = distance_cache_key(radius, reference);
-    if (ctx.HasAroundCache(cache_key)) {
-        return ctx.GetAroundCache(cache_key);
+    const Predicate& reference,
+    Bitset* reference_out = nullptr) {
+    if (const Bitset* cached = ctx.GetCachedMask(owner)) {
+        return *cached;
     }
 
     const OEChem::OEMolBase& mol = ctx.Mol();
-    std::vector mask(mol.NumAtoms(), false);
-    const SpatialIndex& index = ctx.GetSpatialIndex();
+    Bitset mask(mol.GetMaxAtomIdx());
 
-    for (OESystem::OEIter atom = mol.GetAtoms(); atom; ++atom) {
-        if (reference.Evaluate(ctx, *atom)) {
-            const auto nearby = index.FindWithinRadius(*atom, radius);
-            for (const unsigned int idx : nearby) {
-                if (idx < mask.size()) {
-                    mask[idx] = true;
-                }
-            }
-        }
-    }
+    Bitset local_reference;
+    Bitset& reference_mask = reference_out ? *reference_out : local_reference;
+    reference_mask = Bitset(mol.GetMaxAtomIdx());
+    ctx.EvaluateSubtree(reference, reference_mask);
 
-    ctx.SetAroundCache(cache_key, std::move(mask));
-    return ctx.GetAroundCache(cache_key);
+    ctx.MarkWithinRadius(owner, reference_mask, radius, ctx.GetAtomMask(), mask);
+
+    return ctx.SetCachedMask(owner, std::move(mask));
+}
+
+/**
+ * Mark the atoms of @p domain within radius of reference, optionally
+ * leaving out the reference atoms. Only the domain is searched unless the
+ * owner's whole-molecule mask is already cached; restricted results are
+ * not cached, since they do not cover the molecule.
+ */
+void mark_distance_within(
+    Context& ctx,
+    const Predicate& owner,
+    const float radius,
+    const Predicate& reference,
+    const Bitset& domain,
+    const bool exclude_reference,
+    Bitset& out) {
+    Bitset reference_mask(out.Size());
+    ctx.EvaluateSubtree(reference, reference_mask);
+    Bitset candidates = domain;
+    if (exclude_reference) {
+        candidates.AndNot(reference_mask);
+    }
+    if (const Bitset* cached = ctx.GetCachedMask(owner)) {
+        candidates &= *cached;
+        out |= candidates;
+        return;
+    }
+    ctx.MarkWithinRadius(owner, reference_mask, radius, candidates, out);
 }
 }  // namespace
 
@@ -653,25 +945,59 @@ AroundPredicate::AroundPredicate(const float radius, Ptr reference)
     validate_distance_radius(radius_);
 }
 
-const std::vector<bool>& AroundPredicate::GetAroundMask(Context& ctx) const {
-    return get_distance_mask(ctx, radius_, *reference_);
+const Bitset& AroundPredicate::GetAroundMask(Context& ctx) const {
+    return get_distance_mask(ctx, *this, radius_, *reference_);
 }
 
 bool AroundPredicate::Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const {
+    if (const Bitset* cached = ctx.GetCachedResult(*this)) {
+        return cached->Test(atom.GetIdx());
+    }
     // Exclude reference atoms
     if (reference_->Evaluate(ctx, atom)) {
         return false;
     }
     // Then check if it's within radius
-    const auto& mask = GetAroundMask(ctx);
-    const unsigned int idx = atom.GetIdx();
-    return idx < mask.size() && mask[idx];
+    return GetAroundMask(ctx).Test(atom.GetIdx());
+}
+
+void AroundPredicate::EvaluateAll(Context& ctx, Bitset& out) const {
+    if (const Bitset* cached = ctx.GetCachedResult(*this)) {
+        out |= *cached;
+        return;
+    }
+
+    // The slot's shared mask includes the reference atoms; keep the reference evaluated alongside it
+    Bitset reference_mask;
+    Bitset result = get_distance_mask(ctx, *this, radius_, *reference_, &reference_mask);
+    if (reference_mask.Size() != result.Size()) {
+        // Shared mask computed by an expand or beyond node
+        reference_mask = Bitset(result.Size());
+        ctx.EvaluateSubtree(*reference_, reference_mask);
+    }
+    result.AndNot(reference_mask);
+    out |= result;
+    ctx.SetCachedResult(*this, std::move(result));
+}
+
+void AroundPredicate::EvaluateWithin(Context& ctx, const Bitset& domain, Bitset& out) const {
+    if (const Bitset* cached = ctx.GetCachedResult(*this)) {
+        Bitset within = domain;
+        within &= *cached;
+        out |= within;
+        return;
+    }
+    mark_distance_within(ctx, *this, radius_, *reference_, domain, true, out);
 }
 
 std::string AroundPredicate::ToCanonical() const {
     return reference_->ToCanonical() + " around " + format_radius(radius_);
 }
 
+std::string AroundPredicate::CacheKey() const {
+    return distance_cache_key(radius_, *reference_);
+}
+
 // ExpandPredicate implementation (includes reference atoms)
 
 ExpandPredicate::ExpandPredicate(const float radius, Ptr reference)
@@ -679,20 +1005,30 @@ ExpandPredicate::ExpandPredicate(const float radius, Ptr reference)
     validate_distance_radius(radius_);
 }
 
-const std::vector<bool>& ExpandPredicate::GetAroundMask(Context& ctx) const {
-    return get_distance_mask(ctx, radius_, *reference_);
+const Bitset& ExpandPredicate::GetAroundMask(Context& ctx) const {
+    return get_distance_mask(ctx, *this, radius_, *reference_);
 }
 
 bool ExpandPredicate::Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const {
-    const auto& mask = GetAroundMask(ctx);
-    const unsigned int idx = atom.GetIdx();
-    return idx < mask.size() && mask[idx];
+    return GetAroundMask(ctx).Test(atom.GetIdx());
+}
+
+void ExpandPredicate::EvaluateAll(Context& ctx, Bitset& out) const {
+    out |= GetAroundMask(ctx);
+}
+
+void ExpandPredicate::EvaluateWithin(Context& ctx, const Bitset& domain, Bitset& out) const {
+    mark_distance_within(ctx, *this, radius_, *reference_, domain, false, out);
 }
 
 std::string ExpandPredicate::ToCanonical() const {
     return reference_->ToCanonical() + " expand " + format_radius(radius_);
 }
 
+std::string ExpandPredicate::CacheKey() const {
+    return distance_cache_key(radius_, *reference_);
+}
+
 // BeyondPredicate implementation
 
 BeyondPredicate::BeyondPredicate(const float radius, Ptr reference)
@@ -700,8 +1036,8 @@ BeyondPredicate::BeyondPredicate(const float radius, Ptr reference)
     validate_distance_radius(radius_);
 }
 
-const std::vector<bool>& BeyondPredicate::GetAroundMask(Context& ctx) const {
-    return get_distance_mask(ctx, radius_, *reference_);
+const Bitset& BeyondPredicate::GetAroundMask(Context& ctx) const {
+    return get_distance_mask(ctx, *this, radius_, *reference_);
 }
 
 bool BeyondPredicate::Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const {
@@ -709,92 +1045,172 @@ bool BeyondPredicate::Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) con
     const auto& mask = GetAroundMask(ctx);
     const unsigned int idx = atom.GetIdx();
     // If idx is out of range, consider it beyond (shouldn't happen normally)
-    if (idx >= mask.size()) {
+    if (idx >= mask.Size()) {
         return true;
     }
-    return !mask[idx];
+    return !mask.Test(idx);
+}
+
+void BeyondPredicate::EvaluateAll(Context& ctx, Bitset& out) const {
+    out |= ctx.GetAtomMask();
+    out.AndNot(GetAroundMask(ctx));
+}
+
+void BeyondPredicate::EvaluateWithin(Context& ctx, const Bitset& domain, Bitset& out) const {
+    Bitset near(out.Size());
+    mark_distance_within(ctx, *this, radius_, *reference_, domain, false, near);
+    Bitset beyond = domain;
+    beyond &= ctx.GetAtomMask();
+    beyond.AndNot(near);
+    out |= beyond;
 }
 
 std::string BeyondPredicate::ToCanonical() const {
     return reference_->ToCanonical() + " beyond " + format_radius(radius_);
 }
 
-// ============================================================================
-// Expansion Predicates (Task 14)
-// ============================================================================
+std::string BeyondPredicate::CacheKey() const {
+    return distance_cache_key(radius_, *reference_);
+}
 
-// ByResPredicate implementation
+// NearestPredicate implementation
 
-namespace {
-// Helper struct to create a unique residue key
-// A residue is uniquely identified by chain ID, residue number, and insertion code
-struct ResidueKey {
-    char chain_id;
-    int residue_number;
-    char insertion_code;
-
-    bool operator==(const ResidueKey& other) const {
-        return chain_id == other.chain_id &&
-               residue_number == other.residue_number &&
-               insertion_code == other.insertion_code;
-    }
-};
-
-struct ResidueKeyHash {
-    size_t operator()(const ResidueKey& k) const {
-        // Combine hash of all components
-        const size_t h1 = std::hash<char>{}(k.chain_id);
-        const size_t h2 = std::hash<int>{}(k.residue_number);
-        const size_t h3 = std::hash<char>{}(k.insertion_code);
-        return h1 ^ h2 << 1 ^ h3 << 2;
-    }
-};
-
-ResidueKey get_residue_key(const OEChem::OEAtomBase& atom) {
-    const OEChem::OEResidue& res = OEChem::OEAtomGetResidue(&atom);
-    return {res.GetChainID(), res.GetResidueNumber(), res.GetInsertCode()};
+NearestPredicate::NearestPredicate(const unsigned int count, const bool by_residue, Ptr candidates, Ptr reference)
+    : count_(count), by_residue_(by_residue), candidates_(std::move(candidates)), reference_(std::move(reference)) {
+    if (count_ == 0) {
+        throw SelectionError("Nearest count must be positive");
+    }
 }
-}  // namespace
 
-ByResPredicate::ByResPredicate(Ptr child)
-    : child_(std::move(child)) {}
+const Bitset& NearestPredicate::GetNearestMask(Context& ctx) const {
+    if (const Bitset* cached = ctx.GetCachedMask(*this)) {
+        return *cached;
+    }
 
-const std::unordered_set<unsigned int>& ByResPredicate::GetMatchingResidues(Context& ctx) const {
-    const std::string cache_key = "byres_" + child_->ToCanonical();
+    const size_t size = ctx.Mol().GetMaxAtomIdx();
+    Bitset reference_mask(size);
+    ctx.EvaluateSubtree(*reference_, reference_mask);
+    Bitset candidate_mask(size);
+    ctx.EvaluateSubtree(*candidates_, candidate_mask);
+    candidate_mask &= ctx.GetAtomMask();
+    candidate_mask.AndNot(reference_mask);
 
-    // Check if already cached
-    if (ctx.HasResidueCache(cache_key)) {
-        return ctx.GetResidueAtoms(cache_key);
+    Bitset mask(size);
+    const SpatialIndex& index = ctx.GetSpatialIndex();
+    std::vector<unsigned int> nearest;
+    std::vector<float> distance_sq;
+    if (!by_residue_) {
+        index.FindNearest(reference_mask, candidate_mask, count_, nearest, distance_sq);
+        ctx.CountSpatialQuery();
+        for (const unsigned int idx : nearest) {
+            mask.Set(idx);
+        }
+        return ctx.SetCachedMask(*this, std::move(mask));
     }
 
-    const OEChem::OEMolBase& mol = ctx.Mol();
+    const AtomTable& table = ctx.GetAtomTable();
+    const std::vector<std::uint32_t>& atom_groups = table.ResidueGroups();
+    index.FindNearestGroups(reference_mask, candidate_mask, atom_groups, count_, nearest, distance_sq);
+    ctx.CountSpatialQuery();
+    Bitset residues(table.ResidueRuns().NumGroups());
+    for (const unsigned int idx : nearest) {
+        residues.Set(atom_groups[idx]);
+    }
+    table.ResidueRuns().Paint(residues, mask);
+    return ctx.SetCachedMask(*this, std::move(mask));
+}
+
+bool NearestPredicate::Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const {
+    return GetNearestMask(ctx).Test(atom.GetIdx());
+}
+
+void NearestPredicate::EvaluateAll(Context& ctx, Bitset& out) const {
+    out |= GetNearestMask(ctx);
+}
+
+std::string NearestPredicate::ToCanonical() const {
+    // A byres candidate in atom mode is parenthesized so it does not read back as residue mode
+    std::string candidates = candidates_->ToCanonical();
+    if (!by_residue_ && candidates_->Type() == PredicateType::BY_RES) {
+        candidates = "(" + candidates + ")";
+    }
+    return "nearest " + std::to_string(count_) + (by_residue_ ? " byres " : " ") + candidates + " to " +
+           reference_->ToCanonical();
+}
+
+// ============================================================================
+// Expansion Predicates (Task 14)
+// ============================================================================
+
+namespace {
+/// Expand a child mask to every atom of the residues or chains it touches
+Bitset expand_to_groups(Context& ctx, const Bitset& child_mask, const std::vector<std::uint32_t>& atom_groups,
+                        const GroupRuns& runs) {
+    Bitset atoms(child_mask.Size());
+    const size_t count = std::min(child_mask.Size(), atom_groups.size());
+    if (ctx.GetNumThreads() <= 1 || count < Context::kParallelMinAtoms) {
+        // Mark the groups of matching atoms, then paint their atom runs
+        Bitset groups(runs.NumGroups());
+        child_mask.ForEachSet([&](const size_t idx) { groups.Set(atom_groups[idx]); });
+        runs.Paint(groups, atoms);
+        return atoms;
+    }
 
-    // First pass: find all residue keys that have at least one matching atom
-    std::unordered_set<ResidueKey, ResidueKeyHash> matching_residue_keys;
-    for (OESystem::OEIter atom = mol.GetAtoms(); atom; ++atom) {
-        if (child_->Evaluate(ctx, *atom)) {
-            // This atom matches - get its residue key
-            ResidueKey key = get_residue_key(*atom);
-            matching_residue_keys.insert(key);
+    // Parallel mark: each worker collects groups into its own bitset, merged afterwards
+    std::vector<Bitset> marked(ctx.GetNumThreads(), Bitset(runs.NumGroups()));
+    const Bitset::Word* words = child_mask.Words();
+    ctx.ForEachChunk(count, [&](const size_t begin, const size_t end, const unsigned int worker) {
+        for (size_t w = begin / Bitset::kWordBits; w * Bitset::kWordBits < end; ++w) {
+            if (words[w] == 0) continue;
+            const size_t last = std::min(end, (w + 1) * Bitset::kWordBits);
+            for (size_t i = w * Bitset::kWordBits; i < last; ++i) {
+                if (child_mask.Test(i) && atom_groups[i] != AtomTable::kNoGroup) {
+                    marked[worker].Set(atom_groups[i]);
+                }
+            }
         }
+    });
+    Bitset& groups = marked[0];
+    for (size_t k = 1; k < marked.size(); ++k) {
+        groups |= marked[k];
     }
 
-    // Second pass: collect all atom indices that belong to matching residues
-    std::unordered_set<unsigned int> matching_atom_indices;
-    for (OESystem::OEIter atom = mol.GetAtoms(); atom; ++atom) {
-        if (const auto key = get_residue_key(*atom); matching_residue_keys.count(key) > 0) {
-            matching_atom_indices.insert(atom->GetIdx());
+    // Parallel paint: each chunk sets its own atoms whose group is marked
+    ctx.ForEachChunk(count, [&](const size_t begin, const size_t end, unsigned int) {
+        for (size_t i = begin; i < end; ++i) {
+            if (atom_groups[i] != AtomTable::kNoGroup && groups.Test(atom_groups[i])) {
+                atoms.Set(i);
+            }
         }
+    });
+    return atoms;
+}
+}  // namespace
+
+// ByResPredicate implementation
+
+ByResPredicate::ByResPredicate(Ptr child)
+    : child_(std::move(child)) {}
+
+const Bitset& ByResPredicate::GetMatchingResidues(Context& ctx) const {
+    // Check if already cached
+    if (const Bitset* cached = ctx.GetCachedMask(*this)) {
+        return *cached;
     }
 
-    ctx.SetResidueAtoms(cache_key, std::move(matching_atom_indices));
-    return ctx.GetResidueAtoms(cache_key);
+    Bitset child_mask(ctx.Mol().GetMaxAtomIdx());
+    ctx.EvaluateSubtree(*child_, child_mask);
+
+    const AtomTable& table = ctx.GetAtomTable();
+    return ctx.SetCachedMask(*this, expand_to_groups(ctx, child_mask, table.ResidueGroups(), table.ResidueRuns()));
 }
 
 bool ByResPredicate::Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const {
-    const auto& matching = GetMatchingResidues(ctx);
-    const unsigned int idx = atom.GetIdx();
-    return matching.count(idx) > 0;
+    return GetMatchingResidues(ctx).Test(atom.GetIdx());
+}
+
+void ByResPredicate::EvaluateAll(Context& ctx, Bitset& out) const {
+    out |= GetMatchingResidues(ctx);
 }
 
 std::string ByResPredicate::ToCanonical() const {
@@ -806,48 +1222,115 @@ std::string ByResPredicate::ToCanonical() const {
 ByChainPredicate::ByChainPredicate(Ptr child)
     : child_(std::move(child)) {}
 
-const std::unordered_set<unsigned int>& ByChainPredicate::GetMatchingChainAtoms(Context& ctx) const {
-    const std::string cache_key = "bychain_" + child_->ToCanonical();
-
+const Bitset& ByChainPredicate::GetMatchingChainAtoms(Context& ctx) const {
     // Check if already cached
-    if (ctx.HasChainCache(cache_key)) {
-        return ctx.GetChainAtoms(cache_key);
+    if (const Bitset* cached = ctx.GetCachedMask(*this)) {
+        return *cached;
     }
 
-    const OEChem::OEMolBase& mol = ctx.Mol();
+    Bitset child_mask(ctx.Mol().GetMaxAtomIdx());
+    ctx.EvaluateSubtree(*child_, child_mask);
 
-    // First pass: find all chain IDs that have at least one matching atom
-    std::unordered_set<char> matching_chains;
-    for (OESystem::OEIter atom = mol.GetAtoms(); atom; ++atom) {
-        if (child_->Evaluate(ctx, *atom)) {
-            const OEChem::OEResidue& res = OEChem::OEAtomGetResidue(&*atom);
-            char chain_id = res.GetChainID();
-            matching_chains.insert(chain_id);
-        }
+    const AtomTable& table = ctx.GetAtomTable();
+    return ctx.SetCachedMask(*this, expand_to_groups(ctx, child_mask, table.ChainGroups(), table.ChainRuns()));
+}
+
+bool ByChainPredicate::Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const {
+    return GetMatchingChainAtoms(ctx).Test(atom.GetIdx());
+}
+
+void ByChainPredicate::EvaluateAll(Context& ctx, Bitset& out) const {
+    out |= GetMatchingChainAtoms(ctx);
+}
+
+std::string ByChainPredicate::ToCanonical() const {
+    return "bychain " + child_->ToCanonical();
+}
+
+// BoundToPredicate implementation
+
+BoundToPredicate::BoundToPredicate(Ptr child)
+    : child_(std::move(child)) {}
+
+const Bitset& BoundToPredicate::GetBondedAtoms(Context& ctx) const {
+    if (const Bitset* cached = ctx.GetCachedMask(*this)) {
+        return *cached;
     }
 
-    // Second pass: collect all atom indices that belong to matching chains
-    std::unordered_set<unsigned int> matching_atom_indices;
-    for (OESystem::OEIter atom = mol.GetAtoms(); atom; ++atom) {
-        const OEChem::OEResidue& res = OEChem::OEAtomGetResidue(&*atom);
-        if (const auto chain_id = res.GetChainID(); matching_chains.count(chain_id) > 0) {
-            matching_atom_indices.insert(atom->GetIdx());
-        }
+    Bitset child_mask(ctx.Mol().GetMaxAtomIdx());
+    ctx.EvaluateSubtree(*child_, child_mask);
+
+    Bitset bonded(child_mask.Size());
+    ctx.GetBondGraph().MarkNeighbors(child_mask, bonded);
+    return ctx.SetCachedMask(*this, std::move(bonded));
+}
+
+bool BoundToPredicate::Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const {
+    return GetBondedAtoms(ctx).Test(atom.GetIdx());
+}
+
+void BoundToPredicate::EvaluateAll(Context& ctx, Bitset& out) const {
+    out |= GetBondedAtoms(ctx);
+}
+
+std::string BoundToPredicate::ToCanonical() const {
+    return "bound_to " + child_->ToCanonical();
+}
+
+// ExtendPredicate implementation
+
+ExtendPredicate::ExtendPredicate(const unsigned int bonds, Ptr child)
+    : bonds_(bonds), child_(std::move(child)) {}
+
+const Bitset& ExtendPredicate::GetExtendedAtoms(Context& ctx) const {
+    if (const Bitset* cached = ctx.GetCachedMask(*this)) {
+        return *cached;
     }
 
-    ctx.SetChainAtoms(cache_key, std::move(matching_atom_indices));
-    return ctx.GetChainAtoms(cache_key);
+    Bitset reached(ctx.Mol().GetMaxAtomIdx());
+    ctx.EvaluateSubtree(*child_, reached);
+
+    // Breadth-first search one bond layer at a time: only atoms first
+    // reached in the previous layer are expanded
+    const BondGraph& graph = ctx.GetBondGraph();
+    Bitset frontier = reached;
+    Bitset next(reached.Size());
+    for (unsigned int layer = 0; layer < bonds_ && frontier.Any(); ++layer) {
+        next.ResetAll();
+        graph.MarkNeighbors(frontier, next);
+        next.AndNot(reached);
+        reached |= next;
+        std::swap(frontier, next);
+    }
+    return ctx.SetCachedMask(*this, std::move(reached));
 }
 
-bool ByChainPredicate::Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const {
-    const auto& matching = GetMatchingChainAtoms(ctx);
-    const unsigned int idx = atom.GetIdx();
-    return matching.count(idx) > 0;
+bool ExtendPredicate::Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const {
+    return GetExtendedAtoms(ctx).Test(atom.GetIdx());
 }
 
-std::string ByChainPredicate::ToCanonical() const {
-    return "bychain " + child_->ToCanonical();
+void ExtendPredicate::EvaluateAll(Context& ctx, Bitset& out) const {
+    out |= GetExtendedAtoms(ctx);
+}
+
+std::string ExtendPredicate::ToCanonical() const {
+    return child_->ToCanonical() + " extend " + std::to_string(bonds_);
+}
+
+namespace {
+/// Set bits for atoms whose secondary structure flags satisfy a mask test
+void scan_secondary_structure(Context& ctx, const int flags, const bool any_set, Bitset& out) {
+    const auto& column = ctx.GetAtomTable().SecondaryStructure();
+    ctx.ForEachChunk(column.size(), [&](const size_t begin, const size_t end, unsigned int) {
+        for (size_t i = begin; i < end; ++i) {
+            if (((column[i] & flags) != 0) == any_set) {
+                out.Set(i);
+            }
+        }
+    });
+    out &= ctx.GetAtomMask();
 }
+}  // namespace
 
 // HelixPredicate implementation
 bool HelixPredicate::Evaluate(Context&, const OEChem::OEAtomBase& atom) const {
@@ -855,18 +1338,30 @@ bool HelixPredicate::Evaluate(Context&, const OEChem::OEAtomBase& atom) const {
     return (res.GetSecondaryStructure() & OEBio::OESecondaryStructure::Helix) != 0;
 }
 
+void HelixPredicate::EvaluateAll(Context& ctx, Bitset& out) const {
+    scan_secondary_structure(ctx, OEBio::OESecondaryStructure::Helix, true, out);
+}
+
 // SheetPredicate implementation
 bool SheetPredicate::Evaluate(Context&, const OEChem::OEAtomBase& atom) const {
     const OEChem::OEResidue& res = OEChem::OEAtomGetResidue(&atom);
     return (res.GetSecondaryStructure() & OEBio::OESecondaryStructure::Sheet) != 0;
 }
 
+void SheetPredicate::EvaluateAll(Context& ctx, Bitset& out) const {
+    scan_secondary_structure(ctx, OEBio::OESecondaryStructure::Sheet, true, out);
+}
+
 // TurnPredicate implementation
 bool TurnPredicate::Evaluate(Context&, const OEChem::OEAtomBase& atom) const {
     const OEChem::OEResidue& res = OEChem::OEAtomGetResidue(&atom);
     return (res.GetSecondaryStructure() & OEBio::OESecondaryStructure::Turn) != 0;
 }
 
+void TurnPredicate::EvaluateAll(Context& ctx, Bitset& out) const {
+    scan_secondary_structure(ctx, OEBio::OESecondaryStructure::Turn, true, out);
+}
+
 // LoopPredicate implementation
 bool LoopPredicate::Evaluate(Context&, const OEChem::OEAtomBase& atom) const {
     const OEChem::OEResidue& res = OEChem::OEAtomGetResidue(&atom);
@@ -877,4 +1372,43 @@ bool LoopPredicate::Evaluate(Context&, const OEChem::OEAtomBase& atom) const {
            (ss & OEBio::OESecondaryStructure::Turn) == 0;
 }
 
+void LoopPredicate::EvaluateAll(Context& ctx, Bitset& out) const {
+    constexpr int structured = OEBio::OESecondaryStructure::Helix |
+                               OEBio::OESecondaryStructure::Sheet |
+                               OEBio::OESecondaryStructure::Turn;
+    scan_secondary_structure(ctx, structured, false, out);
+}
+
+// ============================================================================
+// Named Set Predicates
+// ============================================================================
+
+NamedSetPredicate::NamedSetPredicate(std::string name)
+    : name_(std::move(name)) {}
+
+const Bitset& NamedSetPredicate::GetMatchingAtoms(Context& ctx) const {
+    if (const Bitset* cached = ctx.GetCachedMask(*this)) {
+        return *cached;
+    }
+
+    // Resolve the binding once per context; rebinding a set clears the cached masks
+    Bitset mask(ctx.Mol().GetMaxAtomIdx());
+    ctx.GetNamedSet(name_).Paint(mask);
+    // Indices of atoms deleted since the result was stored
+    mask &= ctx.GetAtomMask();
+    return ctx.SetCachedMask(*this, std::move(mask));
+}
+
+bool NamedSetPredicate::Evaluate(Context& ctx, const OEChem::OEAtomBase& atom) const {
+    return GetMatchingAtoms(ctx).Test(atom.GetIdx());
+}
+
+void NamedSetPredicate::EvaluateAll(Context& ctx, Bitset& out) const {
+    out |= GetMatchingAtoms(ctx);
+}
+
+std::string NamedSetPredicate::ToCanonical() const {
+    return "%" + name_;
+}
+
 }  // namespace OESel
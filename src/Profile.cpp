@@ -0,0 +1,48 @@
+/**
+ * @file Profile.cpp
+ * @brief Evaluation profile report formatting.
+ */
+
+#include "oeselect/Profile.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace OESel {
+
+std::string EvaluationProfile::ToString() const {
+    // Align the statistics column after the widest indented label
+    size_t width = 0;
+    for (const NodeProfile& node : nodes_) {
+        width = std::max(width, 2 * node.depth + node.label.size());
+    }
+
+    std::string report;
+    char stats[256];
+    for (const NodeProfile& node : nodes_) {
+        std::string line(2 * node.depth, ' ');
+        line += node.label;
+        line.resize(width, ' ');
+
+        std::snprintf(stats, sizeof(stats), "  evals=%llu time=%.3fms self=%.3fms selectivity=%.1f%%",
+                      static_cast<unsigned long long>(node.evaluations), node.seconds * 1e3,
+                      node.self_seconds * 1e3, node.Selectivity() * 100.0);
+        line += stats;
+        if (node.cache_hits != 0 || node.cache_misses != 0) {
+            std::snprintf(stats, sizeof(stats), " cache=%llu/%llu",
+                          static_cast<unsigned long long>(node.cache_hits),
+                          static_cast<unsigned long long>(node.cache_hits + node.cache_misses));
+            line += stats;
+        }
+        if (node.spatial_queries != 0) {
+            std::snprintf(stats, sizeof(stats), " spatial=%llu",
+                          static_cast<unsigned long long>(node.spatial_queries));
+            line += stats;
+        }
+        report += line;
+        report += '\n';
+    }
+    return report;
+}
+
+}  // namespace OESel
@@ -0,0 +1,277 @@
+/**
+ * @file Program.cpp
+ * @brief Selection program compiler and interpreter.
+ */
+
+#include "oeselect/Program.h"
+#include "oeselect/Bitset.h"
+#include "oeselect/Context.h"
+#include "oeselect/Error.h"
+#include "oeselect/Predicate.h"
+
+#include <algorithm>
+#include <limits>
+#include <sstream>
+
+namespace OESel {
+
+namespace {
+/// Highest register index an instruction can address
+constexpr unsigned int kMaxRegister = std::numeric_limits<std::uint16_t>::max();
+
+/// Whether a leaf can search only the atoms its enclosing AND still matches
+bool loads_within(const Predicate& pred) {
+    const PredicateType type = pred.Type();
+    return type == PredicateType::AROUND || type == PredicateType::EXPAND || type == PredicateType::BEYOND;
+}
+
+const char* op_name(const OpCode op) {
+    switch (op) {
+        case OpCode::LOAD:         return "load";
+        case OpCode::LOAD_WITHIN:  return "load_within";
+        case OpCode::LOAD_ALL:     return "load_all";
+        case OpCode::CLEAR:        return "clear";
+        case OpCode::AND:          return "and";
+        case OpCode::OR:           return "or";
+        case OpCode::AND_NOT:      return "and_not";
+        case OpCode::NOT:          return "not";
+        case OpCode::XOR_ACCUM:    return "xor_accum";
+        case OpCode::JUMP_IF_NONE: return "jump_if_none";
+        case OpCode::JUMP_IF_ALL:  return "jump_if_all";
+    }
+    return "?";
+}
+
+/// Emits instructions for a tree, allocating registers by nesting depth
+class Compiler {
+public:
+    std::vector<Instruction> code;
+    unsigned int num_registers = 1;
+
+    /**
+     * @brief Emit code leaving the result of @p pred in register @p dst.
+     *
+     * Registers above @p dst are free for temporaries; registers below it
+     * hold live results of enclosing nodes and are never written.
+     *
+     * :param pred: Subtree to compile.
+     * :param dst: Destination register.
+     */
+    void Emit(const Predicate& pred, const unsigned int dst) {
+        switch (pred.Type()) {
+            case PredicateType::AND:
+                EmitAnd(pred.Children(), dst);
+                break;
+            case PredicateType::OR:
+                EmitOr(pred.Children(), dst);
+                break;
+            case PredicateType::NOT:
+                Emit(*pred.Children().front(), dst);
+                Push(OpCode::NOT, dst);
+                break;
+            case PredicateType::XOR:
+                EmitXor(pred.Children(), dst);
+                break;
+            case PredicateType::ALL_MATCH:
+                Push(OpCode::LOAD_ALL, dst);
+                break;
+            case PredicateType::NO_MATCH:
+                Push(OpCode::CLEAR, dst);
+                break;
+            default:
+                Push(OpCode::LOAD, dst).pred = &pred;
+                break;
+        }
+    }
+
+private:
+    Instruction& Push(const OpCode op, const unsigned int dst, const unsigned int src = 0,
+                      const unsigned int aux = 0) {
+        const unsigned int highest = std::max({dst, src, aux});
+        if (highest > kMaxRegister) {
+            throw SelectionError("Selection is nested too deeply to compile");
+        }
+        num_registers = std::max(num_registers, highest + 1);
+        Instruction& ins = code.emplace_back();
+        ins.op = op;
+        ins.dst = static_cast<std::uint16_t>(dst);
+        ins.src = static_cast<std::uint16_t>(src);
+        ins.aux = static_cast<std::uint16_t>(aux);
+        return ins;
+    }
+
+    /// Point the jumps at @p jumps to the next instruction to be emitted
+    void PatchJumps(const std::vector<size_t>& jumps) {
+        for (const size_t jump : jumps) {
+            code[jump].target = static_cast<std::uint32_t>(code.size());
+        }
+    }
+
+    void EmitAnd(const std::vector<Predicate::Ptr>& children, const unsigned int dst) {
+        if (children.empty()) {
+            Push(OpCode::LOAD_ALL, dst);
+            return;
+        }
+        Emit(*children[0], dst);
+        std::vector<size_t> exits;
+        for (size_t i = 1; i < children.size(); ++i) {
+            exits.push_back(code.size());
+            Push(OpCode::JUMP_IF_NONE, dst);
+            // Subtract a negated conjunct directly instead of complementing it first
+            const bool negated = children[i]->Type() == PredicateType::NOT;
+            const Predicate& operand = negated ? *children[i]->Children().front() : *children[i];
+            if (loads_within(operand)) {
+                Push(OpCode::LOAD_WITHIN, dst + 1, dst).pred = &operand;
+            } else {
+                Emit(operand, dst + 1);
+            }
+            Push(negated ? OpCode::AND_NOT : OpCode::AND, dst, dst + 1);
+        }
+        PatchJumps(exits);
+    }
+
+    void EmitOr(const std::vector<Predicate::Ptr>& children, const unsigned int dst) {
+        if (children.empty()) {
+            Push(OpCode::CLEAR, dst);
+            return;
+        }
+        Emit(*children[0], dst);
+        std::vector<size_t> exits;
+        for (size_t i = 1; i < children.size(); ++i) {
+            exits.push_back(code.size());
+            Push(OpCode::JUMP_IF_ALL, dst);
+            Emit(*children[i], dst + 1);
+            Push(OpCode::OR, dst, dst + 1);
+        }
+        PatchJumps(exits);
+    }
+
+    void EmitXor(const std::vector<Predicate::Ptr>& children, const unsigned int dst) {
+        if (children.empty()) {
+            Push(OpCode::CLEAR, dst);
+            return;
+        }
+        Emit(*children[0], dst);
+        if (children.size() == 1) {
+            return;
+        }
+        // dst + 1 collects atoms matched by more than one child
+        Push(OpCode::CLEAR, dst + 1);
+        for (size_t i = 1; i < children.size(); ++i) {
+            Emit(*children[i], dst + 2);
+            Push(OpCode::XOR_ACCUM, dst, dst + 2, dst + 1);
+        }
+        Push(OpCode::AND_NOT, dst, dst + 1);
+    }
+};
+}  // namespace
+
+SelectionProgram SelectionProgram::Compile(const Predicate& root) {
+    Compiler compiler;
+    compiler.Emit(root, 0);
+    SelectionProgram program;
+    program.code_ = std::move(compiler.code);
+    program.num_registers_ = compiler.num_registers;
+    return program;
+}
+
+void SelectionProgram::Run(Context& ctx, Bitset& out) const {
+    Bitset* const scratch = ctx.GetScratchMasks(num_registers_ - 1, out.Size());
+    const auto reg = [&](const std::uint16_t r) -> Bitset& { return r == 0 ? out : scratch[r - 1]; };
+
+    const size_t size = code_.size();
+    for (size_t pc = 0; pc < size;) {
+        const Instruction& ins = code_[pc++];
+        switch (ins.op) {
+            case OpCode::LOAD: {
+                Bitset& dst = reg(ins.dst);
+                dst.ResetAll();
+                ctx.EvaluateSubtree(*ins.pred, dst);
+                break;
+            }
+            case OpCode::LOAD_WITHIN: {
+                Bitset& dst = reg(ins.dst);
+                dst.ResetAll();
+                ctx.EvaluateSubtreeWithin(*ins.pred, reg(ins.src), dst);
+                break;
+            }
+            case OpCode::LOAD_ALL:
+                reg(ins.dst) = ctx.GetAtomMask();
+                break;
+            case OpCode::CLEAR:
+                reg(ins.dst).ResetAll();
+                break;
+            case OpCode::AND:
+                reg(ins.dst) &= reg(ins.src);
+                break;
+            case OpCode::OR:
+                reg(ins.dst) |= reg(ins.src);
+                break;
+            case OpCode::AND_NOT:
+                reg(ins.dst).AndNot(reg(ins.src));
+                break;
+            case OpCode::NOT: {
+                // Complement against atoms that exist, not every index below GetMaxAtomIdx()
+                Bitset& dst = reg(ins.dst);
+                dst.Flip();
+                dst &= ctx.GetAtomMask();
+                break;
+            }
+            case OpCode::XOR_ACCUM: {
+                Bitset::Word* dst = reg(ins.dst).Words();
+                const Bitset::Word* src = reg(ins.src).Words();
+                Bitset::Word* multiple = reg(ins.aux).Words();
+                const size_t num_words = out.NumWords();
+                for (size_t w = 0; w < num_words; ++w) {
+                    multiple[w] |= dst[w] & src[w];
+                    dst[w] |= src[w];
+                }
+                break;
+            }
+            case OpCode::JUMP_IF_NONE:
+                if (reg(ins.dst).None()) {
+                    pc = ins.target;
+                }
+                break;
+            case OpCode::JUMP_IF_ALL:
+                if (reg(ins.dst) == ctx.GetAtomMask()) {
+                    pc = ins.target;
+                }
+                break;
+        }
+    }
+}
+
+std::string SelectionProgram::ToString() const {
+    std::ostringstream oss;
+    for (size_t pc = 0; pc < code_.size(); ++pc) {
+        const Instruction& ins = code_[pc];
+        oss << pc << ": " << op_name(ins.op) << " r" << ins.dst;
+        switch (ins.op) {
+            case OpCode::LOAD:
+                oss << ", " << ins.pred->ToCanonical();
+                break;
+            case OpCode::LOAD_WITHIN:
+                oss << ", r" << ins.src << ", " << ins.pred->ToCanonical();
+                break;
+            case OpCode::AND:
+            case OpCode::OR:
+            case OpCode::AND_NOT:
+                oss << ", r" << ins.src;
+                break;
+            case OpCode::XOR_ACCUM:
+                oss << ", r" << ins.src << ", r" << ins.aux;
+                break;
+            case OpCode::JUMP_IF_NONE:
+            case OpCode::JUMP_IF_ALL:
+                oss << ", " << ins.target;
+                break;
+            default:
+                break;
+        }
+        oss << '\n';
+    }
+    return oss.str();
+}
+
+}  // namespace OESel
@@ -4,13 +4,15 @@
  */
 
 #include "oeselect/ResidueSelector.h"
+#include "oeselect/AtomTable.h"
 #include "oeselect/Error.h"
 #include "oeselect/Selection.h"
 #include "oeselect/Selector.h"
 
+#include <algorithm>
 #include <limits>
-#include <regex>
 #include <sstream>
+#include <string_view>
 #include <tuple>
 
 #include <oechem.h>
@@ -34,6 +36,28 @@ int parse_selector_residue_number(const std::string& token) {
         throw SelectionError("Invalid residue number in selector: " + token);
     }
 }
+
+/// Largest interned residue name id that fits in an encoded key (0 means "no such name")
+constexpr size_t kMaxNameId = 0xFFFF;
+
+/// Pack a residue into one key: number in the high 32 bits, then name id, chain, and insertion code
+constexpr std::uint64_t encode_residue(const int residue_number, const std::uint32_t name_id,
+                                       const char chain, const char insert_code) {
+    return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(residue_number)) << 32) |
+           (static_cast<std::uint64_t>(name_id) << 16) |
+           (static_cast<std::uint64_t>(static_cast<unsigned char>(chain)) << 8) |
+           static_cast<std::uint64_t>(static_cast<unsigned char>(insert_code));
+}
+
+/// 1-based position of a name in a sorted name list, or 0 if absent
+std::uint32_t find_name_id(const std::vector<std::string>& names, const std::string_view name) {
+    const auto it = std::lower_bound(names.begin(), names.end(), name,
+                                     [](const std::string& lhs, const std::string_view rhs) { return lhs < rhs; });
+    if (it == names.end() || *it != name) {
+        return 0;
+    }
+    return static_cast<std::uint32_t>(it - names.begin()) + 1;
+}
 }  // namespace
 
 // ============================================================================
@@ -119,20 +143,101 @@ bool Selector::operator!=(const Selector& other) const {
 // OEResidueSelector
 // ============================================================================
 
-OEResidueSelector::OEResidueSelector(const std::string& selector_str)
-    : selectors_(parse_selector_set(selector_str)) {}
+OEResidueSelector::OEResidueSelector(const std::string& selector_str) {
+    Encode(parse_selector_set(selector_str));
+}
 
-OEResidueSelector::OEResidueSelector(const std::set<Selector>& selectors)
-    : selectors_(selectors) {}
+OEResidueSelector::OEResidueSelector(const std::set<Selector>& selectors) {
+    Encode(selectors);
+}
 
 OEResidueSelector::OEResidueSelector(const OEResidueSelector& other)
-    : selectors_(other.selectors_) {}
+    : names_(other.names_), keys_(other.keys_) {}
 
 OEResidueSelector::~OEResidueSelector() = default;
 
+void OEResidueSelector::Encode(const std::set<Selector>& selectors) {
+    // Atoms always carry a one-character chain and insertion code, so other selectors never match
+    auto encodable = [](const Selector& sel) {
+        return sel.chain.size() == 1 && sel.insert_code.size() == 1;
+    };
+    for (const Selector& sel : selectors) {
+        if (encodable(sel)) {
+            names_.push_back(sel.name);
+        }
+    }
+    std::sort(names_.begin(), names_.end());
+    names_.erase(std::unique(names_.begin(), names_.end()), names_.end());
+    if (names_.size() > kMaxNameId) {
+        throw SelectionError("Too many distinct residue names in selector set: " +
+                             std::to_string(names_.size()));
+    }
+
+    keys_.reserve(selectors.size());
+    for (const Selector& sel : selectors) {
+        if (encodable(sel)) {
+            keys_.push_back(encode_residue(sel.residue_number, find_name_id(names_, sel.name),
+                                           sel.chain[0], sel.insert_code[0]));
+        }
+    }
+    std::sort(keys_.begin(), keys_.end());
+    keys_.erase(std::unique(keys_.begin(), keys_.end()), keys_.end());
+}
+
 bool OEResidueSelector::operator()(const OEChem::OEAtomBase& atom) const {
-    const Selector sel = Selector::FromAtom(atom);
-    return selectors_.count(sel) > 0;
+    if (keys_.empty()) {
+        return false;
+    }
+    const OEChem::OEResidue res = OEChem::OEAtomGetResidue(&atom);
+    const std::uint32_t name_id = find_name_id(names_, res.GetName());
+    if (name_id == 0) {
+        return false;
+    }
+    const std::uint64_t key = encode_residue(res.GetResidueNumber(), name_id,
+                                             res.GetChainID(), res.GetInsertCode());
+    return std::binary_search(keys_.begin(), keys_.end(), key);
+}
+
+Bitset OEResidueSelector::EvaluateMask(const OEChem::OEMolBase& mol) const {
+    Bitset mask(mol.GetMaxAtomIdx());
+    if (keys_.empty()) {
+        return mask;
+    }
+    const AtomTable table(mol);
+
+    // Map interned table names to selector name ids once per distinct name
+    std::vector<std::uint32_t> name_ids(table.ResidueNames().size());
+    for (size_t i = 0; i < name_ids.size(); ++i) {
+        name_ids[i] = find_name_id(names_, table.ResidueNames()[i]);
+    }
+
+    const auto& groups = table.ResidueGroups();
+    const auto& names = table.ResidueNameIds();
+    const auto& numbers = table.ResidueNumbers();
+    const auto& chains = table.ChainIds();
+    const auto& icodes = table.InsertCodes();
+
+    // Atoms of a residue are usually contiguous, so reuse the previous atom's lookup
+    std::uint64_t last_key = 0;  // Never a valid key: name ids start at 1
+    bool last_match = false;
+    for (size_t idx = 0; idx < table.Size(); ++idx) {
+        if (groups[idx] == AtomTable::kNoGroup) {
+            continue;
+        }
+        const std::uint32_t name_id = name_ids[names[idx]];
+        if (name_id == 0) {
+            continue;
+        }
+        const std::uint64_t key = encode_residue(numbers[idx], name_id, chains[idx], icodes[idx]);
+        if (key != last_key) {
+            last_key = key;
+            last_match = std::binary_search(keys_.begin(), keys_.end(), key);
+        }
+        if (last_match) {
+            mask.Set(idx);
+        }
+    }
+    return mask;
 }
 
 OESystem::OEUnaryFunction<OEChem::OEAtomBase, bool>*
@@ -147,21 +252,26 @@ OEResidueSelector::CreateCopy() const {
 std::set<Selector> parse_selector_set(const std::string& selector_str) {
     std::set<Selector> result;
     // Split on comma, semicolon, ampersand, tab, and newline
-    static const std::regex delimiter(R"([,;&\t\n]+)");
+    constexpr std::string_view delimiters = ",;&\t\n";
+    constexpr std::string_view whitespace = " \t\r\n";
+
+    const std::string_view input(selector_str);
+    size_t pos = 0;
+    while (pos < input.size()) {
+        size_t next = input.find_first_of(delimiters, pos);
+        if (next == std::string_view::npos) {
+            next = input.size();
+        }
+        std::string_view token = input.substr(pos, next - pos);
+        pos = next + 1;
 
-    std::sregex_token_iterator it(selector_str.begin(), selector_str.end(),
-                                  delimiter, -1);
-    for (std::sregex_token_iterator end; it != end; ++it) {
-        std::string token = it->str();
         // Trim whitespace
-        auto start = token.find_first_not_of(" \t\r\n");
-        if (start == std::string::npos) continue;
-        auto finish = token.find_last_not_of(" \t\r\n");
+        const auto start = token.find_first_not_of(whitespace);
+        if (start == std::string_view::npos) continue;
+        const auto finish = token.find_last_not_of(whitespace);
         token = token.substr(start, finish - start + 1);
 
-        if (!token.empty()) {
-            result.insert(Selector::FromString(token));
-        }
+        result.insert(Selector::FromString(std::string(token)));
     }
     return result;
 }
@@ -182,8 +292,9 @@ std::set<Selector> selector_set(
 
 std::set<Selector> selector_set(const OESelect& selector) {
     std::set<Selector> result;
+    const Bitset& mask = selector.GetMask();
     for (OESystem::OEIter atom = selector.GetMol().GetAtoms(); atom; ++atom) {
-        if (selector(*atom)) {
+        if (mask.Test(atom->GetIdx())) {
             result.insert(Selector::FromAtom(*atom));
         }
     }
@@ -4,9 +4,14 @@
  */
 
 #include "oeselect/Selection.h"
+#include "oeselect/Context.h"
 #include "oeselect/Parser.h"
+#include "oeselect/predicates/LogicalPredicates.h"
+#include "lru_cache.h"
 
+#include <oechem.h>
 #include <algorithm>
+#include <unordered_map>
 
 namespace OESel {
 
@@ -21,49 +26,153 @@ public:
     bool Evaluate(Context&, const OEChem::OEAtomBase&) const override {
         return true;
     }
+    void EvaluateAll(Context& ctx, Bitset& out) const override {
+        out |= ctx.GetAtomMask();
+    }
     [[nodiscard]] std::string ToCanonical() const override { return "all"; }
     [[nodiscard]] PredicateType Type() const override { return PredicateType::ALL_MATCH; }
 };
 
-/// PIMPL implementation holding the root predicate
+namespace {
+/**
+ * @brief Number predicates in post-order, sharing slots between equal cache keys.
+ *
+ * @param pred Root of subtree to number.
+ * @param slots Map from cache key to assigned slot.
+ */
+void assign_slots_recursive(Predicate& pred, std::unordered_map<std::string, unsigned int>& slots) {
+    for (const auto& child : pred.Children()) {
+        assign_slots_recursive(*child, slots);
+    }
+    const auto next = static_cast<unsigned int>(slots.size());
+    const auto [it, inserted] = slots.try_emplace(pred.CacheKey(), next);
+    pred.SetSlot(it->second);
+}
+
+unsigned int assign_slots(Predicate& root) {
+    std::unordered_map<std::string, unsigned int> slots;
+    assign_slots_recursive(root, slots);
+    return static_cast<unsigned int>(slots.size());
+}
+}  // namespace
+
+/// PIMPL implementation holding the parsed and optimized trees
 struct OESelection::Impl {
-    Predicate::Ptr root;
+    std::string text;       ///< String the selection was parsed from ("" for all)
+    Predicate::Ptr source;  ///< Tree as parsed; defines canonical form and introspection
+    Predicate::Ptr root;    ///< Optimized tree used for evaluation
+    unsigned int num_slots;
+    SelectionProgram program;  ///< Compiled from root, whose nodes it points into
 
-    Impl() : root(std::make_shared<TruePredicate>()) {}
-    explicit Impl(Predicate::Ptr r) : root(std::move(r)) {}
+    Impl() : Impl(std::string(), std::make_shared<TruePredicate>()) {}
+    Impl(std::string t, Predicate::Ptr r) : Impl(std::move(t), r, optimize_selection(r)) {}
+    Impl(std::string t, Predicate::Ptr s, Predicate::Ptr r)
+        : text(std::move(t)), source(std::move(s)), root(std::move(r)), num_slots(assign_slots(*root))
+        , program(SelectionProgram::Compile(*root)) {}
 };
 
+namespace {
+/// Entries kept by the Parse() cache unless resized
+constexpr size_t kDefaultParseCacheCapacity = 1024;
+
+/// The process-wide Parse() cache, instantiated where OESelection::Impl is accessible
+template <typename Impl>
+ShardedLruCache<Impl>& parse_cache() {
+    static ShardedLruCache<Impl> cache(kDefaultParseCacheCapacity);
+    return cache;
+}
+
+/// Merge() results keyed by their source texts, sized and cleared with the Parse() cache
+template <typename Impl>
+ShardedLruCache<Impl>& merge_cache() {
+    static ShardedLruCache<Impl> cache(kDefaultParseCacheCapacity);
+    return cache;
+}
+
+}  // namespace
+
 OESelection OESelection::Parse(const std::string& sele) {
     if (sele.empty()) {
         return {};  // Empty string = select all
     }
-    const auto root = parse_selection(sele);
-    return OESelection(root);
+    auto& cache = parse_cache<Impl>();
+    if (auto cached = cache.Find(sele)) {
+        return OESelection(std::move(cached));
+    }
+    OESelection result(sele, parse_selection(sele));
+    cache.Insert(sele, result.pimpl_);
+    return result;
 }
 
-OESelection::OESelection() : pimpl_(std::make_unique<Impl>()) {}
+void OESelection::SetParseCacheCapacity(const size_t capacity) {
+    parse_cache<Impl>().SetCapacity(capacity);
+    merge_cache<Impl>().SetCapacity(capacity);
+}
+
+void OESelection::ClearParseCache() {
+    parse_cache<Impl>().Clear();
+    merge_cache<Impl>().Clear();
+}
 
-OESelection::OESelection(Predicate::Ptr root)
-    : pimpl_(std::make_unique<Impl>(std::move(root))) {}
+ParseCacheStats OESelection::GetParseCacheStats() {
+    auto& cache = parse_cache<Impl>();
+    ParseCacheStats stats;
+    stats.hits = cache.Hits();
+    stats.misses = cache.Misses();
+    stats.size = cache.Size();
+    stats.capacity = cache.Capacity();
+    return stats;
+}
 
-OESelection::OESelection(const OESelection& other)
-    : pimpl_(std::make_unique<Impl>(*other.pimpl_)) {}
+OESelection::OESelection() : pimpl_(std::make_shared<const Impl>()) {}
 
-OESelection::OESelection(OESelection&& other) noexcept = default;
+OESelection::OESelection(std::string text, Predicate::Ptr root)
+    : pimpl_(std::make_shared<const Impl>(std::move(text), std::move(root))) {}
+
+OESelection::OESelection(std::shared_ptr<const Impl> impl)
+    : pimpl_(std::move(impl)) {}
 
-OESelection& OESelection::operator=(const OESelection& other) {
-    if (this != &other) {
-        pimpl_ = std::make_unique<Impl>(*other.pimpl_);
+OESelection OESelection::Merge(const std::vector<OESelection>& selections) {
+    // Texts are length-prefixed so that no two lists share a key
+    std::string key;
+    for (const OESelection& sele : selections) {
+        const std::string& text = sele.pimpl_->text;
+        key += std::to_string(text.size());
+        key += ':';
+        key += text;
     }
-    return *this;
+    auto& cache = merge_cache<Impl>();
+    if (auto cached = cache.Find(key)) {
+        return OESelection(std::move(cached));
+    }
+
+    std::vector<Predicate::Ptr> sources;
+    sources.reserve(selections.size());
+    for (const OESelection& sele : selections) {
+        // A fresh parse keeps the merged tree from renumbering nodes the original still uses
+        const std::string& text = sele.pimpl_->text;
+        sources.push_back(text.empty() ? std::make_shared<TruePredicate>() : parse_selection(text));
+    }
+    std::vector<Predicate::Ptr> roots = optimize_selections(sources);
+    OESelection result(std::make_shared<const Impl>(
+        std::string(), std::make_shared<OrPredicate>(std::move(sources)),
+        std::make_shared<OrPredicate>(std::move(roots))));
+    cache.Insert(key, result.pimpl_);
+    return result;
 }
 
+OESelection::OESelection(const OESelection& other) = default;
+
+OESelection::OESelection(OESelection&& other) noexcept = default;
+
+OESelection& OESelection::operator=(const OESelection& other) = default;
+
 OESelection& OESelection::operator=(OESelection&& other) noexcept = default;
 
 OESelection::~OESelection() = default;
 
 std::string OESelection::ToCanonical() const {
-    return pimpl_->root->ToCanonical();
+    return pimpl_->source->ToCanonical();
 }
 
 namespace {
@@ -85,15 +194,68 @@ bool contains_predicate_recursive(const Predicate& pred, const PredicateType typ
 }  // namespace
 
 bool OESelection::ContainsPredicate(const PredicateType type) const {
-    return contains_predicate_recursive(*pimpl_->root, type);
+    return contains_predicate_recursive(*pimpl_->source, type);
 }
 
 const Predicate& OESelection::Root() const {
     return *pimpl_->root;
 }
 
+const SelectionProgram& OESelection::GetProgram() const {
+    return pimpl_->program;
+}
+
+unsigned int OESelection::NumSlots() const {
+    return pimpl_->num_slots;
+}
+
+Bitset OESelection::EvaluateMask(OEChem::OEMolBase& mol) const {
+    Context ctx(mol, *this);
+    Bitset mask(mol.GetMaxAtomIdx());
+    ctx.EvaluateSelection(mask);
+    return mask;
+}
+
 bool OESelection::IsEmpty() const {
-    return pimpl_->root->Type() == PredicateType::ALL_MATCH;
+    return pimpl_->source->Type() == PredicateType::ALL_MATCH;
+}
+
+namespace {
+/// Restores a multi-conformer molecule's active conformer on scope exit
+class ActiveConfGuard {
+public:
+    explicit ActiveConfGuard(OEChem::OEMCMolBase& mol) : mol_(mol), active_(mol.GetActive()) {}
+    ~ActiveConfGuard() { mol_.SetActive(active_); }
+
+    ActiveConfGuard(const ActiveConfGuard&) = delete;
+    ActiveConfGuard& operator=(const ActiveConfGuard&) = delete;
+
+private:
+    OEChem::OEMCMolBase& mol_;
+    OEChem::OEConfBase* active_;
+};
+}  // namespace
+
+std::vector<Bitset> EvaluateConformers(OEChem::OEMCMolBase& mol, const OESelection& sele) {
+    std::vector<Bitset> masks;
+    masks.reserve(mol.NumConfs());
+
+    const ActiveConfGuard guard(mol);
+    Context ctx(mol, sele);
+    ctx.SetShareStaticResults(true);
+    bool first = true;
+    for (OESystem::OEIter<OEChem::OEConfBase> conf = mol.GetConfs(); conf; ++conf) {
+        mol.SetActive(&*conf);
+        if (!first) {
+            ctx.UpdateCoordinates();
+        }
+        first = false;
+
+        Bitset mask(mol.GetMaxAtomIdx());
+        ctx.EvaluateSelection(mask);
+        masks.push_back(std::move(mask));
+    }
+    return masks;
 }
 
 }  // namespace OESel
@@ -0,0 +1,339 @@
+/**
+ * @file SelectionResult.cpp
+ * @brief Compressed selection result containers and set algebra.
+ */
+
+#include "oeselect/SelectionResult.h"
+#include "oeselect/Error.h"
+
+#include <algorithm>
+#include <limits>
+#include <string>
+
+namespace OESel {
+
+namespace {
+using Word = Bitset::Word;
+constexpr size_t kWordBits = Bitset::kWordBits;
+
+size_t popcount(const Word w) {
+    return std::bitset<kWordBits>(w).count();
+}
+
+/// Set bits [begin, end) of a chunk's words
+void set_word_range(Word* words, const size_t begin, const size_t end) {
+    for (size_t bit = begin; bit < end;) {
+        const size_t w = bit / kWordBits;
+        const size_t offset = bit % kWordBits;
+        const size_t span = std::min(kWordBits - offset, end - bit);
+        const Word mask = span == kWordBits ? ~Word{0} : ((Word{1} << span) - 1) << offset;
+        words[w] |= mask;
+        bit += span;
+    }
+}
+}  // namespace
+
+OESelectionResult::OESelectionResult(const size_t size)
+    : size_(size) {}
+
+OESelectionResult::OESelectionResult(const Bitset& mask)
+    : size_(mask.Size()) {
+    std::vector<Word> chunk(kChunkWords);
+    const size_t num_words = mask.NumWords();
+    for (size_t first = 0; first < num_words; first += kChunkWords) {
+        const size_t count = std::min(kChunkWords, num_words - first);
+        std::copy(mask.Words() + first, mask.Words() + first + count, chunk.begin());
+        std::fill(chunk.begin() + static_cast<std::ptrdiff_t>(count), chunk.end(), Word{0});
+        AppendChunk(static_cast<std::uint32_t>(first / kChunkWords), chunk.data());
+    }
+}
+
+OESelectionResult OESelectionResult::FromIndices(const size_t size, const std::vector<unsigned int>& indices) {
+    Bitset mask(size);
+    for (const unsigned int idx : indices) {
+        if (idx >= size) {
+            throw SelectionError("Atom index " + std::to_string(idx) + " is outside a result of " +
+                                 std::to_string(size) + " atoms");
+        }
+        mask.Set(idx);
+    }
+    return OESelectionResult(mask);
+}
+
+void OESelectionResult::AppendChunk(const std::uint32_t key, const Word* words) {
+    size_t count = 0;
+    size_t runs = 0;
+    Word carry = 0;  // Top bit of the previous word, so runs spanning words count once
+    for (size_t w = 0; w < kChunkWords; ++w) {
+        count += popcount(words[w]);
+        runs += popcount(words[w] & ~((words[w] << 1) | carry));
+        carry = words[w] >> (kWordBits - 1);
+    }
+    if (count == 0) return;
+
+    Container c;
+    c.key = key;
+    c.count = static_cast<std::uint32_t>(count);
+    const size_t array_bytes = count * sizeof(std::uint16_t);
+    const size_t run_bytes = runs * 2 * sizeof(std::uint16_t);
+    const size_t bitmap_bytes = kChunkWords * sizeof(Word);
+    if (run_bytes <= array_bytes && run_bytes <= bitmap_bytes) {
+        c.kind = Kind::RUNS;
+        c.values.reserve(runs * 2);
+        bool inside = false;
+        for (size_t w = 0; w < kChunkWords; ++w) {
+            const Word word = words[w];
+            // Words that neither start nor end a run
+            if ((!inside && word == 0) || (inside && word == ~Word{0})) continue;
+            for (size_t b = 0; b < kWordBits; ++b) {
+                const bool set = (word >> b & 1U) != 0;
+                if (set != inside) {
+                    const size_t bit = w * kWordBits + b;
+                    c.values.push_back(static_cast<std::uint16_t>(set ? bit : bit - 1));
+                    inside = set;
+                }
+            }
+        }
+        if (inside) {
+            c.values.push_back(std::numeric_limits<std::uint16_t>::max());
+        }
+    } else if (array_bytes <= bitmap_bytes) {
+        c.kind = Kind::ARRAY;
+        c.values.reserve(count);
+        for (size_t w = 0; w < kChunkWords; ++w) {
+            Word bits = words[w];
+            while (bits != 0) {
+                const Word low = bits & (~bits + 1);
+                c.values.push_back(static_cast<std::uint16_t>(w * kWordBits + popcount(low - 1)));
+                bits ^= low;
+            }
+        }
+    } else {
+        c.kind = Kind::BITMAP;
+        c.words.assign(words, words + kChunkWords);
+    }
+    containers_.push_back(std::move(c));
+}
+
+void OESelectionResult::Decode(const Container& c, Word* words) {
+    switch (c.kind) {
+        case Kind::ARRAY:
+            for (const std::uint16_t value : c.values) {
+                words[value / kWordBits] |= Word{1} << (value % kWordBits);
+            }
+            break;
+        case Kind::RUNS:
+            for (size_t i = 0; i < c.values.size(); i += 2) {
+                set_word_range(words, c.values[i], size_t{c.values[i + 1]} + 1);
+            }
+            break;
+        case Kind::BITMAP:
+            std::copy(c.words.begin(), c.words.end(), words);
+            break;
+    }
+}
+
+void OESelectionResult::Combine(const OESelectionResult& other, const Op op) {
+    if (&other == this) {
+        const OESelectionResult copy = other;
+        Combine(copy, op);
+        return;
+    }
+    std::vector<Container> mine;
+    mine.swap(containers_);
+    std::vector<Word> a(kChunkWords);
+    std::vector<Word> b(kChunkWords);
+    const auto load = [](const Container& c, std::vector<Word>& words) {
+        std::fill(words.begin(), words.end(), Word{0});
+        Decode(c, words.data());
+    };
+
+    // Members of the other operand at or past size_ are dropped
+    const std::uint64_t num_chunks = (size_ + (size_t{1} << kChunkBits) - 1) >> kChunkBits;
+    const auto clip = [this](const std::uint32_t key, std::vector<Word>& words) {
+        const size_t limit = size_ - (size_t{key} << kChunkBits);
+        if (limit >= kChunkWords * kWordBits) return;
+        std::fill(words.begin() + static_cast<std::ptrdiff_t>((limit + kWordBits - 1) / kWordBits), words.end(),
+                  Word{0});
+        if (limit % kWordBits != 0) {
+            words[limit / kWordBits] &= (Word{1} << (limit % kWordBits)) - 1;
+        }
+    };
+
+    constexpr std::uint64_t kEnd = std::numeric_limits<std::uint64_t>::max();
+    size_t i = 0;
+    size_t j = 0;
+    while (i < mine.size() || j < other.containers_.size()) {
+        const std::uint64_t key_a = i < mine.size() ? mine[i].key : kEnd;
+        const std::uint64_t key_b = j < other.containers_.size() ? other.containers_[j].key : kEnd;
+        if (key_a < key_b) {
+            // Chunk only in this result: kept unless intersecting
+            if (op != Op::AND) {
+                containers_.push_back(std::move(mine[i]));
+            }
+            ++i;
+        } else if (key_b < key_a) {
+            // Chunk only in the other result: added by union and symmetric difference
+            const Container& theirs = other.containers_[j];
+            if ((op == Op::OR || op == Op::XOR) && key_b < num_chunks) {
+                load(theirs, b);
+                clip(theirs.key, b);
+                AppendChunk(theirs.key, b.data());
+            }
+            ++j;
+        } else {
+            load(mine[i], a);
+            load(other.containers_[j], b);
+            for (size_t w = 0; w < kChunkWords; ++w) {
+                switch (op) {
+                    case Op::AND: a[w] &= b[w]; break;
+                    case Op::OR: a[w] |= b[w]; break;
+                    case Op::XOR: a[w] ^= b[w]; break;
+                    case Op::AND_NOT: a[w] &= ~b[w]; break;
+                }
+            }
+            clip(mine[i].key, a);
+            AppendChunk(mine[i].key, a.data());
+            ++i;
+            ++j;
+        }
+    }
+}
+
+OESelectionResult& OESelectionResult::operator&=(const OESelectionResult& other) {
+    Combine(other, Op::AND);
+    return *this;
+}
+
+OESelectionResult& OESelectionResult::operator|=(const OESelectionResult& other) {
+    Combine(other, Op::OR);
+    return *this;
+}
+
+OESelectionResult& OESelectionResult::operator^=(const OESelectionResult& other) {
+    Combine(other, Op::XOR);
+    return *this;
+}
+
+OESelectionResult& OESelectionResult::AndNot(const OESelectionResult& other) {
+    Combine(other, Op::AND_NOT);
+    return *this;
+}
+
+bool OESelectionResult::operator==(const OESelectionResult& other) const {
+    // Encodings are chosen from the members alone, so equal sets have equal containers
+    return size_ == other.size_ && containers_ == other.containers_;
+}
+
+size_t OESelectionResult::Count() const {
+    size_t count = 0;
+    for (const Container& c : containers_) {
+        count += c.count;
+    }
+    return count;
+}
+
+bool OESelectionResult::Contains(const size_t idx) const {
+    if (idx >= size_) return false;
+    const auto key = static_cast<std::uint32_t>(idx >> kChunkBits);
+    const auto it = std::lower_bound(containers_.begin(), containers_.end(), key,
+                                     [](const Container& c, const std::uint32_t k) { return c.key < k; });
+    if (it == containers_.end() || it->key != key) return false;
+
+    const auto low = static_cast<std::uint16_t>(idx & ((size_t{1} << kChunkBits) - 1));
+    switch (it->kind) {
+        case Kind::ARRAY:
+            return std::binary_search(it->values.begin(), it->values.end(), low);
+        case Kind::RUNS: {
+            // Last run starting at or before low
+            size_t lo = 0;
+            size_t hi = it->values.size() / 2;
+            while (lo < hi) {
+                const size_t mid = (lo + hi) / 2;
+                if (it->values[mid * 2] <= low) {
+                    lo = mid + 1;
+                } else {
+                    hi = mid;
+                }
+            }
+            return lo > 0 && it->values[(lo - 1) * 2 + 1] >= low;
+        }
+        case Kind::BITMAP:
+            return (it->words[low / kWordBits] >> (low % kWordBits) & 1U) != 0;
+    }
+    return false;
+}
+
+std::vector<unsigned int> OESelectionResult::ToIndices() const {
+    std::vector<unsigned int> indices;
+    indices.reserve(Count());
+    ForEach([&indices](const size_t idx) { indices.push_back(static_cast<unsigned int>(idx)); });
+    return indices;
+}
+
+Bitset OESelectionResult::ToBitset() const {
+    Bitset mask(size_);
+    Paint(mask);
+    return mask;
+}
+
+void OESelectionResult::Paint(Bitset& out) const {
+    const size_t limit = out.Size();
+    for (const Container& c : containers_) {
+        const size_t base = size_t{c.key} << kChunkBits;
+        if (base >= limit) break;
+        switch (c.kind) {
+            case Kind::ARRAY:
+                for (const std::uint16_t value : c.values) {
+                    if (base + value >= limit) break;
+                    out.Set(base + value);
+                }
+                break;
+            case Kind::RUNS:
+                for (size_t i = 0; i < c.values.size(); i += 2) {
+                    const size_t begin = base + c.values[i];
+                    if (begin >= limit) break;
+                    out.SetRange(begin, std::min(base + c.values[i + 1] + 1, limit));
+                }
+                break;
+            case Kind::BITMAP: {
+                const size_t first = base / kWordBits;
+                const size_t count = std::min(kChunkWords, out.NumWords() - first);
+                Word* words = out.Words() + first;
+                for (size_t w = 0; w < count; ++w) {
+                    words[w] |= c.words[w];
+                }
+                // Keep the padding past out.Size() clear
+                if (first + count == out.NumWords() && limit % kWordBits != 0) {
+                    words[count - 1] &= (Word{1} << (limit % kWordBits)) - 1;
+                }
+                break;
+            }
+        }
+    }
+}
+
+size_t OESelectionResult::MemoryUsage() const {
+    size_t bytes = containers_.size() * sizeof(Container);
+    for (const Container& c : containers_) {
+        bytes += c.values.size() * sizeof(std::uint16_t) + c.words.size() * sizeof(Word);
+    }
+    return bytes;
+}
+
+// ============================================================================
+// OEInSelectionResult
+// ============================================================================
+
+OEInSelectionResult::OEInSelectionResult(OESelectionResult result)
+    : result_(std::make_shared<const OESelectionResult>(std::move(result))) {}
+
+bool OEInSelectionResult::operator()(const OEChem::OEAtomBase& atom) const {
+    return result_->Contains(atom.GetIdx());
+}
+
+OESystem::OEUnaryFunction<OEChem::OEAtomBase, bool>* OEInSelectionResult::CreateCopy() const {
+    return new OEInSelectionResult(*this);
+}
+
+}  // namespace OESel
@@ -0,0 +1,126 @@
+/**
+ * @file SelectionSet.cpp
+ * @brief Fused multi-selection evaluation implementation.
+ */
+
+#include "oeselect/SelectionSet.h"
+#include "oeselect/Context.h"
+#include "oeselect/Error.h"
+#include "oeselect/Program.h"
+
+#include <oechem.h>
+
+namespace OESel {
+
+namespace {
+/// Immutable merged form of a set, shared by copies
+struct MergedTree {
+    std::vector<OESelection> selections;
+    OESelection merged;                     ///< Root's i-th child evaluates selections[i]
+    std::vector<SelectionProgram> programs; ///< One per selection, pointing into merged
+
+    MergedTree(std::vector<OESelection> s, OESelection m) : selections(std::move(s)), merged(std::move(m)) {
+        for (const auto& root : merged.Root().Children()) {
+            programs.push_back(SelectionProgram::Compile(*root));
+        }
+    }
+};
+}  // namespace
+
+/// PIMPL containing the shared merged tree and this instance's context
+struct SelectionSet::Impl {
+    std::shared_ptr<const MergedTree> tree;
+    std::unique_ptr<Context> ctx;  ///< Created on first evaluation, then rebound per molecule
+
+    explicit Impl(std::shared_ptr<const MergedTree> t) : tree(std::move(t)) {}
+};
+
+SelectionSet::SelectionSet(const std::vector<OESelection>& selections)
+    : pimpl_(std::make_unique<Impl>(
+          std::make_shared<const MergedTree>(selections, OESelection::Merge(selections)))) {}
+
+SelectionSet::SelectionSet(const SelectionSet& other)
+    : pimpl_(std::make_unique<Impl>(other.pimpl_->tree)) {}
+
+SelectionSet& SelectionSet::operator=(const SelectionSet& other) {
+    if (this != &other) {
+        pimpl_ = std::make_unique<Impl>(other.pimpl_->tree);
+    }
+    return *this;
+}
+
+SelectionSet::SelectionSet(SelectionSet&& other) noexcept = default;
+
+SelectionSet& SelectionSet::operator=(SelectionSet&& other) noexcept = default;
+
+SelectionSet::~SelectionSet() = default;
+
+size_t SelectionSet::Size() const {
+    return pimpl_->tree->selections.size();
+}
+
+const OESelection& SelectionSet::GetSelection(const size_t index) const {
+    const auto& selections = pimpl_->tree->selections;
+    if (index >= selections.size()) {
+        throw SelectionError("Selection index " + std::to_string(index) + " is out of range");
+    }
+    return selections[index];
+}
+
+const OESelection& SelectionSet::GetMergedSelection() const {
+    return pimpl_->tree->merged;
+}
+
+void SelectionSet::EvaluateMasks(OEChem::OEMolBase& mol, std::vector<Bitset>& masks) {
+    Impl& impl = *pimpl_;
+    if (impl.ctx) {
+        impl.ctx->Reset(mol);
+    } else {
+        impl.ctx = std::make_unique<Context>(mol, impl.tree->merged);
+        // Subresults shared between selections are cached for the rest of the pass
+        impl.ctx->SetShareStaticResults(true);
+    }
+
+    const auto& programs = impl.tree->programs;
+    const size_t size = mol.GetMaxAtomIdx();
+    masks.resize(programs.size());
+    for (size_t i = 0; i < programs.size(); ++i) {
+        if (masks[i].Size() == size) {
+            masks[i].ResetAll();
+        } else {
+            masks[i] = Bitset(size);
+        }
+        programs[i].Run(*impl.ctx, masks[i]);
+    }
+}
+
+std::vector<Bitset> SelectionSet::EvaluateMasks(OEChem::OEMolBase& mol) {
+    std::vector<Bitset> masks;
+    EvaluateMasks(mol, masks);
+    return masks;
+}
+
+std::vector<unsigned int> SelectionSet::Count(OEChem::OEMolBase& mol) {
+    std::vector<unsigned int> counts;
+    for (const Bitset& mask : EvaluateMasks(mol)) {
+        counts.push_back(static_cast<unsigned int>(mask.Count()));
+    }
+    return counts;
+}
+
+std::vector<std::vector<unsigned int>> SelectionSet::Select(OEChem::OEMolBase& mol) {
+    std::vector<std::vector<unsigned int>> indices;
+    for (const Bitset& mask : EvaluateMasks(mol)) {
+        indices.push_back(mask.ToIndices());
+    }
+    return indices;
+}
+
+Context& SelectionSet::GetContext() {
+    if (!pimpl_->ctx) {
+        throw SelectionError("Selection set has not been evaluated");
+    }
+    return *pimpl_->ctx;
+}
+
+}  // namespace OESel
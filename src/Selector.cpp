@@ -5,20 +5,131 @@
 
 #include "oeselect/Selector.h"
 #include "oeselect/Context.h"
+#include "fnv1a.h"
 
 #include <oechem.h>
 
+#include <mutex>
+#include <vector>
+
 namespace OESel {
 
-/// PIMPL containing evaluation context and selection
+namespace {
+/// Hash of the atom and bond counts and of every coordinate; @p xyz is scratch space reused between calls
+std::uint64_t Fingerprint(const OEChem::OEMolBase& mol, std::vector<float>& xyz) {
+    xyz.resize(static_cast<size_t>(mol.GetMaxAtomIdx()) * 3);
+    mol.GetCoords(xyz.data());
+    Fnv1a hash;
+    hash.Add(mol.GetMaxAtomIdx());
+    hash.Add(mol.NumAtoms());
+    hash.Add(mol.NumBonds());
+    hash.Bytes(xyz.data(), xyz.size() * sizeof(float));
+    return hash.Value();
+}
+
+/// Bulk mask together with the molecule state it was computed for
+struct Snapshot {
+    Bitset mask;
+    unsigned int num_atoms;
+    unsigned int num_bonds;
+    bool fingerprinted = false;  ///< Only taken once the selector has copies to compare with
+    std::uint64_t fingerprint = 0;
+
+    explicit Snapshot(const OEChem::OEMolBase& mol)
+        : mask(mol.GetMaxAtomIdx()), num_atoms(mol.NumAtoms()), num_bonds(mol.NumBonds()) {}
+
+    /// Whether the molecule still has the atoms and bonds the mask was computed for
+    [[nodiscard]] bool SameTopology(const OEChem::OEMolBase& mol) const {
+        return mask.Size() == mol.GetMaxAtomIdx() && num_atoms == mol.NumAtoms() && num_bonds == mol.NumBonds();
+    }
+};
+
+/// Latest mask published by any member of a family of copies
+struct SharedSnapshot {
+    std::mutex mutex;
+    std::shared_ptr<const Snapshot> snapshot;
+};
+}  // namespace
+
+/// PIMPL containing evaluation context, selection, and bulk result mask
 struct OESelect::Impl {
-    std::unique_ptr<Context> ctx;
     OESelection sele;
+    std::unique_ptr<Context> ctx;              ///< References sele, so declared after it
+    std::shared_ptr<SharedSnapshot> shared;    ///< Common to this selector and its copies
+    std::shared_ptr<const Snapshot> snapshot;  ///< This selector's mask
+    std::shared_ptr<const Snapshot> computed;  ///< Last mask this selector's context computed
+    unsigned int last_idx = 0;                 ///< Atom of the previous operator() call; a lower one starts a pass
+    std::vector<float> xyz;                    ///< Scratch coordinates for Fingerprint()
 
     Impl(OEChem::OEMolBase& mol, const OESelection& s)
-        : ctx(std::make_unique<Context>(mol, s)), sele(s) {}
+        : sele(s), ctx(std::make_unique<Context>(mol, sele)), shared(std::make_shared<SharedSnapshot>()) {}
+
+    /// Join another selector's family and copy its settings; the mask is adopted on first use
+    void ShareWith(const Impl& other) {
+        ctx->SetUnitCell(other.ctx->GetUnitCell());
+        ctx->SetNumThreads(other.ctx->GetNumThreads());
+        ctx->SetVerletSkin(other.ctx->GetVerletSkin());
+        for (const auto& [name, result] : other.ctx->GetNamedSets()) {
+            ctx->SetNamedSet(name, result);
+        }
+        shared = other.shared;
+    }
+
+    /// Leave the family after a change to the evaluation settings
+    void Detach() {
+        shared = std::make_shared<SharedSnapshot>();
+        snapshot.reset();
+    }
+
+    /// Bring the mask up to date with the molecule and the rest of the family
+    const Bitset& Refresh();
 };
 
+const Bitset& OESelect::Impl::Refresh() {
+    std::shared_ptr<const Snapshot> published;
+    {
+        const std::lock_guard<std::mutex> lock(shared->mutex);
+        published = shared->snapshot;
+    }
+    // A selector without copies keeps the mask it computed until a departed copy publishes a newer one
+    const bool has_copies = shared.use_count() > 1;
+    const bool newer = published && published != snapshot;
+    if (snapshot && !has_copies && !newer) {
+        return snapshot->mask;
+    }
+
+    // Otherwise a mask is shared only with the molecule state it was computed for
+    OEChem::OEMolBase& mol = ctx->Mol();
+    const bool fingerprinted = has_copies || newer;
+    const std::uint64_t current = fingerprinted ? Fingerprint(mol, xyz) : 0;
+    if (fingerprinted && published && published->fingerprinted && published->fingerprint == current) {
+        snapshot = std::move(published);
+        return snapshot->mask;
+    }
+
+    // The context may hold results for an earlier molecule state: refit them to the coordinates, or start over
+    if (fingerprinted && computed) {
+        if (computed->SameTopology(mol)) {
+            ctx->UpdateCoordinates(xyz.data());
+        } else {
+            ctx->Reset(mol);
+        }
+    }
+
+    // Evaluate on this selector's own context and publish the result to the family
+    auto fresh = std::make_shared<Snapshot>(mol);
+    ctx->EvaluateSelection(fresh->mask);
+    fresh->fingerprinted = fingerprinted;
+    fresh->fingerprint = current;
+    snapshot = fresh;
+    computed = fresh;
+    {
+        const std::lock_guard<std::mutex> lock(shared->mutex);
+        shared->snapshot = std::move(fresh);
+    }
+    return snapshot->mask;
+}
+
 OESelect::OESelect(OEChem::OEMolBase& mol, const OESelection& sele)
     : pimpl_(std::make_unique<Impl>(mol, sele)) {}
 
@@ -26,11 +137,14 @@ OESelect::OESelect(OEChem::OEMolBase& mol, const std::string& sele)
     : OESelect(mol, OESelection::Parse(sele)) {}
 
 OESelect::OESelect(const OESelect& other)
-    : pimpl_(std::make_unique<Impl>(other.pimpl_->ctx->Mol(), other.pimpl_->sele)) {}
+    : pimpl_(std::make_unique<Impl>(other.pimpl_->ctx->Mol(), other.pimpl_->sele)) {
+    pimpl_->ShareWith(*other.pimpl_);
+}
 
 OESelect& OESelect::operator=(const OESelect& other) {
     if (this != &other) {
         pimpl_ = std::make_unique<Impl>(other.pimpl_->ctx->Mol(), other.pimpl_->sele);
+        pimpl_->ShareWith(*other.pimpl_);
     }
     return *this;
 }
@@ -38,7 +152,17 @@ OESelect& OESelect::operator=(const OESelect& other) {
 OESelect::~OESelect() = default;
 
 bool OESelect::operator()(const OEChem::OEAtomBase& atom) const {
-    return pimpl_->sele.Root().Evaluate(*pimpl_->ctx, atom);
+    Impl& impl = *pimpl_;
+    const unsigned int idx = atom.GetIdx();
+    // Check the mask once per pass over the atoms rather than once per atom
+    const bool new_pass = !impl.snapshot || idx <= impl.last_idx;
+    impl.last_idx = idx;
+    const Bitset& mask = new_pass ? impl.Refresh() : impl.snapshot->mask;
+    if (idx >= mask.Size()) {
+        // Atom added after the mask was computed
+        return impl.sele.Root().Evaluate(*impl.ctx, atom);
+    }
+    return mask.Test(idx);
 }
 
 OESystem::OEUnaryFunction<OEChem::OEAtomBase, bool>* OESelect::CreateCopy() const {
@@ -53,4 +177,57 @@ const OEChem::OEMolBase& OESelect::GetMol() const {
     return pimpl_->ctx->Mol();
 }
 
+const Bitset& OESelect::GetMask() const {
+    return pimpl_->Refresh();
+}
+
+OESelectionResult OESelect::GetResult() const {
+    return OESelectionResult(GetMask());
+}
+
+void OESelect::SetNamedSet(const std::string& name, const OESelectionResult& result) {
+    pimpl_->ctx->SetNamedSet(name, result);
+    pimpl_->Detach();
+}
+
+void OESelect::SetProfiling(const bool enabled) {
+    pimpl_->ctx->SetProfiling(enabled);
+    pimpl_->Detach();
+}
+
+EvaluationProfile OESelect::GetProfile() const {
+    return pimpl_->ctx->GetProfile();
+}
+
+void OESelect::SetUnitCell(const UnitCell& cell) {
+    if (cell == pimpl_->ctx->GetUnitCell()) return;
+    pimpl_->ctx->SetUnitCell(cell);
+    pimpl_->Detach();
+}
+
+const UnitCell& OESelect::GetUnitCell() const {
+    return pimpl_->ctx->GetUnitCell();
+}
+
+void OESelect::SetNumThreads(const unsigned int num_threads) {
+    pimpl_->ctx->SetNumThreads(num_threads);
+}
+
+unsigned int OESelect::GetNumThreads() const {
+    return pimpl_->ctx->GetNumThreads();
+}
+
+void OESelect::SetVerletSkin(const float skin) {
+    pimpl_->ctx->SetVerletSkin(skin);
+}
+
+float OESelect::GetVerletSkin() const {
+    return pimpl_->ctx->GetVerletSkin();
+}
+
+void OESelect::SetFrame(const float* xyz) {
+    pimpl_->ctx->UpdateCoordinates(xyz);
+    pimpl_->Detach();
+}
+
 }  // namespace OESel
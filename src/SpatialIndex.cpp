@@ -1,16 +1,38 @@
 /**
  * @file SpatialIndex.cpp
- * @brief K-d tree spatial index implementation using nanoflann.
+ * @brief Spatial index implementation with k-d tree and cell-list backends.
  *
- * Provides efficient O(log n) radius queries for distance-based predicates.
+ * The k-d tree backend uses nanoflann and provides O(log n) radius queries.
+ * The cell-list backend bins atoms into a uniform grid sized to the query
+ * cutoff, which builds in O(n) and suits short cutoffs on dense systems.
+ *
+ * With a periodic unit cell, coordinates are wrapped into the box. The grid
+ * then tiles the box exactly and its neighbour scans wrap across the faces,
+ * shifting the far side by one box length; the k-d tree is queried at each
+ * periodic image of the query point that reaches into the box.
+ *
+ * Given a worker pool, grid binning and MarkWithinRadius() are split over
+ * the workers. Batch marking then runs target-major: each worker owns whole
+ * target cells and scans the reference atoms around them, so no two
+ * workers write the same hit flag.
  */
 
 #include "oeselect/SpatialIndex.h"
+#include "oeselect/Bitset.h"
+#include "oeselect/UnitCell.h"
+#include "range_kernels.h"
+#include "thread_pool.h"
 
 #include <oechem.h>
 #include <nanoflann.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
 #include <memory>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 namespace OESel {
@@ -25,14 +47,18 @@ struct MoleculePointCloud {
     std::vector<float> coords;           ///< Flat array: x0,y0,z0,x1,y1,z1,...
     std::vector<unsigned int> atom_indices;  ///< Original atom indices
 
-    explicit MoleculePointCloud(const OEChem::OEMolBase& mol) {
-        const size_t n = mol.NumAtoms();
+    MoleculePointCloud() = default;
+
+    /// Points of every atom, or only of the atoms in @p subset when given
+    explicit MoleculePointCloud(const OEChem::OEMolBase& mol, const Bitset* subset = nullptr) {
+        const size_t n = subset ? subset->Count() : mol.NumAtoms();
         coords.reserve(n * 3);
         atom_indices.reserve(n);
 
         for (OESystem::OEIter atom = mol.GetAtoms(); atom; ++atom) {
             float xyz[3];
             const OEChem::OEAtomBase& a = *atom;
+            if (subset && (a.GetIdx() >= subset->Size() || !subset->Test(a.GetIdx()))) continue;
             mol.GetCoords(&a, xyz);
             coords.push_back(xyz[0]);
             coords.push_back(xyz[1]);
@@ -63,28 +89,898 @@ using KDTree = nanoflann::KDTreeSingleIndexAdaptor<
     3               // 3D space
 >;
 
-/// PIMPL containing point cloud and k-d tree
+namespace {
+/// Cell size for a cell-list index built without a cutoff hint
+constexpr float kDefaultCellSize = 5.0f;
+
+/// Points per parallel block when binning
+constexpr size_t kBinBlock = 4096;
+
+/// Target cells per parallel block when marking
+constexpr size_t kMarkBlock = 64;
+
+/// Run body(begin, end) over blocks of [0, count) on @p pool, or once inline when null
+template<typename Body>
+void for_blocks(WorkStealingPool* pool, const size_t count, const size_t block, const Body& body) {
+    if (!pool || count <= block) {
+        body(size_t{0}, count);
+        return;
+    }
+    pool->ParallelFor((count + block - 1) / block, [&](const size_t b, unsigned int) {
+        body(b * block, std::min(count, (b + 1) * block));
+    });
+}
+
+/// Wrap a coordinate into [0, length) for a periodic axis
+float wrap_coordinate(const float value, const float length) {
+    const float wrapped = value - length * std::floor(value / length);
+    // Rounding can land a value just below zero exactly on the upper face; NaN stays NaN
+    return wrapped >= length ? 0.0f : wrapped;
+}
+
+/// Wrap every point of the cloud into a periodic cell (no-op for an open cell)
+void wrap_cloud(MoleculePointCloud& cloud, const UnitCell& cell) {
+    if (!cell.IsPeriodic()) return;
+    for (size_t i = 0; i < cloud.coords.size(); ++i) {
+        cloud.coords[i] = wrap_coordinate(cloud.coords[i], cell.Length(static_cast<int>(i % 3)));
+    }
+}
+
+/// Coarsening steps before a grid gives up and uses one cell; each step roughly halves the cell count
+constexpr int kMaxCoarsenSteps = 128;
+
+/**
+ * Cells of @p size needed to cover @p extent along one axis, saturating at
+ * @p limit so that non-finite or huge ratios never reach the size_t cast.
+ * A periodic axis is tiled by whole cells; an open axis needs one more for
+ * the point on its upper edge.
+ */
+size_t axis_cells(const float extent, const float size, const bool periodic, const size_t limit) {
+    const float cells = extent / size;
+    if (!(cells < static_cast<float>(limit))) return limit;
+    return periodic ? std::max<size_t>(1, static_cast<size_t>(cells)) : static_cast<size_t>(cells) + 1;
+}
+
+/**
+ * Choose the cell size, starting from @p size, and the grid dimensions over
+ * @p extent so that the grid has at most @p max_cells cells. Per-axis counts
+ * are clamped before they are multiplied, and the search is bounded; a grid
+ * that cannot be coarsened enough collapses to a single cell.
+ */
+void fit_grid(const float* extent, const bool periodic, const size_t max_cells, float& size, size_t* dims) {
+    // No axis may need more than max_cells cells, so start at least that coarse
+    const float widest = std::max({extent[0], extent[1], extent[2]});
+    if (std::isfinite(widest) && !(size >= widest / static_cast<float>(max_cells))) {
+        size = widest / static_cast<float>(max_cells);
+    }
+    for (int step = 0; step < kMaxCoarsenSteps; ++step) {
+        size_t total = 1;
+        for (int d = 0; d < 3; ++d) {
+            dims[d] = axis_cells(extent[d], size, periodic, max_cells + 1);
+            // Saturate instead of overflowing; any total above max_cells is rejected alike
+            total = dims[d] > max_cells / total ? max_cells + 1 : total * dims[d];
+        }
+        if (total <= max_cells && size > 0.0f) return;
+        size *= 1.26f;
+    }
+    std::fill(dims, dims + 3, size_t{1});
+    size = widest > 0.0f ? widest : 1.0f;
+}
+
+/// Run of neighbouring cells along one axis whose points are offset by @p shift
+struct CellSpan {
+    size_t lo;
+    size_t hi;
+    float shift;
+};
+
+/**
+ * @brief Uniform grid over indexed points with coordinates sorted by cell.
+ *
+ * A point within radius r of a query lies at most Reach(r, d) cells away
+ * along axis d. Non-finite coordinates are left out; they can never be
+ * within range of anything.
+ *
+ * For a periodic cell the grid spans the box exactly, with every cell at
+ * least the requested size along each axis, and expects points already
+ * wrapped into the box.
+ */
+struct CellGrid {
+    float origin[3] = {0.0f, 0.0f, 0.0f};
+    float cell_size[3] = {1.0f, 1.0f, 1.0f};
+    float min_cell_size = 1.0f;            ///< Requested cell size before coarsening
+    float period[3] = {0.0f, 0.0f, 0.0f};  ///< Box lengths, all zero for an open system
+    size_t dims[3] = {1, 1, 1};
+    std::vector<unsigned int> cell_start;  ///< Sorted-array offset of each cell (num cells + 1)
+    std::vector<float> xs, ys, zs;         ///< Point coordinates in cell order
+    std::vector<unsigned int> atoms;       ///< Atom indices in cell order
+
+    CellGrid(const MoleculePointCloud& cloud, const float min_size, const UnitCell& cell,
+             WorkStealingPool* pool = nullptr)
+        : min_cell_size(min_size) {
+        if (cell.IsPeriodic()) {
+            for (int d = 0; d < 3; ++d) {
+                period[d] = cell.Length(d);
+            }
+        }
+        Bin(cloud, false, pool);
+    }
+
+    /**
+     * Re-sort points after their coordinates changed. The grid geometry is
+     * kept while every point still falls inside it, so a trajectory frame
+     * costs one counting sort into storage that is already allocated.
+     */
+    void Rebin(const MoleculePointCloud& cloud, WorkStealingPool* pool) { Bin(cloud, true, pool); }
+
+    [[nodiscard]] size_t NumCells() const { return cell_start.size() - 1; }
+
+    [[nodiscard]] bool Periodic() const { return period[0] > 0.0f; }
+
+    /// Number of neighbouring cells along axis @p d that can hold points within @p radius
+    [[nodiscard]] size_t Reach(const float radius, const int d) const {
+        return std::max<size_t>(1, static_cast<size_t>(std::ceil(radius / cell_size[d])));
+    }
+
+    /**
+     * Cells within @p reach of cell @p c along axis @p d. An open axis gives
+     * one clamped span. A periodic axis is split at the box faces, and the
+     * points of each wrapped span are offset by whole box lengths; when the
+     * reach exceeds the box, a cell recurs once per image it contributes.
+     */
+    void Spans(const int d, const size_t c, const size_t reach, std::vector<CellSpan>& out) const {
+        out.clear();
+        const size_t n = dims[d];
+        if (!Periodic()) {
+            out.push_back({c > reach ? c - reach : 0, std::min(c + reach, n - 1), 0.0f});
+            return;
+        }
+        const auto count = static_cast<std::ptrdiff_t>(n);
+        const std::ptrdiff_t first = static_cast<std::ptrdiff_t>(c) - static_cast<std::ptrdiff_t>(reach);
+        const std::ptrdiff_t last = static_cast<std::ptrdiff_t>(c + reach);
+        // Floor division, so cells before the lower face belong to image -1
+        std::ptrdiff_t image = first >= 0 ? first / count : -((-first + count - 1) / count);
+        for (; image * count <= last; ++image) {
+            const std::ptrdiff_t base = image * count;
+            const std::ptrdiff_t lo = std::max(first, base);
+            const std::ptrdiff_t hi = std::min(last, base + count - 1);
+            out.push_back({static_cast<size_t>(lo - base), static_cast<size_t>(hi - base),
+                           static_cast<float>(image) * period[d]});
+        }
+    }
+
+    /// Cell coordinate along axis @p d, clamped to the grid
+    [[nodiscard]] size_t Axis(const float value, const int d) const {
+        const float t = (value - origin[d]) / cell_size[d];
+        if (!(t > 0.0f)) return 0;
+        if (t >= static_cast<float>(dims[d])) return dims[d] - 1;
+        return static_cast<size_t>(t);
+    }
+
+    [[nodiscard]] size_t CellOf(const float x, const float y, const float z) const {
+        return (Axis(z, 2) * dims[1] + Axis(y, 1)) * dims[0] + Axis(x, 0);
+    }
+
+private:
+    std::vector<unsigned int> finite_;       ///< Cloud positions with finite coordinates
+    std::vector<unsigned int> point_cells_;  ///< Cell of each finite point, then its sorted slot
+    std::vector<unsigned int> fill_;         ///< Next free sorted slot per cell
+
+    /// Whether the box [lo, hi] lies inside the current grid
+    [[nodiscard]] bool Covers(const float* lo, const float* hi) const {
+        for (int d = 0; d < 3; ++d) {
+            if (!(lo[d] >= origin[d]) || !(hi[d] < origin[d] + static_cast<float>(dims[d]) * cell_size[d])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void Bin(const MoleculePointCloud& cloud, const bool keep_geometry, WorkStealingPool* pool) {
+        const size_t n = cloud.atom_indices.size();
+        float lo[3] = {INFINITY, INFINITY, INFINITY};
+        float hi[3] = {-INFINITY, -INFINITY, -INFINITY};
+        finite_.clear();
+        for (size_t i = 0; i < n; ++i) {
+            const float* p = &cloud.coords[i * 3];
+            if (!std::isfinite(p[0]) || !std::isfinite(p[1]) || !std::isfinite(p[2])) continue;
+            finite_.push_back(static_cast<unsigned int>(i));
+            for (int d = 0; d < 3; ++d) {
+                lo[d] = std::min(lo[d], p[d]);
+                hi[d] = std::max(hi[d], p[d]);
+            }
+        }
+        if (finite_.empty()) {
+            std::fill(dims, dims + 3, size_t{1});
+            cell_start.assign(2, 0);
+            xs.clear();
+            ys.clear();
+            zs.clear();
+            atoms.clear();
+            return;
+        }
+
+        // Coarsen sparse grids so the cell table stays proportional to the atom count
+        const size_t max_cells = std::max<size_t>(64, finite_.size() * 4);
+        if (Periodic()) {
+            // The geometry depends only on the box; tile it with whole cells
+            float size = min_cell_size;
+            fit_grid(period, true, max_cells, size, dims);
+            for (int d = 0; d < 3; ++d) {
+                cell_size[d] = period[d] / static_cast<float>(dims[d]);
+                origin[d] = 0.0f;
+            }
+        } else if (!keep_geometry || !Covers(lo, hi)) {
+            const float extent[3] = {hi[0] - lo[0], hi[1] - lo[1], hi[2] - lo[2]};
+            float size = min_cell_size;
+            fit_grid(extent, false, max_cells, size, dims);
+            std::fill(cell_size, cell_size + 3, size);
+            std::copy(lo, lo + 3, origin);
+        }
+
+        const size_t num_cells = dims[0] * dims[1] * dims[2];
+        point_cells_.resize(finite_.size());
+        for_blocks(pool, finite_.size(), kBinBlock, [&](const size_t begin, const size_t end) {
+            for (size_t k = begin; k < end; ++k) {
+                const float* p = &cloud.coords[finite_[k] * 3];
+                point_cells_[k] = static_cast<unsigned int>(CellOf(p[0], p[1], p[2]));
+            }
+        });
+
+        // Counting sort; the slot pass stays serial so points keep their order within a cell
+        cell_start.assign(num_cells + 1, 0);
+        for (const unsigned int c : point_cells_) {
+            ++cell_start[c + 1];
+        }
+        for (size_t c = 0; c < num_cells; ++c) {
+            cell_start[c + 1] += cell_start[c];
+        }
+        fill_.assign(cell_start.begin(), cell_start.end() - 1);
+        for (unsigned int& c : point_cells_) {
+            c = fill_[c]++;
+        }
+
+        xs.resize(finite_.size());
+        ys.resize(finite_.size());
+        zs.resize(finite_.size());
+        atoms.resize(finite_.size());
+        for_blocks(pool, finite_.size(), kBinBlock, [&](const size_t begin, const size_t end) {
+            for (size_t k = begin; k < end; ++k) {
+                const unsigned int slot = point_cells_[k];
+                const float* p = &cloud.coords[finite_[k] * 3];
+                xs[slot] = p[0];
+                ys[slot] = p[1];
+                zs[slot] = p[2];
+                atoms[slot] = cloud.atom_indices[finite_[k]];
+            }
+        });
+    }
+};
+
+/// Query points in cell order, with one run per occupied cell
+struct QueryRuns {
+    struct Run {
+        size_t cell;
+        size_t begin;
+        size_t end;
+    };
+    std::vector<float> x, y, z;
+    std::vector<unsigned int> atoms;  ///< Atom index of each point
+    std::vector<Run> runs;
+};
+
+/// Indexed reference atoms, already in cell order
+QueryRuns grid_queries(const CellGrid& grid, const Bitset& refs) {
+    QueryRuns queries;
+    for (size_t c = 0; c < grid.NumCells(); ++c) {
+        const size_t begin = queries.x.size();
+        for (unsigned int p = grid.cell_start[c]; p < grid.cell_start[c + 1]; ++p) {
+            if (refs.Test(grid.atoms[p])) {
+                queries.x.push_back(grid.xs[p]);
+                queries.y.push_back(grid.ys[p]);
+                queries.z.push_back(grid.zs[p]);
+                queries.atoms.push_back(grid.atoms[p]);
+            }
+        }
+        if (queries.x.size() > begin) {
+            queries.runs.push_back({c, begin, queries.x.size()});
+        }
+    }
+    return queries;
+}
+
+/**
+ * Atoms outside the grid, binned into its cells. Points are wrapped into a
+ * periodic box; on an open grid, points farther than @p radius beyond its
+ * bounds along any axis can reach nothing and are dropped, and the rest are
+ * clamped to the edge cells, which are no farther from any grid point.
+ */
+QueryRuns external_queries(const CellGrid& grid, const float* xyz, const Bitset& atoms, const float radius) {
+    std::vector<unsigned int> cells;  // Cell of each kept point
+    std::vector<unsigned int> kept;   // Atom index of each kept point
+    std::vector<float> points;
+    atoms.ForEachSet([&](const size_t idx) {
+        float p[3] = {xyz[idx * 3], xyz[idx * 3 + 1], xyz[idx * 3 + 2]};
+        for (int d = 0; d < 3; ++d) {
+            if (!std::isfinite(p[d])) return;
+            if (grid.Periodic()) {
+                p[d] = wrap_coordinate(p[d], grid.period[d]);
+            } else if (p[d] <= grid.origin[d] - radius ||
+                       p[d] >= grid.origin[d] + static_cast<float>(grid.dims[d]) * grid.cell_size[d] + radius) {
+                return;
+            }
+        }
+        cells.push_back(static_cast<unsigned int>(grid.CellOf(p[0], p[1], p[2])));
+        kept.push_back(static_cast<unsigned int>(idx));
+        points.insert(points.end(), p, p + 3);
+    });
+
+    // Counting sort by cell, keeping atom order within each cell
+    std::vector<unsigned int> start(grid.NumCells() + 1, 0);
+    for (const unsigned int c : cells) {
+        ++start[c + 1];
+    }
+    for (size_t c = 0; c < grid.NumCells(); ++c) {
+        start[c + 1] += start[c];
+    }
+    QueryRuns queries;
+    queries.x.resize(kept.size());
+    queries.y.resize(kept.size());
+    queries.z.resize(kept.size());
+    queries.atoms.resize(kept.size());
+    std::vector<unsigned int> fill(start.begin(), start.end() - 1);
+    for (size_t i = 0; i < kept.size(); ++i) {
+        const unsigned int slot = fill[cells[i]]++;
+        queries.x[slot] = points[i * 3];
+        queries.y[slot] = points[i * 3 + 1];
+        queries.z[slot] = points[i * 3 + 2];
+        queries.atoms[slot] = kept[i];
+    }
+    for (size_t c = 0; c < grid.NumCells(); ++c) {
+        if (start[c + 1] > start[c]) {
+            queries.runs.push_back({c, start[c], start[c + 1]});
+        }
+    }
+    return queries;
+}
+
+/**
+ * Visit every (query run, neighbouring cell) pair within reach with the
+ * run's coordinates moved by minus the cell's periodic image shift, since
+ * comparing image points p + shift with q equals comparing p with q - shift.
+ * @p visit returns true once the run needs no more cells.
+ */
+template <typename Visit>
+void for_each_run_neighbor(const CellGrid& grid, const QueryRuns& queries, const float radius, const Visit& visit) {
+    const size_t reach[3] = {grid.Reach(radius, 0), grid.Reach(radius, 1), grid.Reach(radius, 2)};
+    const size_t nx = grid.dims[0];
+    const size_t ny = grid.dims[1];
+    std::vector<CellSpan> x_spans, y_spans, z_spans;
+    std::vector<float> sx, sy, sz;
+    for (const QueryRuns::Run& run : queries.runs) {
+        const size_t count = run.end - run.begin;
+        grid.Spans(0, run.cell % nx, reach[0], x_spans);
+        grid.Spans(1, run.cell / nx % ny, reach[1], y_spans);
+        grid.Spans(2, run.cell / (nx * ny), reach[2], z_spans);
+        bool done = false;
+        for (const CellSpan& zs : z_spans) {
+            for (const CellSpan& ys : y_spans) {
+                for (const CellSpan& xs : x_spans) {
+                    if (done) break;
+                    const float* qx = queries.x.data() + run.begin;
+                    const float* qy = queries.y.data() + run.begin;
+                    const float* qz = queries.z.data() + run.begin;
+                    if (xs.shift != 0.0f || ys.shift != 0.0f || zs.shift != 0.0f) {
+                        sx.resize(count);
+                        sy.resize(count);
+                        sz.resize(count);
+                        for (size_t k = 0; k < count; ++k) {
+                            sx[k] = qx[k] - xs.shift;
+                            sy[k] = qy[k] - ys.shift;
+                            sz[k] = qz[k] - zs.shift;
+                        }
+                        qx = sx.data();
+                        qy = sy.data();
+                        qz = sz.data();
+                    }
+                    for (size_t z = zs.lo; z <= zs.hi && !done; ++z) {
+                        for (size_t y = ys.lo; y <= ys.hi && !done; ++y) {
+                            for (size_t x = xs.lo; x <= xs.hi && !done; ++x) {
+                                done = visit(run, (z * ny + y) * nx + x, qx, qy, qz);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+/// Flag grid points within radius of any query point
+void mark_grid_near(const CellGrid& grid, const QueryRuns& queries, const float radius,
+                    std::vector<std::uint8_t>& hits) {
+    const float radius_sq = radius * radius;
+    std::vector<std::uint8_t> covered(grid.NumCells(), 0);  // Every point in the cell already hit
+    for_each_run_neighbor(grid, queries, radius,
+                          [&](const QueryRuns::Run& run, const size_t cell, const float* qx, const float* qy,
+                              const float* qz) {
+        if (covered[cell]) return false;
+        const unsigned int begin = grid.cell_start[cell];
+        const unsigned int end = grid.cell_start[cell + 1];
+        kernels::mark_within(grid.xs.data() + begin, grid.ys.data() + begin, grid.zs.data() + begin, end - begin,
+                             qx, qy, qz, run.end - run.begin, radius_sq, hits.data() + begin);
+        covered[cell] = std::all_of(hits.begin() + begin, hits.begin() + end,
+                                    [](const std::uint8_t h) { return h != 0; });
+        return false;
+    });
+}
+
+/// Flag query points within radius of any grid point
+void mark_queries_near(const CellGrid& grid, const QueryRuns& queries, const float radius,
+                       std::vector<std::uint8_t>& hits) {
+    const float radius_sq = radius * radius;
+    for_each_run_neighbor(grid, queries, radius,
+                          [&](const QueryRuns::Run& run, const size_t cell, const float* qx, const float* qy,
+                              const float* qz) {
+        const unsigned int begin = grid.cell_start[cell];
+        const unsigned int end = grid.cell_start[cell + 1];
+        if (begin == end) return false;
+        std::uint8_t* run_hits = hits.data() + run.begin;
+        kernels::mark_within(qx, qy, qz, run.end - run.begin, grid.xs.data() + begin, grid.ys.data() + begin,
+                             grid.zs.data() + begin, end - begin, radius_sq, run_hits);
+        // The run is finished once each of its points has a neighbour
+        return std::all_of(run_hits, run_hits + (run.end - run.begin), [](const std::uint8_t h) { return h != 0; });
+    });
+}
+
+/// Batch radius marking over a cell grid (see SpatialIndex::MarkWithinRadius)
+void mark_within_radius(const CellGrid& grid, const Bitset& refs, const float radius, Bitset& out) {
+    std::vector<std::uint8_t> hits(grid.atoms.size(), 0);
+    mark_grid_near(grid, grid_queries(grid, refs), radius, hits);
+    for (size_t p = 0; p < hits.size(); ++p) {
+        if (hits[p] && grid.atoms[p] < out.Size()) {
+            out.Set(grid.atoms[p]);
+        }
+    }
+}
+
+/**
+ * Batch radius marking split over a worker pool, with the same result as
+ * mark_within_radius(). Cells near a reference are found first; workers
+ * then take blocks of them and test each target cell against the
+ * references in the cells within reach, in the mirror image of the serial
+ * reference-major loop.
+ */
+void mark_within_radius_parallel(const CellGrid& grid, const Bitset& refs, const float radius, Bitset& out,
+                                 WorkStealingPool& pool) {
+    const float radius_sq = radius * radius;
+    const size_t reach[3] = {grid.Reach(radius, 0), grid.Reach(radius, 1), grid.Reach(radius, 2)};
+    const size_t nx = grid.dims[0];
+    const size_t ny = grid.dims[1];
+
+    // Reference coordinates in cell order: cell c holds ref_start[c] .. ref_start[c + 1]
+    std::vector<float> rx, ry, rz;
+    std::vector<unsigned int> ref_start(grid.NumCells() + 1, 0);
+    for (size_t c = 0; c < grid.NumCells(); ++c) {
+        for (unsigned int p = grid.cell_start[c]; p < grid.cell_start[c + 1]; ++p) {
+            if (refs.Test(grid.atoms[p])) {
+                rx.push_back(grid.xs[p]);
+                ry.push_back(grid.ys[p]);
+                rz.push_back(grid.zs[p]);
+            }
+        }
+        ref_start[c + 1] = static_cast<unsigned int>(rx.size());
+    }
+    if (rx.empty()) return;
+
+    // Occupied cells within reach of any reference cell
+    std::vector<std::uint8_t> near(grid.NumCells(), 0);
+    std::vector<CellSpan> x_spans, y_spans, z_spans;
+    for (size_t c = 0; c < grid.NumCells(); ++c) {
+        if (ref_start[c] == ref_start[c + 1]) continue;
+        grid.Spans(0, c % nx, reach[0], x_spans);
+        grid.Spans(1, c / nx % ny, reach[1], y_spans);
+        grid.Spans(2, c / (nx * ny), reach[2], z_spans);
+        for (const CellSpan& zs : z_spans) {
+            for (const CellSpan& ys : y_spans) {
+                for (size_t z = zs.lo; z <= zs.hi; ++z) {
+                    for (size_t y = ys.lo; y <= ys.hi; ++y) {
+                        for (const CellSpan& xs : x_spans) {
+                            std::fill(near.begin() + static_cast<std::ptrdiff_t>((z * ny + y) * nx + xs.lo),
+                                      near.begin() + static_cast<std::ptrdiff_t>((z * ny + y) * nx + xs.hi + 1), 1);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    std::vector<unsigned int> targets;
+    for (size_t c = 0; c < grid.NumCells(); ++c) {
+        if (near[c] && grid.cell_start[c] < grid.cell_start[c + 1]) {
+            targets.push_back(static_cast<unsigned int>(c));
+        }
+    }
+
+    // Each worker reuses its own span and shifted-reference scratch
+    struct Scratch {
+        std::vector<CellSpan> x_spans, y_spans, z_spans;
+        std::vector<float> sx, sy, sz;
+    };
+    std::vector<Scratch> scratch(pool.NumWorkers());
+    std::vector<std::uint8_t> hits(grid.atoms.size(), 0);
+    const size_t num_blocks = (targets.size() + kMarkBlock - 1) / kMarkBlock;
+    pool.ParallelFor(num_blocks, [&](const size_t block, const unsigned int worker) {
+        Scratch& local = scratch[worker];
+        const size_t last = std::min(targets.size(), (block + 1) * kMarkBlock);
+        for (size_t t = block * kMarkBlock; t < last; ++t) {
+            const size_t target = targets[t];
+            const unsigned int begin = grid.cell_start[target];
+            const unsigned int end = grid.cell_start[target + 1];
+            std::uint8_t* target_hits = hits.data() + begin;
+            grid.Spans(0, target % nx, reach[0], local.x_spans);
+            grid.Spans(1, target / nx % ny, reach[1], local.y_spans);
+            grid.Spans(2, target / (nx * ny), reach[2], local.z_spans);
+            bool covered = false;
+            for (const CellSpan& zs : local.z_spans) {
+                for (const CellSpan& ys : local.y_spans) {
+                    for (const CellSpan& xs : local.x_spans) {
+                        for (size_t z = zs.lo; z <= zs.hi && !covered; ++z) {
+                            for (size_t y = ys.lo; y <= ys.hi && !covered; ++y) {
+                                for (size_t x = xs.lo; x <= xs.hi && !covered; ++x) {
+                                    const size_t cell = (z * ny + y) * nx + x;
+                                    const unsigned int ref_begin = ref_start[cell];
+                                    const size_t count = ref_start[cell + 1] - ref_begin;
+                                    if (count == 0) continue;
+                                    const float* qx = rx.data() + ref_begin;
+                                    const float* qy = ry.data() + ref_begin;
+                                    const float* qz = rz.data() + ref_begin;
+                                    if (xs.shift != 0.0f || ys.shift != 0.0f || zs.shift != 0.0f) {
+                                        // Reference images in this span sit at q + shift
+                                        local.sx.resize(count);
+                                        local.sy.resize(count);
+                                        local.sz.resize(count);
+                                        for (size_t k = 0; k < count; ++k) {
+                                            local.sx[k] = qx[k] + xs.shift;
+                                            local.sy[k] = qy[k] + ys.shift;
+                                            local.sz[k] = qz[k] + zs.shift;
+                                        }
+                                        qx = local.sx.data();
+                                        qy = local.sy.data();
+                                        qz = local.sz.data();
+                                    }
+                                    kernels::mark_within(grid.xs.data() + begin, grid.ys.data() + begin,
+                                                         grid.zs.data() + begin, end - begin, qx, qy, qz, count,
+                                                         radius_sq, target_hits);
+                                    covered = std::all_of(target_hits, target_hits + (end - begin),
+                                                          [](const std::uint8_t h) { return h != 0; });
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    });
+
+    for (size_t p = 0; p < hits.size(); ++p) {
+        if (hits[p] && grid.atoms[p] < out.Size()) {
+            out.Set(grid.atoms[p]);
+        }
+    }
+}
+
+/// Pair collection over a cell grid (see SpatialIndex::FindPairs)
+void find_pairs(const CellGrid& grid, const Bitset& refs, const Bitset& targets, const float radius,
+                std::vector<unsigned int>& first, std::vector<unsigned int>& second,
+                std::vector<float>& distance_sq) {
+    const float radius_sq = radius * radius;
+    const size_t reach[3] = {grid.Reach(radius, 0), grid.Reach(radius, 1), grid.Reach(radius, 2)};
+
+    struct RefPoint {
+        unsigned int atom;
+        float x, y, z;
+    };
+    std::vector<RefPoint> points;
+    for (size_t p = 0; p < grid.atoms.size(); ++p) {
+        if (refs.Test(grid.atoms[p])) {
+            points.push_back({grid.atoms[p], grid.xs[p], grid.ys[p], grid.zs[p]});
+        }
+    }
+    std::sort(points.begin(), points.end(), [](const RefPoint& a, const RefPoint& b) { return a.atom < b.atom; });
+
+    // Targets of the current reference atom, reused across references
+    std::vector<std::pair<unsigned int, float>> hits;
+    const size_t nx = grid.dims[0];
+    const size_t ny = grid.dims[1];
+    std::vector<CellSpan> x_spans, y_spans, z_spans;
+    for (const RefPoint& ref : points) {
+        grid.Spans(0, grid.Axis(ref.x, 0), reach[0], x_spans);
+        grid.Spans(1, grid.Axis(ref.y, 1), reach[1], y_spans);
+        grid.Spans(2, grid.Axis(ref.z, 2), reach[2], z_spans);
+        hits.clear();
+        for (const CellSpan& zs : z_spans) {
+            for (const CellSpan& ys : y_spans) {
+                for (const CellSpan& xs : x_spans) {
+                    const float qx = ref.x - xs.shift;
+                    const float qy = ref.y - ys.shift;
+                    const float qz = ref.z - zs.shift;
+                    for (size_t z = zs.lo; z <= zs.hi; ++z) {
+                        for (size_t y = ys.lo; y <= ys.hi; ++y) {
+                            // Cells along x are contiguous in the sorted arrays
+                            const size_t row = (z * ny + y) * nx;
+                            for (unsigned int p = grid.cell_start[row + xs.lo]; p < grid.cell_start[row + xs.hi + 1];
+                                 ++p) {
+                                const unsigned int atom = grid.atoms[p];
+                                if (atom == ref.atom || !targets.Test(atom)) continue;
+                                const float dx = qx - grid.xs[p];
+                                const float dy = qy - grid.ys[p];
+                                const float dz = qz - grid.zs[p];
+                                const float d2 = dx * dx + dy * dy + dz * dz;
+                                if (d2 < radius_sq) {
+                                    hits.emplace_back(atom, d2);
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        std::sort(hits.begin(), hits.end());
+        if (grid.Periodic()) {
+            // Boxes smaller than the radius hold several images of a target; keep the nearest
+            hits.erase(std::unique(hits.begin(), hits.end(),
+                                   [](const auto& a, const auto& b) { return a.first == b.first; }),
+                       hits.end());
+        }
+        for (const auto& [atom, d2] : hits) {
+            first.push_back(ref.atom);
+            second.push_back(atom);
+            distance_sq.push_back(d2);
+        }
+    }
+}
+
+/**
+ * @brief k-nearest ranking of candidate atoms against reference atoms.
+ *
+ * Builds one k-d tree over the finite candidate points, so a caller can
+ * widen k without rebuilding it.
+ */
+class NearestSearch {
+public:
+    NearestSearch(const MoleculePointCloud& cloud, const UnitCell& cell, const Bitset& refs,
+                  const Bitset& candidates) {
+        // Candidates go into their own tree; reference points become the queries
+        for (size_t i = 0; i < cloud.atom_indices.size(); ++i) {
+            const unsigned int idx = cloud.atom_indices[i];
+            const float* p = cloud.coords.data() + i * 3;
+            if (!std::isfinite(p[0]) || !std::isfinite(p[1]) || !std::isfinite(p[2])) continue;
+            if (idx < candidates.Size() && candidates.Test(idx)) {
+                subset_.coords.insert(subset_.coords.end(), p, p + 3);
+                subset_.atom_indices.push_back(idx);
+            }
+            if (idx < refs.Size() && refs.Test(idx)) {
+                queries_.insert(queries_.end(), p, p + 3);
+            }
+        }
+        if (Empty()) return;
+
+        tree_ = std::make_unique<KDTree>(3, subset_, nanoflann::KDTreeSingleIndexAdaptorParams(10));
+        tree_->buildIndex();
+
+        // Both sides are wrapped into the box, so one box shift per axis reaches every minimum image
+        for (int d = 0; d < 3; ++d) {
+            shifts_[d].push_back(0.0f);
+            if (cell.IsPeriodic()) {
+                shifts_[d].push_back(-cell.Length(d));
+                shifts_[d].push_back(cell.Length(d));
+            }
+        }
+    }
+
+    /// True when there is nothing to rank against, or nothing to rank
+    [[nodiscard]] bool Empty() const { return subset_.atom_indices.empty() || queries_.empty(); }
+
+    /// Number of finite candidate points
+    [[nodiscard]] size_t NumCandidates() const { return subset_.atom_indices.size(); }
+
+    /// Atom index of candidate point @p point
+    [[nodiscard]] unsigned int Atom(const size_t point) const { return subset_.atom_indices[point]; }
+
+    /// Squared distance of candidate point @p point to its closest reference, after Rank()
+    [[nodiscard]] float DistanceSq(const size_t point) const { return best_[point]; }
+
+    /**
+     * @brief Candidate points of the @p k nearest candidates, nearest first.
+     *
+     * Ties are broken by atom index. Each query keeps every candidate tied
+     * with its k-th nearest, since the tree returns an arbitrary subset of
+     * a tie; a candidate outside every query's k nearest then has k
+     * candidates strictly closer than it.
+     */
+    [[nodiscard]] std::vector<unsigned int> Rank(const size_t k) {
+        const size_t per_query = std::min(k, NumCandidates());
+        best_.assign(NumCandidates(), std::numeric_limits<float>::infinity());
+        std::vector<unsigned int> found;
+        for (size_t q = 0; q < queries_.size(); q += 3) {
+            for (const float sz : shifts_[2]) {
+                for (const float sy : shifts_[1]) {
+                    for (const float sx : shifts_[0]) {
+                        const float query[3] = {queries_[q] + sx, queries_[q + 1] + sy, queries_[q + 2] + sz};
+                        const size_t n = Search(query, per_query);
+                        for (size_t i = 0; i < n; ++i) {
+                            float& slot = best_[points_[i]];
+                            if (std::isinf(slot)) {
+                                found.push_back(points_[i]);
+                            }
+                            slot = std::min(slot, dists_[i]);
+                        }
+                    }
+                }
+            }
+        }
+
+        const auto closer = [&](const unsigned int a, const unsigned int b) {
+            return best_[a] != best_[b] ? best_[a] < best_[b] : Atom(a) < Atom(b);
+        };
+        const size_t count = std::min(k, found.size());
+        std::partial_sort(found.begin(), found.begin() + static_cast<std::ptrdiff_t>(count), found.end(), closer);
+        found.resize(count);
+        return found;
+    }
+
+private:
+    /// k nearest of one query plus every point tied with the k-th; returns how many of points_ to use
+    size_t Search(const float* query, const size_t k) {
+        size_t width = k;
+        for (;;) {
+            points_.resize(width);
+            dists_.resize(width);
+            const size_t n = tree_->knnSearch(query, width, points_.data(), dists_.data());
+            if (n < width || width == NumCandidates() || dists_[n - 1] > dists_[k - 1]) {
+                return std::upper_bound(dists_.begin(), dists_.begin() + static_cast<std::ptrdiff_t>(n),
+                                        dists_[std::min(n, k) - 1]) -
+                       dists_.begin();
+            }
+            width = std::min(width * 2, NumCandidates());
+        }
+    }
+
+    MoleculePointCloud subset_;
+    std::vector<float> queries_;
+    std::vector<float> shifts_[3];
+    std::unique_ptr<KDTree> tree_;
+    std::vector<float> best_;  ///< Smallest squared distance of each candidate point over all queries
+    std::vector<unsigned int> points_;
+    std::vector<float> dists_;
+};
+}  // namespace
+
+/// PIMPL containing the point cloud and the active backend structure
 struct SpatialIndex::Impl {
-    MoleculePointCloud cloud;
+    MoleculePointCloud cloud;  ///< Wrapped into the box when periodic
+    UnitCell cell;
+    SpatialBackend backend;
     std::unique_ptr<KDTree> tree;
+    std::unique_ptr<CellGrid> grid;
+    WorkStealingPool* pool;  ///< Owned by the Context; null to run inline
 
-    explicit Impl(OEChem::OEMolBase& mol) : cloud(mol) {
-        if (!cloud.atom_indices.empty()) {
-            // Leaf size of 10 provides good balance between build and query time
-            tree = std::make_unique<KDTree>(3, cloud, nanoflann::KDTreeSingleIndexAdaptorParams(10));
+    Impl(OEChem::OEMolBase& mol, const Bitset* subset, const SpatialBackend requested, const float cutoff,
+         const UnitCell& c, WorkStealingPool* p)
+        : cloud(mol, subset)
+        , cell(c)
+        , backend(requested == SpatialBackend::AUTO
+                      ? SpatialIndex::ChooseBackend(cloud.atom_indices.size(), cutoff)
+                      : requested)
+        , pool(p) {
+        if (cloud.atom_indices.empty()) {
+            return;
+        }
+        wrap_cloud(cloud, cell);
+        if (backend == SpatialBackend::CELL_LIST) {
+            grid = std::make_unique<CellGrid>(cloud, cutoff > 0.0f ? cutoff : kDefaultCellSize, cell, pool);
+        } else {
+            // Leaf size of 10 provides good balance between build and query time. nanoflann
+            // splits the build over its own threads, one per pool worker.
+            tree = std::make_unique<KDTree>(
+                3, cloud,
+                nanoflann::KDTreeSingleIndexAdaptorParams(10, nanoflann::KDTreeSingleIndexAdaptorFlags::None,
+                                                          pool ? pool->NumWorkers() : 1));
             tree->buildIndex();
         }
     }
+
+    /// Minimum-image radius search for a periodic cell, sorted and without duplicates
+    void FindPeriodic(float x, float y, float z, float radius, std::vector<unsigned int>& result) const;
+
+    /// Run @p mark on the cell list, or on a temporary grid @p radius wide for the k-d tree
+    template <typename Mark>
+    void WithGrid(const float radius, const Mark& mark) const {
+        if (grid) {
+            mark(*grid);
+        } else {
+            mark(CellGrid(cloud, radius, cell, pool));
+        }
+    }
 };
 
-SpatialIndex::SpatialIndex(OEChem::OEMolBase& mol)
-    : pimpl_(std::make_unique<Impl>(mol)) {}
+SpatialIndex::SpatialIndex(OEChem::OEMolBase& mol, const SpatialBackend backend, const float cutoff,
+                           const UnitCell& cell)
+    : SpatialIndex(mol, backend, cutoff, cell, nullptr) {}
+
+SpatialIndex::SpatialIndex(OEChem::OEMolBase& mol, const SpatialBackend backend, const float cutoff,
+                           const UnitCell& cell, WorkStealingPool* pool)
+    : pimpl_(std::make_unique<Impl>(mol, nullptr, backend, cutoff, cell, pool)) {}
+
+SpatialIndex::SpatialIndex(OEChem::OEMolBase& mol, const Bitset& atoms, const SpatialBackend backend,
+                           const float cutoff, const UnitCell& cell)
+    : pimpl_(std::make_unique<Impl>(mol, &atoms, backend, cutoff, cell, nullptr)) {}
+
+void SpatialIndex::SetPool(WorkStealingPool* pool) {
+    pimpl_->pool = pool;
+}
 
 SpatialIndex::~SpatialIndex() = default;
 
+SpatialBackend SpatialIndex::ChooseBackend(const size_t num_atoms, const float max_radius) {
+    if (num_atoms >= kCellListMinAtoms && max_radius > 0.0f && max_radius <= kCellListMaxCutoff) {
+        return SpatialBackend::CELL_LIST;
+    }
+    return SpatialBackend::KD_TREE;
+}
+
+SpatialBackend SpatialIndex::Backend() const {
+    return pimpl_->backend;
+}
+
+const UnitCell& SpatialIndex::GetUnitCell() const {
+    return pimpl_->cell;
+}
+
+void SpatialIndex::UpdateCoordinates(const float* xyz) {
+    MoleculePointCloud& cloud = pimpl_->cloud;
+    for (size_t i = 0; i < cloud.atom_indices.size(); ++i) {
+        const float* p = xyz + static_cast<size_t>(cloud.atom_indices[i]) * 3;
+        std::copy(p, p + 3, cloud.coords.begin() + static_cast<std::ptrdiff_t>(i * 3));
+    }
+    wrap_cloud(cloud, pimpl_->cell);
+    if (pimpl_->grid) {
+        pimpl_->grid->Rebin(cloud, pimpl_->pool);
+    } else if (pimpl_->tree) {
+        // nanoflann has no refit; rebuild the tree over the updated cloud in place
+        pimpl_->tree->buildIndex();
+    }
+}
+
 std::vector<unsigned int> SpatialIndex::FindWithinRadius(
         const float x, const float y, const float z, const float radius) const {
     std::vector<unsigned int> result;
+    if (pimpl_->cell.IsPeriodic()) {
+        pimpl_->FindPeriodic(x, y, z, radius, result);
+        return result;
+    }
+
+    if (const CellGrid* grid = pimpl_->grid.get()) {
+        // Scan the block of cells overlapping the query sphere's bounding box
+        const float radius_sq = radius * radius;
+        const size_t lo[3] = {grid->Axis(x - radius, 0), grid->Axis(y - radius, 1), grid->Axis(z - radius, 2)};
+        const size_t hi[3] = {grid->Axis(x + radius, 0), grid->Axis(y + radius, 1), grid->Axis(z + radius, 2)};
+        for (size_t cz = lo[2]; cz <= hi[2]; ++cz) {
+            for (size_t cy = lo[1]; cy <= hi[1]; ++cy) {
+                const size_t row = (cz * grid->dims[1] + cy) * grid->dims[0];
+                for (unsigned int p = grid->cell_start[row + lo[0]]; p < grid->cell_start[row + hi[0] + 1]; ++p) {
+                    const float dx = x - grid->xs[p];
+                    const float dy = y - grid->ys[p];
+                    const float dz = z - grid->zs[p];
+                    if (dx * dx + dy * dy + dz * dz < radius_sq) {
+                        result.push_back(grid->atoms[p]);
+                    }
+                }
+            }
+        }
+        return result;
+    }
+
     if (!pimpl_->tree) return result;
 
     const float query[3] = {x, y, z};
@@ -107,6 +1003,170 @@ std::vector<unsigned int> SpatialIndex::FindWithinRadius(const OEChem::OEAtomBas
     return FindWithinRadius(xyz[0], xyz[1], xyz[2], radius);
 }
 
+void SpatialIndex::MarkWithinRadius(const Bitset& refs, const float radius, Bitset& out) const {
+    // Radius search is strict (d < r), so a zero radius matches nothing
+    if (!(radius > 0.0f) || pimpl_->cloud.atom_indices.empty()) return;
+
+    // The k-d tree has no cell structure; bin into a grid sized to this radius
+    std::unique_ptr<CellGrid> temporary;
+    if (!pimpl_->grid) {
+        temporary = std::make_unique<CellGrid>(pimpl_->cloud, radius, pimpl_->cell, pimpl_->pool);
+    }
+    const CellGrid& grid = pimpl_->grid ? *pimpl_->grid : *temporary;
+    if (pimpl_->pool) {
+        mark_within_radius_parallel(grid, refs, radius, out, *pimpl_->pool);
+    } else {
+        mark_within_radius(grid, refs, radius, out);
+    }
+}
+
+void SpatialIndex::MarkIndexedNear(const float* xyz, const Bitset& queries, const float radius, Bitset& out) const {
+    if (!(radius > 0.0f) || pimpl_->cloud.atom_indices.empty() || queries.None()) return;
+
+    pimpl_->WithGrid(radius, [&](const CellGrid& grid) {
+        std::vector<std::uint8_t> hits(grid.atoms.size(), 0);
+        mark_grid_near(grid, external_queries(grid, xyz, queries, radius), radius, hits);
+        for (size_t p = 0; p < hits.size(); ++p) {
+            if (hits[p] && grid.atoms[p] < out.Size()) {
+                out.Set(grid.atoms[p]);
+            }
+        }
+    });
+}
+
+void SpatialIndex::MarkNearIndexed(const float* xyz, const Bitset& queries, const float radius, Bitset& out) const {
+    if (!(radius > 0.0f) || pimpl_->cloud.atom_indices.empty() || queries.None()) return;
+
+    pimpl_->WithGrid(radius, [&](const CellGrid& grid) {
+        const QueryRuns points = external_queries(grid, xyz, queries, radius);
+        std::vector<std::uint8_t> hits(points.atoms.size(), 0);
+        mark_queries_near(grid, points, radius, hits);
+        for (size_t i = 0; i < hits.size(); ++i) {
+            if (hits[i] && points.atoms[i] < out.Size()) {
+                out.Set(points.atoms[i]);
+            }
+        }
+    });
+}
+
+void SpatialIndex::FindPairs(const Bitset& refs, const Bitset& targets, const float radius,
+                             std::vector<unsigned int>& first, std::vector<unsigned int>& second,
+                             std::vector<float>& distance_sq) const {
+    if (!(radius > 0.0f) || pimpl_->cloud.atom_indices.empty()) return;
+
+    if (pimpl_->grid) {
+        find_pairs(*pimpl_->grid, refs, targets, radius, first, second, distance_sq);
+    } else {
+        find_pairs(CellGrid(pimpl_->cloud, radius, pimpl_->cell), refs, targets, radius, first, second,
+                   distance_sq);
+    }
+}
+
+void SpatialIndex::FindNearest(const Bitset& refs, const Bitset& candidates, const size_t k,
+                               std::vector<unsigned int>& nearest, std::vector<float>& distance_sq) const {
+    if (k == 0 || pimpl_->cloud.atom_indices.empty()) return;
+
+    NearestSearch search(pimpl_->cloud, pimpl_->cell, refs, candidates);
+    if (search.Empty()) return;
+    for (const unsigned int point : search.Rank(k)) {
+        nearest.push_back(search.Atom(point));
+        distance_sq.push_back(search.DistanceSq(point));
+    }
+}
+
+void SpatialIndex::FindNearestGroups(const Bitset& refs, const Bitset& candidates,
+                                     const std::vector<std::uint32_t>& groups, const size_t count,
+                                     std::vector<unsigned int>& nearest, std::vector<float>& distance_sq) const {
+    if (count == 0 || pimpl_->cloud.atom_indices.empty()) return;
+
+    NearestSearch search(pimpl_->cloud, pimpl_->cell, refs, candidates);
+    if (search.Empty()) return;
+
+    // Widen the atom ranking over the one tree until it reaches count distinct groups or every candidate
+    std::unordered_set<std::uint32_t> seen;
+    std::vector<unsigned int> points;
+    for (size_t k = count;; k = std::min(k * 2, search.NumCandidates())) {
+        seen.clear();
+        points.clear();
+        for (const unsigned int point : search.Rank(k)) {
+            const unsigned int idx = search.Atom(point);
+            if (idx < groups.size() && seen.insert(groups[idx]).second) {
+                points.push_back(point);
+                if (points.size() == count) break;
+            }
+        }
+        if (points.size() == count || k >= search.NumCandidates()) break;
+    }
+    for (const unsigned int point : points) {
+        nearest.push_back(search.Atom(point));
+        distance_sq.push_back(search.DistanceSq(point));
+    }
+}
+
+void SpatialIndex::Impl::FindPeriodic(
+        const float x, const float y, const float z, const float radius, std::vector<unsigned int>& result) const {
+    const float query[3] = {wrap_coordinate(x, cell.Length(0)), wrap_coordinate(y, cell.Length(1)),
+                            wrap_coordinate(z, cell.Length(2))};
+    if (!std::isfinite(query[0]) || !std::isfinite(query[1]) || !std::isfinite(query[2])) return;
+    const float radius_sq = radius * radius;
+
+    if (grid) {
+        std::vector<CellSpan> spans[3];
+        for (int d = 0; d < 3; ++d) {
+            grid->Spans(d, grid->Axis(query[d], d), grid->Reach(radius, d), spans[d]);
+        }
+        for (const CellSpan& zs : spans[2]) {
+            for (const CellSpan& ys : spans[1]) {
+                for (const CellSpan& xs : spans[0]) {
+                    for (size_t cz = zs.lo; cz <= zs.hi; ++cz) {
+                        for (size_t cy = ys.lo; cy <= ys.hi; ++cy) {
+                            const size_t row = (cz * grid->dims[1] + cy) * grid->dims[0];
+                            for (unsigned int p = grid->cell_start[row + xs.lo];
+                                 p < grid->cell_start[row + xs.hi + 1]; ++p) {
+                                const float dx = query[0] - xs.shift - grid->xs[p];
+                                const float dy = query[1] - ys.shift - grid->ys[p];
+                                const float dz = query[2] - zs.shift - grid->zs[p];
+                                if (dx * dx + dy * dy + dz * dz < radius_sq) {
+                                    result.push_back(grid->atoms[p]);
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    } else if (tree) {
+        // Query every image of the point whose sphere overlaps the box
+        std::vector<float> images[3];
+        for (int d = 0; d < 3; ++d) {
+            const float length = cell.Length(d);
+            const auto span = static_cast<int>(std::ceil(radius / length));
+            for (int image = -span; image <= span + 1; ++image) {
+                const float centre = query[d] + static_cast<float>(image) * length;
+                if (centre + radius > 0.0f && centre - radius < length) {
+                    images[d].push_back(centre);
+                }
+            }
+        }
+        std::vector<nanoflann::ResultItem<unsigned int, float>> matches;
+        for (const float iz : images[2]) {
+            for (const float iy : images[1]) {
+                for (const float ix : images[0]) {
+                    const float image[3] = {ix, iy, iz};
+                    tree->radiusSearch(image, radius_sq, matches);
+                    for (const auto& match : matches) {
+                        result.push_back(cloud.atom_indices[match.first]);
+                    }
+                }
+            }
+        }
+    }
+
+    // An atom can lie within range of several images when the radius exceeds half the box
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+}
+
 size_t SpatialIndex::Size() const {
     return pimpl_->cloud.atom_indices.size();
 }
@@ -0,0 +1,334 @@
+/**
+ * @file StreamFilter.cpp
+ * @brief Pipelined stream filtering implementation.
+ */
+
+#include "oeselect/StreamFilter.h"
+#include "oeselect/Context.h"
+
+#include <oechem.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace OESel {
+
+namespace {
+/// Molecules in flight per evaluation thread when no queue depth is given
+constexpr size_t kQueueDepthPerThread = 4;
+
+/// One molecule moving through the pipeline, reused from molecule to molecule
+struct Slot {
+    OEChem::OEGraphMol mol;
+    Bitset mask;
+    size_t index = 0;
+    OEChem::OEGraphMol subset;  ///< Output of Run(ifs, ofs)
+    std::string record;         ///< Output of Run(ifs, output, out)
+};
+
+/// Blocking FIFO of slots; Close() wakes every waiter and stops further pops
+class SlotQueue {
+public:
+    void Push(Slot* slot) {
+        {
+            const std::lock_guard<std::mutex> lock(mutex_);
+            items_.push_back(slot);
+        }
+        ready_.notify_one();
+    }
+
+    /// Next slot, or null once the queue is closed and drained
+    Slot* Pop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        ready_.wait(lock, [&] { return !items_.empty() || closed_; });
+        if (items_.empty()) return nullptr;
+        Slot* slot = items_.front();
+        items_.pop_front();
+        return slot;
+    }
+
+    void Close() {
+        {
+            const std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+        }
+        ready_.notify_all();
+    }
+
+    /// Drop queued slots so a failed run stops promptly
+    void Abort() {
+        {
+            const std::lock_guard<std::mutex> lock(mutex_);
+            items_.clear();
+            closed_ = true;
+        }
+        ready_.notify_all();
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::deque<Slot*> items_;
+    bool closed_ = false;
+};
+
+/// Atom predicate over a precomputed mask, for OESubsetMol
+class MaskPredicate : public OESystem::OEUnaryPredicate<OEChem::OEAtomBase> {
+public:
+    explicit MaskPredicate(const Bitset& mask)
+        : mask_(mask) {}
+
+    bool operator()(const OEChem::OEAtomBase& atom) const override { return mask_.Test(atom.GetIdx()); }
+
+    [[nodiscard]] OESystem::OEUnaryFunction<OEChem::OEAtomBase, bool>* CreateCopy() const override {
+        return new MaskPredicate(*this);
+    }
+
+private:
+    const Bitset& mask_;
+};
+}  // namespace
+
+/// PIMPL containing the selection and the per-thread contexts
+struct StreamFilter::Impl {
+    /// Extra work run on an evaluation thread after the mask is computed
+    using Stage = std::function<void(Slot& slot)>;
+
+    /// Receives finished slots on the calling thread in input order
+    using Emit = std::function<void(Slot& slot)>;
+
+    OESelection sele;
+    unsigned int num_threads;
+    size_t queue_depth;
+    std::vector<std::unique_ptr<Context>> contexts;  ///< One per evaluation thread, kept across runs
+
+    Impl(OESelection s, const unsigned int threads, const size_t depth)
+        : sele(std::move(s))
+        , num_threads(threads != 0 ? threads : std::max(1U, std::thread::hardware_concurrency()))
+        , queue_depth(depth != 0 ? depth : kQueueDepthPerThread * num_threads)
+        , contexts(num_threads) {}
+
+    /// Evaluate the selection on a slot's molecule with one thread's context
+    void Evaluate(const unsigned int worker, Slot& slot, const Stage& stage) {
+        std::unique_ptr<Context>& ctx = contexts[worker];
+        if (!ctx) {
+            ctx = std::make_unique<Context>(slot.mol, sele);
+        } else {
+            ctx->Reset(slot.mol);
+        }
+        slot.mask = Bitset(slot.mol.GetMaxAtomIdx());
+        ctx->EvaluateSelection(slot.mask);
+        if (stage) stage(slot);
+    }
+
+    /// Run the pipeline; returns the number of molecules read
+    size_t Run(const MoleculeSource& source, const Stage& stage, const Emit& emit);
+
+    /// Read, evaluate, and emit one molecule at a time on the calling thread
+    size_t RunInline(const MoleculeSource& source, const Stage& stage, const Emit& emit);
+};
+
+size_t StreamFilter::Impl::RunInline(const MoleculeSource& source, const Stage& stage, const Emit& emit) {
+    Slot slot;
+    for (;; ++slot.index) {
+        slot.mol.Clear();
+        if (!source(slot.mol)) {
+            return slot.index;
+        }
+        Evaluate(0, slot, stage);
+        emit(slot);
+    }
+}
+
+size_t StreamFilter::Impl::Run(const MoleculeSource& source, const Stage& stage, const Emit& emit) {
+    if (num_threads == 1) {
+        return RunInline(source, stage, emit);
+    }
+
+    std::vector<Slot> slots(queue_depth);
+    SlotQueue free_slots;
+    SlotQueue pending;
+    for (Slot& slot : slots) {
+        free_slots.Push(&slot);
+    }
+
+    // Finished slot of index i waits in done[i % queue_depth] until it is next in order
+    std::mutex done_mutex;
+    std::condition_variable done_ready;
+    std::vector<Slot*> done(queue_depth, nullptr);
+    size_t total = 0;
+    bool reader_finished = false;
+    bool failed = false;  ///< Guarded by done_mutex, like the writer's wait predicate
+    std::exception_ptr error;
+
+    auto fail = [&](std::exception_ptr e) {
+        {
+            // Set under the lock so the writer cannot test the predicate and then miss the wakeup
+            const std::lock_guard<std::mutex> lock(done_mutex);
+            if (!error) error = std::move(e);
+            failed = true;
+        }
+        free_slots.Abort();
+        pending.Abort();
+        done_ready.notify_all();
+    };
+
+    std::thread reader([&] {
+        size_t count = 0;
+        try {
+            while (Slot* slot = free_slots.Pop()) {
+                slot->mol.Clear();
+                if (!source(slot->mol)) break;
+                slot->index = count++;
+                pending.Push(slot);
+            }
+        } catch (...) {
+            fail(std::current_exception());
+        }
+        pending.Close();
+        {
+            const std::lock_guard<std::mutex> lock(done_mutex);
+            total = count;
+            reader_finished = true;
+        }
+        done_ready.notify_all();
+    });
+
+    std::vector<std::thread> workers;
+    workers.reserve(num_threads);
+    for (unsigned int w = 0; w < num_threads; ++w) {
+        workers.emplace_back([&, w] {
+            while (Slot* slot = pending.Pop()) {
+                try {
+                    Evaluate(w, *slot, stage);
+                } catch (...) {
+                    fail(std::current_exception());
+                    return;
+                }
+                {
+                    const std::lock_guard<std::mutex> lock(done_mutex);
+                    done[slot->index % queue_depth] = slot;
+                }
+                done_ready.notify_all();
+            }
+        });
+    }
+
+    // Write on the calling thread, in input order
+    for (size_t next = 0;; ++next) {
+        Slot* slot = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(done_mutex);
+            done_ready.wait(lock, [&] {
+                return failed || done[next % queue_depth] || (reader_finished && next == total);
+            });
+            if (failed || !done[next % queue_depth]) break;
+            std::swap(slot, done[next % queue_depth]);
+        }
+        try {
+            emit(*slot);
+        } catch (...) {
+            fail(std::current_exception());
+            break;
+        }
+        free_slots.Push(slot);
+    }
+
+    reader.join();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    return total;
+}
+
+StreamFilter::StreamFilter(OESelection sele, const unsigned int num_threads, const size_t queue_depth)
+    : pimpl_(std::make_unique<Impl>(std::move(sele), num_threads, queue_depth)) {}
+
+StreamFilter::~StreamFilter() = default;
+
+const OESelection& StreamFilter::GetSelection() const {
+    return pimpl_->sele;
+}
+
+unsigned int StreamFilter::NumThreads() const {
+    return pimpl_->num_threads;
+}
+
+size_t StreamFilter::QueueDepth() const {
+    return pimpl_->queue_depth;
+}
+
+StreamFilterStats StreamFilter::Run(const MoleculeSource& source, const ResultCallback& callback) {
+    StreamFilterStats stats;
+    stats.molecules_read = pimpl_->Run(source, nullptr, [&](Slot& slot) {
+        stats.atoms_selected += slot.mask.Count();
+        ++stats.molecules_written;
+        callback(slot.index, slot.mol, slot.mask);
+    });
+    return stats;
+}
+
+StreamFilterStats StreamFilter::Run(OEChem::oemolistream& ifs, OEChem::oemolostream& ofs, const bool keep_empty) {
+    StreamFilterStats stats;
+    const auto source = [&](OEChem::OEMolBase& mol) { return OEChem::OEReadMolecule(ifs, mol); };
+    const auto subset = [&](Slot& slot) {
+        slot.subset.Clear();
+        if (keep_empty || slot.mask.Any()) {
+            OEChem::OESubsetMol(slot.subset, slot.mol, MaskPredicate(slot.mask));
+            slot.subset.SetTitle(slot.mol.GetTitle());
+        }
+    };
+    stats.molecules_read = pimpl_->Run(source, subset, [&](Slot& slot) {
+        const size_t selected = slot.mask.Count();
+        stats.atoms_selected += selected;
+        if (keep_empty || selected > 0) {
+            OEChem::OEWriteMolecule(ofs, slot.subset);
+            ++stats.molecules_written;
+        }
+    });
+    return stats;
+}
+
+StreamFilterStats StreamFilter::Run(OEChem::oemolistream& ifs, const FilterOutput output, std::ostream& out) {
+    StreamFilterStats stats;
+    const auto source = [&](OEChem::OEMolBase& mol) { return OEChem::OEReadMolecule(ifs, mol); };
+    const auto format = [&](Slot& slot) {
+        std::ostringstream record;
+        WriteRecord(record, output, slot.index, slot.mol, slot.mask);
+        slot.record = record.str();
+    };
+    stats.molecules_read = pimpl_->Run(source, format, [&](Slot& slot) {
+        stats.atoms_selected += slot.mask.Count();
+        out << slot.record;
+        ++stats.molecules_written;
+    });
+    return stats;
+}
+
+void StreamFilter::WriteRecord(std::ostream& out, const FilterOutput output, const size_t index,
+                               const OEChem::OEMolBase& mol, const Bitset& mask) {
+    out << index << '\t' << mol.GetTitle() << '\t';
+    if (output == FilterOutput::COUNT) {
+        out << mask.Count();
+    } else {
+        const char* separator = "";
+        mask.ForEachSet([&](const size_t idx) {
+            out << separator << idx;
+            separator = ",";
+        });
+    }
+    out << '\n';
+}
+
+}  // namespace OESel
@@ -0,0 +1,202 @@
+/**
+ * @file TableCache.cpp
+ * @brief Table cache file writing and memory-mapped loading.
+ */
+
+#include "oeselect/TableCache.h"
+#include "oeselect/AtomTable.h"
+#include "oeselect/BondGraph.h"
+#include "oeselect/Context.h"
+#include "oeselect/Error.h"
+#include "oeselect/Tagger.h"
+#include "fnv1a.h"
+#include "table_file.h"
+
+#include <oechem.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+#ifdef _WIN32
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace OESel {
+
+namespace {
+
+constexpr char kMagic[8] = {'O', 'E', 'S', 'E', 'L', 'T', 'C', '\0'};
+constexpr std::uint32_t kByteOrderMark = 0x01020304;
+
+/// Fixed file header; the section image follows immediately
+struct FileHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byte_order;
+    std::uint64_t key;
+    std::uint64_t residue_classes;  ///< Tagger::ResidueClassDigest() at save time
+    std::uint64_t payload_size;
+};
+static_assert(sizeof(FileHeader) == 40, "header layout must not depend on padding");
+
+/// Read-only view of a whole file, memory-mapped where the platform allows
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+#ifdef _WIN32
+        std::ifstream in(path, std::ios::binary);
+        if (!in) return;
+        buffer_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        data_ = buffer_.data();
+        size_ = buffer_.size();
+        valid_ = !in.bad();
+#else
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return;
+        struct stat info {};
+        if (::fstat(fd, &info) == 0 && info.st_size > 0) {
+            void* mapped = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped != MAP_FAILED) {
+                data_ = static_cast<const char*>(mapped);
+                size_ = static_cast<size_t>(info.st_size);
+                valid_ = true;
+            }
+        }
+        // The mapping stays valid after the descriptor is closed
+        ::close(fd);
+#endif
+    }
+
+    ~MappedFile() {
+#ifndef _WIN32
+        if (valid_) {
+            ::munmap(const_cast<char*>(data_), size_);
+        }
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    [[nodiscard]] bool Valid() const { return valid_; }
+    [[nodiscard]] const char* Data() const { return data_; }
+    [[nodiscard]] size_t Size() const { return size_; }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    bool valid_ = false;
+#ifdef _WIN32
+    std::vector<char> buffer_;
+#endif
+};
+
+}  // namespace
+
+std::uint64_t TableCache::Key(const OEChem::OEMolBase& mol) {
+    Fnv1a hash;
+    hash.Add(static_cast<std::uint64_t>(mol.GetMaxAtomIdx()));
+    for (OESystem::OEIter atom = mol.GetAtoms(); atom; ++atom) {
+        const OEChem::OEResidue& res = OEChem::OEAtomGetResidue(&*atom);
+        hash.Add(atom->GetIdx());
+        hash.Add(atom->GetAtomicNum());
+        hash.Add(atom->GetName());
+        hash.Add(res.GetName());
+        hash.Add(res.GetResidueNumber());
+        hash.Add(res.GetChainID());
+        hash.Add(res.GetInsertCode());
+        hash.Add(res.GetSerialNumber());
+        hash.Add(res.GetAlternateLocation());
+        hash.Add(static_cast<float>(res.GetBFactor()));
+        hash.Add(res.GetFragmentNumber());
+        hash.Add(res.GetSecondaryStructure());
+    }
+    for (OESystem::OEIter bond = mol.GetBonds(); bond; ++bond) {
+        hash.Add(bond->GetBgn()->GetIdx());
+        hash.Add(bond->GetEnd()->GetIdx());
+    }
+    return hash.Value();
+}
+
+std::uint64_t TableCache::FileKey(const std::string& path) {
+    const MappedFile file(path);
+    if (!file.Valid()) {
+        throw SelectionError("Cannot read structure file: " + path);
+    }
+    Fnv1a hash;
+    hash.Add(static_cast<std::uint64_t>(file.Size()));
+    hash.Bytes(file.Data(), file.Size());
+    return hash.Value();
+}
+
+void TableCache::Save(Context& ctx, const std::string& path, const std::uint64_t key) {
+    TableFileWriter writer;
+    ctx.GetAtomTable().Write(writer);
+    ctx.GetBondGraph().Write(writer);
+    const std::vector<char>& payload = writer.Bytes();
+
+    FileHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.byte_order = kByteOrderMark;
+    header.key = key;
+    header.residue_classes = Tagger::ResidueClassDigest();
+    header.payload_size = payload.size();
+
+    // Write beside the target and rename, so readers never map a partial file
+    const std::string partial = path + ".partial";
+    {
+        std::ofstream out(partial, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+        if (!out.flush()) {
+            std::remove(partial.c_str());
+            throw SelectionError("Cannot write table cache: " + path);
+        }
+    }
+    std::remove(path.c_str());
+    if (std::rename(partial.c_str(), path.c_str()) != 0) {
+        std::remove(partial.c_str());
+        throw SelectionError("Cannot write table cache: " + path);
+    }
+}
+
+bool TableCache::Load(Context& ctx, const std::string& path, const std::uint64_t key) {
+    const MappedFile file(path);
+    if (!file.Valid() || file.Size() < sizeof(FileHeader)) return false;
+
+    FileHeader header{};
+    std::memcpy(&header, file.Data(), sizeof(header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion ||
+        header.byte_order != kByteOrderMark || header.key != key ||
+        header.residue_classes != Tagger::ResidueClassDigest() ||
+        header.payload_size != file.Size() - sizeof(FileHeader)) {
+        return false;
+    }
+
+    // Copy the sections out of the mapping; a corrupt file is a cache miss
+    std::unique_ptr<AtomTable> table(new AtomTable());
+    std::unique_ptr<BondGraph> bonds(new BondGraph());
+    try {
+        TableFileReader reader(file.Data() + sizeof(FileHeader), static_cast<size_t>(header.payload_size));
+        table->Read(reader);
+        bonds->Read(reader);
+        if (!reader.AtEnd()) return false;
+    } catch (const SelectionError&) {
+        return false;
+    }
+
+    const size_t size = ctx.Mol().GetMaxAtomIdx();
+    if (table->Size() != size || bonds->Size() != size) return false;
+    ctx.SetTables(std::move(table), std::move(bonds));
+    return true;
+}
+
+}  // namespace OESel
@@ -2,120 +2,480 @@
  * @file Tagger.cpp
  * @brief Molecular component tagging implementation.
  *
- * Classifies atoms into molecular components based on residue names.
- * Uses OEChem generic data tags for efficient storage and retrieval.
+ * Classifies residue names through a perfect hash table (computed at compile
+ * time for the built-in names, refrozen at runtime after registrations) and
+ * optionally persists the per-atom result as OEChem generic data.
  */
 
 #include "oeselect/Tagger.h"
+#include "oeselect/Error.h"
+#include "fnv1a.h"
 
 #include <oechem.h>
 
-#include <set>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
 #include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace OESel {
 
 namespace {
-// Lazy-initialized global tags for atom and molecule data
-unsigned int g_component_tag = 0;
-unsigned int g_tagged_tag = 0;
-
+// Tags for atom and molecule data, looked up once on first use. Function-local
+// statics are initialized exactly once even when threads race on the first call.
 unsigned int get_component_tag() {
-    if (g_component_tag == 0) {
-        g_component_tag = OESystem::OEGetTag("OESel_Component");
-    }
-    return g_component_tag;
+    static const unsigned int tag = OESystem::OEGetTag("OESel_Component");
+    return tag;
 }
 
 unsigned int get_tagged_tag() {
-    if (g_tagged_tag == 0) {
-        g_tagged_tag = OESystem::OEGetTag("OESel_Tagged");
-    }
-    return g_tagged_tag;
+    static const unsigned int tag = OESystem::OEGetTag("OESel_Tagged");
+    return tag;
 }
 
-// Standard residue name sets for classification
-const std::set<std::string> WATER_RESNAMES = {
-    "HOH", "WAT", "H2O", "DOD", "TIP", "TIP3", "SPC"
+/// A residue name and the component it classifies as
+struct ResidueClass {
+    const char* name;
+    ComponentFlag flag;
 };
 
-const std::set<std::string> AMINO_ACIDS = {
-    "ALA", "ARG", "ASN", "ASP", "CYS", "GLN", "GLU", "GLY", "HIS", "ILE",
-    "LEU", "LYS", "MET", "PHE", "PRO", "SER", "THR", "TRP", "TYR", "VAL",
+// Standard residue names for classification
+constexpr ResidueClass RESIDUE_CLASSES[] = {
+    // Water
+    {"HOH", ComponentFlag::WATER}, {"WAT", ComponentFlag::WATER}, {"H2O", ComponentFlag::WATER},
+    {"DOD", ComponentFlag::WATER}, {"TIP", ComponentFlag::WATER}, {"TIP3", ComponentFlag::WATER},
+    {"SPC", ComponentFlag::WATER},
+
+    // Amino acids
+    {"ALA", ComponentFlag::PROTEIN}, {"ARG", ComponentFlag::PROTEIN}, {"ASN", ComponentFlag::PROTEIN},
+    {"ASP", ComponentFlag::PROTEIN}, {"CYS", ComponentFlag::PROTEIN}, {"GLN", ComponentFlag::PROTEIN},
+    {"GLU", ComponentFlag::PROTEIN}, {"GLY", ComponentFlag::PROTEIN}, {"HIS", ComponentFlag::PROTEIN},
+    {"ILE", ComponentFlag::PROTEIN}, {"LEU", ComponentFlag::PROTEIN}, {"LYS", ComponentFlag::PROTEIN},
+    {"MET", ComponentFlag::PROTEIN}, {"PHE", ComponentFlag::PROTEIN}, {"PRO", ComponentFlag::PROTEIN},
+    {"SER", ComponentFlag::PROTEIN}, {"THR", ComponentFlag::PROTEIN}, {"TRP", ComponentFlag::PROTEIN},
+    {"TYR", ComponentFlag::PROTEIN}, {"VAL", ComponentFlag::PROTEIN},
     // Common protonation states and modifications
-    "HID", "HIE", "HIP", "CYX", "ASH", "GLH",
+    {"HID", ComponentFlag::PROTEIN}, {"HIE", ComponentFlag::PROTEIN}, {"HIP", ComponentFlag::PROTEIN},
+    {"CYX", ComponentFlag::PROTEIN}, {"ASH", ComponentFlag::PROTEIN}, {"GLH", ComponentFlag::PROTEIN},
     // CHARMM histidine naming
-    "HSD", "HSE", "HSP",
+    {"HSD", ComponentFlag::PROTEIN}, {"HSE", ComponentFlag::PROTEIN}, {"HSP", ComponentFlag::PROTEIN},
     // Additional protonation states
-    "CYM", "LYN",
+    {"CYM", ComponentFlag::PROTEIN}, {"LYN", ComponentFlag::PROTEIN},
     // Non-standard amino acids
-    "MSE", "SEC", "PYL",
+    {"MSE", ComponentFlag::PROTEIN}, {"SEC", ComponentFlag::PROTEIN}, {"PYL", ComponentFlag::PROTEIN},
     // Ambiguous codes
-    "ASX", "GLX",
+    {"ASX", ComponentFlag::PROTEIN}, {"GLX", ComponentFlag::PROTEIN},
     // Terminal capping groups
-    "ACE", "NME"
+    {"ACE", ComponentFlag::PROTEIN}, {"NME", ComponentFlag::PROTEIN},
+
+    // Nucleotides
+    {"A", ComponentFlag::NUCLEIC}, {"G", ComponentFlag::NUCLEIC}, {"C", ComponentFlag::NUCLEIC},
+    {"U", ComponentFlag::NUCLEIC}, {"T", ComponentFlag::NUCLEIC},
+    {"DA", ComponentFlag::NUCLEIC}, {"DG", ComponentFlag::NUCLEIC}, {"DC", ComponentFlag::NUCLEIC},
+    {"DT", ComponentFlag::NUCLEIC}, {"DU", ComponentFlag::NUCLEIC},
+    {"ADE", ComponentFlag::NUCLEIC}, {"GUA", ComponentFlag::NUCLEIC}, {"CYT", ComponentFlag::NUCLEIC},
+    {"URA", ComponentFlag::NUCLEIC}, {"THY", ComponentFlag::NUCLEIC},
+    {"RA", ComponentFlag::NUCLEIC}, {"RG", ComponentFlag::NUCLEIC}, {"RC", ComponentFlag::NUCLEIC},
+    {"RU", ComponentFlag::NUCLEIC},
+
+    // Cofactors
+    {"NAD", ComponentFlag::COFACTOR}, {"NAP", ComponentFlag::COFACTOR},   // NAD variants
+    {"NAI", ComponentFlag::COFACTOR}, {"NDP", ComponentFlag::COFACTOR},
+    {"FAD", ComponentFlag::COFACTOR}, {"FMN", ComponentFlag::COFACTOR},   // Flavin cofactors
+    {"FNR", ComponentFlag::COFACTOR},
+    {"HEM", ComponentFlag::COFACTOR}, {"HEC", ComponentFlag::COFACTOR},   // Heme variants
+    {"HEA", ComponentFlag::COFACTOR},
+    {"ATP", ComponentFlag::COFACTOR}, {"ADP", ComponentFlag::COFACTOR},   // Adenine nucleotides
+    {"AMP", ComponentFlag::COFACTOR},
+    {"GTP", ComponentFlag::COFACTOR}, {"GDP", ComponentFlag::COFACTOR},   // Guanine nucleotides
+    {"GMP", ComponentFlag::COFACTOR},
+    {"COA", ComponentFlag::COFACTOR}, {"ACO", ComponentFlag::COFACTOR},   // Coenzyme A
+    {"PLP", ComponentFlag::COFACTOR},                                     // Pyridoxal phosphate
+    {"BTN", ComponentFlag::COFACTOR},                                     // Biotin
+    {"B12", ComponentFlag::COFACTOR}, {"CBY", ComponentFlag::COFACTOR},   // Vitamin B12
+    {"SF4", ComponentFlag::COFACTOR}, {"FES", ComponentFlag::COFACTOR},   // Iron-sulfur clusters
+    {"F3S", ComponentFlag::COFACTOR},
+    {"MG", ComponentFlag::COFACTOR}, {"CA", ComponentFlag::COFACTOR},     // Common metal cofactors
+    {"ZN", ComponentFlag::COFACTOR}, {"FE", ComponentFlag::COFACTOR},
+    {"MN", ComponentFlag::COFACTOR}, {"CU", ComponentFlag::COFACTOR},
+
+    // Solvents
+    {"DMS", ComponentFlag::SOLVENT}, {"DMF", ComponentFlag::SOLVENT}, {"ACN", ComponentFlag::SOLVENT},
+    {"MOH", ComponentFlag::SOLVENT}, {"EOH", ComponentFlag::SOLVENT}, {"IPA", ComponentFlag::SOLVENT},
+    {"GOL", ComponentFlag::SOLVENT}, {"PEG", ComponentFlag::SOLVENT}, {"EDO", ComponentFlag::SOLVENT},
+
+    // Lipids (CHARMM-GUI membrane names and common PDB codes)
+    {"POPC", ComponentFlag::LIPID}, {"POPE", ComponentFlag::LIPID}, {"POPG", ComponentFlag::LIPID},
+    {"POPS", ComponentFlag::LIPID}, {"DPPC", ComponentFlag::LIPID}, {"DMPC", ComponentFlag::LIPID},
+    {"DOPC", ComponentFlag::LIPID}, {"DOPE", ComponentFlag::LIPID},
+    {"CHL1", ComponentFlag::LIPID}, {"CLR", ComponentFlag::LIPID},    // Cholesterol
+    {"OLA", ComponentFlag::LIPID}, {"PLM", ComponentFlag::LIPID},     // Fatty acids
+
+    // Glycans (common monosaccharide codes)
+    {"NAG", ComponentFlag::GLYCAN}, {"NDG", ComponentFlag::GLYCAN}, {"MAN", ComponentFlag::GLYCAN},
+    {"BMA", ComponentFlag::GLYCAN}, {"GAL", ComponentFlag::GLYCAN}, {"GLA", ComponentFlag::GLYCAN},
+    {"GLC", ComponentFlag::GLYCAN}, {"BGC", ComponentFlag::GLYCAN}, {"FUC", ComponentFlag::GLYCAN},
+    {"FUL", ComponentFlag::GLYCAN}, {"SIA", ComponentFlag::GLYCAN}, {"XYS", ComponentFlag::GLYCAN},
 };
 
-const std::set<std::string> NUCLEOTIDES = {
-    "A", "G", "C", "U", "T",
-    "DA", "DG", "DC", "DT", "DU",
-    "ADE", "GUA", "CYT", "URA", "THY",
-    "RA", "RG", "RC", "RU"
+// Residue names of up to four characters are packed into a 32-bit code and
+// looked up in an open table whose multiplicative hash is chosen to be
+// collision-free over every known name (a perfect hash). The built-in table
+// is computed at compile time; registrations freeze a new table at runtime.
+
+/// Longest residue name the table can hold
+constexpr size_t kMaxCodeLength = 4;
+
+/// Built-in table slots as a power of two; ~16x the key count keeps the multiplier search short
+constexpr unsigned int kBuiltinHashBits = 12;
+constexpr size_t kBuiltinHashSize = size_t{1} << kBuiltinHashBits;
+
+/// Multipliers tried per table size before the table is doubled
+constexpr std::uint32_t kMultiplierAttempts = 4096;
+
+/// Largest frozen table as a power of two (1M slots, 5 MB)
+constexpr unsigned int kMaxFrozenHashBits = 20;
+
+/// Registrations the frozen table is sized to hold; a perfect hash needs
+/// slots roughly quadratic in the key count, so this bounds the table above
+constexpr size_t kMaxRegistrations = 1024;
+
+/// Pack up to four characters into a code; a name of zero length packs to 0
+constexpr std::uint32_t pack_code(const char* name, const size_t length) {
+    std::uint32_t code = 0;
+    for (size_t i = 0; i < length; ++i) {
+        code = code << 8 | static_cast<unsigned char>(name[i]);
+    }
+    return code;
+}
+
+constexpr size_t const_strlen(const char* s) {
+    size_t n = 0;
+    while (s[n] != '\0') {
+        ++n;
+    }
+    return n;
+}
+
+constexpr std::uint32_t hash_slot(const std::uint32_t code, const std::uint32_t multiplier, const unsigned int bits) {
+    return static_cast<std::uint32_t>(code * multiplier) >> (32 - bits);
+}
+
+constexpr std::uint32_t candidate_multiplier(const std::uint32_t attempt) {
+    return 0x9E3779B1u + 2u * attempt;  // Odd values near 2^32 / golden ratio
+}
+
+/// Find an odd multiplier mapping every built-in residue code to a distinct slot
+constexpr std::uint32_t find_builtin_multiplier() {
+    for (std::uint32_t attempt = 0; attempt < kMultiplierAttempts; ++attempt) {
+        const std::uint32_t multiplier = candidate_multiplier(attempt);
+        bool used[kBuiltinHashSize] = {};
+        bool collision = false;
+        for (const ResidueClass& entry : RESIDUE_CLASSES) {
+            const std::uint32_t slot =
+                hash_slot(pack_code(entry.name, const_strlen(entry.name)), multiplier, kBuiltinHashBits);
+            if (used[slot]) {
+                collision = true;
+                break;
+            }
+            used[slot] = true;
+        }
+        if (!collision) {
+            return multiplier;
+        }
+    }
+    return 0;
+}
+
+constexpr std::uint32_t kBuiltinMultiplier = find_builtin_multiplier();
+static_assert(kBuiltinMultiplier != 0, "No collision-free multiplier for the residue class table");
+
+/// Built-in perfect hash table: the residue code held by each slot and its component flag
+struct BuiltinTable {
+    std::uint32_t codes[kBuiltinHashSize] = {};
+    std::uint8_t flags[kBuiltinHashSize] = {};
 };
 
-const std::set<std::string> COFACTORS = {
-    "NAD", "NAP", "NAI", "NDP",   // NAD variants
-    "FAD", "FMN", "FNR",          // Flavin cofactors
-    "HEM", "HEC", "HEA",          // Heme variants
-    "ATP", "ADP", "AMP",          // Adenine nucleotides
-    "GTP", "GDP", "GMP",          // Guanine nucleotides
-    "COA", "ACO",                 // Coenzyme A
-    "PLP",                        // Pyridoxal phosphate
-    "BTN",                        // Biotin
-    "B12", "CBY",                 // Vitamin B12
-    "SF4", "FES", "F3S",          // Iron-sulfur clusters
-    "MG", "CA", "ZN", "FE", "MN", "CU"  // Common metal cofactors
+constexpr BuiltinTable build_builtin_table() {
+    BuiltinTable table;
+    for (const ResidueClass& entry : RESIDUE_CLASSES) {
+        const std::uint32_t code = pack_code(entry.name, const_strlen(entry.name));
+        const std::uint32_t slot = hash_slot(code, kBuiltinMultiplier, kBuiltinHashBits);
+        table.codes[slot] = code;
+        table.flags[slot] = static_cast<std::uint8_t>(entry.flag);
+    }
+    return table;
+}
+
+constexpr BuiltinTable BUILTIN_TABLE = build_builtin_table();
+
+/// Read-only view of a perfect hash table, shared by built-in and frozen tables
+struct TableView {
+    const std::uint32_t* codes;
+    const std::uint8_t* flags;
+    std::uint32_t multiplier;
+    unsigned int bits;
 };
 
-const std::set<std::string> SOLVENTS = {
-    "DMS", "DMF", "ACN", "MOH", "EOH", "IPA", "GOL", "PEG", "EDO"
+constexpr TableView BUILTIN_VIEW = {BUILTIN_TABLE.codes, BUILTIN_TABLE.flags, kBuiltinMultiplier, kBuiltinHashBits};
+
+/// A perfect hash table frozen at runtime from built-in entries plus registrations
+struct FrozenTable {
+    std::vector<std::uint32_t> codes;
+    std::vector<std::uint8_t> flags;
+    TableView view{};
 };
 
-/**
- * @brief Remove leading and trailing whitespace from a string.
- */
-std::string trim_whitespace(const std::string& str) {
-    std::string result = str;
-    while (!result.empty() && std::isspace(static_cast<unsigned char>(result.back()))) {
-        result.pop_back();
+/// Build a perfect hash table over code/flag pairs with unique codes
+std::shared_ptr<const FrozenTable> freeze_table(const std::vector<std::pair<std::uint32_t, std::uint8_t>>& entries) {
+    auto table = std::make_shared<FrozenTable>();
+    unsigned int bits = kBuiltinHashBits;
+    while (bits < kMaxFrozenHashBits && (size_t{1} << bits) < 16 * entries.size()) {
+        ++bits;
     }
-    size_t start = 0;
-    while (start < result.size() && std::isspace(static_cast<unsigned char>(result[start]))) {
-        ++start;
+    std::vector<bool> used;
+    for (; bits <= kMaxFrozenHashBits; ++bits) {
+        const size_t size = size_t{1} << bits;
+        for (std::uint32_t attempt = 0; attempt < kMultiplierAttempts; ++attempt) {
+            const std::uint32_t multiplier = candidate_multiplier(attempt);
+            used.assign(size, false);
+            bool collision = false;
+            for (const auto& entry : entries) {
+                const std::uint32_t slot = hash_slot(entry.first, multiplier, bits);
+                if (used[slot]) {
+                    collision = true;
+                    break;
+                }
+                used[slot] = true;
+            }
+            if (collision) {
+                continue;
+            }
+            table->codes.assign(size, 0);
+            table->flags.assign(size, 0);
+            for (const auto& [code, flag] : entries) {
+                const std::uint32_t slot = hash_slot(code, multiplier, bits);
+                table->codes[slot] = code;
+                table->flags[slot] = flag;
+            }
+            table->view = {table->codes.data(), table->flags.data(), multiplier, bits};
+            return table;
+        }
     }
-    return result.substr(start);
+    throw SelectionError("Cannot build a collision-free residue class table for " +
+                         std::to_string(entries.size()) + " names");
 }
 
 /**
- * @brief Classify a residue by its name.
+ * Process-wide residue class registry.
  *
- * @param resname The residue name to classify.
- * @return Component flag indicating the residue type.
+ * Registrations are collected under a mutex and frozen lazily into a new
+ * table on the next classification. Readers take shared ownership of the
+ * active table, so a replaced or cleared table is freed once the last
+ * concurrent reader has finished probing it. No frozen table means the
+ * built-in one is in effect.
  */
-ComponentFlag classify_residue(const std::string& resname) {
-    const std::string name = trim_whitespace(resname);
+class ResidueRegistry {
+public:
+    static ResidueRegistry& Instance() {
+        static ResidueRegistry registry;
+        return registry;
+    }
+
+    std::shared_ptr<const FrozenTable> Active() {
+        if (dirty_.load(std::memory_order_acquire)) {
+            Freeze();
+        }
+        return std::atomic_load_explicit(&active_, std::memory_order_acquire);
+    }
+
+    void Register(const std::vector<std::pair<std::uint32_t, std::uint8_t>>& entries) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t added = 0;
+        for (const auto& entry : entries) {
+            added += custom_.count(entry.first) == 0 ? 1 : 0;
+        }
+        if (custom_.size() + added > kMaxRegistrations) {
+            throw SelectionError("At most " + std::to_string(kMaxRegistrations) +
+                                 " residue classes can be registered");
+        }
+        for (const auto& [code, flag] : entries) {
+            custom_[code] = flag;
+        }
+        digest_.store(Digest(), std::memory_order_release);
+        dirty_.store(true, std::memory_order_release);
+    }
+
+    void Clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        custom_.clear();
+        digest_.store(0, std::memory_order_release);
+        std::atomic_store_explicit(&active_, std::shared_ptr<const FrozenTable>(), std::memory_order_release);
+        dirty_.store(false, std::memory_order_release);
+    }
+
+    [[nodiscard]] std::uint64_t GetDigest() const {
+        return digest_.load(std::memory_order_acquire);
+    }
+
+private:
+    /// FNV-1a over the registrations in code order; caller holds the mutex
+    std::uint64_t Digest() const {
+        std::vector<std::pair<std::uint32_t, std::uint8_t>> entries(custom_.begin(), custom_.end());
+        std::sort(entries.begin(), entries.end());
+        Fnv1a hash;
+        for (const auto& [code, flag] : entries) {
+            hash.Add(code);
+            hash.Add(flag);
+        }
+        return entries.empty() ? 0 : hash.Value();
+    }
+
+    void Freeze() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!dirty_.load(std::memory_order_relaxed)) {
+            return;  // Another thread froze the table first
+        }
+        // Registrations override built-in entries with the same name
+        std::unordered_map<std::uint32_t, std::uint8_t> merged;
+        for (const ResidueClass& entry : RESIDUE_CLASSES) {
+            merged[pack_code(entry.name, const_strlen(entry.name))] = static_cast<std::uint8_t>(entry.flag);
+        }
+        for (const auto& [code, flag] : custom_) {
+            merged[code] = flag;
+        }
+        std::atomic_store_explicit(&active_, freeze_table({merged.begin(), merged.end()}), std::memory_order_release);
+        dirty_.store(false, std::memory_order_release);
+    }
+
+    std::mutex mutex_;
+    std::unordered_map<std::uint32_t, std::uint8_t> custom_;
+    std::shared_ptr<const FrozenTable> active_;  ///< Accessed only through std::atomic_load/store
+    std::atomic<std::uint64_t> digest_{0};
+    std::atomic<bool> dirty_{false};
+};
+
+bool is_space(const char c) {
+    return std::isspace(static_cast<unsigned char>(c)) != 0;
+}
+
+/// Trim surrounding whitespace in place; returns the trimmed length
+size_t trim_span(const char*& begin, const char* end) {
+    while (begin < end && is_space(*begin)) {
+        ++begin;
+    }
+    while (end > begin && is_space(end[-1])) {
+        --end;
+    }
+    return static_cast<size_t>(end - begin);
+}
+
+/// Pack a registered residue name, rejecting names the table cannot hold
+std::uint32_t registration_code(const std::string& name) {
+    const char* begin = name.c_str();
+    const size_t length = trim_span(begin, name.c_str() + name.size());
+    if (length == 0 || length > kMaxCodeLength) {
+        throw SelectionError("Residue class names must be 1 to 4 characters: '" + name + "'");
+    }
+    return pack_code(begin, length);
+}
 
-    if (WATER_RESNAMES.count(name)) return ComponentFlag::WATER;
-    if (AMINO_ACIDS.count(name)) return ComponentFlag::PROTEIN;
-    if (NUCLEOTIDES.count(name)) return ComponentFlag::NUCLEIC;
-    if (COFACTORS.count(name)) return ComponentFlag::COFACTOR;
-    if (SOLVENTS.count(name)) return ComponentFlag::SOLVENT;
+std::uint8_t registration_flag(const ComponentFlag flag) {
+    const auto bits = static_cast<std::uint32_t>(flag);
+    if (bits == 0 || bits > 0xFF) {
+        throw SelectionError("Invalid component flag for residue class: " + std::to_string(bits));
+    }
+    return static_cast<std::uint8_t>(bits);
+}
 
-    // Unknown residues default to ligand
-    return ComponentFlag::LIGAND;
+/// Parse a component class keyword as used in residue class files
+bool parse_component_name(std::string name, ComponentFlag& flag) {
+    std::transform(name.begin(), name.end(), name.begin(),
+                   [](const unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    static const std::pair<const char*, ComponentFlag> names[] = {
+        {"protein", ComponentFlag::PROTEIN}, {"ligand", ComponentFlag::LIGAND},
+        {"solvent", ComponentFlag::SOLVENT}, {"cofactor", ComponentFlag::COFACTOR},
+        {"nucleic", ComponentFlag::NUCLEIC}, {"water", ComponentFlag::WATER},
+        {"lipid", ComponentFlag::LIPID}, {"glycan", ComponentFlag::GLYCAN},
+    };
+    for (const auto& [keyword, value] : names) {
+        if (name == keyword) {
+            flag = value;
+            return true;
+        }
+    }
+    return false;
 }
 }  // namespace
 
+ComponentFlag Tagger::ClassifyResidueName(const char* resname) {
+    // Trim surrounding whitespace without copying the name
+    const char* begin = resname;
+    const size_t length = trim_span(begin, resname + std::strlen(resname));
+    if (length == 0 || length > kMaxCodeLength) {
+        return ComponentFlag::LIGAND;  // Unknown residues default to ligand
+    }
+
+    const std::shared_ptr<const FrozenTable> frozen = ResidueRegistry::Instance().Active();
+    const TableView& table = frozen ? frozen->view : BUILTIN_VIEW;
+    const std::uint32_t code = pack_code(begin, length);
+    const std::uint32_t slot = hash_slot(code, table.multiplier, table.bits);
+    if (table.codes[slot] != code) {
+        return ComponentFlag::LIGAND;
+    }
+    return static_cast<ComponentFlag>(table.flags[slot]);
+}
+
+void Tagger::RegisterResidueClass(const std::string& name, const ComponentFlag flag) {
+    ResidueRegistry::Instance().Register({{registration_code(name), registration_flag(flag)}});
+}
+
+void Tagger::LoadResidueClasses(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        throw SelectionError("Cannot open residue class file: " + path);
+    }
+
+    // Validate the whole file before registering anything
+    std::vector<std::pair<std::uint32_t, std::uint8_t>> entries;
+    std::string line;
+    for (size_t line_number = 1; std::getline(in, line); ++line_number) {
+        if (const auto comment = line.find('#'); comment != std::string::npos) {
+            line.erase(comment);
+        }
+        std::istringstream fields(line);
+        std::string name;
+        std::string component;
+        if (!(fields >> name)) {
+            continue;  // Blank or comment-only line
+        }
+        ComponentFlag flag = ComponentFlag::NONE;
+        std::string extra;
+        if (!(fields >> component) || (fields >> extra) || !parse_component_name(component, flag)) {
+            throw SelectionError(path + ":" + std::to_string(line_number) +
+                                 ": expected '<residue name> <component>', got '" + line + "'");
+        }
+        entries.emplace_back(registration_code(name), registration_flag(flag));
+    }
+    ResidueRegistry::Instance().Register(entries);
+}
+
+void Tagger::ClearResidueClasses() {
+    ResidueRegistry::Instance().Clear();
+}
+
+std::uint64_t Tagger::ResidueClassDigest() {
+    return ResidueRegistry::Instance().GetDigest();
+}
+
 void Tagger::TagMolecule(OEChem::OEMolBase& mol) {
     if (IsTagged(mol)) {
         return;  // Idempotent - skip if already tagged
@@ -124,9 +484,7 @@ void Tagger::TagMolecule(OEChem::OEMolBase& mol) {
     // Iterate all atoms and assign component flags based on residue name
     for (OESystem::OEIter atom = mol.GetAtoms(); atom; ++atom) {
         const OEChem::OEResidue& res = OEChem::OEAtomGetResidue(&*atom);
-        const std::string resname = res.GetName();
-
-        ComponentFlag flag = classify_residue(resname);
+        const ComponentFlag flag = ClassifyResidueName(res.GetName());
         atom->SetData<unsigned int>(get_component_tag(), static_cast<uint32_t>(flag));
     }
 
@@ -0,0 +1,46 @@
+/**
+ * @file fnv1a.h
+ * @brief 64-bit FNV-1a hash over raw field bytes.
+ *
+ * This header is private to the library (src/ only) and is not installed.
+ */
+
+#ifndef OESELECT_FNV1A_H
+#define OESELECT_FNV1A_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace OESel {
+
+/// 64-bit FNV-1a over raw field bytes
+class Fnv1a {
+public:
+    template<typename T>
+    void Add(const T& value) {
+        Bytes(&value, sizeof(value));
+    }
+
+    void Add(const char* str) {
+        const size_t length = str ? std::strlen(str) : 0;
+        Add(static_cast<std::uint64_t>(length));
+        Bytes(str, length);
+    }
+
+    void Bytes(const void* data, const size_t size) {
+        const auto* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash_ = (hash_ ^ bytes[i]) * 0x100000001b3ULL;
+        }
+    }
+
+    [[nodiscard]] std::uint64_t Value() const { return hash_; }
+
+private:
+    std::uint64_t hash_ = 0xcbf29ce484222325ULL;
+};
+
+}  // namespace OESel
+
+#endif  // OESELECT_FNV1A_H
@@ -7,14 +7,18 @@
  *  - `?` matches exactly one character.
  *
  * No character classes, no escapes — the grammar (src/Parser.cpp glob_char)
- * cannot produce them. This header is private to the library (src/ only)
- * and is not installed.
+ * cannot produce them. GlobMatcher compiles a list of patterns once so
+ * that Name/Resn predicates can reuse it for every atom. This header is
+ * private to the library (src/ only) and is not installed.
  */
 
 #ifndef OESELECT_GLOB_MATCH_H
 #define OESELECT_GLOB_MATCH_H
 
+#include <algorithm>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace OESel {
 
@@ -53,6 +57,171 @@ inline bool match_glob(const std::string& pattern, const std::string& text) {
     return pi == np;
 }
 
+/**
+ * @brief A set of wildcard patterns compiled for repeated matching.
+ *
+ * Each pattern is sorted into the cheapest form that can match it:
+ *  - exact names go into a sorted literal table,
+ *  - ``X*`` and ``*X`` (no other wildcards) become prefix and suffix tests,
+ *  - anything else is split on ``*`` into segments that are matched
+ *    anchored at both ends and leftmost-first in between.
+ *
+ * A text matches the set if it matches any pattern.
+ */
+class GlobMatcher {
+public:
+    /**
+     * @brief Compile a list of patterns.
+     *
+     * :param patterns: Patterns containing literal chars plus `*` and `?`.
+     */
+    explicit GlobMatcher(const std::vector<std::string>& patterns) {
+        for (const std::string& pattern : patterns) {
+            Add(pattern);
+        }
+        std::sort(literals_.begin(), literals_.end());
+        literals_.erase(std::unique(literals_.begin(), literals_.end()), literals_.end());
+    }
+
+    /**
+     * @brief Test a string against every compiled pattern.
+     *
+     * :param text: String to test.
+     * :returns: ``true`` if any pattern matches the entire text.
+     */
+    [[nodiscard]] bool Matches(const std::string_view text) const {
+        if (match_all_) {
+            return true;
+        }
+        if (!literals_.empty()) {
+            const auto it = std::lower_bound(literals_.begin(), literals_.end(), text,
+                                             [](const std::string& lhs, const std::string_view rhs) { return lhs < rhs; });
+            if (it != literals_.end() && *it == text) {
+                return true;
+            }
+        }
+        for (const std::string& prefix : prefixes_) {
+            if (text.substr(0, prefix.size()) == prefix) {
+                return true;
+            }
+        }
+        for (const std::string& suffix : suffixes_) {
+            if (text.size() >= suffix.size() && text.substr(text.size() - suffix.size()) == suffix) {
+                return true;
+            }
+        }
+        for (const Glob& glob : globs_) {
+            if (MatchesGlob(glob, text)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    /// A general pattern: segments separated by `*`, with `?` kept in segments
+    struct Glob {
+        std::vector<std::string> segments;
+        bool leading_star = false;   ///< First segment may start anywhere
+        bool trailing_star = false;  ///< Last segment may end anywhere
+    };
+
+    void Add(const std::string& pattern) {
+        const size_t first_star = pattern.find('*');
+        const bool has_question = pattern.find('?') != std::string::npos;
+        if (first_star == std::string::npos && !has_question) {
+            literals_.push_back(pattern);
+            return;
+        }
+        if (pattern.find_first_not_of('*') == std::string::npos) {
+            match_all_ = true;
+            return;
+        }
+        if (!has_question && first_star == pattern.size() - 1) {
+            prefixes_.push_back(pattern.substr(0, first_star));
+            return;
+        }
+        if (!has_question && first_star == 0 && pattern.find('*', 1) == std::string::npos) {
+            suffixes_.push_back(pattern.substr(1));
+            return;
+        }
+
+        Glob glob;
+        glob.leading_star = pattern.front() == '*';
+        glob.trailing_star = pattern.back() == '*';
+        size_t start = 0;
+        while (start <= pattern.size()) {
+            size_t star = pattern.find('*', start);
+            if (star == std::string::npos) {
+                star = pattern.size();
+            }
+            if (star > start) {
+                glob.segments.push_back(pattern.substr(start, star - start));
+            }
+            start = star + 1;
+        }
+        globs_.push_back(std::move(glob));
+    }
+
+    /// Match a segment at text[pos..], where `?` matches any one character
+    static bool SegmentAt(const std::string& segment, const std::string_view text, const size_t pos) {
+        if (pos + segment.size() > text.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < segment.size(); ++i) {
+            if (segment[i] != '?' && segment[i] != text[pos + i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static bool MatchesGlob(const Glob& glob, const std::string_view text) {
+        const std::vector<std::string>& segments = glob.segments;
+        size_t first = 0;
+        size_t last = segments.size();
+        size_t begin = 0;
+        size_t end = text.size();
+
+        if (!glob.leading_star) {
+            if (!SegmentAt(segments[0], text, 0)) {
+                return false;
+            }
+            begin = segments[0].size();
+            ++first;
+            if (first == last) {
+                return glob.trailing_star || begin == end;
+            }
+        }
+        if (!glob.trailing_star) {
+            const std::string& tail = segments[last - 1];
+            if (tail.size() > end - begin || !SegmentAt(tail, text, end - tail.size())) {
+                return false;
+            }
+            end -= tail.size();
+            --last;
+        }
+        // Leftmost placement of each middle segment leaves the most room for the rest
+        for (size_t s = first; s < last; ++s) {
+            const std::string& segment = segments[s];
+            while (begin + segment.size() <= end && !SegmentAt(segment, text, begin)) {
+                ++begin;
+            }
+            if (begin + segment.size() > end) {
+                return false;
+            }
+            begin += segment.size();
+        }
+        return true;
+    }
+
+    bool match_all_ = false;
+    std::vector<std::string> literals_;  ///< Sorted exact names
+    std::vector<std::string> prefixes_;  ///< From ``X*`` patterns
+    std::vector<std::string> suffixes_;  ///< From ``*X`` patterns
+    std::vector<Glob> globs_;
+};
+
 }  // namespace OESel
 
 #endif  // OESELECT_GLOB_MATCH_H
@@ -0,0 +1,171 @@
+/**
+ * @file lru_cache.h
+ * @brief Bounded, sharded, thread-safe LRU cache keyed by string.
+ *
+ * Keys are spread over a fixed number of shards by hash, and each shard has
+ * its own mutex and recency list, so concurrent lookups of different keys
+ * rarely contend. Values are immutable and handed out as shared pointers,
+ * so an evicted entry stays alive for as long as a caller still holds it.
+ *
+ * This header is private to the library (src/ only) and is not installed.
+ */
+
+#ifndef OESELECT_LRU_CACHE_H
+#define OESELECT_LRU_CACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace OESel {
+
+/**
+ * @brief String-keyed LRU cache of shared immutable values.
+ *
+ * Capacity is the total number of entries across all shards: it is split
+ * into per-shard limits of floor(capacity / kNumShards), with the remainder
+ * going one entry each to the first shards, so the limits sum to exactly
+ * the capacity. Below kNumShards entries some shards hold nothing and keys
+ * hashed to them are never cached. A capacity of zero disables the cache:
+ * lookups miss and inserts are dropped.
+ */
+template <typename Value>
+class ShardedLruCache {
+public:
+    using ValuePtr = std::shared_ptr<const Value>;
+
+    /// Number of independently locked shards
+    static constexpr size_t kNumShards = 16;
+
+    /**
+     * @brief Create a cache.
+     *
+     * :param capacity: Maximum number of entries across all shards.
+     */
+    explicit ShardedLruCache(const size_t capacity) { SetCapacity(capacity); }
+
+    ShardedLruCache(const ShardedLruCache&) = delete;
+    ShardedLruCache& operator=(const ShardedLruCache&) = delete;
+
+    /**
+     * @brief Look up a key and mark it most recently used.
+     *
+     * :param key: Key to find.
+     * :returns: The cached value, or null on a miss.
+     */
+    ValuePtr Find(const std::string& key) {
+        Shard& shard = ShardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        const auto it = shard.index.find(key);
+        if (it == shard.index.end()) {
+            misses_.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return it->second->second;
+    }
+
+    /**
+     * @brief Insert or replace a value, evicting the least recently used entries.
+     *
+     * :param key: Key to store.
+     * :param value: Value to share.
+     */
+    void Insert(const std::string& key, ValuePtr value) {
+        Shard& shard = ShardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (shard.limit == 0) {
+            return;
+        }
+        if (const auto it = shard.index.find(key); it != shard.index.end()) {
+            it->second->second = std::move(value);
+            shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+            return;
+        }
+        shard.entries.emplace_front(key, std::move(value));
+        shard.index.emplace(key, shard.entries.begin());
+        Trim(shard);
+    }
+
+    /**
+     * @brief Change the capacity, evicting entries that no longer fit.
+     *
+     * :param capacity: Maximum number of entries across all shards; 0 disables the cache.
+     */
+    void SetCapacity(const size_t capacity) {
+        capacity_.store(capacity, std::memory_order_relaxed);
+        for (size_t i = 0; i < kNumShards; ++i) {
+            Shard& shard = shards_[i];
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.limit = capacity / kNumShards + (i < capacity % kNumShards ? 1 : 0);
+            Trim(shard);
+        }
+    }
+
+    /// @brief Remove every entry and reset the hit and miss counters.
+    void Clear() {
+        for (Shard& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.index.clear();
+            shard.entries.clear();
+        }
+        hits_.store(0, std::memory_order_relaxed);
+        misses_.store(0, std::memory_order_relaxed);
+    }
+
+    /// @brief Configured total capacity.
+    [[nodiscard]] size_t Capacity() const { return capacity_.load(std::memory_order_relaxed); }
+
+    /// @brief Number of entries currently cached.
+    [[nodiscard]] size_t Size() {
+        size_t size = 0;
+        for (Shard& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            size += shard.index.size();
+        }
+        return size;
+    }
+
+    /// @brief Lookups that found a value.
+    [[nodiscard]] std::uint64_t Hits() const { return hits_.load(std::memory_order_relaxed); }
+
+    /// @brief Lookups that found nothing.
+    [[nodiscard]] std::uint64_t Misses() const { return misses_.load(std::memory_order_relaxed); }
+
+private:
+    using Entry = std::pair<std::string, ValuePtr>;
+
+    struct Shard {
+        std::mutex mutex;
+        std::list<Entry> entries;  ///< Most recently used first
+        std::unordered_map<std::string, typename std::list<Entry>::iterator> index;
+        size_t limit = 0;  ///< This shard's share of the capacity
+    };
+
+    Shard& ShardFor(const std::string& key) {
+        return shards_[std::hash<std::string>{}(key) % kNumShards];
+    }
+
+    static void Trim(Shard& shard) {
+        while (shard.index.size() > shard.limit) {
+            shard.index.erase(shard.entries.back().first);
+            shard.entries.pop_back();
+        }
+    }
+
+    Shard shards_[kNumShards];
+    std::atomic<size_t> capacity_{0};
+    std::atomic<std::uint64_t> hits_{0};
+    std::atomic<std::uint64_t> misses_{0};
+};
+
+}  // namespace OESel
+
+#endif  // OESELECT_LRU_CACHE_H
@@ -0,0 +1,436 @@
+/**
+ * @file range_kernels.cpp
+ * @brief AVX2, NEON and scalar comparison kernels with runtime dispatch.
+ */
+
+#include "range_kernels.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define OESEL_KERNELS_AVX2 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define OESEL_TARGET_AVX2
+#else
+#define OESEL_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define OESEL_KERNELS_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace OESel {
+namespace kernels {
+
+namespace {
+
+constexpr size_t kWordBits = 64;
+
+// ============================================================================
+// Scalar kernels
+// ============================================================================
+
+template<CompareOp Op, typename T>
+bool compare_one(const T value, const T first, const T last) {
+    if constexpr (Op == CompareOp::EQ) return value == first;
+    if constexpr (Op == CompareOp::LT) return value < first;
+    if constexpr (Op == CompareOp::LE) return value <= first;
+    if constexpr (Op == CompareOp::GT) return value > first;
+    if constexpr (Op == CompareOp::GE) return value >= first;
+    if constexpr (Op == CompareOp::RANGE) return value >= first && value <= last;
+}
+
+template<CompareOp Op, typename T>
+void scalar_rows(const T* values, const size_t begin, const size_t end,
+                 const T first, const T last, std::uint64_t* words) {
+    for (size_t i = begin; i < end; ++i) {
+        if (compare_one<Op>(values[i], first, last)) {
+            words[i / kWordBits] |= std::uint64_t{1} << (i % kWordBits);
+        }
+    }
+}
+
+/// Invoke a kernel template instantiated for the runtime operator.
+template<template<CompareOp> class Kernel, typename... Args>
+void dispatch_op(const CompareOp op, Args... args) {
+    switch (op) {
+        case CompareOp::EQ:    Kernel<CompareOp::EQ>::Run(args...); break;
+        case CompareOp::LT:    Kernel<CompareOp::LT>::Run(args...); break;
+        case CompareOp::LE:    Kernel<CompareOp::LE>::Run(args...); break;
+        case CompareOp::GT:    Kernel<CompareOp::GT>::Run(args...); break;
+        case CompareOp::GE:    Kernel<CompareOp::GE>::Run(args...); break;
+        case CompareOp::RANGE: Kernel<CompareOp::RANGE>::Run(args...); break;
+    }
+}
+
+template<CompareOp Op>
+struct ScalarKernel {
+    template<typename T>
+    static void Run(const T* values, const size_t count, const T first, const T last,
+                    std::uint64_t* words) {
+        scalar_rows<Op>(values, 0, count, first, last, words);
+    }
+};
+
+void scalar_mark_within(const float* cx, const float* cy, const float* cz,
+                        const size_t begin, const size_t end,
+                        const float* rx, const float* ry, const float* rz, const size_t ref_count,
+                        const float radius_sq, std::uint8_t* hits) {
+    for (size_t i = begin; i < end; ++i) {
+        if (hits[i] != 0) continue;
+        for (size_t j = 0; j < ref_count; ++j) {
+            const float dx = cx[i] - rx[j];
+            const float dy = cy[i] - ry[j];
+            const float dz = cz[i] - rz[j];
+            if (dx * dx + dy * dy + dz * dz < radius_sq) {
+                hits[i] = 1;
+                break;
+            }
+        }
+    }
+}
+
+// ============================================================================
+// AVX2 kernels (x86-64): 8 lanes per compare, 8 compares per output word
+// ============================================================================
+
+#if defined(OESEL_KERNELS_AVX2)
+
+bool cpu_has_avx2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+template<CompareOp Op>
+OESEL_TARGET_AVX2 inline __m256i avx2_compare_epi32(const __m256i v, const __m256i a, const __m256i b) {
+    const __m256i ones = _mm256_set1_epi32(-1);
+    if constexpr (Op == CompareOp::EQ) return _mm256_cmpeq_epi32(v, a);
+    if constexpr (Op == CompareOp::LT) return _mm256_cmpgt_epi32(a, v);
+    if constexpr (Op == CompareOp::LE) return _mm256_xor_si256(_mm256_cmpgt_epi32(v, a), ones);
+    if constexpr (Op == CompareOp::GT) return _mm256_cmpgt_epi32(v, a);
+    if constexpr (Op == CompareOp::GE) return _mm256_xor_si256(_mm256_cmpgt_epi32(a, v), ones);
+    if constexpr (Op == CompareOp::RANGE) {
+        const __m256i outside = _mm256_or_si256(_mm256_cmpgt_epi32(a, v), _mm256_cmpgt_epi32(v, b));
+        return _mm256_xor_si256(outside, ones);
+    }
+}
+
+template<CompareOp Op>
+OESEL_TARGET_AVX2 inline __m256 avx2_compare_ps(const __m256 v, const __m256 a, const __m256 b) {
+    if constexpr (Op == CompareOp::EQ) return _mm256_cmp_ps(v, a, _CMP_EQ_OQ);
+    if constexpr (Op == CompareOp::LT) return _mm256_cmp_ps(v, a, _CMP_LT_OQ);
+    if constexpr (Op == CompareOp::LE) return _mm256_cmp_ps(v, a, _CMP_LE_OQ);
+    if constexpr (Op == CompareOp::GT) return _mm256_cmp_ps(v, a, _CMP_GT_OQ);
+    if constexpr (Op == CompareOp::GE) return _mm256_cmp_ps(v, a, _CMP_GE_OQ);
+    if constexpr (Op == CompareOp::RANGE) {
+        return _mm256_and_ps(_mm256_cmp_ps(v, a, _CMP_GE_OQ), _mm256_cmp_ps(v, b, _CMP_LE_OQ));
+    }
+}
+
+template<CompareOp Op>
+struct Avx2IntKernel {
+    // Unsigned compares flip the sign bit so signed compares order correctly
+    template<typename T>
+    OESEL_TARGET_AVX2 static void Run(const T* values, const size_t count, const T first,
+                                      const T last, std::uint64_t* words) {
+        constexpr bool is_unsigned = static_cast<T>(-1) > T{0};
+        const __m256i bias = _mm256_set1_epi32(is_unsigned ? static_cast<int>(0x80000000u) : 0);
+        const __m256i a = _mm256_xor_si256(_mm256_set1_epi32(static_cast<int>(first)), bias);
+        const __m256i b = _mm256_xor_si256(_mm256_set1_epi32(static_cast<int>(last)), bias);
+
+        const size_t full = count / kWordBits * kWordBits;
+        for (size_t base = 0; base < full; base += kWordBits) {
+            std::uint64_t word = 0;
+            for (size_t lane = 0; lane < kWordBits; lane += 8) {
+                const __m256i raw = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + base + lane));
+                const __m256i m = avx2_compare_epi32<Op>(_mm256_xor_si256(raw, bias), a, b);
+                const auto bits = static_cast<unsigned int>(_mm256_movemask_ps(_mm256_castsi256_ps(m)));
+                word |= static_cast<std::uint64_t>(bits) << lane;
+            }
+            words[base / kWordBits] |= word;
+        }
+        scalar_rows<Op>(values, full, count, first, last, words);
+    }
+};
+
+template<CompareOp Op>
+struct Avx2FloatKernel {
+    OESEL_TARGET_AVX2 static void Run(const float* values, const size_t count, const float first,
+                                      const float last, std::uint64_t* words) {
+        const __m256 a = _mm256_set1_ps(first);
+        const __m256 b = _mm256_set1_ps(last);
+
+        const size_t full = count / kWordBits * kWordBits;
+        for (size_t base = 0; base < full; base += kWordBits) {
+            std::uint64_t word = 0;
+            for (size_t lane = 0; lane < kWordBits; lane += 8) {
+                const __m256 m = avx2_compare_ps<Op>(_mm256_loadu_ps(values + base + lane), a, b);
+                const auto bits = static_cast<unsigned int>(_mm256_movemask_ps(m));
+                word |= static_cast<std::uint64_t>(bits) << lane;
+            }
+            words[base / kWordBits] |= word;
+        }
+        scalar_rows<Op>(values, full, count, first, last, words);
+    }
+};
+
+/// True when all eight flags starting at @p hits are set
+bool all_hit8(const std::uint8_t* hits) {
+    std::uint64_t flags;
+    std::memcpy(&flags, hits, sizeof(flags));
+    return flags == 0x0101010101010101ULL;
+}
+
+/// Eight candidates per block against one broadcast reference at a time
+OESEL_TARGET_AVX2 void avx2_mark_within(const float* cx, const float* cy, const float* cz,
+                                        const size_t count, const float* rx, const float* ry,
+                                        const float* rz, const size_t ref_count,
+                                        const float radius_sq, std::uint8_t* hits) {
+    const __m256 r2 = _mm256_set1_ps(radius_sq);
+    const size_t full = count / 8 * 8;
+    for (size_t base = 0; base < full; base += 8) {
+        if (all_hit8(hits + base)) continue;
+        const __m256 x = _mm256_loadu_ps(cx + base);
+        const __m256 y = _mm256_loadu_ps(cy + base);
+        const __m256 z = _mm256_loadu_ps(cz + base);
+        int mask = 0;
+        for (size_t j = 0; j < ref_count && mask != 0xFF; ++j) {
+            const __m256 dx = _mm256_sub_ps(x, _mm256_set1_ps(rx[j]));
+            const __m256 dy = _mm256_sub_ps(y, _mm256_set1_ps(ry[j]));
+            const __m256 dz = _mm256_sub_ps(z, _mm256_set1_ps(rz[j]));
+            const __m256 d2 = _mm256_add_ps(
+                _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+            mask |= _mm256_movemask_ps(_mm256_cmp_ps(d2, r2, _CMP_LT_OQ));
+        }
+        for (size_t lane = 0; lane < 8; ++lane) {
+            if ((mask >> lane & 1) != 0) hits[base + lane] = 1;
+        }
+    }
+    scalar_mark_within(cx, cy, cz, full, count, rx, ry, rz, ref_count, radius_sq, hits);
+}
+
+#endif  // OESEL_KERNELS_AVX2
+
+// ============================================================================
+// NEON kernels (AArch64): 4 lanes per compare, 16 compares per output word
+// ============================================================================
+
+#if defined(OESEL_KERNELS_NEON)
+
+inline std::uint64_t neon_lane_bits(const uint32x4_t m) {
+    static const uint32_t kLaneWeights[4] = {1, 2, 4, 8};
+    return vaddvq_u32(vandq_u32(m, vld1q_u32(kLaneWeights)));
+}
+
+template<CompareOp Op>
+inline uint32x4_t neon_compare(const int32x4_t v, const int32x4_t a, const int32x4_t b) {
+    if constexpr (Op == CompareOp::EQ) return vceqq_s32(v, a);
+    if constexpr (Op == CompareOp::LT) return vcltq_s32(v, a);
+    if constexpr (Op == CompareOp::LE) return vcleq_s32(v, a);
+    if constexpr (Op == CompareOp::GT) return vcgtq_s32(v, a);
+    if constexpr (Op == CompareOp::GE) return vcgeq_s32(v, a);
+    if constexpr (Op == CompareOp::RANGE) return vandq_u32(vcgeq_s32(v, a), vcleq_s32(v, b));
+}
+
+template<CompareOp Op>
+inline uint32x4_t neon_compare(const uint32x4_t v, const uint32x4_t a, const uint32x4_t b) {
+    if constexpr (Op == CompareOp::EQ) return vceqq_u32(v, a);
+    if constexpr (Op == CompareOp::LT) return vcltq_u32(v, a);
+    if constexpr (Op == CompareOp::LE) return vcleq_u32(v, a);
+    if constexpr (Op == CompareOp::GT) return vcgtq_u32(v, a);
+    if constexpr (Op == CompareOp::GE) return vcgeq_u32(v, a);
+    if constexpr (Op == CompareOp::RANGE) return vandq_u32(vcgeq_u32(v, a), vcleq_u32(v, b));
+}
+
+template<CompareOp Op>
+inline uint32x4_t neon_compare(const float32x4_t v, const float32x4_t a, const float32x4_t b) {
+    if constexpr (Op == CompareOp::EQ) return vceqq_f32(v, a);
+    if constexpr (Op == CompareOp::LT) return vcltq_f32(v, a);
+    if constexpr (Op == CompareOp::LE) return vcleq_f32(v, a);
+    if constexpr (Op == CompareOp::GT) return vcgtq_f32(v, a);
+    if constexpr (Op == CompareOp::GE) return vcgeq_f32(v, a);
+    if constexpr (Op == CompareOp::RANGE) return vandq_u32(vcgeq_f32(v, a), vcleq_f32(v, b));
+}
+
+inline int32x4_t neon_load(const int* p) { return vld1q_s32(p); }
+inline uint32x4_t neon_load(const unsigned int* p) { return vld1q_u32(p); }
+inline float32x4_t neon_load(const float* p) { return vld1q_f32(p); }
+inline int32x4_t neon_splat(const int v) { return vdupq_n_s32(v); }
+inline uint32x4_t neon_splat(const unsigned int v) { return vdupq_n_u32(v); }
+inline float32x4_t neon_splat(const float v) { return vdupq_n_f32(v); }
+
+template<CompareOp Op>
+struct NeonKernel {
+    template<typename T>
+    static void Run(const T* values, const size_t count, const T first, const T last,
+                    std::uint64_t* words) {
+        const auto a = neon_splat(first);
+        const auto b = neon_splat(last);
+
+        const size_t full = count / kWordBits * kWordBits;
+        for (size_t base = 0; base < full; base += kWordBits) {
+            std::uint64_t word = 0;
+            for (size_t lane = 0; lane < kWordBits; lane += 4) {
+                const uint32x4_t m = neon_compare<Op>(neon_load(values + base + lane), a, b);
+                word |= neon_lane_bits(m) << lane;
+            }
+            words[base / kWordBits] |= word;
+        }
+        scalar_rows<Op>(values, full, count, first, last, words);
+    }
+};
+
+/// Four candidates per block against one broadcast reference at a time
+void neon_mark_within(const float* cx, const float* cy, const float* cz, const size_t count,
+                      const float* rx, const float* ry, const float* rz, const size_t ref_count,
+                      const float radius_sq, std::uint8_t* hits) {
+    const float32x4_t r2 = vdupq_n_f32(radius_sq);
+    const size_t full = count / 4 * 4;
+    for (size_t base = 0; base < full; base += 4) {
+        const float32x4_t x = vld1q_f32(cx + base);
+        const float32x4_t y = vld1q_f32(cy + base);
+        const float32x4_t z = vld1q_f32(cz + base);
+        std::uint64_t mask = 0;
+        for (size_t j = 0; j < ref_count && mask != 0xF; ++j) {
+            const float32x4_t dx = vsubq_f32(x, vdupq_n_f32(rx[j]));
+            const float32x4_t dy = vsubq_f32(y, vdupq_n_f32(ry[j]));
+            const float32x4_t dz = vsubq_f32(z, vdupq_n_f32(rz[j]));
+            const float32x4_t d2 = vaddq_f32(vaddq_f32(vmulq_f32(dx, dx), vmulq_f32(dy, dy)),
+                                             vmulq_f32(dz, dz));
+            mask |= neon_lane_bits(vcltq_f32(d2, r2));
+        }
+        for (size_t lane = 0; lane < 4; ++lane) {
+            if ((mask >> lane & 1) != 0) hits[base + lane] = 1;
+        }
+    }
+    scalar_mark_within(cx, cy, cz, full, count, rx, ry, rz, ref_count, radius_sq, hits);
+}
+
+#endif  // OESEL_KERNELS_NEON
+
+// ============================================================================
+// Runtime dispatch
+// ============================================================================
+
+enum class Backend { SCALAR, AVX2, NEON };
+
+Backend detect_backend() {
+#if defined(OESEL_KERNELS_AVX2)
+    if (cpu_has_avx2()) {
+        return Backend::AVX2;
+    }
+#elif defined(OESEL_KERNELS_NEON)
+    return Backend::NEON;  // NEON is mandatory on AArch64
+#endif
+    return Backend::SCALAR;
+}
+
+Backend active() {
+    static const Backend backend = detect_backend();
+    return backend;
+}
+
+}  // namespace
+
+void compare_int_scalar(const int* values, const size_t count, const CompareOp op,
+                        const int first, const int last, std::uint64_t* words) {
+    dispatch_op<ScalarKernel>(op, values, count, first, last, words);
+}
+
+void compare_uint_scalar(const unsigned int* values, const size_t count, const CompareOp op,
+                         const unsigned int first, const unsigned int last, std::uint64_t* words) {
+    dispatch_op<ScalarKernel>(op, values, count, first, last, words);
+}
+
+void compare_float_scalar(const float* values, const size_t count, const CompareOp op,
+                          const float first, const float last, std::uint64_t* words) {
+    dispatch_op<ScalarKernel>(op, values, count, first, last, words);
+}
+
+void compare_int(const int* values, const size_t count, const CompareOp op,
+                 const int first, const int last, std::uint64_t* words) {
+    switch (active()) {
+#if defined(OESEL_KERNELS_AVX2)
+        case Backend::AVX2: dispatch_op<Avx2IntKernel>(op, values, count, first, last, words); return;
+#endif
+#if defined(OESEL_KERNELS_NEON)
+        case Backend::NEON: dispatch_op<NeonKernel>(op, values, count, first, last, words); return;
+#endif
+        default: compare_int_scalar(values, count, op, first, last, words); return;
+    }
+}
+
+void compare_uint(const unsigned int* values, const size_t count, const CompareOp op,
+                  const unsigned int first, const unsigned int last, std::uint64_t* words) {
+    switch (active()) {
+#if defined(OESEL_KERNELS_AVX2)
+        case Backend::AVX2: dispatch_op<Avx2IntKernel>(op, values, count, first, last, words); return;
+#endif
+#if defined(OESEL_KERNELS_NEON)
+        case Backend::NEON: dispatch_op<NeonKernel>(op, values, count, first, last, words); return;
+#endif
+        default: compare_uint_scalar(values, count, op, first, last, words); return;
+    }
+}
+
+void compare_float(const float* values, const size_t count, const CompareOp op,
+                   const float first, const float last, std::uint64_t* words) {
+    switch (active()) {
+#if defined(OESEL_KERNELS_AVX2)
+        case Backend::AVX2: dispatch_op<Avx2FloatKernel>(op, values, count, first, last, words); return;
+#endif
+#if defined(OESEL_KERNELS_NEON)
+        case Backend::NEON: dispatch_op<NeonKernel>(op, values, count, first, last, words); return;
+#endif
+        default: compare_float_scalar(values, count, op, first, last, words); return;
+    }
+}
+
+void mark_within_scalar(const float* cx, const float* cy, const float* cz, const size_t count,
+                        const float* rx, const float* ry, const float* rz, const size_t ref_count,
+                        const float radius_sq, std::uint8_t* hits) {
+    scalar_mark_within(cx, cy, cz, 0, count, rx, ry, rz, ref_count, radius_sq, hits);
+}
+
+void mark_within(const float* cx, const float* cy, const float* cz, const size_t count,
+                 const float* rx, const float* ry, const float* rz, const size_t ref_count,
+                 const float radius_sq, std::uint8_t* hits) {
+    switch (active()) {
+#if defined(OESEL_KERNELS_AVX2)
+        case Backend::AVX2:
+            avx2_mark_within(cx, cy, cz, count, rx, ry, rz, ref_count, radius_sq, hits);
+            return;
+#endif
+#if defined(OESEL_KERNELS_NEON)
+        case Backend::NEON:
+            neon_mark_within(cx, cy, cz, count, rx, ry, rz, ref_count, radius_sq, hits);
+            return;
+#endif
+        default: mark_within_scalar(cx, cy, cz, count, rx, ry, rz, ref_count, radius_sq, hits); return;
+    }
+}
+
+const char* active_backend() {
+    switch (active()) {
+        case Backend::AVX2: return "avx2";
+        case Backend::NEON: return "neon";
+        case Backend::SCALAR: break;
+    }
+    return "scalar";
+}
+
+}  // namespace kernels
+}  // namespace OESel
@@ -0,0 +1,105 @@
+/**
+ * @file range_kernels.h
+ * @brief Vectorized comparison kernels for numeric atom table columns.
+ *
+ * Each column kernel compares a contiguous column against a predicate's
+ * operator and bounds and ORs the result into packed 64-bit bitset words.
+ * The distance kernel tests blocks of candidate coordinates against blocks
+ * of reference coordinates for the spatial index. The implementation is
+ * chosen once at runtime: AVX2 on x86-64 CPUs that support it, NEON on
+ * AArch64, and a portable scalar loop otherwise.
+ *
+ * This header is private to the library (src/ only) and is not installed.
+ */
+
+#ifndef OESELECT_RANGE_KERNELS_H
+#define OESELECT_RANGE_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace OESel {
+namespace kernels {
+
+/// Comparison operators shared by the numeric range predicates.
+enum class CompareOp { EQ, LT, LE, GT, GE, RANGE };
+
+/// Map a predicate's own Op enum (EQ, LT, LE, GT, GE, RANGE) onto CompareOp.
+template<typename Op>
+CompareOp to_compare_op(const Op op) {
+    switch (op) {
+        case Op::EQ:    return CompareOp::EQ;
+        case Op::LT:    return CompareOp::LT;
+        case Op::LE:    return CompareOp::LE;
+        case Op::GT:    return CompareOp::GT;
+        case Op::GE:    return CompareOp::GE;
+        case Op::RANGE: return CompareOp::RANGE;
+    }
+    return CompareOp::EQ;
+}
+
+/**
+ * @brief Set bits where an int column satisfies a comparison.
+ *
+ * :param values: Column of ``count`` values.
+ * :param count: Number of rows.
+ * :param op: Comparison operator.
+ * :param first: Comparison value, or range start for RANGE.
+ * :param last: Range end (inclusive) for RANGE; ignored otherwise.
+ * :param words: Bitset words receiving matches (bit ``i`` for row ``i``).
+ */
+void compare_int(const int* values, size_t count, CompareOp op, int first, int last,
+                 std::uint64_t* words);
+
+/// @brief Unsigned variant of compare_int().
+void compare_uint(const unsigned int* values, size_t count, CompareOp op,
+                  unsigned int first, unsigned int last, std::uint64_t* words);
+
+/// @brief Float variant of compare_int(); NaN never matches.
+void compare_float(const float* values, size_t count, CompareOp op, float first, float last,
+                   std::uint64_t* words);
+
+/**
+ * @brief Flag candidate points strictly within a radius of any reference point.
+ *
+ * Coordinates are structure-of-arrays blocks. The squared distance is
+ * accumulated in x, y, z order and compared with ``<``, matching the k-d
+ * tree's radius search. Flags that are already set are left untouched and
+ * their candidates may be skipped.
+ *
+ * :param cx: Candidate x coordinates (``count`` values; likewise ``cy``, ``cz``).
+ * :param count: Number of candidates.
+ * :param rx: Reference x coordinates (``ref_count`` values; likewise ``ry``, ``rz``).
+ * :param ref_count: Number of references.
+ * :param radius_sq: Squared distance threshold.
+ * :param hits: Per-candidate flags; set to 1 for each candidate within range.
+ */
+void mark_within(const float* cx, const float* cy, const float* cz, size_t count,
+                 const float* rx, const float* ry, const float* rz, size_t ref_count,
+                 float radius_sq, std::uint8_t* hits);
+
+/// @name Scalar reference implementations
+/// Always available; used as the fallback and to validate the vector paths.
+/// @{
+void compare_int_scalar(const int* values, size_t count, CompareOp op, int first, int last,
+                        std::uint64_t* words);
+void compare_uint_scalar(const unsigned int* values, size_t count, CompareOp op,
+                         unsigned int first, unsigned int last, std::uint64_t* words);
+void compare_float_scalar(const float* values, size_t count, CompareOp op, float first,
+                          float last, std::uint64_t* words);
+void mark_within_scalar(const float* cx, const float* cy, const float* cz, size_t count,
+                        const float* rx, const float* ry, const float* rz, size_t ref_count,
+                        float radius_sq, std::uint8_t* hits);
+/// @}
+
+/**
+ * @brief Name of the kernel implementation selected for this CPU.
+ *
+ * :returns: ``"avx2"``, ``"neon"`` or ``"scalar"``.
+ */
+const char* active_backend();
+
+}  // namespace kernels
+}  // namespace OESel
+
+#endif  // OESELECT_RANGE_KERNELS_H
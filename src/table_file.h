@@ -0,0 +1,137 @@
+/**
+ * @file table_file.h
+ * @brief Section reader and writer for the table cache file format.
+ *
+ * A table file is a fixed header followed by sections. Each section is a
+ * 16-byte descriptor (element count, element size) and a payload padded
+ * to 8 bytes, so every column starts aligned and the file holds no
+ * pointers. Sections are read back in the order they were written; the
+ * format version in the header pins that order.
+ *
+ * This header is private to the library (src/ only) and is not installed.
+ */
+
+#ifndef OESELECT_TABLE_FILE_H
+#define OESELECT_TABLE_FILE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "oeselect/Error.h"
+
+namespace OESel {
+
+/// Appends sections to an in-memory file image
+class TableFileWriter {
+public:
+    /// @brief Append a column of trivially copyable values.
+    template<typename T>
+    void Column(const std::vector<T>& values) {
+        static_assert(std::is_trivially_copyable_v<T>, "columns must be trivially copyable");
+        Raw(values.data(), values.size(), sizeof(T));
+    }
+
+    /// @brief Append a list of strings as an offset column and a character column.
+    void Strings(const std::vector<std::string>& values) {
+        std::vector<std::uint64_t> offsets{0};
+        std::vector<char> chars;
+        for (const std::string& value : values) {
+            chars.insert(chars.end(), value.begin(), value.end());
+            offsets.push_back(chars.size());
+        }
+        Column(offsets);
+        Column(chars);
+    }
+
+    /// @brief The sections written so far.
+    [[nodiscard]] const std::vector<char>& Bytes() const { return bytes_; }
+
+private:
+    void Raw(const void* data, const std::uint64_t count, const std::uint32_t size) {
+        const std::uint32_t reserved = 0;
+        Append(&count, sizeof(count));
+        Append(&size, sizeof(size));
+        Append(&reserved, sizeof(reserved));
+        Append(data, count * size);
+        bytes_.resize((bytes_.size() + 7) / 8 * 8, 0);
+    }
+
+    void Append(const void* data, const size_t size) {
+        if (size == 0) return;
+        const auto* begin = static_cast<const char*>(data);
+        bytes_.insert(bytes_.end(), begin, begin + size);
+    }
+
+    std::vector<char> bytes_;
+};
+
+/// Reads sections back from a file image, validating every bound
+class TableFileReader {
+public:
+    TableFileReader(const char* data, const size_t size)
+        : data_(data), size_(size) {}
+
+    /// @brief Read the next column into @p values.
+    /// @throws SelectionError if the section is truncated or has another element type.
+    template<typename T>
+    void Column(std::vector<T>& values) {
+        static_assert(std::is_trivially_copyable_v<T>, "columns must be trivially copyable");
+        std::uint64_t count = 0;
+        std::uint32_t size = 0;
+        std::uint32_t reserved = 0;
+        Read(&count, sizeof(count));
+        Read(&size, sizeof(size));
+        Read(&reserved, sizeof(reserved));
+        if (size != sizeof(T) || count > (size_ - pos_) / sizeof(T)) {
+            throw SelectionError("Table cache section is corrupt");
+        }
+        values.resize(count);
+        Read(values.data(), count * sizeof(T));
+        pos_ = std::min(size_, (pos_ + 7) / 8 * 8);
+    }
+
+    /// @brief Read a list of strings written by TableFileWriter::Strings().
+    void Strings(std::vector<std::string>& values) {
+        std::vector<std::uint64_t> offsets;
+        std::vector<char> chars;
+        Column(offsets);
+        Column(chars);
+        if (offsets.empty() || offsets.back() != chars.size()) {
+            throw SelectionError("Table cache section is corrupt");
+        }
+        values.clear();
+        values.reserve(offsets.size() - 1);
+        for (size_t i = 0; i + 1 < offsets.size(); ++i) {
+            if (offsets[i] > offsets[i + 1]) {
+                throw SelectionError("Table cache section is corrupt");
+            }
+            values.emplace_back(chars.data() + offsets[i], offsets[i + 1] - offsets[i]);
+        }
+    }
+
+    /// @brief Whether every byte has been consumed.
+    [[nodiscard]] bool AtEnd() const { return pos_ >= size_; }
+
+private:
+    void Read(void* out, const size_t size) {
+        if (size > size_ - pos_) {
+            throw SelectionError("Table cache file is truncated");
+        }
+        if (size != 0) {
+            std::memcpy(out, data_ + pos_, size);
+        }
+        pos_ += size;
+    }
+
+    const char* data_;
+    size_t size_;
+    size_t pos_ = 0;
+};
+
+}  // namespace OESel
+
+#endif  // OESELECT_TABLE_FILE_H
@@ -0,0 +1,147 @@
+/**
+ * @file thread_pool.cpp
+ * @brief Work-stealing thread pool implementation.
+ */
+
+#include "thread_pool.h"
+
+#include <algorithm>
+
+namespace OESel {
+
+namespace {
+/// Blocks handed to each worker per loop; more blocks give stealing finer granularity
+constexpr size_t kBlocksPerWorker = 8;
+}  // namespace
+
+WorkStealingPool::WorkStealingPool(const unsigned int num_workers)
+    : num_workers_(num_workers != 0 ? num_workers : std::max(1U, std::thread::hardware_concurrency())) {
+    for (unsigned int w = 0; w < num_workers_; ++w) {
+        queues_.push_back(std::make_unique<Queue>());
+    }
+    if (num_workers_ > 1) {
+        threads_.reserve(num_workers_);
+        for (unsigned int w = 0; w < num_workers_; ++w) {
+            threads_.emplace_back(&WorkStealingPool::WorkerLoop, this, w);
+        }
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        stop_ = true;
+    }
+    start_cv_.notify_all();
+    for (std::thread& thread : threads_) {
+        thread.join();
+    }
+}
+
+void WorkStealingPool::ParallelFor(const size_t count, const Task& task) {
+    std::lock_guard<std::mutex> run_lock(run_mutex_);
+    if (count == 0) {
+        return;
+    }
+    if (threads_.empty()) {
+        for (size_t i = 0; i < count; ++i) {
+            task(i, 0);
+        }
+        return;
+    }
+
+    // Deal contiguous runs of blocks to each worker so neighbouring items stay together
+    const size_t grain = std::max<size_t>(1, count / (num_workers_ * kBlocksPerWorker));
+    const size_t num_blocks = (count + grain - 1) / grain;
+    for (size_t b = 0; b < num_blocks; ++b) {
+        Queue& queue = *queues_[b * num_workers_ / num_blocks];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.blocks.emplace_back(b * grain, std::min(count, (b + 1) * grain));
+    }
+
+    error_ = nullptr;
+    failed_.store(false, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        task_ = &task;
+        running_ = num_workers_;
+        ++generation_;
+    }
+    start_cv_.notify_all();
+    {
+        std::unique_lock<std::mutex> lock(state_mutex_);
+        done_cv_.wait(lock, [this] { return running_ == 0; });
+        task_ = nullptr;
+    }
+    if (error_) {
+        std::rethrow_exception(error_);
+    }
+}
+
+void WorkStealingPool::WorkerLoop(const unsigned int worker) {
+    size_t seen = 0;
+    for (;;) {
+        const Task* task = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(state_mutex_);
+            start_cv_.wait(lock, [&] { return stop_ || generation_ != seen; });
+            if (stop_) {
+                return;
+            }
+            seen = generation_;
+            task = task_;
+        }
+        Drain(worker, *task);
+        {
+            std::lock_guard<std::mutex> lock(state_mutex_);
+            if (--running_ == 0) {
+                done_cv_.notify_all();
+            }
+        }
+    }
+}
+
+void WorkStealingPool::Drain(const unsigned int worker, const Task& task) {
+    Block block;
+    while (PopBlock(worker, block)) {
+        for (size_t i = block.first; i < block.second; ++i) {
+            if (failed_.load(std::memory_order_relaxed)) {
+                break;  // Skip the rest of the loop after a failure
+            }
+            try {
+                task(i, worker);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(error_mutex_);
+                if (!error_) {
+                    error_ = std::current_exception();
+                }
+                failed_.store(true, std::memory_order_relaxed);
+            }
+        }
+    }
+}
+
+bool WorkStealingPool::PopBlock(const unsigned int worker, Block& block) {
+    {
+        Queue& own = *queues_[worker];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.blocks.empty()) {
+            block = own.blocks.front();
+            own.blocks.pop_front();
+            return true;
+        }
+    }
+    // All blocks are queued before workers start, so empty queues everywhere means done
+    for (unsigned int offset = 1; offset < num_workers_; ++offset) {
+        Queue& victim = *queues_[(worker + offset) % num_workers_];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.blocks.empty()) {
+            block = victim.blocks.back();
+            victim.blocks.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace OESel
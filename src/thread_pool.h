@@ -0,0 +1,101 @@
+/**
+ * @file thread_pool.h
+ * @brief Work-stealing thread pool for batch evaluation.
+ *
+ * Each worker owns a deque of index blocks. Workers take blocks from the
+ * front of their own deque and, once it is empty, steal from the back of
+ * the others, so uneven per-item costs (a 100k-atom complex next to a
+ * 2k-atom one) even out without a shared queue on the hot path.
+ *
+ * This header is private to the library (src/ only) and is not installed.
+ */
+
+#ifndef OESELECT_THREAD_POOL_H
+#define OESELECT_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace OESel {
+
+/**
+ * @brief Fixed-size pool running indexed loops on persistent workers.
+ *
+ * A pool with one worker runs loops inline on the calling thread.
+ */
+class WorkStealingPool {
+public:
+    /// Loop body: receives the item index and the id of the worker running it.
+    using Task = std::function<void(size_t index, unsigned int worker)>;
+
+    /**
+     * @brief Start the workers.
+     *
+     * :param num_workers: Number of workers; 0 uses std::thread::hardware_concurrency().
+     */
+    explicit WorkStealingPool(unsigned int num_workers);
+
+    /// @brief Stop and join the workers.
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    /// @brief Number of workers (worker ids are 0 .. NumWorkers() - 1).
+    [[nodiscard]] unsigned int NumWorkers() const { return num_workers_; }
+
+    /**
+     * @brief Run @p task for every index in [0, count) and wait for completion.
+     *
+     * Calls from several threads are serialized. If a task throws, the
+     * remaining items are skipped and the first exception is rethrown here.
+     *
+     * :param count: Number of items.
+     * :param task: Loop body.
+     */
+    void ParallelFor(size_t count, const Task& task);
+
+private:
+    /// Half-open range of item indices
+    using Block = std::pair<size_t, size_t>;
+
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Block> blocks;
+    };
+
+    void WorkerLoop(unsigned int worker);
+    void Drain(unsigned int worker, const Task& task);
+    bool PopBlock(unsigned int worker, Block& block);
+
+    unsigned int num_workers_;
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> threads_;
+
+    std::mutex run_mutex_;  ///< Serializes ParallelFor()
+
+    std::mutex state_mutex_;
+    std::condition_variable start_cv_;
+    std::condition_variable done_cv_;
+    const Task* task_ = nullptr;
+    size_t generation_ = 0;
+    unsigned int running_ = 0;
+    bool stop_ = false;
+
+    std::atomic<bool> failed_{false};
+    std::mutex error_mutex_;
+    std::exception_ptr error_;  ///< First exception thrown by a task
+};
+
+}  // namespace OESel
+
+#endif  // OESELECT_THREAD_POOL_H
@@ -0,0 +1,106 @@
+/**
+ * @file verlet_list.cpp
+ * @brief Candidate pair lists re-measured across trajectory frames.
+ */
+
+#include "verlet_list.h"
+#include "oeselect/SpatialIndex.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace OESel {
+
+namespace {
+/// Shift a coordinate difference to its nearest periodic image; @p length 0 leaves it unchanged
+inline float minimum_image(const float d, const float length, const float inv_length) {
+    return d - length * std::nearbyint(d * inv_length);
+}
+}  // namespace
+
+float max_displacement(const std::vector<float>& from, const std::vector<float>& to, const UnitCell& cell) {
+    const size_t count = std::min(from.size(), to.size()) / 3;
+    const float* a = from.data();
+    const float* b = to.data();
+    float max_sq = 0.0f;
+    if (cell.IsPeriodic()) {
+        const float length[3] = {cell.Length(0), cell.Length(1), cell.Length(2)};
+        const float inv[3] = {1.0f / length[0], 1.0f / length[1], 1.0f / length[2]};
+        for (size_t i = 0; i < count; ++i) {
+            const float dx = minimum_image(b[3 * i] - a[3 * i], length[0], inv[0]);
+            const float dy = minimum_image(b[3 * i + 1] - a[3 * i + 1], length[1], inv[1]);
+            const float dz = minimum_image(b[3 * i + 2] - a[3 * i + 2], length[2], inv[2]);
+            max_sq = std::max(max_sq, dx * dx + dy * dy + dz * dz);
+        }
+    } else {
+        // Branch-free reduction over the interleaved layout, which compilers vectorize
+        for (size_t i = 0; i < count; ++i) {
+            const float dx = b[3 * i] - a[3 * i];
+            const float dy = b[3 * i + 1] - a[3 * i + 1];
+            const float dz = b[3 * i + 2] - a[3 * i + 2];
+            max_sq = std::max(max_sq, dx * dx + dy * dy + dz * dz);
+        }
+    }
+    return std::sqrt(max_sq);
+}
+
+bool VerletList::Covers(const Bitset& refs, const float radius, const float skin, const float displacement) const {
+    // Two atoms moving toward each other close the gap by twice the largest displacement
+    return frame_ && radius == radius_ && skin == skin_ && 2.0f * displacement <= skin_ && refs == refs_;
+}
+
+void VerletList::Build(const SpatialIndex& index, const Bitset& refs, const Bitset& atoms, const float radius,
+                       const float skin, FrameCoords frame) {
+    refs_ = refs;
+    radius_ = radius;
+    skin_ = skin;
+    frame_ = std::move(frame);
+    first_.clear();
+    second_.clear();
+    std::vector<float> distance_sq;
+    if (radius > 0.0f) {
+        index.FindPairs(refs, atoms, radius + skin, first_, second_, distance_sq);
+    }
+    within_.resize(first_.size());
+}
+
+void VerletList::Mark(const float* xyz, const UnitCell& cell, Bitset& out) const {
+    // A zero radius matches nothing, as in SpatialIndex::MarkWithinRadius()
+    if (!(radius_ > 0.0f)) return;
+    out |= refs_;
+
+    const float radius_sq = radius_ * radius_;
+    const size_t count = first_.size();
+    const unsigned int* first = first_.data();
+    const unsigned int* second = second_.data();
+    unsigned char* within = within_.data();
+    if (cell.IsPeriodic()) {
+        const float length[3] = {cell.Length(0), cell.Length(1), cell.Length(2)};
+        const float inv[3] = {1.0f / length[0], 1.0f / length[1], 1.0f / length[2]};
+        for (size_t k = 0; k < count; ++k) {
+            const float* a = xyz + 3 * size_t{first[k]};
+            const float* b = xyz + 3 * size_t{second[k]};
+            const float dx = minimum_image(b[0] - a[0], length[0], inv[0]);
+            const float dy = minimum_image(b[1] - a[1], length[1], inv[1]);
+            const float dz = minimum_image(b[2] - a[2], length[2], inv[2]);
+            within[k] = dx * dx + dy * dy + dz * dz < radius_sq;
+        }
+    } else {
+        // Distances first, without branches, so the loop vectorizes with gathers
+        for (size_t k = 0; k < count; ++k) {
+            const float* a = xyz + 3 * size_t{first[k]};
+            const float* b = xyz + 3 * size_t{second[k]};
+            const float dx = b[0] - a[0];
+            const float dy = b[1] - a[1];
+            const float dz = b[2] - a[2];
+            within[k] = dx * dx + dy * dy + dz * dz < radius_sq;
+        }
+    }
+    for (size_t k = 0; k < count; ++k) {
+        if (within[k]) {
+            out.Set(second[k]);
+        }
+    }
+}
+
+}  // namespace OESel
@@ -0,0 +1,89 @@
+/**
+ * @file verlet_list.h
+ * @brief Skin-padded candidate pair lists for distance predicates across frames.
+ *
+ * A VerletList records every (reference, target) pair closer than
+ * radius + skin when it is built. While no atom has moved more than
+ * skin / 2 since then, no pair outside the list can have come within the
+ * radius, so a new frame is answered by re-measuring the listed pairs
+ * instead of querying the spatial index.
+ *
+ * This header is private to the library (src/ only) and is not installed.
+ */
+
+#ifndef OESELECT_VERLET_LIST_H
+#define OESELECT_VERLET_LIST_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "oeselect/Bitset.h"
+#include "oeselect/UnitCell.h"
+
+namespace OESel {
+
+class SpatialIndex;
+
+/// Coordinates of one frame, 3 floats per atom index, shared by the lists built on it
+using FrameCoords = std::shared_ptr<const std::vector<float>>;
+
+/**
+ * @brief Largest distance any atom moved between two frames.
+ * @param from Coordinates of the earlier frame.
+ * @param to Coordinates of the later frame, of the same length.
+ * @param cell Periodic box; displacements are taken to the nearest image.
+ * @return Maximum displacement in Angstroms.
+ */
+float max_displacement(const std::vector<float>& from, const std::vector<float>& to, const UnitCell& cell);
+
+class VerletList {
+public:
+    /**
+     * @brief Whether the list answers a query on the current frame.
+     * @param refs Current reference atoms.
+     * @param radius Query radius.
+     * @param skin Current skin width.
+     * @param displacement Largest atom displacement since Frame().
+     */
+    [[nodiscard]] bool Covers(const Bitset& refs, float radius, float skin, float displacement) const;
+
+    /**
+     * @brief Collect the candidate pairs on the frame the index was built from.
+     * @param index Spatial index fitted to @p frame.
+     * @param refs Reference atoms.
+     * @param atoms Every atom of the molecule.
+     * @param radius Query radius.
+     * @param skin Padding added to the radius.
+     * @param frame Coordinates the index was fitted to.
+     */
+    void Build(const SpatialIndex& index, const Bitset& refs, const Bitset& atoms, float radius, float skin,
+               FrameCoords frame);
+
+    /**
+     * @brief Mark the atoms within the radius of a reference atom on a new frame.
+     * @param xyz Current coordinates, 3 floats per atom index.
+     * @param cell Periodic box for minimum-image distances.
+     * @param out Receives the reference atoms and every target closer than the radius.
+     */
+    void Mark(const float* xyz, const UnitCell& cell, Bitset& out) const;
+
+    /// @brief Coordinates the list was built on.
+    [[nodiscard]] const FrameCoords& Frame() const { return frame_; }
+
+    /// @brief Number of candidate pairs.
+    [[nodiscard]] size_t NumPairs() const { return first_.size(); }
+
+private:
+    Bitset refs_;
+    float radius_ = 0.0f;
+    float skin_ = 0.0f;
+    FrameCoords frame_;
+    std::vector<unsigned int> first_;   ///< Reference atom of each pair
+    std::vector<unsigned int> second_;  ///< Target atom of each pair
+    mutable std::vector<unsigned char> within_;  ///< Per-pair scratch for Mark()
+};
+
+}  // namespace OESel
+
+#endif  // OESELECT_VERLET_LIST_H
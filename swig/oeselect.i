@@ -5,6 +5,7 @@
 %{
 // Include all necessary headers
 #include "oeselect/oeselect.h"
+#include "oeselect/Bitset.h"
 #include "oeselect/Selection.h"
 #include "oeselect/Selector.h"
 #include "oeselect/Context.h"
@@ -12,10 +13,19 @@
 #include "oeselect/Error.h"
 #include "oeselect/ResidueSelector.h"
 #include "oeselect/CustomPredicates.h"
+#include "oeselect/SelectionSet.h"
+#include "oeselect/SelectionResult.h"
+#include "oeselect/Contacts.h"
+#include "oeselect/UnitCell.h"
+#include "oeselect/BatchEvaluator.h"
+#include "oeselect/Profile.h"
 
 #include <oechem.h>
 #include <oegrid.h>
 
+#include <cstdint>
+#include <cstring>
+
 using namespace OESel;
 %}
 
@@ -210,16 +220,8 @@ std::vector<unsigned int> EvaluateSelection(
     OEChem::OEMolBase& mol,
     const std::string& selection_str
 ) {
-    OESel::OESelection sele = OESel::OESelection::Parse(selection_str);
-    OESel::OESelect selector(mol, sele);
-
-    std::vector<unsigned int> result;
-    for (OESystem::OEIter<OEChem::OEAtomBase> atom = mol.GetAtoms(); atom; ++atom) {
-        if (selector(*atom)) {
-            result.push_back(atom->GetIdx());
-        }
-    }
-    return result;
+    const OESel::OESelection sele = OESel::OESelection::Parse(selection_str);
+    return sele.EvaluateMask(mol).ToIndices();
 }
 
 // Helper function to count atoms matching a selection
@@ -227,16 +229,109 @@ unsigned int CountSelection(
     OEChem::OEMolBase& mol,
     const std::string& selection_str
 ) {
-    OESel::OESelection sele = OESel::OESelection::Parse(selection_str);
-    OESel::OESelect selector(mol, sele);
+    const OESel::OESelection sele = OESel::OESelection::Parse(selection_str);
+    return static_cast<unsigned int>(sele.EvaluateMask(mol).Count());
+}
 
-    unsigned int count = 0;
-    for (OESystem::OEIter<OEChem::OEAtomBase> atom = mol.GetAtoms(); atom; ++atom) {
-        if (selector(*atom)) {
-            count++;
-        }
+// ---- Buffer-protocol results (wrapped by numpy.frombuffer without a copy) ----
+
+// Evaluate with the GIL released; rethrows with the GIL held again
+static OESel::Bitset _oeselect_evaluate_nogil(OEChem::OEMolBase& mol, const OESel::OESelection& sele) {
+    PyThreadState* thread_state = PyEval_SaveThread();
+    OESel::Bitset mask;
+    try {
+        mask = sele.EvaluateMask(mol);
+    } catch (...) {
+        PyEval_RestoreThread(thread_state);
+        throw;
+    }
+    PyEval_RestoreThread(thread_state);
+    return mask;
+}
+
+// Matching atom indices written straight into a bytearray of native uint32 values
+PyObject* SelectIndexBuffer(OEChem::OEMolBase& mol, const OESel::OESelection& sele) {
+    const OESel::Bitset mask = _oeselect_evaluate_nogil(mol, sele);
+    const size_t count = mask.Count();
+    PyObject* buffer = PyByteArray_FromStringAndSize(NULL, static_cast<Py_ssize_t>(count * sizeof(uint32_t)));
+    if (!buffer) {
+        return NULL;
+    }
+    uint32_t* out = reinterpret_cast<uint32_t*>(PyByteArray_AS_STRING(buffer));
+    mask.ForEachSet([&out](const size_t idx) { *out++ = static_cast<uint32_t>(idx); });
+    return buffer;
+}
+
+// One byte per atom index (0 or 1), sized to mol.GetMaxAtomIdx()
+PyObject* SelectMaskBuffer(OEChem::OEMolBase& mol, const OESel::OESelection& sele) {
+    const OESel::Bitset mask = _oeselect_evaluate_nogil(mol, sele);
+    PyObject* buffer = PyByteArray_FromStringAndSize(NULL, static_cast<Py_ssize_t>(mask.Size()));
+    if (!buffer) {
+        return NULL;
+    }
+    char* out = PyByteArray_AS_STRING(buffer);
+    std::memset(out, 0, mask.Size());
+    mask.ForEachSet([out](const size_t idx) { out[idx] = 1; });
+    return buffer;
+}
+
+// Members of a stored result as a bytearray of native uint32 values
+PyObject* ResultIndexBuffer(const OESel::OESelectionResult& result) {
+    PyObject* buffer = PyByteArray_FromStringAndSize(NULL, static_cast<Py_ssize_t>(result.Count() * sizeof(uint32_t)));
+    if (!buffer) {
+        return NULL;
     }
-    return count;
+    uint32_t* out = reinterpret_cast<uint32_t*>(PyByteArray_AS_STRING(buffer));
+    result.ForEach([&out](const size_t idx) { *out++ = static_cast<uint32_t>(idx); });
+    return buffer;
+}
+
+// One byte per atom index (0 or 1), sized to result.Size()
+PyObject* ResultMaskBuffer(const OESel::OESelectionResult& result) {
+    PyObject* buffer = PyByteArray_FromStringAndSize(NULL, static_cast<Py_ssize_t>(result.Size()));
+    if (!buffer) {
+        return NULL;
+    }
+    char* out = PyByteArray_AS_STRING(buffer);
+    std::memset(out, 0, result.Size());
+    result.ForEach([out](const size_t idx) { out[idx] = 1; });
+    return buffer;
+}
+
+// Copy a vector into a new bytearray of its native element values
+template <typename T>
+static PyObject* _oeselect_vector_buffer(const std::vector<T>& values) {
+    PyObject* buffer = PyByteArray_FromStringAndSize(NULL, static_cast<Py_ssize_t>(values.size() * sizeof(T)));
+    if (buffer && !values.empty()) {
+        std::memcpy(PyByteArray_AS_STRING(buffer), values.data(), values.size() * sizeof(T));
+    }
+    return buffer;
+}
+
+// Contact pairs as a (first, second, distance_sq) tuple of uint32, uint32 and float32 bytearrays
+PyObject* FindContactsBuffers(OEChem::OEMolBase& mol, const OESel::OESelection& first,
+                              const OESel::OESelection& second, float cutoff, bool per_residue) {
+    PyThreadState* thread_state = PyEval_SaveThread();
+    OESel::ContactList contacts;
+    try {
+        contacts = OESel::FindContacts(mol, first, second, cutoff,
+                                       per_residue ? OESel::ContactLevel::RESIDUE : OESel::ContactLevel::ATOM);
+    } catch (...) {
+        PyEval_RestoreThread(thread_state);
+        throw;
+    }
+    PyEval_RestoreThread(thread_state);
+    static_assert(sizeof(unsigned int) == sizeof(uint32_t), "contact indices must be 32-bit");
+    PyObject* a = _oeselect_vector_buffer(contacts.First());
+    PyObject* b = _oeselect_vector_buffer(contacts.Second());
+    PyObject* d = _oeselect_vector_buffer(contacts.DistanceSq());
+    if (!a || !b || !d) {
+        Py_XDECREF(a);
+        Py_XDECREF(b);
+        Py_XDECREF(d);
+        return NULL;
+    }
+    return Py_BuildValue("(NNN)", a, b, d);
 }
 %}
 
@@ -416,12 +511,73 @@ OE_CROSS_RUNTIME_REF_TYPEMAPS(OEDocking::OEReceptor, _oeselect_is_oereceptor, "E
     }
 }
 
+// ============================================================================
+// Molecule batches and GIL release for BatchEvaluator
+// ============================================================================
+// A Python sequence of OpenEye molecules becomes a vector of borrowed
+// pointers; the sequence keeps the molecules alive for the duration of the call.
+%typemap(in) const std::vector<OEChem::OEMolBase*>& (std::vector<OEChem::OEMolBase*> temp) {
+    PyObject* seq = PySequence_Fast($input, "Expected a sequence of OEMolBase objects.");
+    if (!seq) SWIG_fail;
+    const Py_ssize_t n = PySequence_Fast_GET_SIZE(seq);
+    temp.reserve(static_cast<size_t>(n));
+    for (Py_ssize_t i = 0; i < n; ++i) {
+        PyObject* item = PySequence_Fast_GET_ITEM(seq, i);
+        void* ptr = _oeselect_is_oemolbase(item) ? _oeselect_extract_swig_ptr(item) : NULL;
+        if (!ptr) {
+            Py_DECREF(seq);
+            SWIG_exception_fail(SWIG_TypeError, "Expected a sequence of OEMolBase objects.");
+        }
+        temp.push_back(reinterpret_cast<OEChem::OEMolBase*>(ptr));
+    }
+    Py_DECREF(seq);
+    $1 = &temp;
+}
+
+%typemap(typecheck, precedence=SWIG_TYPECHECK_POINTER) const std::vector<OEChem::OEMolBase*>& {
+    $1 = (PySequence_Check($input) && !PyUnicode_Check($input)) ? 1 : 0;
+}
+
+// Batch methods run entirely in C++ on worker threads, so release the GIL
+// around the call. Arguments are converted before and results after.
+%define OESELECT_RELEASE_GIL(METHOD)
+%exception METHOD {
+    PyThreadState* _oeselect_thread_state = PyEval_SaveThread();
+    try {
+        $action
+    } catch (const OESel::SelectionError& e) {
+        PyEval_RestoreThread(_oeselect_thread_state);
+        SWIG_exception(SWIG_ValueError, e.what());
+    } catch (const std::exception& e) {
+        PyEval_RestoreThread(_oeselect_thread_state);
+        SWIG_exception(SWIG_RuntimeError, e.what());
+    } catch (...) {
+        PyEval_RestoreThread(_oeselect_thread_state);
+        SWIG_exception(SWIG_RuntimeError, "Unknown C++ exception");
+    }
+    PyEval_RestoreThread(_oeselect_thread_state);
+}
+%enddef
+
+OESELECT_RELEASE_GIL(OESel::BatchEvaluator::EvaluateMasks)
+OESELECT_RELEASE_GIL(OESel::BatchEvaluator::Count)
+OESELECT_RELEASE_GIL(OESel::BatchEvaluator::Select)
+OESELECT_RELEASE_GIL(OESel::SelectionSet::EvaluateMasks)
+OESELECT_RELEASE_GIL(OESel::SelectionSet::Count)
+OESELECT_RELEASE_GIL(OESel::SelectionSet::Select)
+
 // ============================================================================
 // Template instantiations for container types
 // ============================================================================
 %template(UnsignedIntVector) std::vector<unsigned int>;
 %template(SelectorSet) std::set<OESel::Selector>;
 %template(StringSet) std::set<std::string>;
+%template(BitsetVector) std::vector<OESel::Bitset>;
+%template(BitsetVectorVector) std::vector<std::vector<OESel::Bitset> >;
+%template(UnsignedIntVectorVector) std::vector<std::vector<unsigned int> >;
+%template(UnsignedIntVectorVectorVector) std::vector<std::vector<std::vector<unsigned int> > >;
+%template(OESelectionVector) std::vector<OESel::OESelection>;
+%template(NodeProfileVector) std::vector<OESel::NodeProfile>;
 
 // ============================================================================
 // Version macros
@@ -444,7 +600,11 @@ enum class PredicateType {
     BY_RES, BY_CHAIN,
     AROUND, EXPAND, BEYOND,
     HELIX, SHEET, TURN, LOOP,
-    ALL_MATCH, NO_MATCH
+    ALL_MATCH, NO_MATCH,
+    LIPID, GLYCAN,
+    BOUND_TO, EXTEND,
+    NAMED_SET,
+    NEAREST
 };
 
 // ============================================================================
@@ -457,12 +617,118 @@ public:
     size_t Position() const;
 };
 
+// ============================================================================
+// Residue classification registry
+// ============================================================================
+enum class ComponentFlag : uint32_t {
+    NONE     = 0,
+    PROTEIN  = 1 << 0,
+    LIGAND   = 1 << 1,
+    SOLVENT  = 1 << 2,
+    COFACTOR = 1 << 3,
+    NUCLEIC  = 1 << 4,
+    WATER    = 1 << 5,
+    LIPID    = 1 << 6,
+    GLYCAN   = 1 << 7
+};
+
+class Tagger {
+public:
+    static ComponentFlag ClassifyResidueName(const char* resname);
+    static void RegisterResidueClass(const std::string& name, ComponentFlag flag);
+    static void LoadResidueClasses(const std::string& path);
+    static void ClearResidueClasses();
+    static uint64_t ResidueClassDigest();
+};
+
+// ============================================================================
+// Bitset - packed atom mask from bulk evaluation
+// ============================================================================
+class Bitset {
+public:
+    Bitset();
+    explicit Bitset(size_t size, bool value = false);
+
+    size_t Size() const;
+    bool Test(size_t idx) const;
+    size_t Count() const;
+    bool Any() const;
+    bool None() const;
+    std::vector<unsigned int> ToIndices() const;
+};
+
+// ============================================================================
+// OESelectionResult - compressed, combinable selection result
+// ============================================================================
+class OESelectionResult {
+public:
+    OESelectionResult();
+    explicit OESelectionResult(size_t size);
+    explicit OESelectionResult(const Bitset& mask);
+    static OESelectionResult FromIndices(size_t size, const std::vector<unsigned int>& indices);
+
+    size_t Size() const;
+    size_t Count() const;
+    bool Any() const;
+    bool None() const;
+    bool Contains(size_t idx) const;
+    OESelectionResult& AndNot(const OESelectionResult& other);
+    bool operator==(const OESelectionResult& other) const;
+    bool operator!=(const OESelectionResult& other) const;
+    std::vector<unsigned int> ToIndices() const;
+    Bitset ToBitset() const;
+    size_t MemoryUsage() const;
+};
+
+%extend OESelectionResult {
+    OESelectionResult __and__(const OESelectionResult& other) const { return *$self & other; }
+    OESelectionResult __or__(const OESelectionResult& other) const { return *$self | other; }
+    OESelectionResult __xor__(const OESelectionResult& other) const { return *$self ^ other; }
+    OESelectionResult __sub__(const OESelectionResult& other) const {
+        OESel::OESelectionResult difference = *$self;
+        difference.AndNot(other);
+        return difference;
+    }
+    size_t __len__() const { return $self->Count(); }
+    bool __contains__(size_t idx) const { return $self->Contains(idx); }
+
+%pythoncode %{
+def __repr__(self):
+    return f"OESelectionResult(size={self.Size()}, count={self.Count()})"
+
+def __iter__(self):
+    return iter(self.ToIndices())
+
+def ToArray(self):
+    """Member atom indices as a ``uint32`` NumPy array in ascending order."""
+    import numpy
+
+    return numpy.frombuffer(ResultIndexBuffer(self), dtype=numpy.uint32)
+
+def ToMask(self):
+    """Boolean NumPy mask with ``Size()`` entries, True for members."""
+    import numpy
+
+    return numpy.frombuffer(ResultMaskBuffer(self), dtype=numpy.bool_)
+%}
+}
+
 // ============================================================================
 // OESelection - immutable parsed selection
 // ============================================================================
+struct ParseCacheStats {
+    uint64_t hits;
+    uint64_t misses;
+    size_t size;
+    size_t capacity;
+};
+
 class OESelection {
 public:
     static OESelection Parse(const std::string& sele);
+    static void SetParseCacheCapacity(size_t capacity);
+    static void ClearParseCache();
+    static ParseCacheStats GetParseCacheStats();
 
     OESelection();
     OESelection(const OESelection& other);
@@ -471,6 +737,61 @@ public:
     std::string ToCanonical() const;
     bool ContainsPredicate(PredicateType type) const;
     bool IsEmpty() const;
+    Bitset EvaluateMask(OEChem::OEMolBase& mol) const;
+};
+
+// ============================================================================
+// UnitCell - periodic box for minimum-image distances
+// ============================================================================
+class UnitCell {
+public:
+    UnitCell();
+    static UnitCell Orthorhombic(float a, float b, float c);
+    bool IsPeriodic() const;
+    float Length(int axis) const;
+};
+
+%extend UnitCell {
+%pythoncode %{
+def __repr__(self):
+    if not self.IsPeriodic():
+        return "UnitCell()"
+    return f"UnitCell.Orthorhombic({self.Length(0):g}, {self.Length(1):g}, {self.Length(2):g})"
+
+def __eq__(self, other):
+    if not isinstance(other, UnitCell):
+        return NotImplemented
+    return all(self.Length(axis) == other.Length(axis) for axis in range(3))
+
+def __hash__(self):
+    return hash(tuple(self.Length(axis) for axis in range(3)))
+%}
+}
+
+// ============================================================================
+// EvaluationProfile - per-node evaluation statistics
+// ============================================================================
+struct NodeProfile {
+    std::string label;
+    PredicateType type;
+    unsigned int depth;
+    uint64_t evaluations;
+    double seconds;
+    double self_seconds;
+    uint64_t cache_hits;
+    uint64_t cache_misses;
+    uint64_t atoms_evaluated;
+    uint64_t atoms_matched;
+    uint64_t spatial_queries;
+
+    double Selectivity() const;
+};
+
+class EvaluationProfile {
+public:
+    EvaluationProfile();
+    const std::vector<NodeProfile>& Nodes() const;
+    std::string ToString() const;
 };
 
 // ============================================================================
@@ -486,6 +807,15 @@ public:
     bool operator()(const OEChem::OEAtomBase& atom) const;
     const OESelection& GetSelection() const;
     const OEChem::OEMolBase& GetMol() const;
+    const Bitset& GetMask() const;
+    void SetProfiling(bool enabled);
+    EvaluationProfile GetProfile() const;
+    void SetUnitCell(const UnitCell& cell);
+    UnitCell GetUnitCell() const;  // Returned by value so the proxy owns its copy
+    void SetNumThreads(unsigned int num_threads);
+    unsigned int GetNumThreads() const;
+    OESelectionResult GetResult() const;
+    void SetNamedSet(const std::string& name, const OESelectionResult& result);
 };
 
 // ============================================================================
@@ -524,6 +854,7 @@ public:
     ~OEResidueSelector();
 
     bool operator()(const OEChem::OEAtomBase& atom) const;
+    Bitset EvaluateMask(const OEChem::OEMolBase& mol) const;
 };
 
 // ============================================================================
@@ -551,6 +882,49 @@ public:
     bool operator()(const OEChem::OEAtomBase& atom) const;
 };
 
+class OEInSelectionResult {
+public:
+    explicit OEInSelectionResult(OESelectionResult result);
+    OEInSelectionResult(const OEInSelectionResult& other);
+    bool operator()(const OEChem::OEAtomBase& atom) const;
+    const OESelectionResult& GetResult() const;
+};
+
+// ============================================================================
+// SelectionSet - fused evaluation of many selections
+// ============================================================================
+class SelectionSet {
+public:
+    explicit SelectionSet(const std::vector<OESelection>& selections);
+    SelectionSet(const SelectionSet& other);
+    ~SelectionSet();
+
+    size_t Size() const;
+    const OESelection& GetSelection(size_t index) const;
+    const OESelection& GetMergedSelection() const;
+
+    std::vector<Bitset> EvaluateMasks(OEChem::OEMolBase& mol);
+    std::vector<unsigned int> Count(OEChem::OEMolBase& mol);
+    std::vector<std::vector<unsigned int> > Select(OEChem::OEMolBase& mol);
+};
+
+// ============================================================================
+// BatchEvaluator - parallel evaluation over many molecules
+// ============================================================================
+class BatchEvaluator {
+public:
+    explicit BatchEvaluator(std::vector<OESelection> selections, unsigned int num_threads = 0);
+    ~BatchEvaluator();
+
+    size_t NumSelections() const;
+    unsigned int NumThreads() const;
+
+    std::vector<std::vector<Bitset> > EvaluateMasks(const std::vector<OEChem::OEMolBase*>& mols);
+    std::vector<std::vector<unsigned int> > Count(const std::vector<OEChem::OEMolBase*>& mols);
+    std::vector<std::vector<unsigned int> > Count(OEChem::oemolistream& ifs);
+    std::vector<std::vector<std::vector<unsigned int> > > Select(const std::vector<OEChem::OEMolBase*>& mols);
+};
+
 // ============================================================================
 // Utility functions
 // ============================================================================
@@ -561,6 +935,7 @@ std::set<Selector> selector_set(OEChem::OEMolBase& mol, const std::string& selec
 std::set<Selector> selector_set(const OESelect& selector);
 std::set<std::string> str_selector_set(OEChem::OEMolBase& mol, const std::string& selection_str);
 std::string get_selector_string(const OEChem::OEAtomBase& atom);
+std::vector<Bitset> EvaluateConformers(OEChem::OEMCMolBase& mol, const OESelection& sele);
 
 } // namespace OESel
 
@@ -577,6 +952,13 @@ unsigned int CountSelection(
     const std::string& selection_str
 );
 
+PyObject* SelectIndexBuffer(OEChem::OEMolBase& mol, const OESel::OESelection& sele);
+PyObject* SelectMaskBuffer(OEChem::OEMolBase& mol, const OESel::OESelection& sele);
+PyObject* ResultIndexBuffer(const OESel::OESelectionResult& result);
+PyObject* ResultMaskBuffer(const OESel::OESelectionResult& result);
+PyObject* FindContactsBuffers(OEChem::OEMolBase& mol, const OESel::OESelection& first,
+                              const OESel::OESelection& second, float cutoff, bool per_residue);
+
 // ============================================================================
 // Python extensions for OESelection
 // ============================================================================
@@ -590,6 +972,29 @@ def __str__(self):
 %}
 }
 
+// ============================================================================
+// Python extensions for EvaluationProfile
+// ============================================================================
+%extend OESel::NodeProfile {
+%pythoncode %{
+def __repr__(self):
+    return f"NodeProfile('{self.label}', evaluations={self.evaluations}, seconds={self.seconds:.6f})"
+%}
+}
+
+%extend OESel::EvaluationProfile {
+%pythoncode %{
+def __str__(self):
+    return self.ToString()
+
+def __len__(self):
+    return len(self.Nodes())
+
+def __iter__(self):
+    return iter(self.Nodes())
+%}
+}
+
 // ============================================================================
 // Python extensions for OESelect
 // ============================================================================
@@ -656,6 +1061,72 @@ def count(mol, selection_str):
     """
     return CountSelection(mol, selection_str)
 
+def select_array(mol, sele):
+    """Evaluate a selection and return matching atom indices as a NumPy array.
+
+    The indices are written by C++ directly into the buffer the array wraps,
+    so no per-element conversion happens in Python. The GIL is released
+    while the selection is evaluated.
+
+    :param mol: An OpenEye OEMolBase object.
+    :param sele: PyMOL-style selection string or a pre-parsed OESelection.
+    :returns: ``numpy.ndarray`` of dtype ``uint32`` with ascending atom indices.
+
+    Example::
+
+        ca = select_array(mol, "name CA")
+        ca_coords = coords[ca]
+    """
+    import numpy
+
+    if isinstance(sele, str):
+        sele = OESelection.Parse(sele)
+    return numpy.frombuffer(SelectIndexBuffer(mol, sele), dtype=numpy.uint32)
+
+def select_mask(mol, sele):
+    """Evaluate a selection and return a boolean NumPy mask over atom indices.
+
+    :param mol: An OpenEye OEMolBase object.
+    :param sele: PyMOL-style selection string or a pre-parsed OESelection.
+    :returns: ``numpy.ndarray`` of dtype ``bool`` with ``mol.GetMaxAtomIdx()``
+        entries, True where the atom matches.
+    """
+    import numpy
+
+    if isinstance(sele, str):
+        sele = OESelection.Parse(sele)
+    return numpy.frombuffer(SelectMaskBuffer(mol, sele), dtype=numpy.bool_)
+
+def find_contacts(mol, first, second, cutoff, per_residue=False):
+    """Find atom pairs of two selections closer than a cutoff.
+
+    Pairs are collected in C++ into flat arrays and handed to NumPy without
+    per-pair Python objects. The GIL is released during the search.
+
+    :param mol: An OpenEye OEMolBase object.
+    :param first: Selection string or OESelection supplying the first atoms.
+    :param second: Selection string or OESelection supplying the second atoms.
+    :param cutoff: Maximum distance in Angstroms (exclusive).
+    :param per_residue: Report only the closest atom pair of each residue pair.
+    :returns: Tuple ``(i, j, d2)`` of ``uint32``, ``uint32`` and ``float32``
+        arrays: atom ``i[k]`` of ``first`` lies ``sqrt(d2[k])`` Angstroms
+        from atom ``j[k]`` of ``second``.
+
+    Example::
+
+        i, j, d2 = find_contacts(mol, "ligand", "protein", 4.0)
+    """
+    import numpy
+
+    if isinstance(first, str):
+        first = OESelection.Parse(first)
+    if isinstance(second, str):
+        second = OESelection.Parse(second)
+    i, j, d2 = FindContactsBuffers(mol, first, second, float(cutoff), bool(per_residue))
+    return (numpy.frombuffer(i, dtype=numpy.uint32),
+            numpy.frombuffer(j, dtype=numpy.uint32),
+            numpy.frombuffer(d2, dtype=numpy.float32))
+
 def parse(selection_str):
     """Parse a selection string and return an OESelection object.
 
@@ -0,0 +1,182 @@
+// tests/cpp/test_batch_evaluator.cpp
+// Unit tests for the parallel batch evaluator and its thread pool.
+
+#include <gtest/gtest.h>
+
+#include <oeselect/BatchEvaluator.h>
+#include <oechem.h>
+
+#include "test_molecules.h"
+#include "thread_pool.h"
+
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace OESel;
+using namespace OESelTest;
+
+namespace {
+std::vector<OESelection> make_selections() {
+    return {
+        OESelection::Parse("protein"),
+        OESelection::Parse("ligand around 4"),
+        OESelection::Parse("water and not (ligand around 3)"),
+        OESelection::Parse("byres (ligand around 5)"),
+    };
+}
+
+/// Titled complexes of varying size, owned by @p owned
+std::vector<OEChem::OEMolBase*> make_molecules(const unsigned int count, std::mt19937& rng,
+                                               std::vector<std::unique_ptr<OEChem::OEGraphMol>>& owned) {
+    std::vector<OEChem::OEMolBase*> mols;
+    for (unsigned int i = 0; i < count; ++i) {
+        owned.push_back(make_complex(rng, 2 + i % 9));
+        owned.back()->SetTitle(("complex" + std::to_string(i)).c_str());
+        mols.push_back(owned.back().get());
+    }
+    return mols;
+}
+
+/// Write molecules to a fresh OEB file in the test temporary directory
+std::string write_stream(const std::string& name, const std::vector<OEChem::OEMolBase*>& mols) {
+    const std::string path = ::testing::TempDir() + "oeselect_" + name + ".oeb";
+    OEChem::oemolostream ofs(path);
+    for (const OEChem::OEMolBase* mol : mols) {
+        OEChem::OEWriteMolecule(ofs, *mol);
+    }
+    ofs.close();
+    return path;
+}
+}  // namespace
+
+TEST(WorkStealingPoolTest, VisitsEveryIndexOnce) {
+    WorkStealingPool pool(4);
+    EXPECT_EQ(pool.NumWorkers(), 4U);
+    for (const size_t count : {size_t{0}, size_t{1}, size_t{7}, size_t{1000}}) {
+        std::vector<std::atomic<int>> visits(count);
+        pool.ParallelFor(count, [&](const size_t i, const unsigned int worker) {
+            EXPECT_LT(worker, 4U);
+            visits[i].fetch_add(1);
+        });
+        for (size_t i = 0; i < count; ++i) {
+            EXPECT_EQ(visits[i].load(), 1) << "count=" << count << " i=" << i;
+        }
+    }
+}
+
+TEST(WorkStealingPoolTest, RethrowsTaskException) {
+    for (const unsigned int workers : {1U, 3U}) {
+        WorkStealingPool pool(workers);
+        EXPECT_THROW(pool.ParallelFor(100, [](const size_t i, unsigned int) {
+            if (i == 42) throw std::runtime_error("boom");
+        }), std::runtime_error);
+
+        // The pool stays usable after a failed loop
+        std::atomic<size_t> total{0};
+        pool.ParallelFor(10, [&](const size_t i, unsigned int) { total += i; });
+        EXPECT_EQ(total.load(), 45U);
+    }
+}
+
+TEST(BatchEvaluatorTest, MatchesPerMoleculeEvaluation) {
+    std::mt19937 rng(3);
+    std::vector<std::unique_ptr<OEChem::OEGraphMol>> owned;
+    std::vector<OEChem::OEMolBase*> mols;
+    for (unsigned int i = 0; i < 40; ++i) {
+        owned.push_back(make_complex(rng, 2 + i % 9));
+        mols.push_back(owned.back().get());
+    }
+    const std::vector<OESelection> selections = make_selections();
+
+    for (const unsigned int threads : {1U, 4U}) {
+        BatchEvaluator batch(selections, threads);
+        EXPECT_EQ(batch.NumThreads(), threads);
+        ASSERT_EQ(batch.NumSelections(), selections.size());
+
+        const auto masks = batch.EvaluateMasks(mols);
+        const auto counts = batch.Count(mols);
+        const auto indices = batch.Select(mols);
+        ASSERT_EQ(masks.size(), mols.size());
+        ASSERT_EQ(counts.size(), mols.size());
+        ASSERT_EQ(indices.size(), mols.size());
+        for (size_t m = 0; m < mols.size(); ++m) {
+            ASSERT_EQ(masks[m].size(), selections.size());
+            for (size_t s = 0; s < selections.size(); ++s) {
+                const Bitset expected = selections[s].EvaluateMask(*mols[m]);
+                EXPECT_EQ(masks[m][s], expected) << "threads=" << threads << " m=" << m << " s=" << s;
+                EXPECT_EQ(counts[m][s], expected.Count());
+                EXPECT_EQ(indices[m][s], expected.ToIndices());
+            }
+        }
+    }
+}
+
+TEST(BatchEvaluatorTest, EmptyBatch) {
+    BatchEvaluator batch(make_selections(), 2);
+    EXPECT_TRUE(batch.Count(std::vector<OEChem::OEMolBase*>{}).empty());
+}
+
+TEST(BatchEvaluatorTest, StreamEvaluateMatchesPerMoleculeInOrder) {
+    std::mt19937 rng(6);
+    std::vector<std::unique_ptr<OEChem::OEGraphMol>> owned;
+    const std::vector<OESelection> selections = make_selections();
+
+    // 64 molecules fill one single-threaded chunk exactly; 150 span several chunks with a partial tail
+    for (const unsigned int count : {64U, 150U}) {
+        const std::vector<OEChem::OEMolBase*> mols = make_molecules(count, rng, owned);
+        const std::string path = write_stream("batch_stream", mols);
+        for (const unsigned int threads : {1U, 2U}) {
+            BatchEvaluator batch(selections, threads);
+            OEChem::oemolistream ifs(path);
+            size_t next = 0;
+            const size_t read = batch.Evaluate(ifs, [&](const size_t index, OEChem::OEMolBase& mol,
+                                                        const std::vector<Bitset>& masks) {
+                ASSERT_EQ(index, next++);
+                ASSERT_LT(index, mols.size());
+                EXPECT_STREQ(mol.GetTitle(), mols[index]->GetTitle());
+                EXPECT_EQ(mol.NumAtoms(), mols[index]->NumAtoms());
+                ASSERT_EQ(masks.size(), selections.size());
+                for (size_t s = 0; s < selections.size(); ++s) {
+                    EXPECT_EQ(masks[s], selections[s].EvaluateMask(*mols[index]))
+                        << "threads=" << threads << " m=" << index << " s=" << s;
+                }
+            });
+            EXPECT_EQ(read, mols.size());
+            EXPECT_EQ(next, mols.size());
+        }
+        std::remove(path.c_str());
+    }
+}
+
+TEST(BatchEvaluatorTest, StreamCountMatchesVectorCount) {
+    std::mt19937 rng(7);
+    std::vector<std::unique_ptr<OEChem::OEGraphMol>> owned;
+    const std::vector<OEChem::OEMolBase*> mols = make_molecules(90, rng, owned);
+    const std::string path = write_stream("batch_count", mols);
+
+    BatchEvaluator batch(make_selections(), 3);
+    OEChem::oemolistream ifs(path);
+    EXPECT_EQ(batch.Count(ifs), batch.Count(mols));
+    std::remove(path.c_str());
+}
+
+TEST(BatchEvaluatorTest, EmptyStream) {
+    const std::string path = write_stream("batch_empty", {});
+    BatchEvaluator batch(make_selections(), 2);
+    {
+        OEChem::oemolistream ifs(path);
+        size_t calls = 0;
+        EXPECT_EQ(batch.Evaluate(ifs, [&](size_t, OEChem::OEMolBase&, const std::vector<Bitset>&) { ++calls; }), 0u);
+        EXPECT_EQ(calls, 0u);
+    }
+    {
+        OEChem::oemolistream ifs(path);
+        EXPECT_TRUE(batch.Count(ifs).empty());
+    }
+    std::remove(path.c_str());
+}
@@ -0,0 +1,136 @@
+// tests/cpp/test_bitset.cpp
+// Unit tests for the packed Bitset used by bulk selection evaluation.
+
+#include <gtest/gtest.h>
+
+#include <oeselect/Bitset.h>
+
+using OESel::Bitset;
+
+TEST(BitsetTest, DefaultIsEmpty) {
+    const Bitset bits;
+    EXPECT_EQ(bits.Size(), 0u);
+    EXPECT_EQ(bits.Count(), 0u);
+    EXPECT_TRUE(bits.None());
+    EXPECT_FALSE(bits.Test(0));
+}
+
+TEST(BitsetTest, SetResetAndTest) {
+    Bitset bits(130);
+    bits.Set(0);
+    bits.Set(64);
+    bits.Set(129);
+    EXPECT_TRUE(bits.Test(0));
+    EXPECT_TRUE(bits.Test(64));
+    EXPECT_TRUE(bits.Test(129));
+    EXPECT_FALSE(bits.Test(1));
+    EXPECT_EQ(bits.Count(), 3u);
+
+    bits.Reset(64);
+    EXPECT_FALSE(bits.Test(64));
+    EXPECT_EQ(bits.Count(), 2u);
+}
+
+TEST(BitsetTest, OutOfRangeTestIsFalse) {
+    const Bitset bits(10, true);
+    EXPECT_TRUE(bits.Test(9));
+    EXPECT_FALSE(bits.Test(10));
+    EXPECT_FALSE(bits.Test(1000));
+}
+
+TEST(BitsetTest, FilledConstructorAndFlipRespectSize) {
+    Bitset bits(70, true);
+    EXPECT_EQ(bits.Count(), 70u);
+
+    bits.Flip();
+    EXPECT_EQ(bits.Count(), 0u);
+
+    bits.Flip();
+    EXPECT_EQ(bits.Count(), 70u);
+
+    bits.ResetAll();
+    EXPECT_TRUE(bits.None());
+
+    bits.SetAll();
+    EXPECT_EQ(bits.Count(), 70u);
+}
+
+TEST(BitsetTest, WordWideOperators) {
+    Bitset a(100);
+    Bitset b(100);
+    a.Set(1);
+    a.Set(2);
+    a.Set(99);
+    b.Set(2);
+    b.Set(3);
+    b.Set(99);
+
+    Bitset and_bits = a;
+    and_bits &= b;
+    EXPECT_EQ(and_bits.ToIndices(), (std::vector<unsigned int>{2, 99}));
+
+    Bitset or_bits = a;
+    or_bits |= b;
+    EXPECT_EQ(or_bits.ToIndices(), (std::vector<unsigned int>{1, 2, 3, 99}));
+
+    Bitset xor_bits = a;
+    xor_bits ^= b;
+    EXPECT_EQ(xor_bits.ToIndices(), (std::vector<unsigned int>{1, 3}));
+
+    Bitset diff = a;
+    diff.AndNot(b);
+    EXPECT_EQ(diff.ToIndices(), (std::vector<unsigned int>{1}));
+}
+
+TEST(BitsetTest, EqualityComparesSizeAndBits) {
+    Bitset a(8);
+    Bitset b(8);
+    EXPECT_EQ(a, b);
+
+    a.Set(3);
+    EXPECT_NE(a, b);
+
+    b.Set(3);
+    EXPECT_EQ(a, b);
+
+    EXPECT_NE(Bitset(8), Bitset(9));
+}
+
+TEST(BitsetTest, ToIndicesAscending) {
+    Bitset bits(200);
+    for (const unsigned int idx : {199u, 0u, 63u, 64u, 128u}) {
+        bits.Set(idx);
+    }
+    EXPECT_EQ(bits.ToIndices(), (std::vector<unsigned int>{0, 63, 64, 128, 199}));
+}
+
+TEST(BitsetTest, SetRangeWithinAndAcrossWords) {
+    Bitset bits(200);
+    bits.SetRange(3, 6);
+    EXPECT_EQ(bits.ToIndices(), (std::vector<unsigned int>{3, 4, 5}));
+
+    bits.ResetAll();
+    bits.SetRange(60, 130);
+    EXPECT_EQ(bits.Count(), 70u);
+    EXPECT_FALSE(bits.Test(59));
+    EXPECT_TRUE(bits.Test(60));
+    EXPECT_TRUE(bits.Test(129));
+    EXPECT_FALSE(bits.Test(130));
+
+    bits.ResetAll();
+    bits.SetRange(5, 5);
+    EXPECT_TRUE(bits.None());
+
+    bits.SetRange(0, 200);
+    EXPECT_EQ(bits.Count(), 200u);
+}
+
+TEST(BitsetTest, ForEachSetMatchesToIndices) {
+    Bitset bits(200);
+    for (const unsigned int idx : {0u, 5u, 63u, 64u, 130u, 199u}) {
+        bits.Set(idx);
+    }
+    std::vector<unsigned int> visited;
+    bits.ForEachSet([&](const size_t idx) { visited.push_back(static_cast<unsigned int>(idx)); });
+    EXPECT_EQ(visited, bits.ToIndices());
+}
@@ -0,0 +1,152 @@
+// tests/cpp/test_bond_graph.cpp
+// Unit tests for the CSR bond graph and bond-graph selection operators.
+
+#include <gtest/gtest.h>
+
+#include <oeselect/oeselect.h>
+#include <oeselect/predicates/ExpansionPredicates.h>
+#include <oechem.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace OESel;
+
+namespace {
+/// Alanine, water, ethanol, and thiol with explicit hydrogens; one atom deleted
+void make_molecule(OEChem::OEGraphMol& mol) {
+    OEChem::OESmilesToMol(mol, "CC(N)C(=O)O.O.CCO.CS");
+    OEChem::OEAddExplicitHydrogens(mol);
+    for (OESystem::OEIter<OEChem::OEAtomBase> atom = mol.GetAtoms(); atom; ++atom) {
+        OEChem::OEResidue res;
+        res.SetName(atom->GetIdx() < 6 ? "ALA" : "LIG");
+        OEChem::OEAtomSetResidue(&(*atom), res);
+    }
+    // Leave a hole in the atom indices
+    for (OESystem::OEIter<OEChem::OEAtomBase> atom = mol.GetAtoms(); atom; ++atom) {
+        if (atom->GetAtomicNum() == 1 && atom->GetIdx() > 12) {
+            mol.DeleteAtom(&(*atom));
+            break;
+        }
+    }
+}
+
+/// Sorted neighbour indices of an atom by walking its OEChem bonds
+std::vector<unsigned int> walk_neighbors(const OEChem::OEAtomBase& atom) {
+    std::vector<unsigned int> neighbors;
+    for (OESystem::OEIter<OEChem::OEBondBase> bond = atom.GetBonds(); bond; ++bond) {
+        neighbors.push_back(bond->GetNbr(&atom)->GetIdx());
+    }
+    std::sort(neighbors.begin(), neighbors.end());
+    return neighbors;
+}
+
+/// Indices of hydrogens bonded to an atom of one of the given elements
+std::vector<unsigned int> bonded_hydrogens(OEChem::OEMolBase& mol, const std::vector<unsigned int>& elements) {
+    std::vector<unsigned int> result;
+    for (OESystem::OEIter<OEChem::OEAtomBase> atom = mol.GetAtoms(); atom; ++atom) {
+        if (atom->GetAtomicNum() != 1) continue;
+        for (OESystem::OEIter<OEChem::OEBondBase> bond = atom->GetBonds(); bond; ++bond) {
+            const unsigned int nbr = bond->GetNbr(&(*atom))->GetAtomicNum();
+            if (std::find(elements.begin(), elements.end(), nbr) != elements.end()) {
+                result.push_back(atom->GetIdx());
+                break;
+            }
+        }
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+std::vector<unsigned int> select(OEChem::OEMolBase& mol, const std::string& text) {
+    return OESelection::Parse(text).EvaluateMask(mol).ToIndices();
+}
+}  // namespace
+
+TEST(BondGraphTest, MatchesBondWalk) {
+    OEChem::OEGraphMol mol;
+    make_molecule(mol);
+    const BondGraph graph(mol);
+    ASSERT_EQ(graph.Size(), mol.GetMaxAtomIdx());
+    ASSERT_EQ(graph.Offsets().size(), graph.Size() + 1);
+    EXPECT_EQ(graph.Neighbors().size(), 2 * mol.NumBonds());
+    EXPECT_EQ(graph.NeighborAtomicNumbers().size(), graph.Neighbors().size());
+
+    std::vector<char> present(graph.Size(), 0);
+    for (OESystem::OEIter<OEChem::OEAtomBase> atom = mol.GetAtoms(); atom; ++atom) {
+        const unsigned int idx = atom->GetIdx();
+        present[idx] = 1;
+        EXPECT_EQ(graph.AtomicNumbers()[idx], atom->GetAtomicNum());
+
+        std::vector<unsigned int> neighbors(graph.Neighbors().begin() + graph.Offsets()[idx],
+                                            graph.Neighbors().begin() + graph.Offsets()[idx + 1]);
+        std::sort(neighbors.begin(), neighbors.end());
+        EXPECT_EQ(neighbors, walk_neighbors(*atom)) << "atom " << idx;
+        EXPECT_EQ(graph.Degree(idx), neighbors.size());
+        for (std::uint32_t k = graph.Offsets()[idx]; k < graph.Offsets()[idx + 1]; ++k) {
+            EXPECT_EQ(graph.NeighborAtomicNumbers()[k], graph.AtomicNumbers()[graph.Neighbors()[k]]);
+        }
+    }
+    for (size_t idx = 0; idx < graph.Size(); ++idx) {
+        if (!present[idx]) {
+            EXPECT_EQ(graph.Degree(idx), 0u);
+            EXPECT_EQ(graph.AtomicNumbers()[idx], 0u);
+        }
+    }
+    EXPECT_FALSE(graph.AnyNeighbor(graph.Size() + 3, [](unsigned int) { return true; }));
+}
+
+TEST(BondGraphTest, BondWalkingPredicatesMatchReference) {
+    OEChem::OEGraphMol mol;
+    make_molecule(mol);
+    EXPECT_EQ(select(mol, "polarh"), bonded_hydrogens(mol, {7, 8, 16}));
+    EXPECT_EQ(select(mol, "apolarh"), bonded_hydrogens(mol, {6}));
+    ASSERT_FALSE(select(mol, "polarh").empty());
+
+    // Bulk and per-atom paths agree
+    for (const char* text : {"polarh", "apolarh", "organic"}) {
+        const OESelection sele = OESelection::Parse(text);
+        Context ctx(mol, sele);
+        std::vector<unsigned int> per_atom;
+        for (OESystem::OEIter<OEChem::OEAtomBase> atom = mol.GetAtoms(); atom; ++atom) {
+            if (sele.Root().Evaluate(ctx, *atom)) {
+                per_atom.push_back(atom->GetIdx());
+            }
+        }
+        EXPECT_EQ(per_atom, sele.EvaluateMask(mol).ToIndices()) << text;
+    }
+}
+
+TEST(BondGraphTest, BoundToSelectsBondedNeighbors) {
+    OEChem::OEGraphMol mol;
+    OEChem::OESmilesToMol(mol, "CCCCCC");
+    EXPECT_EQ(select(mol, "bound_to index 0"), (std::vector<unsigned int>{1}));
+    EXPECT_EQ(select(mol, "bound_to index 2"), (std::vector<unsigned int>{1, 3}));
+    EXPECT_EQ(select(mol, "bound_to (index 0 or index 1)"), (std::vector<unsigned int>{0, 1, 2}));
+    EXPECT_EQ(select(mol, "not (bound_to index 0)"), (std::vector<unsigned int>{0, 2, 3, 4, 5}));
+    EXPECT_TRUE(select(mol, "bound_to none").empty());
+
+    const OESelection sele = OESelection::Parse("BOUND_TO index 0");
+    EXPECT_EQ(sele.Root().Type(), PredicateType::BOUND_TO);
+    EXPECT_EQ(sele.ToCanonical(), "bound_to index 0");
+}
+
+TEST(BondGraphTest, ExtendGrowsSelectionAlongBonds) {
+    OEChem::OEGraphMol mol;
+    OEChem::OESmilesToMol(mol, "CCCCCC.O");
+    EXPECT_EQ(select(mol, "index 0 extend 0"), (std::vector<unsigned int>{0}));
+    EXPECT_EQ(select(mol, "index 0 extend 2"), (std::vector<unsigned int>{0, 1, 2}));
+    EXPECT_EQ(select(mol, "index 2 extend 1"), (std::vector<unsigned int>{1, 2, 3}));
+    EXPECT_EQ(select(mol, "(index 0 or index 5) extend 1"), (std::vector<unsigned int>{0, 1, 4, 5}));
+    // The search stops at the end of the connected component
+    EXPECT_EQ(select(mol, "index 0 extend 1000"), (std::vector<unsigned int>{0, 1, 2, 3, 4, 5}));
+    EXPECT_EQ(select(mol, "byres (index 6 extend 3)"), select(mol, "byres index 6"));
+
+    const OESelection sele = OESelection::Parse("index 0 EXTEND 2");
+    ASSERT_EQ(sele.Root().Type(), PredicateType::EXTEND);
+    EXPECT_EQ(static_cast<const ExtendPredicate&>(sele.Root()).Bonds(), 2u);
+    EXPECT_EQ(OESelection::Parse(sele.ToCanonical()).ToCanonical(), sele.ToCanonical());
+    EXPECT_THROW(static_cast<void>(OESelection::Parse("index 0 extend")), SelectionError);
+    EXPECT_THROW(static_cast<void>(OESelection::Parse("index 0 extend 1.5")), SelectionError);
+}
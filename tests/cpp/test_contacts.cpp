@@ -0,0 +1,120 @@
+// tests/cpp/test_contacts.cpp
+// Unit tests for contact pair search.
+
+#include <gtest/gtest.h>
+
+#include <oeselect/oeselect.h>
+#include <oechem.h>
+
+#include "test_molecules.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <random>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+using namespace OESel;
+using namespace OESelTest;
+
+namespace {
+/// All (i, j, d²) pairs with i in first, j in second, i != j, and d < cutoff
+std::vector<std::tuple<unsigned int, unsigned int, float>> brute_force(
+    OEChem::OEMolBase& mol, const Bitset& first, const Bitset& second, const float cutoff) {
+    std::vector<std::tuple<unsigned int, unsigned int, float>> pairs;
+    for (OESystem::OEIter<OEChem::OEAtomBase> a = mol.GetAtoms(); a; ++a) {
+        if (!first.Test(a->GetIdx())) continue;
+        float ca[3];
+        mol.GetCoords(&*a, ca);
+        for (OESystem::OEIter<OEChem::OEAtomBase> b = mol.GetAtoms(); b; ++b) {
+            if (a->GetIdx() == b->GetIdx() || !second.Test(b->GetIdx())) continue;
+            float cb[3];
+            mol.GetCoords(&*b, cb);
+            const float dx = ca[0] - cb[0];
+            const float dy = ca[1] - cb[1];
+            const float dz = ca[2] - cb[2];
+            const float d2 = dx * dx + dy * dy + dz * dz;
+            if (d2 < cutoff * cutoff) {
+                pairs.emplace_back(a->GetIdx(), b->GetIdx(), d2);
+            }
+        }
+    }
+    return pairs;
+}
+}  // namespace
+
+TEST(ContactsTest, AtomPairsMatchBruteForce) {
+    std::mt19937 rng(5);
+    auto mol = make_complex(rng, 40);
+    for (const auto& [a, b] : std::vector<std::pair<const char*, const char*>>{
+             {"ligand", "protein"}, {"protein", "protein"}, {"water", "ligand"}, {"", "name CA"},
+             {"ligand around 6", "water"}}) {
+        const OESelection first = OESelection::Parse(a);
+        const OESelection second = OESelection::Parse(b);
+        for (const float cutoff : {0.0f, 2.5f, 4.0f}) {
+            const ContactList contacts = FindContacts(*mol, first, second, cutoff);
+            const auto expected =
+                brute_force(*mol, first.EvaluateMask(*mol), second.EvaluateMask(*mol), cutoff);
+            ASSERT_EQ(contacts.Size(), expected.size()) << a << " / " << b << " cutoff=" << cutoff;
+            EXPECT_EQ(contacts.Second().size(), contacts.Size());
+            EXPECT_EQ(contacts.DistanceSq().size(), contacts.Size());
+            for (size_t k = 0; k < expected.size(); ++k) {
+                EXPECT_EQ(contacts.First()[k], std::get<0>(expected[k]));
+                EXPECT_EQ(contacts.Second()[k], std::get<1>(expected[k]));
+                EXPECT_FLOAT_EQ(contacts.DistanceSq()[k], std::get<2>(expected[k]));
+            }
+        }
+    }
+}
+
+TEST(ContactsTest, ResidueLevelKeepsClosestPairPerResiduePair) {
+    std::mt19937 rng(9);
+    auto mol = make_complex(rng, 30);
+    const OESelection ligand = OESelection::Parse("ligand");
+    const OESelection protein = OESelection::Parse("protein");
+
+    const ContactList atoms = FindContacts(*mol, ligand, protein, 5.0f);
+    const ContactList residues = FindContacts(*mol, ligand, protein, 5.0f, ContactLevel::RESIDUE);
+    ASSERT_FALSE(atoms.Empty());
+
+    const AtomTable table(*mol);
+    const auto& groups = table.ResidueGroups();
+    std::map<std::pair<std::uint32_t, std::uint32_t>, float> closest;
+    for (size_t k = 0; k < atoms.Size(); ++k) {
+        const auto key = std::make_pair(groups[atoms.First()[k]], groups[atoms.Second()[k]]);
+        const auto [it, inserted] = closest.try_emplace(key, atoms.DistanceSq()[k]);
+        if (!inserted) {
+            it->second = std::min(it->second, atoms.DistanceSq()[k]);
+        }
+    }
+
+    // Residue pairs in the order of their first atom contact
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> discovered;
+    for (size_t k = 0; k < atoms.Size(); ++k) {
+        const auto key = std::make_pair(groups[atoms.First()[k]], groups[atoms.Second()[k]]);
+        if (std::find(discovered.begin(), discovered.end(), key) == discovered.end()) {
+            discovered.push_back(key);
+        }
+    }
+
+    ASSERT_EQ(residues.Size(), closest.size());
+    for (size_t k = 0; k < residues.Size(); ++k) {
+        const auto key = std::make_pair(groups[residues.First()[k]], groups[residues.Second()[k]]);
+        ASSERT_TRUE(closest.count(key));
+        EXPECT_FLOAT_EQ(residues.DistanceSq()[k], closest[key]);
+        EXPECT_EQ(key, discovered[k]);
+    }
+}
+
+TEST(ContactsTest, RejectsInvalidCutoff) {
+    std::mt19937 rng(1);
+    auto mol = make_complex(rng, 4);
+    const OESelection all = OESelection::Parse("");
+    EXPECT_THROW(static_cast<void>(FindContacts(*mol, all, all, -1.0f)), SelectionError);
+    EXPECT_THROW(static_cast<void>(FindContacts(*mol, all, all, std::nanf(""))), SelectionError);
+    EXPECT_TRUE(FindContacts(*mol, all, all, 0.0f).Empty());
+}
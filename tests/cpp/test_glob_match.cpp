@@ -1,10 +1,16 @@
 // tests/cpp/test_glob_match.cpp
-// Unit tests for the portable match_glob helper used by Name/Resn predicates.
+// Unit tests for the portable match_glob helper and the compiled GlobMatcher
+// used by Name/Resn predicates.
 
 #include <gtest/gtest.h>
 
 #include "glob_match.h"
 
+#include <random>
+#include <string>
+#include <vector>
+
+using OESel::GlobMatcher;
 using OESel::match_glob;
 
 TEST(GlobMatch, ExactStringMatches) {
@@ -59,3 +65,39 @@ TEST(GlobMatch, BiologicalAtomNames) {
     EXPECT_TRUE(match_glob("HD?", "HD2"));
     EXPECT_FALSE(match_glob("HD?", "HE1"));
 }
+
+TEST(GlobMatcher, MatchesAnyPattern) {
+    const GlobMatcher matcher({"CA", "N", "H*", "*G", "C?*1", "O*X*"});
+    for (const char* name : {"CA", "N", "H", "HB2", "CG", "OG", "CD1", "CZ11", "OXT", "OAXB"}) {
+        EXPECT_TRUE(matcher.Matches(name)) << name;
+    }
+    for (const char* name : {"", "C", "CB", "NZ", "GC", "C1", "O", "OAB"}) {
+        EXPECT_FALSE(matcher.Matches(name)) << name;
+    }
+    EXPECT_TRUE(GlobMatcher({"**"}).Matches(""));
+    EXPECT_TRUE(GlobMatcher({""}).Matches(""));
+    EXPECT_FALSE(GlobMatcher({}).Matches(""));
+}
+
+TEST(GlobMatcher, AgreesWithMatchGlob) {
+    // Random patterns over a tiny alphabet hit every compiled form and overlap case
+    std::mt19937 rng(11);
+    const std::string pattern_chars = "AB*?";
+    const std::string text_chars = "AB";
+    auto random_string = [&](const std::string& alphabet, const size_t max_len) {
+        std::string value(std::uniform_int_distribution<size_t>(0, max_len)(rng), ' ');
+        for (char& c : value) {
+            c = alphabet[std::uniform_int_distribution<size_t>(0, alphabet.size() - 1)(rng)];
+        }
+        return value;
+    };
+    for (int trial = 0; trial < 2000; ++trial) {
+        const std::string pattern = random_string(pattern_chars, 5);
+        const GlobMatcher matcher({pattern});
+        for (int t = 0; t < 8; ++t) {
+            const std::string text = random_string(text_chars, 6);
+            EXPECT_EQ(matcher.Matches(text), match_glob(pattern, text))
+                << "pattern='" << pattern << "' text='" << text << "'";
+        }
+    }
+}
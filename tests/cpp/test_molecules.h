@@ -0,0 +1,91 @@
+// tests/cpp/test_molecules.h
+// Toy protein-ligand complexes shared by the unit tests.
+
+#ifndef OESELECT_TEST_MOLECULES_H
+#define OESELECT_TEST_MOLECULES_H
+
+#include <oechem.h>
+
+#include <memory>
+#include <random>
+
+namespace OESelTest {
+
+/// Shape of a generated complex; the defaults give the small complex most tests use
+struct ComplexSpec {
+    unsigned int num_residues = 10;  ///< ALA residues of five atoms (N, CA, C, O, CB)
+    unsigned int num_chains = 1;     ///< Protein chains A, B, ... in contiguous blocks of residues
+    unsigned int num_ligands = 1;    ///< LIG residues of three atoms (C1, C2, O1) in chain L
+    unsigned int num_waters = 5;     ///< HOH residues of one atom in chain W
+    float min_coord = -8.0f;         ///< Coordinates are uniform in [min_coord, max_coord) per axis
+    float max_coord = 8.0f;
+    bool bfactors = false;           ///< Draw a B-factor in [0, 100) after each atom's coordinates
+    bool bonds = false;              ///< Bond the residues' heavy atoms (C=O double)
+};
+
+/// Append a complex of the given shape to @p mol, drawing coordinates from @p rng
+inline void build_complex(OEChem::OEMolBase& mol, std::mt19937& rng, const ComplexSpec& spec) {
+    std::uniform_real_distribution<float> dist(spec.min_coord, spec.max_coord);
+    std::uniform_real_distribution<float> bfactor(0.0f, 100.0f);
+    auto add_atom = [&](const char* name, const char* resname, const int resnum, const char chain) {
+        OEChem::OEAtomBase* atom = mol.NewAtom(name[0] == 'O' ? 8 : (name[0] == 'N' ? 7 : 6));
+        atom->SetName(name);
+        float coords[3] = {dist(rng), dist(rng), dist(rng)};
+        mol.SetCoords(atom, coords);
+        OEChem::OEResidue res;
+        res.SetName(resname);
+        res.SetResidueNumber(resnum);
+        res.SetChainID(chain);
+        if (spec.bfactors) {
+            res.SetBFactor(bfactor(rng));
+        }
+        OEChem::OEAtomSetResidue(atom, res);
+        return atom;
+    };
+    for (unsigned int r = 1; r <= spec.num_residues; ++r) {
+        const auto chain = static_cast<char>('A' + (r - 1) * spec.num_chains / spec.num_residues);
+        const int resnum = static_cast<int>(r);
+        OEChem::OEAtomBase* n = add_atom("N", "ALA", resnum, chain);
+        OEChem::OEAtomBase* ca = add_atom("CA", "ALA", resnum, chain);
+        OEChem::OEAtomBase* c = add_atom("C", "ALA", resnum, chain);
+        OEChem::OEAtomBase* o = add_atom("O", "ALA", resnum, chain);
+        OEChem::OEAtomBase* cb = add_atom("CB", "ALA", resnum, chain);
+        if (spec.bonds) {
+            mol.NewBond(n, ca);
+            mol.NewBond(ca, c);
+            mol.NewBond(c, o, 2);
+            mol.NewBond(ca, cb);
+        }
+    }
+    for (unsigned int l = 1; l <= spec.num_ligands; ++l) {
+        OEChem::OEAtomBase* c1 = add_atom("C1", "LIG", static_cast<int>(l), 'L');
+        OEChem::OEAtomBase* c2 = add_atom("C2", "LIG", static_cast<int>(l), 'L');
+        OEChem::OEAtomBase* o1 = add_atom("O1", "LIG", static_cast<int>(l), 'L');
+        if (spec.bonds) {
+            mol.NewBond(c1, c2);
+            mol.NewBond(c1, o1);
+        }
+    }
+    for (unsigned int w = 1; w <= spec.num_waters; ++w) {
+        add_atom("O", "HOH", static_cast<int>(w), 'W');
+    }
+}
+
+/// Build a complex of the given shape
+inline std::unique_ptr<OEChem::OEGraphMol> make_complex(std::mt19937& rng, const ComplexSpec& spec) {
+    auto mol = std::make_unique<OEChem::OEGraphMol>();
+    build_complex(*mol, rng, spec);
+    return mol;
+}
+
+/// Build the standard toy complex: a run of ALA residues, one LIG residue, and half as many waters
+inline std::unique_ptr<OEChem::OEGraphMol> make_complex(std::mt19937& rng, const unsigned int num_residues) {
+    ComplexSpec spec;
+    spec.num_residues = num_residues;
+    spec.num_waters = num_residues / 2;
+    return make_complex(rng, spec);
+}
+
+}  // namespace OESelTest
+
+#endif  // OESELECT_TEST_MOLECULES_H
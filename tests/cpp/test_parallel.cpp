@@ -0,0 +1,131 @@
+// tests/cpp/test_parallel.cpp
+// Unit tests for multi-threaded evaluation of one large molecule.
+
+#include <gtest/gtest.h>
+
+#include <oeselect/oeselect.h>
+#include <oechem.h>
+
+#include "test_molecules.h"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace OESel;
+using namespace OESelTest;
+
+namespace {
+/// Residues of five atoms needed to pass Context::kParallelMinAtoms
+constexpr unsigned int kNumResidues = 13500;
+
+/// Build a solvated complex large enough to be split across threads
+std::unique_ptr<OEChem::OEGraphMol> make_large_complex(std::mt19937& rng) {
+    ComplexSpec spec;
+    spec.num_residues = kNumResidues;
+    spec.num_chains = 6;
+    spec.num_ligands = 20;
+    spec.num_waters = kNumResidues / 4;
+    spec.min_coord = 0.0f;
+    spec.max_coord = 80.0f;
+    spec.bfactors = true;
+    return make_complex(rng, spec);
+}
+
+/// Mask indices of a selection evaluated with the given thread count
+std::vector<unsigned int> select(OEChem::OEMolBase& mol, const std::string& text, const unsigned int threads,
+                                 const UnitCell& cell = UnitCell()) {
+    OESelect sel(mol, text);
+    sel.SetUnitCell(cell);
+    sel.SetNumThreads(threads);
+    return sel.GetMask().ToIndices();
+}
+}  // namespace
+
+TEST(ParallelTest, ThreadCountResolvesAndIsCopied) {
+    OEChem::OEGraphMol mol;
+    OESelect sel(mol, "protein");
+    EXPECT_EQ(sel.GetNumThreads(), 1u);
+    sel.SetNumThreads(3);
+    EXPECT_EQ(sel.GetNumThreads(), 3u);
+    const OESelect copy(sel);
+    EXPECT_EQ(copy.GetNumThreads(), 3u);
+    sel.SetNumThreads(0);
+    EXPECT_GE(sel.GetNumThreads(), 1u);
+}
+
+TEST(ParallelTest, ChunksAreCacheLineAligned) {
+    std::mt19937 rng(3);
+    auto mol = make_large_complex(rng);
+    const OESelection sele = OESelection::Parse("protein");
+    Context ctx(*mol, sele);
+    ctx.SetNumThreads(4);
+
+    const size_t count = Context::kParallelMinAtoms + 1000;
+    std::mutex mutex;
+    std::vector<std::pair<size_t, size_t>> chunks;
+    ctx.ForEachChunk(count, [&](const size_t begin, const size_t end, const unsigned int worker) {
+        EXPECT_LT(worker, 4u);
+        const std::lock_guard<std::mutex> lock(mutex);
+        chunks.emplace_back(begin, end);
+    });
+    std::sort(chunks.begin(), chunks.end());
+    ASSERT_EQ(chunks.size(), (count + Context::kChunkAtoms - 1) / Context::kChunkAtoms);
+    size_t next = 0;
+    for (const auto& [begin, end] : chunks) {
+        EXPECT_EQ(begin, next);
+        EXPECT_EQ(begin % Context::kChunkAtoms, 0u);
+        next = end;
+    }
+    EXPECT_EQ(next, count);
+
+    // Small ranges run inline as one chunk
+    chunks.clear();
+    ctx.ForEachChunk(100, [&](const size_t begin, const size_t end, const unsigned int worker) {
+        EXPECT_EQ(worker, 0u);
+        chunks.emplace_back(begin, end);
+    });
+    EXPECT_EQ(chunks, (std::vector<std::pair<size_t, size_t>>{{0, 100}}));
+}
+
+TEST(ParallelTest, MasksMatchSingleThreaded) {
+    std::mt19937 rng(7);
+    auto mol = make_large_complex(rng);
+    ASSERT_GE(mol->NumAtoms(), Context::kParallelMinAtoms);
+    for (const char* text : {"protein", "name CA", "resn ALA and chain B", "resi 100-2000", "b > 50",
+                             "water or ligand", "ligand around 5", "water beyond 6", "ligand expand 4",
+                             "ligand around 12", "byres (ligand around 4)", "bychain (ligand around 2)",
+                             "byres (b < 1)"}) {
+        const std::vector<unsigned int> expected = select(*mol, text, 1);
+        EXPECT_EQ(select(*mol, text, 4), expected) << text;
+        EXPECT_FALSE(expected.empty()) << text;
+    }
+}
+
+TEST(ParallelTest, PeriodicAndTrajectoryMatchSingleThreaded) {
+    std::mt19937 rng(11);
+    auto mol = make_large_complex(rng);
+    const UnitCell cell = UnitCell::Orthorhombic(80.0f, 80.0f, 80.0f);
+    for (const char* text : {"ligand around 5", "water beyond 3", "ligand around 10"}) {
+        EXPECT_EQ(select(*mol, text, 4, cell), select(*mol, text, 1, cell)) << text;
+    }
+
+    OESelect serial(*mol, "byres (ligand around 4)");
+    OESelect parallel(*mol, "byres (ligand around 4)");
+    parallel.SetNumThreads(4);
+    ASSERT_EQ(parallel.GetMask().ToIndices(), serial.GetMask().ToIndices());
+
+    // A new frame rebins the index in place
+    std::vector<float> xyz(static_cast<size_t>(mol->GetMaxAtomIdx()) * 3);
+    mol->GetCoords(xyz.data());
+    for (float& x : xyz) {
+        x += 1.5f;
+    }
+    parallel.SetFrame(xyz.data());
+    serial.SetFrame(xyz.data());
+    EXPECT_EQ(parallel.GetMask().ToIndices(), serial.GetMask().ToIndices());
+}
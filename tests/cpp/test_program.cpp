@@ -0,0 +1,140 @@
+// tests/cpp/test_program.cpp
+// Unit tests for compiled selection programs.
+
+#include <gtest/gtest.h>
+
+#include <oeselect/oeselect.h>
+#include <oechem.h>
+
+#include "test_molecules.h"
+
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace OESel;
+using namespace OESelTest;
+
+namespace {
+/// Evaluate by walking the optimized tree, bypassing the compiled program
+Bitset evaluate_tree(OEChem::OEMolBase& mol, const OESelection& sele) {
+    Context ctx(mol, sele);
+    Bitset mask(mol.GetMaxAtomIdx());
+    sele.Root().EvaluateAll(ctx, mask);
+    return mask;
+}
+}  // namespace
+
+TEST(SelectionProgramTest, MatchesTreeEvaluation) {
+    std::mt19937 rng(11);
+    auto mol = make_complex(rng, 12);
+    // Deleted atoms leave holes that complements must not fill
+    OEChem::OEAtomBase* hole = nullptr;
+    for (OESystem::OEIter<OEChem::OEAtomBase> atom = mol->GetAtoms(); atom; ++atom) {
+        if (atom->GetIdx() == 7) {
+            hole = &*atom;
+        }
+    }
+    ASSERT_NE(hole, nullptr);
+    mol->DeleteAtom(hole);
+
+    const std::vector<std::string> selections = {
+        "all",
+        "none",
+        "name CA",
+        "not name CA",
+        "name CA and resi 2-5",
+        "chain A and not (name CA or name CB)",
+        "name CA or name N or elem O",
+        "all or name CA",
+        "name XX and chain A",
+        "name CA xor resi 3",
+        "name CA xor name CB xor chain A",
+        "(name CA or resn LIG) and not (resi 1 xor chain L)",
+        "not (chain A and not resn HOH)",
+        "protein and (ligand around 4)",
+        "byres (ligand around 3) and not ligand",
+        "water or (bychain resn LIG) or none",
+        "(name C* and not elem O) xor (resi < 4 or resi > 9)",
+    };
+    for (const std::string& text : selections) {
+        const OESelection sele = OESelection::Parse(text);
+        const Bitset expected = evaluate_tree(*mol, sele);
+        EXPECT_EQ(sele.EvaluateMask(*mol), expected) << text << "\n" << sele.GetProgram().ToString();
+
+        OESelect sel(*mol, sele);
+        EXPECT_EQ(sel.GetMask(), expected) << text;
+    }
+}
+
+TEST(SelectionProgramTest, ReusesContextAcrossMolecules) {
+    std::mt19937 rng(5);
+    const OESelection sele = OESelection::Parse("(name CA or name CB) and not (ligand around 5) and chain A");
+    std::unique_ptr<OEChem::OEGraphMol> first = make_complex(rng, 3);
+    Context ctx(*first, sele);
+    for (const unsigned int size : {3U, 20U, 1U, 20U}) {
+        auto mol = make_complex(rng, size);
+        ctx.Reset(*mol);
+        Bitset mask(mol->GetMaxAtomIdx());
+        ctx.EvaluateSelection(mask);
+        EXPECT_EQ(mask, evaluate_tree(*mol, sele)) << "residues=" << size;
+    }
+}
+
+TEST(SelectionProgramTest, CompilesLogicalNodesInline) {
+    const OESelection sele = OESelection::Parse("name CA and not resn HOH and chain A");
+    const SelectionProgram& program = sele.GetProgram();
+    EXPECT_EQ(program.NumRegisters(), 2U);
+
+    // Three leaf loads, two short-circuit exits, and the negation folded into and_not
+    std::map<OpCode, int> ops;
+    for (const Instruction& ins : program.Instructions()) {
+        ++ops[ins.op];
+    }
+    EXPECT_EQ(program.Instructions().size(), 7U) << program.ToString();
+    EXPECT_EQ(program.Instructions().front().op, OpCode::LOAD);
+    EXPECT_EQ(ops[OpCode::LOAD], 3);
+    EXPECT_EQ(ops[OpCode::JUMP_IF_NONE], 2);
+    EXPECT_EQ(ops[OpCode::AND], 1);
+    EXPECT_EQ(ops[OpCode::AND_NOT], 1);
+    EXPECT_EQ(ops[OpCode::NOT], 0);
+    for (const Instruction& ins : program.Instructions()) {
+        if (ins.op == OpCode::JUMP_IF_NONE) {
+            EXPECT_EQ(ins.target, program.Instructions().size());
+        }
+    }
+    EXPECT_NE(program.ToString().find("and_not r0, r1"), std::string::npos) << program.ToString();
+}
+
+TEST(SelectionProgramTest, DistanceConjunctsLoadWithinTheirDomain) {
+    const OESelection sele = OESelection::Parse("resn HOH and not (resn LIG around 3) and (resn LIG expand 5)");
+    const SelectionProgram& program = sele.GetProgram();
+    std::map<OpCode, int> ops;
+    for (const Instruction& ins : program.Instructions()) {
+        ++ops[ins.op];
+        if (ins.op == OpCode::LOAD_WITHIN) {
+            EXPECT_EQ(ins.src, 0U);
+            EXPECT_EQ(ins.dst, 1U);
+        }
+    }
+    // The leading conjunct loads in full; both distance conjuncts search only its atoms
+    EXPECT_EQ(program.Instructions().front().op, OpCode::LOAD) << program.ToString();
+    EXPECT_EQ(ops[OpCode::LOAD], 1) << program.ToString();
+    EXPECT_EQ(ops[OpCode::LOAD_WITHIN], 2) << program.ToString();
+    EXPECT_EQ(ops[OpCode::AND_NOT], 1);
+    EXPECT_NE(program.ToString().find("load_within r1, r0, resn LIG around 3"), std::string::npos)
+        << program.ToString();
+
+    std::mt19937 rng(19);
+    auto mol = make_complex(rng, 10);
+    EXPECT_EQ(sele.EvaluateMask(*mol), evaluate_tree(*mol, sele));
+}
+
+TEST(SelectionProgramTest, ConstantsNeedNoLoads) {
+    const OESelection empty;
+    ASSERT_EQ(empty.GetProgram().Instructions().size(), 1U);
+    EXPECT_EQ(empty.GetProgram().Instructions()[0].op, OpCode::LOAD_ALL);
+    EXPECT_EQ(empty.GetProgram().ToString(), "0: load_all r0\n");
+}
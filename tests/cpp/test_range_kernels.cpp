@@ -0,0 +1,142 @@
+// tests/cpp/test_range_kernels.cpp
+// Unit tests for the vectorized column comparison kernels.
+
+#include <gtest/gtest.h>
+
+#include "range_kernels.h"
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace OESel::kernels;
+
+namespace {
+const CompareOp kAllOps[] = {
+    CompareOp::EQ, CompareOp::LT, CompareOp::LE, CompareOp::GT, CompareOp::GE, CompareOp::RANGE};
+
+std::vector<std::uint64_t> empty_words(const size_t count) {
+    return std::vector<std::uint64_t>((count + 63) / 64, 0);
+}
+
+bool bit(const std::vector<std::uint64_t>& words, const size_t i) {
+    return (words[i / 64] >> (i % 64) & 1U) != 0;
+}
+}  // namespace
+
+TEST(RangeKernelsTest, BackendNameIsKnown) {
+    const std::string backend = active_backend();
+    EXPECT_TRUE(backend == "avx2" || backend == "neon" || backend == "scalar") << backend;
+}
+
+TEST(RangeKernelsTest, IntMatchesScalarReference) {
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> dist(-50, 50);
+    // Sizes cover empty input, a partial word, exact words and a ragged tail
+    for (const size_t count : {size_t{0}, size_t{5}, size_t{64}, size_t{128}, size_t{1000}}) {
+        std::vector<int> values(count);
+        for (int& v : values) v = dist(rng);
+
+        for (const CompareOp op : kAllOps) {
+            auto expected = empty_words(count);
+            auto actual = empty_words(count);
+            compare_int_scalar(values.data(), count, op, -10, 20, expected.data());
+            compare_int(values.data(), count, op, -10, 20, actual.data());
+            EXPECT_EQ(actual, expected) << "count=" << count << " op=" << static_cast<int>(op);
+        }
+    }
+}
+
+TEST(RangeKernelsTest, UintOrdersValuesAboveSignBit) {
+    const std::vector<unsigned int> values = {
+        0u, 1u, 0x7fffffffu, 0x80000000u, 0xfffffffeu, 0xffffffffu, 5u, 6u};
+    std::vector<unsigned int> column;
+    for (int rep = 0; rep < 20; ++rep) {
+        column.insert(column.end(), values.begin(), values.end());
+    }
+
+    for (const CompareOp op : kAllOps) {
+        auto expected = empty_words(column.size());
+        auto actual = empty_words(column.size());
+        compare_uint_scalar(column.data(), column.size(), op, 6u, 0x80000000u, expected.data());
+        compare_uint(column.data(), column.size(), op, 6u, 0x80000000u, actual.data());
+        EXPECT_EQ(actual, expected) << "op=" << static_cast<int>(op);
+    }
+
+    auto gt = empty_words(column.size());
+    compare_uint(column.data(), column.size(), CompareOp::GT, 0x7fffffffu, 0u, gt.data());
+    EXPECT_TRUE(bit(gt, 3));
+    EXPECT_TRUE(bit(gt, 5));
+    EXPECT_FALSE(bit(gt, 2));
+}
+
+TEST(RangeKernelsTest, FloatMatchesScalarReferenceAndSkipsNaN) {
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> dist(0.0f, 100.0f);
+    std::vector<float> values(300);
+    for (float& v : values) v = dist(rng);
+    values[10] = std::numeric_limits<float>::quiet_NaN();
+    values[70] = 80.0f;
+
+    for (const CompareOp op : kAllOps) {
+        auto expected = empty_words(values.size());
+        auto actual = empty_words(values.size());
+        compare_float_scalar(values.data(), values.size(), op, 80.0f, 90.0f, expected.data());
+        compare_float(values.data(), values.size(), op, 80.0f, 90.0f, actual.data());
+        EXPECT_EQ(actual, expected) << "op=" << static_cast<int>(op);
+        EXPECT_FALSE(bit(actual, 10)) << "NaN must never match";
+    }
+
+    auto eq = empty_words(values.size());
+    compare_float(values.data(), values.size(), CompareOp::EQ, 80.0f, 0.0f, eq.data());
+    EXPECT_TRUE(bit(eq, 70));
+}
+
+TEST(RangeKernelsTest, KernelsOrIntoExistingWords) {
+    const std::vector<int> values(64, 0);
+    std::vector<std::uint64_t> words = {std::uint64_t{1} << 63};
+    compare_int(values.data(), 8, CompareOp::EQ, 0, 0, words.data());
+    EXPECT_EQ(words[0], (std::uint64_t{1} << 63) | 0xffU);
+}
+
+TEST(RangeKernelsTest, MarkWithinMatchesScalarReference) {
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> dist(-10.0f, 10.0f);
+    for (const size_t count : {size_t{0}, size_t{3}, size_t{8}, size_t{37}, size_t{256}}) {
+        std::vector<float> cx(count), cy(count), cz(count);
+        for (size_t i = 0; i < count; ++i) {
+            cx[i] = dist(rng);
+            cy[i] = dist(rng);
+            cz[i] = dist(rng);
+        }
+        std::vector<float> rx(5), ry(5), rz(5);
+        for (size_t j = 0; j < rx.size(); ++j) {
+            rx[j] = dist(rng);
+            ry[j] = dist(rng);
+            rz[j] = dist(rng);
+        }
+
+        std::vector<std::uint8_t> expected(count, 0);
+        std::vector<std::uint8_t> actual(count, 0);
+        mark_within_scalar(cx.data(), cy.data(), cz.data(), count,
+                           rx.data(), ry.data(), rz.data(), rx.size(), 36.0f, expected.data());
+        mark_within(cx.data(), cy.data(), cz.data(), count,
+                    rx.data(), ry.data(), rz.data(), rx.size(), 36.0f, actual.data());
+        EXPECT_EQ(actual, expected) << "count=" << count;
+    }
+}
+
+TEST(RangeKernelsTest, MarkWithinIsStrictAndKeepsExistingFlags) {
+    const std::vector<float> cx = {3.0f, 2.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 9.0f};
+    const std::vector<float> zeros(cx.size(), 0.0f);
+    std::vector<std::uint8_t> hits(cx.size(), 0);
+    hits[8] = 1;  // Out of range but already flagged
+
+    const float origin = 0.0f;
+    mark_within(cx.data(), zeros.data(), zeros.data(), cx.size(),
+                &origin, &origin, &origin, 1, 9.0f, hits.data());
+    EXPECT_EQ(hits, (std::vector<std::uint8_t>{0, 1, 1, 1, 1, 1, 1, 1, 1}));
+}
@@ -2,7 +2,19 @@
 #include <gtest/gtest.h>
 
 #include <oeselect/oeselect.h>
+#include <oeselect/AtomTable.h>
+#include <oeselect/SpatialIndex.h>
 #include <oechem.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <random>
+#include <thread>
 
 using namespace OESel;
 
@@ -170,7 +182,9 @@ TEST_F(SelectionTest, XorOperator) {
     }
     // AB1 matches both, so XOR should NOT match it
     // A3, A4, etc. match only A*, so XOR should match them
-    EXPECT_GT(count, 0);
+    EXPECT_EQ(count, static_cast<int>(mol_.NumAtoms()) - 2);
+    EXPECT_EQ(sel.GetMask().Count(), mol_.NumAtoms() - 2);
+    EXPECT_EQ(OESelection::Parse("name A* xor name *B*").ToCanonical(), "(name *B* xor name A*)");
 }
 
 TEST_F(SelectionTest, ParenthesesGrouping) {
@@ -764,6 +778,74 @@ TEST_F(AtomPropertyTest, SelectorSetCanSeedResidueSelector) {
     EXPECT_EQ(count, 5);
 }
 
+TEST_F(AtomPropertyTest, ResidueSelectorMatchesNameNumberChainAndInsertCode) {
+    // Wrong name, number, chain, or insertion code must each miss
+    const OEResidueSelector selector(
+        "GLY:1: :A, ALA:2: :A; ALA:1: :B & ALA:1:X:A\tGLY:2: :A\n\n, ,");
+
+    std::vector<unsigned int> matched;
+    for (OESystem::OEIter<OEChem::OEAtomBase> atom = mol_.GetAtoms(); atom; ++atom) {
+        if (selector(*atom)) {
+            matched.push_back(atom->GetIdx());
+        }
+    }
+    EXPECT_EQ(matched.size(), mol_.NumAtoms() - 5);
+    EXPECT_EQ(selector.EvaluateMask(mol_).ToIndices(), matched);
+
+    const std::unique_ptr<OESystem::OEUnaryFunction<OEChem::OEAtomBase, bool>> copy(selector.CreateCopy());
+    unsigned int copy_count = 0;
+    for (OESystem::OEIter<OEChem::OEAtomBase> atom = mol_.GetAtoms(); atom; ++atom) {
+        copy_count += (*copy)(*atom) ? 1 : 0;
+    }
+    EXPECT_EQ(copy_count, mol_.NumAtoms() - 5);
+}
+
+TEST_F(AtomPropertyTest, ResidueSelectorMaskMatchesPerAtomTest) {
+    // Interleave residues and give one atom a different name inside residue 1
+    unsigned int i = 0;
+    for (OESystem::OEIter<OEChem::OEAtomBase> atom = mol_.GetAtoms(); atom; ++atom, ++i) {
+        OEChem::OEResidue res = OEChem::OEAtomGetResidue(&(*atom));
+        res.SetResidueNumber(static_cast<int>(i % 2) + 1);
+        res.SetName(i == 2 ? "SER" : (i % 2 == 0 ? "ALA" : "GLY"));
+        OEChem::OEAtomSetResidue(&(*atom), res);
+    }
+    OEChem::OEAtomBase* deleted = nullptr;
+    for (OESystem::OEIter<OEChem::OEAtomBase> atom = mol_.GetAtoms(); atom; ++atom) {
+        if (atom->GetIdx() == 4) {
+            deleted = &(*atom);
+        }
+    }
+    ASSERT_NE(deleted, nullptr);
+    mol_.DeleteAtom(deleted);
+
+    for (const std::string spec : {"ALA:1: :A", "SER:1: :A", "GLY:2: :A,SER:1: :A", "HOH:1: :A", ""}) {
+        const OEResidueSelector selector(spec);
+        std::vector<unsigned int> expected;
+        for (OESystem::OEIter<OEChem::OEAtomBase> atom = mol_.GetAtoms(); atom; ++atom) {
+            if (selector(*atom)) {
+                expected.push_back(atom->GetIdx());
+            }
+        }
+        const Bitset mask = selector.EvaluateMask(mol_);
+        EXPECT_EQ(mask.Size(), mol_.GetMaxAtomIdx());
+        EXPECT_EQ(mask.ToIndices(), expected) << spec;
+    }
+}
+
+TEST(ParseSelectorSetTest, SplitsOnDelimitersAndTrims) {
+    const std::set<Selector> selectors = parse_selector_set(
+        "  ALA:1: :A ,,;GLY:2: :B\r\n&\tSER : -3 : X : C\t\n");
+    std::vector<std::string> strings;
+    for (const Selector& selector : selectors) {
+        strings.push_back(selector.ToString());
+    }
+    EXPECT_EQ(strings, (std::vector<std::string>{"ALA:1: :A", "GLY:2: :B", "SER:-3:X:C"}));
+
+    EXPECT_TRUE(parse_selector_set("").empty());
+    EXPECT_TRUE(parse_selector_set(" ,;&\t\n ").empty());
+    EXPECT_THROW(parse_selector_set("ALA:1: :A,ALA:1"), SelectionError);
+}
+
 // Use the aspirin molecule for element tests (has C, O, and H atoms)
 class ElemTest : public ::testing::Test {
 protected:
@@ -1216,6 +1298,155 @@ TEST(TaggerTest, MixedComponentMolecule) {
     }
 }
 
+TEST(TaggerTest, ClassifyResidueName) {
+    EXPECT_EQ(Tagger::ClassifyResidueName("HOH"), ComponentFlag::WATER);
+    EXPECT_EQ(Tagger::ClassifyResidueName("TIP3"), ComponentFlag::WATER);
+    EXPECT_EQ(Tagger::ClassifyResidueName(" ALA "), ComponentFlag::PROTEIN);
+    EXPECT_EQ(Tagger::ClassifyResidueName("NME"), ComponentFlag::PROTEIN);
+    EXPECT_EQ(Tagger::ClassifyResidueName("A"), ComponentFlag::NUCLEIC);
+    EXPECT_EQ(Tagger::ClassifyResidueName("DT"), ComponentFlag::NUCLEIC);
+    EXPECT_EQ(Tagger::ClassifyResidueName("HEM"), ComponentFlag::COFACTOR);
+    EXPECT_EQ(Tagger::ClassifyResidueName("ZN"), ComponentFlag::COFACTOR);
+    EXPECT_EQ(Tagger::ClassifyResidueName("EDO"), ComponentFlag::SOLVENT);
+
+    // Unknown, empty, case-mismatched and over-long names are ligands
+    for (const char* name : {"LIG", "", "   ", "ala", "ALAX", "HOHHOH", "TIP33"}) {
+        EXPECT_EQ(Tagger::ClassifyResidueName(name), ComponentFlag::LIGAND) << "'" << name << "'";
+    }
+}
+
+TEST(TaggerTest, BuiltInLipidsAndGlycans) {
+    EXPECT_EQ(Tagger::ClassifyResidueName("POPC"), ComponentFlag::LIPID);
+    EXPECT_EQ(Tagger::ClassifyResidueName("CHL1"), ComponentFlag::LIPID);
+    EXPECT_EQ(Tagger::ClassifyResidueName("NAG"), ComponentFlag::GLYCAN);
+    EXPECT_EQ(Tagger::ClassifyResidueName("MAN"), ComponentFlag::GLYCAN);
+}
+
+/// Restores the built-in residue tables after each registry test
+class ResidueRegistryTest : public ::testing::Test {
+protected:
+    void TearDown() override { Tagger::ClearResidueClasses(); }
+};
+
+TEST_F(ResidueRegistryTest, RegisterOverridesAndExtends) {
+    EXPECT_EQ(Tagger::ClassifyResidueName("XCP"), ComponentFlag::LIGAND);
+    Tagger::RegisterResidueClass("XCP", ComponentFlag::PROTEIN);
+    Tagger::RegisterResidueClass(" LPX", ComponentFlag::LIPID);
+    Tagger::RegisterResidueClass("HEM", ComponentFlag::LIGAND);  // Override a built-in
+    EXPECT_EQ(Tagger::ClassifyResidueName("XCP"), ComponentFlag::PROTEIN);
+    EXPECT_EQ(Tagger::ClassifyResidueName("LPX"), ComponentFlag::LIPID);
+    EXPECT_EQ(Tagger::ClassifyResidueName("HEM"), ComponentFlag::LIGAND);
+    EXPECT_EQ(Tagger::ClassifyResidueName("ALA"), ComponentFlag::PROTEIN);
+
+    Tagger::ClearResidueClasses();
+    EXPECT_EQ(Tagger::ClassifyResidueName("XCP"), ComponentFlag::LIGAND);
+    EXPECT_EQ(Tagger::ClassifyResidueName("HEM"), ComponentFlag::COFACTOR);
+}
+
+TEST_F(ResidueRegistryTest, ManyRegistrationsStayExact) {
+    // Hundreds of custom names are frozen into one table without collisions
+    std::vector<std::string> names;
+    for (int i = 0; i < 500; ++i) {
+        names.push_back("Z" + std::to_string(i));
+        Tagger::RegisterResidueClass(names.back(), i % 2 == 0 ? ComponentFlag::LIPID : ComponentFlag::GLYCAN);
+    }
+    for (int i = 0; i < 500; ++i) {
+        EXPECT_EQ(Tagger::ClassifyResidueName(names[i].c_str()),
+                  i % 2 == 0 ? ComponentFlag::LIPID : ComponentFlag::GLYCAN) << names[i];
+    }
+    EXPECT_EQ(Tagger::ClassifyResidueName("HOH"), ComponentFlag::WATER);
+    EXPECT_EQ(Tagger::ClassifyResidueName("Z500"), ComponentFlag::LIGAND);
+}
+
+TEST_F(ResidueRegistryTest, RegistrationsAreBounded) {
+    // Four-character names Y + three letters
+    auto name = [](const int i) {
+        return std::string{'Y', static_cast<char>('A' + i / 676), static_cast<char>('A' + i / 26 % 26),
+                           static_cast<char>('A' + i % 26)};
+    };
+    for (int i = 0; i < 1024; ++i) {
+        Tagger::RegisterResidueClass(name(i), ComponentFlag::LIPID);
+    }
+    // Re-registering a known name does not count against the limit
+    Tagger::RegisterResidueClass(name(0), ComponentFlag::GLYCAN);
+    EXPECT_THROW(Tagger::RegisterResidueClass(name(1024), ComponentFlag::LIPID), SelectionError);
+    EXPECT_EQ(Tagger::ClassifyResidueName(name(0).c_str()), ComponentFlag::GLYCAN);
+    EXPECT_EQ(Tagger::ClassifyResidueName(name(1023).c_str()), ComponentFlag::LIPID);
+    EXPECT_EQ(Tagger::ClassifyResidueName(name(1024).c_str()), ComponentFlag::LIGAND);
+}
+
+TEST_F(ResidueRegistryTest, RejectsInvalidRegistrations) {
+    EXPECT_THROW(Tagger::RegisterResidueClass("", ComponentFlag::LIPID), SelectionError);
+    EXPECT_THROW(Tagger::RegisterResidueClass("TOOLONG", ComponentFlag::LIPID), SelectionError);
+    EXPECT_THROW(Tagger::RegisterResidueClass("ABC", ComponentFlag::NONE), SelectionError);
+}
+
+TEST_F(ResidueRegistryTest, LoadResidueClassesFromFile) {
+    const std::string path = ::testing::TempDir() + "oeselect_residue_classes.txt";
+    {
+        std::ofstream out(path);
+        out << "# In-house residues\n"
+            << "POPX  lipid\n"
+            << "\n"
+            << "SUGA  Glycan   # custom sugar\n";
+    }
+    Tagger::LoadResidueClasses(path);
+    EXPECT_EQ(Tagger::ClassifyResidueName("POPX"), ComponentFlag::LIPID);
+    EXPECT_EQ(Tagger::ClassifyResidueName("SUGA"), ComponentFlag::GLYCAN);
+
+    {
+        std::ofstream out(path);
+        out << "GOOD lipid\n"
+            << "BAD wax\n";
+    }
+    EXPECT_THROW(Tagger::LoadResidueClasses(path), SelectionError);
+    EXPECT_EQ(Tagger::ClassifyResidueName("GOOD"), ComponentFlag::LIGAND);  // Nothing registered
+    EXPECT_THROW(Tagger::LoadResidueClasses(path + ".missing"), SelectionError);
+    std::remove(path.c_str());
+}
+
+TEST_F(ResidueRegistryTest, LipidAndGlycanKeywords) {
+    OEChem::OEGraphMol mol;
+    OEChem::OESmilesToMol(mol, "CCCCCC");
+    const char* resnames[] = {"POPC", "POPC", "NAG", "LPX", "ALA", "LIG"};
+    int i = 0;
+    for (OESystem::OEIter<OEChem::OEAtomBase> atom = mol.GetAtoms(); atom; ++atom, ++i) {
+        OEChem::OEResidue res;
+        res.SetName(resnames[i]);
+        res.SetResidueNumber(i + 1);
+        OEChem::OEAtomSetResidue(&(*atom), res);
+    }
+    Tagger::RegisterResidueClass("LPX", ComponentFlag::LIPID);
+
+    EXPECT_EQ(OESelection::Parse("lipid").EvaluateMask(mol).ToIndices(), (std::vector<unsigned int>{0, 1, 3}));
+    EXPECT_EQ(OESelection::Parse("glycans").EvaluateMask(mol).ToIndices(), (std::vector<unsigned int>{2}));
+    EXPECT_EQ(OESelection::Parse("ligand").EvaluateMask(mol).ToIndices(), (std::vector<unsigned int>{5}));
+    EXPECT_EQ(OESelection::Parse("LIPIDS").ToCanonical(), "lipid");
+    EXPECT_EQ(OESelection::Parse("glycan").Root().Type(), PredicateType::GLYCAN);
+
+    OESelect sel(mol, "lipid or glycan");
+    EXPECT_EQ(OEChem::OECount(mol, sel), 4u);
+}
+
+TEST(TaggerTest, SelectionDoesNotTagMolecule) {
+    OEChem::OEGraphMol mol;
+    OEChem::OESmilesToMol(mol, "CC.O");
+    int i = 0;
+    for (OESystem::OEIter<OEChem::OEAtomBase> atom = mol.GetAtoms(); atom; ++atom, ++i) {
+        OEChem::OEResidue res;
+        res.SetName(i < 2 ? "ALA" : "HOH");
+        OEChem::OEAtomSetResidue(&(*atom), res);
+    }
+
+    EXPECT_EQ(OESelection::Parse("protein").EvaluateMask(mol).ToIndices(), (std::vector<unsigned int>{0, 1}));
+    OESelect sel(mol, "water or backbone");
+    EXPECT_EQ(OEChem::OECount(mol, sel), 1u);
+    EXPECT_FALSE(Tagger::IsTagged(mol));
+    for (OESystem::OEIter<OEChem::OEAtomBase> atom = mol.GetAtoms(); atom; ++atom) {
+        EXPECT_EQ(Tagger::GetFlags(*atom), 0u);
+    }
+}
+
 TEST(TaggerTest, GetFlagsReturnsZeroForUntaggedAtom) {
     OEChem::OEGraphMol mol;
     OEChem::OESmilesToMol(mol, "C");
@@ -2311,6 +2542,96 @@ TEST_F(DistancePredicateTest, ToCanonicalBeyond) {
     EXPECT_TRUE(canonical.find("10") != std::string::npos);
 }
 
+TEST_F(DistancePredicateTest, NearestRanksCandidatesByDistance) {
+    // Reference atoms are never candidates
+    EXPECT_EQ(OESelect(mol_, "nearest 1 all to name REF").GetMask().ToIndices(), (std::vector<unsigned int>{1}));
+    EXPECT_EQ(OESelect(mol_, "nearest 2 all to name REF").GetMask().ToIndices(),
+              (std::vector<unsigned int>{1, 2}));
+    EXPECT_EQ(OESelect(mol_, "nearest 1 not name NEAR to name REF").GetMask().ToIndices(),
+              (std::vector<unsigned int>{2}));
+    // Distance is to the closest reference atom
+    EXPECT_EQ(OESelect(mol_, "nearest 1 name REF+NEAR to name FAR+MID").GetMask().ToIndices(),
+              (std::vector<unsigned int>{1}));
+    // Fewer candidates than requested
+    EXPECT_EQ(OESelect(mol_, "nearest 10 all to name MID").GetMask().ToIndices(),
+              (std::vector<unsigned int>{0, 1, 3}));
+    EXPECT_TRUE(OESelect(mol_, "nearest 3 name REF to name REF").GetMask().None());
+
+    // Binds tighter than and; the reference takes distance suffixes
+    OESelect sel(mol_, "nearest 1 all to name REF around 2 and not name FAR");
+    EXPECT_EQ(sel.GetMask().ToIndices(), (std::vector<unsigned int>{0}));
+    for (OESystem::OEIter<OEChem::OEAtomBase> atom = mol_.GetAtoms(); atom; ++atom) {
+        EXPECT_EQ(sel(*atom), atom->GetIdx() == 0);
+    }
+
+    EXPECT_THROW(OESelection::Parse("nearest 0 all to name REF"), SelectionError);
+    EXPECT_THROW(OESelection::Parse("nearest 2 all name REF"), SelectionError);
+}
+
+TEST_F(DistancePredicateTest, NearestCanonicalRoundTrips) {
+    for (const char* text : {"nearest 2 all to name REF", "nearest 3 byres water to ligand",
+                             "nearest 1 (byres name CA) to name REF", "nearest 20 (water or name O) to ligand around 4"}) {
+        const OESelection sele = OESelection::Parse(text);
+        EXPECT_EQ(OESelection::Parse(sele.ToCanonical()).ToCanonical(), sele.ToCanonical()) << text;
+    }
+    EXPECT_EQ(OESelection::Parse("NEAREST 3 BYRES water TO ligand").ToCanonical(), "nearest 3 byres water to ligand");
+    EXPECT_TRUE(OESelection::Parse("nearest 2 all to name REF").ContainsPredicate(PredicateType::NEAREST));
+}
+
+TEST_F(DistancePredicateTest, NearestFollowsFramesAndUnitCell) {
+    OESelect sel(mol_, "nearest 1 all to name REF");
+    EXPECT_EQ(sel.GetMask().ToIndices(), (std::vector<unsigned int>{1}));
+
+    // In an 11 A box FAR (x = 10) sits 1 A from REF's image
+    sel.SetUnitCell(UnitCell::Orthorhombic(11.0f, 11.0f, 11.0f));
+    EXPECT_EQ(sel.GetMask().ToIndices(), (std::vector<unsigned int>{3}));
+    sel.SetUnitCell(UnitCell());
+
+    // Swap NEAR and MID along the x axis
+    std::vector<float> xyz(static_cast<size_t>(mol_.GetMaxAtomIdx()) * 3);
+    mol_.GetCoords(xyz.data());
+    xyz[1 * 3] = 4.0f;
+    xyz[2 * 3] = 1.5f;
+    sel.SetFrame(xyz.data());
+    EXPECT_EQ(sel.GetMask().ToIndices(), (std::vector<unsigned int>{2}));
+}
+
+TEST(NearestPredicateTest, ByresRanksResiduesByClosestAtom) {
+    // Three-atom waters along x; residue r's oxygen sits 3r A from a ligand atom at the origin
+    OEChem::OEGraphMol mol;
+    auto add_atom = [&](const char* name, const unsigned int elem, const char* resname, const int resnum,
+                        const float x, const float y) {
+        OEChem::OEAtomBase* atom = mol.NewAtom(elem);
+        atom->SetName(name);
+        const float xyz[3] = {x, y, 0.0f};
+        mol.SetCoords(atom, xyz);
+        OEChem::OEResidue res;
+        res.SetName(resname);
+        res.SetResidueNumber(resnum);
+        res.SetChainID(elem == 6 ? 'L' : 'W');
+        OEChem::OEAtomSetResidue(atom, res);
+    };
+    add_atom("C1", 6, "LIG", 1, 0.0f, 0.0f);
+    for (int r = 1; r <= 4; ++r) {
+        // Hydrogens of residue 3 reach closer than residue 2's oxygen
+        const float reach = r == 3 ? 4.0f : 0.5f;
+        add_atom("O", 8, "HOH", r, 3.0f * static_cast<float>(r), 0.0f);
+        add_atom("H1", 1, "HOH", r, 3.0f * static_cast<float>(r), reach);
+        add_atom("H2", 1, "HOH", r, 3.0f * static_cast<float>(r) - (r == 3 ? 3.9f : 0.1f), -0.2f);
+    }
+
+    // Residue 3's H2 (5.1 A away) is closer than any atom of residue 2
+    EXPECT_EQ(OESelect(mol, "nearest 2 byres resn HOH to resn LIG").GetMask().ToIndices(),
+              (std::vector<unsigned int>{1, 2, 3, 7, 8, 9}));
+    // Atom mode counts atoms, so one residue can supply several
+    EXPECT_EQ(OESelect(mol, "nearest 3 resn HOH to resn LIG").GetMask().ToIndices(),
+              (std::vector<unsigned int>{1, 2, 3}));
+    // Candidate filters restrict ranking but whole residues are painted
+    EXPECT_EQ(OESelect(mol, "nearest 1 byres name O to resn LIG").GetMask().ToIndices(),
+              (std::vector<unsigned int>{1, 2, 3}));
+    EXPECT_EQ(OESelect(mol, "nearest 9 byres resn HOH to resn LIG").GetMask().Count(), 12u);
+}
+
 // ============================================================================
 // Expansion Predicate Tests (Task 14)
 // ============================================================================
@@ -3051,6 +3372,20 @@ TEST(CappingPredicateTest, ToCanonical) {
     EXPECT_EQ(sele_caps.ToCanonical(), "capping");
 }
 
+TEST(PredicateTypeTest, ValuesKeepTheirNumbers) {
+    // Released values are part of the ABI and of pickled Python constants
+    EXPECT_EQ(static_cast<int>(PredicateType::NAME), 4);
+    EXPECT_EQ(static_cast<int>(PredicateType::CAPPING), 22);
+    EXPECT_EQ(static_cast<int>(PredicateType::BY_CHAIN), 28);
+    EXPECT_EQ(static_cast<int>(PredicateType::AROUND), 29);
+    EXPECT_EQ(static_cast<int>(PredicateType::LOOP), 35);
+    EXPECT_EQ(static_cast<int>(PredicateType::ALL_MATCH), 36);
+    EXPECT_EQ(static_cast<int>(PredicateType::NO_MATCH), 37);
+    // Later types are appended
+    EXPECT_EQ(static_cast<int>(PredicateType::LIPID), 38);
+    EXPECT_EQ(static_cast<int>(PredicateType::NEAREST), 43);
+}
+
 // ============================================================================
 // Expanded Protein Residue Tests
 // ============================================================================
@@ -3117,3 +3452,1016 @@ TEST(TaggerTest, MethionineStillClassifiedAsProtein) {
         EXPECT_TRUE(Tagger::HasComponent(*atom, ComponentFlag::PROTEIN));
     }
 }
+
+// ============================================================================
+// Bulk Evaluation Tests
+// ============================================================================
+
+namespace {
+// Evaluate a selection atom-by-atom through the predicate tree
+Bitset evaluate_per_atom(OEChem::OEMolBase& mol, const OESelection& sele) {
+    Context ctx(mol, sele);
+    Bitset mask(mol.GetMaxAtomIdx());
+    for (OESystem::OEIter<OEChem::OEAtomBase> atom = mol.GetAtoms(); atom; ++atom) {
+        if (sele.Root().Evaluate(ctx, *atom)) {
+            mask.Set(atom->GetIdx());
+        }
+    }
+    return mask;
+}
+}  // namespace
+
+TEST_F(SelectionTest, EvaluateMaskMatchesPerAtomEvaluation) {
+    OEChem::OEAddExplicitHydrogens(mol_);
+
+    for (const char* expr : {
+            "all", "none", "elem C", "not elem C", "elem C and not hydrogen",
+            "elem O or hydrogen", "elem C xor heavy", "heavy xor elem O xor elem C",
+            "not (elem C or elem O)", "index 2-5 or index > 10"}) {
+        const OESelection sele = OESelection::Parse(expr);
+        EXPECT_EQ(sele.EvaluateMask(mol_), evaluate_per_atom(mol_, sele)) << expr;
+    }
+}
+
+TEST_F(SelectionTest, EvaluateMaskSizedToMaxAtomIdx) {
+    const OESelection sele = OESelection::Parse("all");
+    const Bitset mask = sele.EvaluateMask(mol_);
+    EXPECT_EQ(mask.Size(), mol_.GetMaxAtomIdx());
+    EXPECT_EQ(mask.Count(), mol_.NumAtoms());
+}
+
+TEST_F(SelectionTest, EvaluateMaskNotSkipsDeletedAtoms) {
+    OEChem::OEAtomBase* first = nullptr;
+    for (OESystem::OEIter<OEChem::OEAtomBase> atom = mol_.GetAtoms(); atom; ++atom) {
+        first = &(*atom);
+        break;
+    }
+    ASSERT_NE(first, nullptr);
+    const unsigned int deleted_idx = first->GetIdx();
+    mol_.DeleteAtom(first);
+
+    const Bitset mask = OESelection::Parse("not none").EvaluateMask(mol_);
+    EXPECT_FALSE(mask.Test(deleted_idx));
+    EXPECT_EQ(mask.Count(), mol_.NumAtoms());
+}
+
+TEST_F(SelectionTest, OESelectMaskMatchesOperator) {
+    OESelect sel(mol_, "elem O or (elem C and index < 3)");
+    const Bitset& mask = sel.GetMask();
+
+    for (OESystem::OEIter<OEChem::OEAtomBase> atom = mol_.GetAtoms(); atom; ++atom) {
+        EXPECT_EQ(sel(*atom), mask.Test(atom->GetIdx()));
+    }
+    EXPECT_EQ(mask.Count(), OEChem::OECount(mol_, sel));
+}
+
+TEST_F(DistancePredicateTest, EvaluateMaskDistanceOperators) {
+    EXPECT_EQ(OESelection::Parse("name REF around 5.0").EvaluateMask(mol_).ToIndices(),
+              (std::vector<unsigned int>{1, 2}));
+    EXPECT_EQ(OESelection::Parse("name REF expand 5.0").EvaluateMask(mol_).ToIndices(),
+              (std::vector<unsigned int>{0, 1, 2}));
+    EXPECT_EQ(OESelection::Parse("name REF beyond 5.0").EvaluateMask(mol_).ToIndices(),
+              (std::vector<unsigned int>{3}));
+    EXPECT_EQ(OESelection::Parse("not (name REF around 2.0)").EvaluateMask(mol_).ToIndices(),
+              (std::vector<unsigned int>{0, 2, 3}));
+}
+
+TEST(ExpansionPredicateTest, EvaluateMaskByResAndByChain) {
+    OEChem::OEGraphMol mol;
+    OEChem::OESmilesToMol(mol, "CCCC");
+
+    int i = 0;
+    for (OESystem::OEIter<OEChem::OEAtomBase> atom = mol.GetAtoms(); atom; ++atom, ++i) {
+        OEChem::OEResidue res;
+        res.SetName(i < 2 ? "ALA" : "GLY");
+        res.SetResidueNumber(i < 2 ? 1 : 2);
+        res.SetChainID(i < 3 ? 'A' : 'B');
+        OEChem::OEAtomSetResidue(&(*atom), res);
+        atom->SetName(i % 2 == 0 ? "CA" : "CB");
+    }
+
+    EXPECT_EQ(OESelection::Parse("byres index 0").EvaluateMask(mol).ToIndices(),
+              (std::vector<unsigned int>{0, 1}));
+    EXPECT_EQ(OESelection::Parse("bychain index 3").EvaluateMask(mol).ToIndices(),
+              (std::vector<unsigned int>{3}));
+    EXPECT_EQ(OESelection::Parse("bychain resn GLY").EvaluateMask(mol).ToIndices(),
+              (std::vector<unsigned int>{0, 1, 2, 3}));
+}
+
+TEST(ExpansionPredicateTest, TopologyRunsHandleInterleavedResidues) {
+    // Residues 1 and 2 of chain A interleave, chain B sits in the middle,
+    // and a deleted atom leaves a hole in the index space
+    OEChem::OEGraphMol mol;
+    const std::vector<std::pair<int, char>> layout = {
+        {1, 'A'}, {1, 'A'}, {2, 'A'}, {1, 'A'}, {7, 'B'}, {7, 'B'}, {2, 'A'}, {2, 'A'}};
+    for (const auto& [resnum, chain] : layout) {
+        OEChem::OEAtomBase* atom = mol.NewAtom(6);
+        OEChem::OEResidue res;
+        res.SetName("ALA");
+        res.SetResidueNumber(resnum);
+        res.SetChainID(chain);
+        OEChem::OEAtomSetResidue(atom, res);
+    }
+    for (OESystem::OEIter<OEChem::OEAtomBase> atom = mol.GetAtoms(); atom; ++atom) {
+        if (atom->GetIdx() == 6) {
+            mol.DeleteAtom(&(*atom));
+            break;
+        }
+    }
+
+    const AtomTable table(mol);
+    EXPECT_EQ(table.ResidueRuns().NumGroups(), 3u);
+    EXPECT_EQ(table.ChainRuns().NumGroups(), 2u);
+    EXPECT_EQ(table.ResidueGroups()[6], AtomTable::kNoGroup);
+    EXPECT_EQ(table.ResidueGroups()[0], table.ResidueGroups()[3]);
+    EXPECT_EQ(table.ChainGroups()[2], table.ChainGroups()[7]);
+
+    EXPECT_EQ(OESelection::Parse("byres index 1").EvaluateMask(mol).ToIndices(),
+              (std::vector<unsigned int>{0, 1, 3}));
+    EXPECT_EQ(OESelection::Parse("byres index 7").EvaluateMask(mol).ToIndices(),
+              (std::vector<unsigned int>{2, 7}));
+    EXPECT_EQ(OESelection::Parse("bychain index 0").EvaluateMask(mol).ToIndices(),
+              (std::vector<unsigned int>{0, 1, 2, 3, 7}));
+    EXPECT_EQ(OESelection::Parse("bychain index 5").EvaluateMask(mol).ToIndices(),
+              (std::vector<unsigned int>{4, 5}));
+}
+
+TEST_F(AtomPropertyExtendedTest, AtomTableColumnsMatchResidueData) {
+    const AtomTable table(mol_);
+    ASSERT_EQ(table.Size(), mol_.GetMaxAtomIdx());
+
+    for (OESystem::OEIter<OEChem::OEAtomBase> atom = mol_.GetAtoms(); atom; ++atom) {
+        const unsigned int idx = atom->GetIdx();
+        const OEChem::OEResidue res = OEChem::OEAtomGetResidue(&(*atom));
+        EXPECT_EQ(table.ResidueNames()[table.ResidueNameIds()[idx]], res.GetName());
+        EXPECT_EQ(table.AtomNames()[table.AtomNameIds()[idx]], atom->GetName());
+        EXPECT_EQ(table.ResidueNumbers()[idx], res.GetResidueNumber());
+        EXPECT_EQ(table.ChainIds()[idx], res.GetChainID());
+        EXPECT_EQ(table.SerialNumbers()[idx], res.GetSerialNumber());
+        EXPECT_EQ(table.AltLocations()[idx], res.GetAlternateLocation());
+        EXPECT_FLOAT_EQ(table.BFactors()[idx], static_cast<float>(res.GetBFactor()));
+        EXPECT_EQ(table.FragmentNumbers()[idx], res.GetFragmentNumber());
+        EXPECT_EQ(table.AtomicNumbers()[idx], atom->GetAtomicNum());
+    }
+}
+
+TEST_F(AtomPropertyExtendedTest, AtomTableInternsNames) {
+    const AtomTable table(mol_);
+    // All five atoms share one residue name; atom names are distinct
+    EXPECT_EQ(table.ResidueNames().size(), 1u);
+    EXPECT_EQ(table.AtomNames().size(), 5u);
+}
+
+TEST_F(AtomPropertyExtendedTest, EvaluateMaskPropertyColumnsMatchPerAtom) {
+    for (const char* expr : {
+            "id 5", "id 2-10", "id > 5", "alt B", "b 30.5", "b >= 30.5", "b 20.0-60.0",
+            "frag 2", "frag < 2", "resi 1-2", "resn AL*", "name C*", "elem N",
+            "chain A and not alt A", "helix", "loop"}) {
+        const OESelection sele = OESelection::Parse(expr);
+        EXPECT_EQ(sele.EvaluateMask(mol_), evaluate_per_atom(mol_, sele)) << expr;
+    }
+}
+
+TEST(BulkEvaluationTest, VectorizedRangePredicatesMatchPerAtom) {
+    // Enough atoms to exercise full 64-bit words plus a ragged tail
+    OEChem::OEGraphMol mol;
+    for (int i = 0; i < 203; ++i) {
+        OEChem::OEAtomBase* atom = mol.NewAtom(6 + i % 3);
+        OEChem::OEResidue res;
+        res.SetName(i % 2 == 0 ? "ALA" : "GLY");
+        res.SetResidueNumber(i / 4 - 10);
+        res.SetSerialNumber(i * 3);
+        res.SetBFactor(static_cast<double>(i % 97) + 0.5);
+        res.SetFragmentNumber(static_cast<unsigned int>(i % 7));
+        OEChem::OEAtomSetResidue(atom, res);
+    }
+
+    for (const char* expr : {
+            "resi 5", "resi < 0", "resi <= 3", "resi > 20", "resi >= 40", "resi 3-12",
+            "id 30", "id > 300", "id 99-402", "b > 80", "b <= 10.5", "b 20.0-40.0",
+            "frag 3", "frag >= 5", "frag 1-2", "index 64", "index < 70", "index >= 128",
+            "index 60-140", "b > 80 or resi 1-50"}) {
+        const OESelection sele = OESelection::Parse(expr);
+        const Bitset mask = sele.EvaluateMask(mol);
+        EXPECT_EQ(mask, evaluate_per_atom(mol, sele)) << expr;
+    }
+}
+
+TEST(CacheSlotTest, IdenticalSubtreesShareSlot) {
+    const auto sele = OESelection::Parse("(name CA and chain A) or (chain B and name CA)");
+    const auto children = sele.Root().Children();
+    ASSERT_EQ(children.size(), 2u);
+    const auto find_name = [](const Predicate& pred) {
+        for (const auto& child : pred.Children()) {
+            if (child->Type() == PredicateType::NAME) {
+                return child;
+            }
+        }
+        return Predicate::Ptr();
+    };
+    const auto first = find_name(*children[0]);
+    const auto second = find_name(*children[1]);
+    ASSERT_TRUE(first && second);
+    EXPECT_EQ(first->Slot(), second->Slot());
+    EXPECT_NE(children[0]->Slot(), children[1]->Slot());
+    // name CA, chain A, chain B, two ANDs, and the OR
+    EXPECT_EQ(sele.NumSlots(), 6u);
+}
+
+TEST(CacheSlotTest, SlotsAreDense) {
+    const auto sele = OESelection::Parse("byres (name CA around 5) and not water");
+    std::vector<bool> seen(sele.NumSlots(), false);
+    std::vector<const Predicate*> stack{&sele.Root()};
+    while (!stack.empty()) {
+        const Predicate* pred = stack.back();
+        stack.pop_back();
+        ASSERT_LT(pred->Slot(), sele.NumSlots());
+        seen[pred->Slot()] = true;
+        for (const auto& child : pred->Children()) {
+            stack.push_back(child.get());
+        }
+    }
+    EXPECT_TRUE(std::all_of(seen.begin(), seen.end(), [](const bool s) { return s; }));
+    EXPECT_EQ(OESelection().NumSlots(), 1u);
+}
+
+TEST(CacheSlotTest, DistancePredicatesShareMaskSlot) {
+    const auto sele = OESelection::Parse("(index 0 around 2) or (index 0 expand 2) or (index 0 beyond 3)");
+    const auto children = sele.Root().Children();
+    ASSERT_EQ(children.size(), 3u);
+    std::vector<unsigned int> slots;
+    for (const auto& child : children) {
+        slots.push_back(child->Slot());
+    }
+    std::sort(slots.begin(), slots.end());
+    // around/expand at 2A share one mask; beyond at 3A gets its own
+    EXPECT_EQ(std::unique(slots.begin(), slots.end()) - slots.begin(), 2);
+}
+
+TEST_F(DistancePredicateTest, SharedSlotsMatchPerAtomEvaluation) {
+    for (const char* expr : {
+            "(name REF around 2.0) or (name REF expand 2.0)",
+            "(name REF expand 2.0) and not (name REF around 2.0)",
+            "name REF beyond 2.0 or byres name REF",
+            "byres name REF and bychain name REF"}) {
+        const OESelection sele = OESelection::Parse(expr);
+        EXPECT_EQ(sele.EvaluateMask(mol_), evaluate_per_atom(mol_, sele)) << expr;
+    }
+}
+
+// ============================================================================
+// Optimizer Tests
+// ============================================================================
+
+/// Starts each parse cache test from an empty cache at the default capacity
+class ParseCacheTest : public ::testing::Test {
+protected:
+    void SetUp() override { OESelection::ClearParseCache(); }
+    void TearDown() override {
+        OESelection::SetParseCacheCapacity(1024);
+        OESelection::ClearParseCache();
+    }
+};
+
+TEST_F(ParseCacheTest, RepeatedParsesShareOneTree) {
+    const OESelection first = OESelection::Parse("protein and name CA");
+    const OESelection second = OESelection::Parse("protein and name CA");
+    const OESelection copy = first;
+    EXPECT_EQ(&first.Root(), &second.Root());
+    EXPECT_EQ(&first.Root(), &copy.Root());
+
+    const ParseCacheStats stats = OESelection::GetParseCacheStats();
+    EXPECT_EQ(stats.misses, 1u);
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.size, 1u);
+    EXPECT_EQ(stats.capacity, 1024u);
+}
+
+TEST_F(ParseCacheTest, InvalidSelectionsAreNotCached) {
+    EXPECT_THROW(OESelection::Parse("name CA and"), SelectionError);
+    EXPECT_THROW(OESelection::Parse("name CA and"), SelectionError);
+    EXPECT_EQ(OESelection::GetParseCacheStats().size, 0u);
+    EXPECT_EQ(OESelection::GetParseCacheStats().misses, 2u);
+}
+
+TEST_F(ParseCacheTest, CapacityBoundsAndDisables) {
+    OESelection::SetParseCacheCapacity(32);
+    for (int i = 0; i < 200; ++i) {
+        (void)OESelection::Parse("resi " + std::to_string(i));
+    }
+    EXPECT_LE(OESelection::GetParseCacheStats().size, 32u);
+
+    // The bound is the total even when it does not divide among the shards
+    for (const size_t capacity : {size_t{1}, size_t{20}}) {
+        OESelection::SetParseCacheCapacity(capacity);
+        for (int i = 0; i < 200; ++i) {
+            (void)OESelection::Parse("index " + std::to_string(i));
+        }
+        EXPECT_LE(OESelection::GetParseCacheStats().size, capacity);
+        EXPECT_EQ(OESelection::GetParseCacheStats().capacity, capacity);
+    }
+
+    OESelection::SetParseCacheCapacity(0);
+    EXPECT_EQ(OESelection::GetParseCacheStats().size, 0u);
+    const OESelection a = OESelection::Parse("water");
+    const OESelection b = OESelection::Parse("water");
+    EXPECT_NE(&a.Root(), &b.Root());
+    EXPECT_EQ(OESelection::GetParseCacheStats().hits, 0u);
+}
+
+TEST_F(ParseCacheTest, ConcurrentParsesAgree) {
+    OESelection::SetParseCacheCapacity(16);
+    const std::vector<std::string> exprs = {
+        "protein", "ligand around 4", "name CA+CB", "resi 1-10 and chain A", "not water",
+        "byres (ligand around 5)", "elem C or elem N", "b > 30.0", "heavy and not backbone"};
+    std::vector<std::thread> threads;
+    std::atomic<int> mismatches{0};
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < 500; ++i) {
+                const std::string& expr = exprs[(i + t) % exprs.size()];
+                if (OESelection::Parse(expr).ToCanonical() != OESelection::Parse(expr).ToCanonical()) {
+                    ++mismatches;
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(mismatches.load(), 0);
+    const ParseCacheStats stats = OESelection::GetParseCacheStats();
+    EXPECT_EQ(stats.hits + stats.misses, 4000u);
+}
+
+TEST(OptimizerTest, CanonicalFormUnchanged) {
+    for (const char* expr : {
+            "not not name CA", "all and elem C", "none or elem C", "none and protein",
+            "name CA and (chain A and (elem C and resi 5))", "(elem N or elem O) or elem S",
+            "(ligand around 5 and protein) or (ligand around 5 and water)",
+            "byres (name CA around 5) and elem C", "elem C xor none xor chain A"}) {
+        EXPECT_EQ(OESelection::Parse(expr).ToCanonical(), parse_selection(expr)->ToCanonical()) << expr;
+    }
+}
+
+TEST(OptimizerTest, FoldsConstantsAndDoubleNegation) {
+    EXPECT_EQ(OESelection::Parse("not not name CA").Root().Type(), PredicateType::NAME);
+    EXPECT_EQ(OESelection::Parse("all and elem C").Root().Type(), PredicateType::ELEM);
+    EXPECT_EQ(OESelection::Parse("none or elem C").Root().Type(), PredicateType::ELEM);
+    EXPECT_EQ(OESelection::Parse("none and protein").Root().Type(), PredicateType::NO_MATCH);
+    EXPECT_EQ(OESelection::Parse("elem C or all").Root().Type(), PredicateType::ALL_MATCH);
+    EXPECT_EQ(OESelection::Parse("not all").Root().Type(), PredicateType::NO_MATCH);
+
+    // Introspection still reflects the selection as written
+    EXPECT_TRUE(OESelection::Parse("none and protein").ContainsPredicate(PredicateType::PROTEIN));
+}
+
+TEST(OptimizerTest, FlattensNestedAndOr) {
+    const auto and_sele = OESelection::Parse("name CA and (chain A and (elem C and resi 5))");
+    EXPECT_EQ(and_sele.Root().Type(), PredicateType::AND);
+    EXPECT_EQ(and_sele.Root().Children().size(), 4u);
+
+    const auto or_sele = OESelection::Parse("(elem N or elem O) or (elem S or elem N)");
+    EXPECT_EQ(or_sele.Root().Type(), PredicateType::OR);
+    EXPECT_EQ(or_sele.Root().Children().size(), 3u);  // Duplicate elem N removed
+}
+
+TEST(OptimizerTest, FusesNameListsIntoOneMatcher) {
+    const auto names = OESelection::Parse("name CA+CB+C*");
+    EXPECT_EQ(names.Root().Type(), PredicateType::NAME);
+    EXPECT_EQ(names.Root().ToCanonical(), "name CA+CB+C*");
+    EXPECT_EQ(names.ToCanonical(), parse_selection("name CA+CB+C*")->ToCanonical());
+
+    // Name and residue name leaves fuse separately; other children are kept
+    const auto mixed = OESelection::Parse("resn ALA or elem N or resn G* or name X or name Y?");
+    EXPECT_EQ(mixed.Root().Type(), PredicateType::OR);
+    EXPECT_EQ(mixed.Root().Children().size(), 3u);
+
+    OEChem::OEGraphMol mol;
+    OEChem::OESmilesToMol(mol, "CCCCNO");
+    const std::vector<std::string> atom_names = {" CA ", "CB", "CG1", "XC", "N", "YO"};
+    size_t i = 0;
+    for (OESystem::OEIter<OEChem::OEAtomBase> atom = mol.GetAtoms(); atom && i < atom_names.size(); ++atom, ++i) {
+        atom->SetName(atom_names[i].c_str());
+    }
+    EXPECT_EQ(names.EvaluateMask(mol).ToIndices(), (std::vector<unsigned int>{0, 1, 2}));
+
+    const OESelect per_atom(mol, "name XC+Y?+N");
+    std::vector<unsigned int> matched;
+    for (OESystem::OEIter<OEChem::OEAtomBase> atom = mol.GetAtoms(); atom; ++atom) {
+        if (per_atom(*atom)) {
+            matched.push_back(atom->GetIdx());
+        }
+    }
+    EXPECT_EQ(matched, (std::vector<unsigned int>{3, 4, 5}));
+}
+
+TEST(OptimizerTest, SharesCommonSubexpressions) {
+    const auto sele = OESelection::Parse("(ligand around 5 and protein) or (ligand around 5 and water)");
+    const auto branches = sele.Root().Children();
+    ASSERT_EQ(branches.size(), 2u);
+
+    std::vector<const Predicate*> around_nodes;
+    for (const auto& branch : branches) {
+        for (const auto& child : branch->Children()) {
+            if (child->Type() == PredicateType::AROUND) {
+                around_nodes.push_back(child.get());
+            }
+        }
+    }
+    ASSERT_EQ(around_nodes.size(), 2u);
+    EXPECT_EQ(around_nodes[0], around_nodes[1]);
+}
+
+TEST(OptimizerTest, OrdersChildrenByCost) {
+    const auto sele = OESelection::Parse("name CA around 5 and byres resn ALA and protein and elem C");
+    std::vector<PredicateType> types;
+    for (const auto& child : sele.Root().Children()) {
+        types.push_back(child->Type());
+    }
+    EXPECT_EQ(types, (std::vector<PredicateType>{
+        PredicateType::ELEM, PredicateType::PROTEIN, PredicateType::BY_RES, PredicateType::AROUND}));
+}
+
+TEST_F(DistancePredicateTest, OptimizedTreeMatchesParsedTree) {
+    for (const char* expr : {
+            "not not name REF around 2.0", "all and (name REF expand 2.0)",
+            "(name REF around 2.0 and elem C) or (name REF around 2.0 and name MID)",
+            "none or (name REF beyond 3.0 and not none)", "name NEAR xor none xor name FAR",
+            "byres name REF and (all and bychain name FAR)"}) {
+        const OESelection sele = OESelection::Parse(expr);
+        const Predicate::Ptr parsed = parse_selection(expr);
+
+        Context ctx(mol_, sele);
+        Bitset expected(mol_.GetMaxAtomIdx());
+        for (OESystem::OEIter<OEChem::OEAtomBase> atom = mol_.GetAtoms(); atom; ++atom) {
+            if (parsed->Evaluate(ctx, *atom)) {
+                expected.Set(atom->GetIdx());
+            }
+        }
+        EXPECT_EQ(sele.EvaluateMask(mol_), expected) << expr;
+        EXPECT_EQ(evaluate_per_atom(mol_, sele), expected) << expr;
+    }
+}
+
+TEST(SpatialBackendTest, ContextChoosesBackendFromSelectionRadii) {
+    OEChem::OEGraphMol mol;
+    for (size_t i = 0; i < SpatialIndex::kCellListMinAtoms; ++i) {
+        OEChem::OEAtomBase* atom = mol.NewAtom(6);
+        float coords[3] = {static_cast<float>(i % 20), static_cast<float>(i / 20 % 20),
+                           static_cast<float>(i / 400)};
+        mol.SetCoords(atom, coords);
+    }
+
+    const auto short_cutoff = OESelection::Parse("index 0 around 5 or index 1 expand 3");
+    Context short_ctx(mol, short_cutoff);
+    EXPECT_EQ(short_ctx.GetSpatialIndex().Backend(), SpatialBackend::CELL_LIST);
+
+    const auto long_cutoff = OESelection::Parse("index 0 around 5 or index 1 beyond 12");
+    Context long_ctx(mol, long_cutoff);
+    EXPECT_EQ(long_ctx.GetSpatialIndex().Backend(), SpatialBackend::KD_TREE);
+
+    // Both backends select the same atoms
+    const auto sele = OESelection::Parse("index 0 around 5");
+    EXPECT_EQ(sele.EvaluateMask(mol), evaluate_per_atom(mol, sele));
+}
+
+TEST_F(DistancePredicateTest, SetFrameRecomputesDistanceSelections) {
+    OESelect sel(mol_, "name REF around 3.0");
+    std::vector<float> xyz(static_cast<size_t>(mol_.GetMaxAtomIdx()) * 3);
+    mol_.GetCoords(xyz.data());
+    EXPECT_EQ(sel.GetMask().ToIndices(), (std::vector<unsigned int>{1}));
+
+    // Swap NEAR and MID along the x axis
+    xyz[1 * 3] = 4.0f;
+    xyz[2 * 3] = 1.5f;
+    sel.SetFrame(xyz.data());
+    EXPECT_EQ(sel.GetMask().ToIndices(), (std::vector<unsigned int>{2}));
+
+    // Coordinates are written back to the molecule
+    std::vector<float> stored(xyz.size());
+    mol_.GetCoords(stored.data());
+    EXPECT_EQ(stored, xyz);
+}
+
+TEST_F(DistancePredicateTest, UnitCellFindsNeighboursAcrossBoxFaces) {
+    // In an 11 A box FAR (x = 10) sits 1 A from REF's image; MID stays 4 A away
+    OESelect sel(mol_, "name REF around 3.0");
+    EXPECT_EQ(sel.GetMask().ToIndices(), (std::vector<unsigned int>{1}));
+    sel.SetUnitCell(UnitCell::Orthorhombic(11.0f, 11.0f, 11.0f));
+    EXPECT_EQ(sel.GetMask().ToIndices(), (std::vector<unsigned int>{1, 3}));
+
+    // Copies made for GetAtoms() keep the cell
+    unsigned int count = 0;
+    for (OESystem::OEIter<OEChem::OEAtomBase> atom = mol_.GetAtoms(sel); atom; ++atom) {
+        ++count;
+    }
+    EXPECT_EQ(count, 2u);
+
+    const OESelection beyond = OESelection::Parse("name REF beyond 3.0");
+    Context ctx(mol_, beyond);
+    ctx.SetUnitCell(UnitCell::Orthorhombic(11.0f, 11.0f, 11.0f));
+    Bitset mask(mol_.GetMaxAtomIdx());
+    ctx.EvaluateSelection(mask);
+    EXPECT_EQ(mask.ToIndices(), (std::vector<unsigned int>{2}));
+
+    // Clearing the cell drops the periodic results
+    ctx.SetUnitCell(UnitCell());
+    Bitset open(mol_.GetMaxAtomIdx());
+    ctx.EvaluateSelection(open);
+    EXPECT_EQ(open.ToIndices(), (std::vector<unsigned int>{2, 3}));
+}
+
+TEST_F(DistancePredicateTest, CopiesShareEvaluationSnapshot) {
+    OESelect sel(mol_, "name REF around 3.0");
+    const OESelect early(sel);
+
+    // Whichever copy evaluates first publishes the mask to the others
+    const Bitset& mask = early.GetMask();
+    EXPECT_EQ(mask.ToIndices(), (std::vector<unsigned int>{1}));
+    EXPECT_EQ(&sel.GetMask(), &mask);
+    const std::unique_ptr<OESystem::OEUnaryFunction<OEChem::OEAtomBase, bool>> copy(sel.CreateCopy());
+    EXPECT_EQ(&static_cast<const OESelect&>(*copy).GetMask(), &mask);
+
+    // Changing a copy's settings gives it private results
+    OESelect periodic(sel);
+    periodic.SetUnitCell(UnitCell::Orthorhombic(11.0f, 11.0f, 11.0f));
+    EXPECT_EQ(periodic.GetMask().ToIndices(), (std::vector<unsigned int>{1, 3}));
+    EXPECT_EQ(sel.GetMask().ToIndices(), (std::vector<unsigned int>{1}));
+    const OESelect periodic_copy(periodic);
+    EXPECT_EQ(&periodic_copy.GetMask(), &periodic.GetMask());
+
+    // A copy made after the molecule changed does not reuse the stale mask
+    OEChem::OEAtomBase* added = mol_.NewAtom(6);
+    const float coords[3] = {0.0f, 2.0f, 0.0f};
+    mol_.SetCoords(added, coords);
+    const OESelect later(sel);
+    EXPECT_NE(&later.GetMask(), &mask);
+    EXPECT_EQ(later.GetMask().ToIndices(), (std::vector<unsigned int>{1, added->GetIdx()}));
+}
+
+TEST_F(DistancePredicateTest, CopiesReevaluateAfterSetCoords) {
+    const OESelect sel(mol_, "name REF around 3.0");
+    const Bitset& mask = sel.GetMask();
+    EXPECT_EQ(mask.ToIndices(), (std::vector<unsigned int>{1}));
+
+    // Move MID next to REF without changing the atom or bond counts
+    std::vector<float> xyz(static_cast<size_t>(mol_.GetMaxAtomIdx()) * 3);
+    mol_.GetCoords(xyz.data());
+    xyz[2 * 3] = 2.0f;
+    mol_.SetCoords(xyz.data());
+
+    const OESelect later(sel);
+    EXPECT_NE(&later.GetMask(), &mask);
+    EXPECT_EQ(later.GetMask().ToIndices(), (std::vector<unsigned int>{1, 2}));
+    EXPECT_EQ(OECount(mol_, later), 2u);
+}
+
+TEST_F(DistancePredicateTest, OwnerAndCopiesAgreeAfterSetCoords) {
+    OESelect sel(mol_, "name REF around 3.0");
+    EXPECT_EQ(sel.GetMask().ToIndices(), (std::vector<unsigned int>{1}));
+    auto matched = [&](const OESelect& selector) {
+        std::vector<unsigned int> atoms;
+        for (OESystem::OEIter<OEChem::OEAtomBase> atom = mol_.GetAtoms(); atom; ++atom) {
+            if (selector(*atom)) atoms.push_back(atom->GetIdx());
+        }
+        return atoms;
+    };
+
+    // A copy evaluating after the move publishes the new mask, and the owner picks it up
+    std::vector<float> xyz(static_cast<size_t>(mol_.GetMaxAtomIdx()) * 3);
+    mol_.GetCoords(xyz.data());
+    const float mid_x = xyz[2 * 3];
+    xyz[2 * 3] = 2.0f;
+    mol_.SetCoords(xyz.data());
+    EXPECT_EQ(OECount(mol_, sel), 2u);
+    EXPECT_EQ(matched(sel), (std::vector<unsigned int>{1, 2}));
+    EXPECT_EQ(sel.GetMask().ToIndices(), (std::vector<unsigned int>{1, 2}));
+
+    // With a live copy, the owner re-evaluates on its own context and the copy follows
+    const OESelect copy(sel);
+    EXPECT_EQ(&copy.GetMask(), &sel.GetMask());
+    xyz[2 * 3] = mid_x;
+    mol_.SetCoords(xyz.data());
+    EXPECT_EQ(matched(sel), (std::vector<unsigned int>{1}));
+    EXPECT_EQ(sel.GetMask().ToIndices(), (std::vector<unsigned int>{1}));
+    EXPECT_EQ(&copy.GetMask(), &sel.GetMask());
+}
+
+TEST_F(DistancePredicateTest, PropertyEditsNeedANewSelector) {
+    const OESelect sel(mol_, "name NEAR or resn ALA");
+    const OESelect copy(sel);
+    EXPECT_EQ(copy.GetMask().ToIndices(), (std::vector<unsigned int>{1}));
+
+    // The fingerprint covers counts and coordinates only, so a rename keeps the shared mask
+    std::vector<OEChem::OEAtomBase*> by_idx;
+    for (OESystem::OEIter<OEChem::OEAtomBase> atom = mol_.GetAtoms(); atom; ++atom) {
+        by_idx.push_back(&*atom);
+    }
+    by_idx[3]->SetName("NEAR");
+    EXPECT_EQ(sel.GetMask().ToIndices(), (std::vector<unsigned int>{1}));
+    EXPECT_EQ(OESelect(mol_, sel.GetSelection()).GetMask().ToIndices(), (std::vector<unsigned int>{1, 3}));
+}
+
+TEST_F(DistancePredicateTest, UpdateCoordinatesKeepsTopologyCaches) {
+    const OESelection sele = OESelection::Parse("(bychain name FAR) or (byres name REF around 3.0)");
+    Context ctx(mol_, sele);
+    Bitset mask(mol_.GetMaxAtomIdx());
+    sele.Root().EvaluateAll(ctx, mask);
+
+    const Predicate* bychain = nullptr;
+    const Predicate* byres = nullptr;
+    for (const auto& child : sele.Root().Children()) {
+        if (child->Type() == PredicateType::BY_CHAIN) bychain = child.get();
+        if (child->Type() == PredicateType::BY_RES) byres = child.get();
+    }
+    ASSERT_NE(bychain, nullptr);
+    ASSERT_NE(byres, nullptr);
+    ASSERT_NE(ctx.GetCachedMask(*bychain), nullptr);
+    ASSERT_NE(ctx.GetCachedMask(*byres), nullptr);
+    const Predicate& around = *byres->Children().front();
+    ASSERT_NE(ctx.GetCachedMask(around), nullptr);
+
+    // Move FAR next to REF
+    std::vector<float> xyz(static_cast<size_t>(mol_.GetMaxAtomIdx()) * 3);
+    mol_.GetCoords(xyz.data());
+    xyz[3 * 3] = -1.0f;
+    ctx.UpdateCoordinates(xyz.data());
+
+    EXPECT_NE(ctx.GetCachedMask(*bychain), nullptr);
+    EXPECT_EQ(ctx.GetCachedMask(*byres), nullptr);
+    EXPECT_EQ(ctx.GetCachedMask(around), nullptr);
+
+    Bitset updated(mol_.GetMaxAtomIdx());
+    sele.Root().EvaluateAll(ctx, updated);
+    EXPECT_EQ(updated, sele.EvaluateMask(mol_));
+}
+
+TEST(ConformerEvaluationTest, MatchesPerConformerEvaluation) {
+    OEChem::OEMol mol;
+    for (const char* name : {"REF", "NEAR", "MID", "FAR"}) {
+        mol.NewAtom(6)->SetName(name);
+    }
+    // REF at the origin; the other atoms slide along x between conformers
+    const float frames[3][12] = {
+        {0, 0, 0, 1.5f, 0, 0, 4.0f, 0, 0, 10.0f, 0, 0},
+        {0, 0, 0, 4.0f, 0, 0, 1.5f, 0, 0, 2.5f, 0, 0},
+        {0, 0, 0, 9.0f, 0, 0, 8.0f, 0, 0, 7.0f, 0, 0},
+    };
+    for (const auto& frame : frames) {
+        mol.NewConf(frame);
+    }
+
+    for (const char* expr : {
+            "name REF around 3.0", "name REF around 3.0 and not name FAR",
+            "byres (name REF expand 3.0)", "name REF beyond 5.0 or name MID", "name MID"}) {
+        const OESelection sele = OESelection::Parse(expr);
+        OEChem::OEConfBase* const active = mol.GetActive();
+        const std::vector<Bitset> masks = EvaluateConformers(mol, sele);
+        EXPECT_EQ(mol.GetActive(), active) << expr;
+        ASSERT_EQ(masks.size(), mol.NumConfs()) << expr;
+
+        size_t i = 0;
+        for (OESystem::OEIter<OEChem::OEConfBase> conf = mol.GetConfs(); conf; ++conf, ++i) {
+            mol.SetActive(&*conf);
+            EXPECT_EQ(masks[i], sele.EvaluateMask(mol)) << expr << " conformer " << i;
+        }
+        mol.SetActive(active);
+    }
+}
+
+TEST_F(DistancePredicateTest, SharedStaticResultsSurviveCoordinateUpdates) {
+    const OESelection sele = OESelection::Parse("name REF around 3.0 and not name FAR");
+    Context ctx(mol_, sele);
+    ctx.SetShareStaticResults(true);
+    Bitset mask(mol_.GetMaxAtomIdx());
+    ctx.EvaluateSubtree(sele.Root(), mask);
+    EXPECT_TRUE(ctx.UsesCoordinates(sele.Root()));
+
+    const Predicate* static_child = nullptr;
+    for (const auto& child : sele.Root().Children()) {
+        if (!ctx.UsesCoordinates(*child)) static_child = child.get();
+    }
+    ASSERT_NE(static_child, nullptr);
+    ASSERT_NE(ctx.GetCachedMask(*static_child), nullptr);
+
+    ctx.UpdateCoordinates();
+    EXPECT_NE(ctx.GetCachedMask(*static_child), nullptr);
+}
+
+namespace {
+/// Uniform random gas of carbon atoms in a cube of side @p box
+void fill_gas(OEChem::OEGraphMol& mol, std::mt19937& rng, const unsigned int count, const float box) {
+    std::uniform_real_distribution<float> dist(0.0f, box);
+    for (unsigned int i = 0; i < count; ++i) {
+        OEChem::OEAtomBase* atom = mol.NewAtom(6);
+        const float xyz[3] = {dist(rng), dist(rng), dist(rng)};
+        mol.SetCoords(atom, xyz);
+    }
+}
+}  // namespace
+
+TEST(VerletSkinTest, MatchesFreshEvaluationAcrossFrames) {
+    for (const bool periodic : {false, true}) {
+        std::mt19937 rng(periodic ? 17 : 5);
+        OEChem::OEGraphMol mol;
+        fill_gas(mol, rng, 3000, 30.0f);
+        const UnitCell cell = periodic ? UnitCell::Orthorhombic(30.0f, 30.0f, 30.0f) : UnitCell();
+
+        const OESelection sele = OESelection::Parse(
+            "(index < 40 around 5) or (index 500-520 expand 3.5 and not index 510) or (index 0-9 beyond 12)");
+        Context ctx(mol, sele);
+        ctx.SetUnitCell(cell);
+        ctx.SetVerletSkin(1.0f);
+        std::vector<float> xyz(static_cast<size_t>(mol.GetMaxAtomIdx()) * 3);
+        mol.GetCoords(xyz.data());
+
+        std::uniform_real_distribution<float> step(-0.02f, 0.02f);
+        for (int frame = 0; frame < 12; ++frame) {
+            if (frame == 8) {
+                // One atom jumps well past skin / 2, forcing a rebuild
+                xyz[3 * 7] += 3.0f;
+            }
+            for (float& x : xyz) {
+                x += step(rng);
+            }
+            ctx.UpdateCoordinates(xyz.data());
+            Bitset mask(mol.GetMaxAtomIdx());
+            ctx.EvaluateSelection(mask);
+
+            Context fresh(mol, sele);
+            fresh.SetUnitCell(cell);
+            Bitset expected(mol.GetMaxAtomIdx());
+            fresh.EvaluateSelection(expected);
+            EXPECT_EQ(mask, expected) << "frame " << frame << (periodic ? " periodic" : "");
+        }
+        // One build per distance predicate, then one more each after the jump
+        EXPECT_EQ(ctx.NumNeighborListBuilds(), 6u) << (periodic ? "periodic" : "");
+    }
+}
+
+TEST(VerletSkinTest, ReferenceChangesRebuildTheList) {
+    std::mt19937 rng(3);
+    OEChem::OEGraphMol mol;
+    fill_gas(mol, rng, 500, 15.0f);
+    // The reference set itself depends on coordinates
+    const OESelection sele = OESelection::Parse("(index 0 around 4) around 2");
+    Context ctx(mol, sele);
+    ctx.SetVerletSkin(0.5f);
+    std::vector<float> xyz(static_cast<size_t>(mol.GetMaxAtomIdx()) * 3);
+    mol.GetCoords(xyz.data());
+    for (int frame = 0; frame < 4; ++frame) {
+        // Atom 0 sweeps through the gas, so the inner shell changes every frame
+        xyz[0] += 1.5f;
+        ctx.UpdateCoordinates(xyz.data());
+        Bitset mask(mol.GetMaxAtomIdx());
+        ctx.EvaluateSelection(mask);
+        EXPECT_EQ(mask, sele.EvaluateMask(mol)) << "frame " << frame;
+    }
+}
+
+TEST(VerletSkinTest, SelectorKeepsSkinAcrossCopies) {
+    std::mt19937 rng(8);
+    OEChem::OEGraphMol mol;
+    fill_gas(mol, rng, 200, 10.0f);
+    OESelect sel(mol, "index < 5 around 3");
+    EXPECT_EQ(sel.GetVerletSkin(), 0.0f);
+    const Bitset before = sel.GetMask();
+    sel.SetVerletSkin(0.8f);
+    EXPECT_EQ(sel.GetMask(), before);
+    EXPECT_EQ(OESelect(sel).GetVerletSkin(), 0.8f);
+
+    std::vector<float> xyz(static_cast<size_t>(mol.GetMaxAtomIdx()) * 3);
+    mol.GetCoords(xyz.data());
+    for (float& x : xyz) {
+        x *= 1.01f;
+    }
+    sel.SetFrame(xyz.data());
+    EXPECT_EQ(sel.GetMask(), OESelection::Parse("index < 5 around 3").EvaluateMask(mol));
+
+    EXPECT_THROW(sel.SetVerletSkin(-1.0f), SelectionError);
+    EXPECT_THROW(sel.SetVerletSkin(std::numeric_limits<float>::infinity()), SelectionError);
+}
+
+namespace {
+/// Atoms of @p side within radius of any atom of @p refs, measured directly
+Bitset brute_near(const std::vector<float>& xyz, const Bitset& side, const Bitset& refs, const float radius,
+                  const float box) {
+    Bitset near(side.Size());
+    side.ForEachSet([&](const size_t a) {
+        refs.ForEachSet([&](const size_t b) {
+            float d2 = 0.0f;
+            for (int d = 0; d < 3; ++d) {
+                float delta = xyz[a * 3 + d] - xyz[b * 3 + d];
+                if (box > 0.0f) {
+                    delta -= box * std::round(delta / box);
+                }
+                d2 += delta * delta;
+            }
+            if (d2 < radius * radius) {
+                near.Set(a);
+            }
+        });
+    });
+    return near;
+}
+
+Bitset index_mask(const size_t size, const std::function<bool(size_t)>& member) {
+    Bitset mask(size);
+    for (size_t i = 0; i < size; ++i) {
+        if (member(i)) mask.Set(i);
+    }
+    return mask;
+}
+}  // namespace
+
+TEST(DomainIndexTest, RestrictedDistanceQueriesMatchBruteForce) {
+    for (const bool periodic : {false, true}) {
+        std::mt19937 rng(periodic ? 23 : 29);
+        OEChem::OEGraphMol mol;
+        fill_gas(mol, rng, 1500, 24.0f);
+        const float box = periodic ? 24.0f : 0.0f;
+        const size_t size = mol.GetMaxAtomIdx();
+        const Bitset all = index_mask(size, [](size_t) { return true; });
+        const Bitset ligand = index_mask(size, [](const size_t i) { return i < 12; });
+        const Bitset water = index_mask(size, [](const size_t i) { return i >= 1200; });
+        const Bitset sparse = index_mask(size, [](const size_t i) { return i % 50 == 7; });
+
+        // Each selection with the mask it must produce from the current coordinates
+        const std::vector<std::pair<std::string, std::function<Bitset(const std::vector<float>&)>>> cases = {
+            {"%wat and (%lig around 5)",
+             [&](const std::vector<float>& xyz) { return brute_near(xyz, water, ligand, 5.0f, box); }},
+            {"%wat and (%lig expand 4)",
+             [&](const std::vector<float>& xyz) { return brute_near(xyz, water, ligand, 4.0f, box); }},
+            {"%sparse and (%wat beyond 3)",
+             [&](const std::vector<float>& xyz) {
+                 Bitset expected = sparse;
+                 expected.AndNot(brute_near(xyz, sparse, water, 3.0f, box));
+                 return expected;
+             }},
+            {"index < 1200 and not (%sparse around 4)",
+             [&](const std::vector<float>& xyz) {
+                 Bitset expected = index_mask(size, [](const size_t i) { return i < 1200; });
+                 Bitset near = brute_near(xyz, all, sparse, 4.0f, box);
+                 near.AndNot(sparse);
+                 expected.AndNot(near);
+                 return expected;
+             }},
+            {"%sparse and (%lig around 6 or %wat around 2)",
+             [&](const std::vector<float>& xyz) {
+                 Bitset a = brute_near(xyz, sparse, ligand, 6.0f, box);
+                 a.AndNot(ligand);
+                 Bitset b = brute_near(xyz, sparse, water, 2.0f, box);
+                 b.AndNot(water);
+                 a |= b;
+                 return a;
+             }},
+        };
+
+        std::vector<float> xyz(size * 3);
+        mol.GetCoords(xyz.data());
+        std::uniform_real_distribution<float> step(-0.4f, 0.4f);
+        for (const auto& [text, expect] : cases) {
+            const OESelection sele = OESelection::Parse(text);
+            Context program(mol, sele);
+            Context tree(mol, sele);
+            for (Context* ctx : {&program, &tree}) {
+                ctx->SetNamedSet("lig", OESelectionResult(ligand));
+                ctx->SetNamedSet("wat", OESelectionResult(water));
+                ctx->SetNamedSet("sparse", OESelectionResult(sparse));
+            }
+            program.SetUnitCell(periodic ? UnitCell::Orthorhombic(box, box, box) : UnitCell());
+            tree.SetUnitCell(program.GetUnitCell());
+            tree.SetProfiling(true);  // Walks the tree instead of the compiled program
+            for (int frame = 0; frame < 3; ++frame) {
+                const Bitset expected = expect(xyz);
+                Bitset from_program(size);
+                program.EvaluateSelection(from_program);
+                EXPECT_EQ(from_program, expected) << text << " frame " << frame << (periodic ? " periodic" : "");
+                Bitset from_tree(size);
+                tree.EvaluateSelection(from_tree);
+                EXPECT_EQ(from_tree, expected) << text << " frame " << frame << (periodic ? " periodic" : "");
+
+                for (float& x : xyz) {
+                    x += step(rng);
+                }
+                program.UpdateCoordinates(xyz.data());
+                tree.UpdateCoordinates(xyz.data());
+            }
+            // Domain indexes are built on the first frame and refitted afterwards
+            EXPECT_GT(program.NumDomainIndexBuilds(), 0u) << text;
+            EXPECT_LE(program.NumDomainIndexBuilds(), 2u) << text;
+        }
+    }
+}
+
+TEST(DomainIndexTest, LargeSidesAndSkinUseTheFullIndex) {
+    std::mt19937 rng(4);
+    OEChem::OEGraphMol mol;
+    fill_gas(mol, rng, 600, 14.0f);
+    const OESelection sele = OESelection::Parse("index >= 200 and (index < 400 expand 2)");
+    const Bitset expected = evaluate_per_atom(mol, sele);
+
+    // Both sides cover most of the molecule
+    Context ctx(mol, sele);
+    Bitset mask(mol.GetMaxAtomIdx());
+    ctx.EvaluateSelection(mask);
+    EXPECT_EQ(mask, expected);
+    EXPECT_EQ(ctx.NumDomainIndexBuilds(), 0u);
+
+    // Neighbor lists cover the molecule, so the domain is applied afterwards
+    const OESelection small = OESelection::Parse("index < 30 and (index >= 100 around 2)");
+    Context skin(mol, small);
+    skin.SetVerletSkin(0.5f);
+    Bitset skin_mask(mol.GetMaxAtomIdx());
+    skin.EvaluateSelection(skin_mask);
+    EXPECT_EQ(skin_mask, evaluate_per_atom(mol, small));
+    EXPECT_EQ(skin.NumDomainIndexBuilds(), 0u);
+    EXPECT_EQ(skin.NumNeighborListBuilds(), 1u);
+}
+
+TEST(DomainIndexTest, RadiusIsPartOfTheKey) {
+    std::mt19937 rng(5);
+    OEChem::OEGraphMol mol;
+    fill_gas(mol, rng, 600, 14.0f);
+    // One small domain queried at two cutoffs needs a cell list sized to each
+    const OESelection sele = OESelection::Parse(
+        "(index < 30 and (index >= 100 around 1.5)) or (index < 30 and (index >= 100 around 6))");
+    Context ctx(mol, sele);
+    std::vector<float> xyz(size_t{mol.GetMaxAtomIdx()} * 3);
+    mol.GetCoords(xyz.data());
+    std::uniform_real_distribution<float> step(-0.4f, 0.4f);
+    for (int frame = 0; frame < 2; ++frame) {
+        Bitset mask(mol.GetMaxAtomIdx());
+        ctx.EvaluateSelection(mask);
+        EXPECT_EQ(mask, evaluate_per_atom(mol, sele)) << "frame " << frame;
+        for (float& x : xyz) {
+            x += step(rng);
+        }
+        mol.SetCoords(xyz.data());
+        ctx.UpdateCoordinates(xyz.data());
+    }
+    // Built once per cutoff, then refitted
+    EXPECT_EQ(ctx.NumDomainIndexBuilds(), 2u);
+}
+
+TEST_F(DistancePredicateTest, AroundEvaluatesReferenceOnce) {
+    const OESelection sele = OESelection::Parse("name REF around 5.0");
+    Context ctx(mol_, sele);
+    ctx.SetProfiling(true);
+    for (int pass = 0; pass < 2; ++pass) {
+        Bitset mask(mol_.GetMaxAtomIdx());
+        ctx.EvaluateSelection(mask);
+        EXPECT_EQ(mask.ToIndices(), (std::vector<unsigned int>{1, 2})) << "pass " << pass;
+    }
+
+    // The reference feeds the radius query once; the cached result already excludes it
+    const EvaluationProfile profile = ctx.GetProfile();
+    const std::vector<NodeProfile>& nodes = profile.Nodes();
+    const auto reference = std::find_if(nodes.begin(), nodes.end(), [](const NodeProfile& node) {
+        return node.type == PredicateType::NAME;
+    });
+    ASSERT_NE(reference, nodes.end());
+    EXPECT_EQ(reference->evaluations, 1u);
+}
+
+TEST_F(DistancePredicateTest, ProfileAnnotatesEvaluatedTree) {
+    OESelect plain(mol_, "name REF around 5.0 and not name MID");
+    EXPECT_TRUE(plain.GetProfile().Nodes().empty());
+
+    OESelect sel(mol_, "name REF around 5.0 and not name MID");
+    sel.SetProfiling(true);
+    EXPECT_EQ(sel.GetMask(), plain.GetMask());
+
+    const EvaluationProfile profile = sel.GetProfile();
+    const std::vector<NodeProfile>& nodes = profile.Nodes();
+    ASSERT_FALSE(nodes.empty());
+    EXPECT_EQ(nodes[0].label, sel.GetSelection().Root().ToCanonical());
+    EXPECT_EQ(nodes[0].depth, 0u);
+    EXPECT_EQ(nodes[0].evaluations, 1u);
+    EXPECT_EQ(nodes[0].atoms_evaluated, mol_.NumAtoms());
+    EXPECT_EQ(nodes[0].atoms_matched, 1u);  // NEAR
+    EXPECT_DOUBLE_EQ(nodes[0].Selectivity(), 0.25);
+    EXPECT_GE(nodes[0].seconds, nodes[0].self_seconds);
+
+    const auto around = std::find_if(nodes.begin(), nodes.end(), [](const NodeProfile& node) {
+        return node.type == PredicateType::AROUND;
+    });
+    ASSERT_NE(around, nodes.end());
+    EXPECT_EQ(around->depth, 1u);
+    EXPECT_EQ(around->spatial_queries, 1u);
+    EXPECT_EQ(around->cache_misses, 1u);
+    EXPECT_EQ(around->atoms_evaluated, 3u);  // Restricted to the atoms not named MID
+    EXPECT_EQ(around->atoms_matched, 1u);    // NEAR
+
+    const std::string report = profile.ToString();
+    EXPECT_NE(report.find("  name REF around 5"), std::string::npos) << report;
+    EXPECT_NE(report.find("spatial=1"), std::string::npos) << report;
+
+    // Re-enabling starts over; disabling drops the statistics
+    sel.SetProfiling(true);
+    EXPECT_EQ(sel.GetProfile().Nodes()[0].evaluations, 0u);
+    sel.SetProfiling(false);
+    EXPECT_TRUE(sel.GetProfile().Nodes().empty());
+    EXPECT_EQ(sel.GetMask(), plain.GetMask());
+}
@@ -0,0 +1,259 @@
+// tests/cpp/test_selection_result.cpp
+// Unit tests for compressed selection results and named sets.
+
+#include <gtest/gtest.h>
+
+#include <oeselect/oeselect.h>
+#include <oechem.h>
+
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace OESel;
+
+namespace {
+/// Random mask mixing scattered bits, dense stretches, and an empty stretch
+Bitset random_mask(std::mt19937& rng, const size_t size) {
+    Bitset mask(size);
+    std::uniform_int_distribution<size_t> pick(0, size - 1);
+    for (size_t i = 0; i < size / 50; ++i) {
+        mask.Set(pick(rng));
+    }
+    for (size_t r = 0; r < 8; ++r) {
+        const size_t begin = pick(rng);
+        mask.SetRange(begin, std::min(size, begin + pick(rng) % 3000));
+    }
+    // One chunk of dense scattered bits, stored as a bitmap
+    std::bernoulli_distribution coin(0.5);
+    for (size_t i = 70000; i < std::min(size, size_t{80000}); ++i) {
+        if (coin(rng)) mask.Set(i);
+    }
+    return mask;
+}
+
+Bitset bitset_and(Bitset a, const Bitset& b) { return a &= b; }
+Bitset bitset_or(Bitset a, const Bitset& b) { return a |= b; }
+Bitset bitset_xor(Bitset a, const Bitset& b) { return a ^= b; }
+
+/// Three residues of four atoms each: ALA 1, GLY 2, HOH 3
+std::unique_ptr<OEChem::OEGraphMol> make_mol() {
+    auto mol = std::make_unique<OEChem::OEGraphMol>();
+    const char* names[] = {"N", "CA", "C", "O"};
+    const char* resnames[] = {"ALA", "GLY", "HOH"};
+    for (int r = 0; r < 3; ++r) {
+        for (int a = 0; a < 4; ++a) {
+            OEChem::OEAtomBase* atom = mol->NewAtom(a == 3 ? 8 : (a == 0 ? 7 : 6));
+            atom->SetName(names[a]);
+            float coords[3] = {static_cast<float>(r * 4 + a), 0.0f, 0.0f};
+            mol->SetCoords(atom, coords);
+            OEChem::OEResidue res;
+            res.SetName(resnames[r]);
+            res.SetResidueNumber(r + 1);
+            res.SetChainID('A');
+            OEChem::OEAtomSetResidue(atom, res);
+        }
+    }
+    return mol;
+}
+}  // namespace
+
+TEST(SelectionResultTest, EmptyResult) {
+    const OESelectionResult result(100);
+    EXPECT_EQ(result.Size(), 100u);
+    EXPECT_EQ(result.Count(), 0u);
+    EXPECT_TRUE(result.None());
+    EXPECT_FALSE(result.Contains(5));
+    EXPECT_TRUE(result.ToIndices().empty());
+    EXPECT_EQ(result.MemoryUsage(), 0u);
+}
+
+TEST(SelectionResultTest, PicksCompactEncodings) {
+    constexpr size_t size = 65536;
+
+    // A long contiguous run is a single [first, last] pair
+    Bitset run(size);
+    run.SetRange(1000, 40000);
+    const OESelectionResult runs(run);
+    EXPECT_EQ(runs.Count(), 39000u);
+    EXPECT_LT(runs.MemoryUsage(), 128u);
+
+    // A few scattered atoms are a short sorted array
+    const OESelectionResult sparse = OESelectionResult::FromIndices(size, {7, 3, 60000, 3});
+    EXPECT_EQ(sparse.Count(), 3u);
+    EXPECT_LT(sparse.MemoryUsage(), 128u);
+
+    // Every other atom is too dense for an array or runs: one 8 KiB bitmap
+    Bitset alternating(size);
+    for (size_t i = 0; i < size; i += 2) {
+        alternating.Set(i);
+    }
+    const OESelectionResult dense(alternating);
+    EXPECT_EQ(dense.Count(), size / 2);
+    EXPECT_GE(dense.MemoryUsage(), 8192u);
+    EXPECT_LT(dense.MemoryUsage(), 8192u + 128u);
+}
+
+TEST(SelectionResultTest, RoundTripsMasks) {
+    std::mt19937 rng(11);
+    for (const size_t size : {size_t{1}, size_t{63}, size_t{65536}, size_t{65537}, size_t{200001}}) {
+        const Bitset mask = random_mask(rng, size);
+        const OESelectionResult result(mask);
+        EXPECT_EQ(result.Size(), size);
+        EXPECT_EQ(result.Count(), mask.Count());
+        EXPECT_EQ(result.ToBitset(), mask);
+        EXPECT_EQ(result.ToIndices(), mask.ToIndices());
+        for (const unsigned int idx : {0u, 1u, 62u, 65535u, 65536u, 70001u, 199999u}) {
+            EXPECT_EQ(result.Contains(idx), idx < size && mask.Test(idx)) << size << " " << idx;
+        }
+        EXPECT_FALSE(result.Contains(size));
+    }
+}
+
+TEST(SelectionResultTest, SetAlgebraMatchesBitset) {
+    std::mt19937 rng(23);
+    for (const size_t size : {size_t{130}, size_t{65536 * 3 + 17}}) {
+        for (int trial = 0; trial < 4; ++trial) {
+            const Bitset a = random_mask(rng, size);
+            const Bitset b = random_mask(rng, size);
+            const OESelectionResult ra(a);
+            const OESelectionResult rb(b);
+
+            EXPECT_EQ((ra & rb).ToBitset(), bitset_and(a, b));
+            EXPECT_EQ((ra | rb).ToBitset(), bitset_or(a, b));
+            EXPECT_EQ((ra ^ rb).ToBitset(), bitset_xor(a, b));
+            OESelectionResult diff = ra;
+            diff.AndNot(rb);
+            Bitset expected = a;
+            expected.AndNot(b);
+            EXPECT_EQ(diff.ToBitset(), expected);
+
+            // Results built through the operators compare equal to results built from masks
+            EXPECT_EQ(ra | rb, OESelectionResult(bitset_or(a, b)));
+            EXPECT_EQ((ra & rb).Count(), bitset_and(a, b).Count());
+        }
+    }
+}
+
+TEST(SelectionResultTest, SelfOperands) {
+    std::mt19937 rng(4);
+    const Bitset mask = random_mask(rng, 100000);
+    OESelectionResult result(mask);
+    const OESelectionResult copy = result;
+    result &= result;
+    EXPECT_EQ(result, copy);
+    result |= result;
+    EXPECT_EQ(result, copy);
+    result ^= result;
+    EXPECT_TRUE(result.None());
+}
+
+TEST(SelectionResultTest, OtherOperandIsClippedToSize) {
+    const OESelectionResult small = OESelectionResult::FromIndices(10, {1, 2});
+    const OESelectionResult large = OESelectionResult::FromIndices(100, {2, 50, 99});
+    OESelectionResult u = small;
+    u |= large;
+    EXPECT_EQ(u.Size(), 10u);
+    EXPECT_EQ(u.ToIndices(), (std::vector<unsigned int>{1, 2}));
+
+    Bitset painted(5);
+    large.Paint(painted);
+    EXPECT_EQ(painted.ToIndices(), (std::vector<unsigned int>{2}));
+}
+
+TEST(SelectionResultTest, FromIndicesRejectsOutOfRange) {
+    EXPECT_THROW(static_cast<void>(OESelectionResult::FromIndices(10, {3, 10})), SelectionError);
+}
+
+TEST(SelectionResultTest, ForEachVisitsMembersInOrder) {
+    Bitset mask(140000);
+    mask.SetRange(10, 20);
+    mask.Set(65540);
+    mask.SetRange(139990, 140000);
+    std::vector<unsigned int> visited;
+    OESelectionResult(mask).ForEach([&visited](const size_t idx) {
+        visited.push_back(static_cast<unsigned int>(idx));
+    });
+    EXPECT_EQ(visited, mask.ToIndices());
+}
+
+TEST(SelectionResultTest, OpenEyePredicate) {
+    auto mol = make_mol();
+    OESelect site(*mol, "resn GLY");
+    const OEInSelectionResult in_site(site.GetResult());
+    EXPECT_EQ(OEChem::OECount(*mol, in_site), 4u);
+
+    std::unique_ptr<OESystem::OEUnaryFunction<OEChem::OEAtomBase, bool>> copy(in_site.CreateCopy());
+    unsigned int matched = 0;
+    for (OESystem::OEIter<OEChem::OEAtomBase> atom = mol->GetAtoms(); atom; ++atom) {
+        if ((*copy)(*atom)) ++matched;
+    }
+    EXPECT_EQ(matched, 4u);
+}
+
+TEST(SelectionResultTest, NamedSetInSelection) {
+    auto mol = make_mol();
+    const OESelectionResult site = OESelect(*mol, "resi 1-2").GetResult();
+
+    OESelect sel(*mol, "%site and name CA");
+    sel.SetNamedSet("site", site);
+    EXPECT_EQ(sel.GetMask().ToIndices(), (std::vector<unsigned int>{1, 5}));
+
+    // Copies keep the binding
+    const OESelect copy(sel);
+    EXPECT_EQ(copy.GetMask().ToIndices(), (std::vector<unsigned int>{1, 5}));
+
+    // Rebinding discards the cached mask
+    sel.SetNamedSet("site", OESelect(*mol, "resn HOH").GetResult());
+    EXPECT_EQ(sel.GetMask().ToIndices(), (std::vector<unsigned int>{9}));
+
+    OESelect negated(*mol, "not %site");
+    negated.SetNamedSet("site", site);
+    EXPECT_EQ(negated.GetMask().Count(), 4u);
+    EXPECT_EQ(OESelection::Parse("%site or %other_2").ToCanonical(), "(%other_2 or %site)");
+}
+
+TEST(SelectionResultTest, NamedSetErrors) {
+    auto mol = make_mol();
+    OESelect unbound(*mol, "%missing");
+    EXPECT_THROW(static_cast<void>(unbound.GetMask()), SelectionError);
+
+    OESelect mismatched(*mol, "%site");
+    mismatched.SetNamedSet("site", OESelectionResult(5));
+    EXPECT_THROW(static_cast<void>(mismatched.GetMask()), SelectionError);
+
+    EXPECT_THROW(mismatched.SetNamedSet("1site", OESelectionResult(12)), SelectionError);
+    EXPECT_THROW(mismatched.SetNamedSet("", OESelectionResult(12)), SelectionError);
+    EXPECT_THROW(OESelection::Parse("%"), SelectionError);
+}
+
+TEST(SelectionResultTest, ContextNamedSetBindings) {
+    auto mol = make_mol();
+    const OESelection sele = OESelection::Parse("%a");
+    Context ctx(*mol, sele);
+    ctx.SetNamedSet("a", OESelectionResult::FromIndices(12, {0, 11}));
+    Bitset mask(12);
+    ctx.EvaluateSelection(mask);
+    EXPECT_EQ(mask.ToIndices(), (std::vector<unsigned int>{0, 11}));
+
+    // Per-atom tests share the resolved set, and rebinding on the same context is seen
+    auto matched = [&] {
+        std::vector<unsigned int> indices;
+        for (OESystem::OEIter<OEChem::OEAtomBase> atom = mol->GetAtoms(); atom; ++atom) {
+            if (sele.Root().Evaluate(ctx, *atom)) indices.push_back(atom->GetIdx());
+        }
+        return indices;
+    };
+    EXPECT_EQ(matched(), (std::vector<unsigned int>{0, 11}));
+    ctx.SetNamedSet("a", OESelectionResult::FromIndices(12, {3}));
+    EXPECT_EQ(matched(), (std::vector<unsigned int>{3}));
+    ctx.SetNamedSet("a", OESelectionResult::FromIndices(12, {0, 11}));
+
+    // Bindings survive Reset()
+    ctx.Reset(*mol);
+    EXPECT_EQ(ctx.GetNamedSets().size(), 1u);
+    EXPECT_TRUE(ctx.RemoveNamedSet("a"));
+    EXPECT_FALSE(ctx.RemoveNamedSet("a"));
+    EXPECT_THROW(static_cast<void>(ctx.GetNamedSet("a")), SelectionError);
+}
@@ -0,0 +1,127 @@
+// tests/cpp/test_selection_set.cpp
+// Unit tests for fused multi-selection evaluation.
+
+#include <gtest/gtest.h>
+
+#include <oeselect/oeselect.h>
+#include <oechem.h>
+
+#include "test_molecules.h"
+
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace OESel;
+using namespace OESelTest;
+
+namespace {
+std::vector<OESelection> parse_all(const std::vector<std::string>& texts) {
+    std::vector<OESelection> selections;
+    for (const std::string& text : texts) {
+        selections.push_back(OESelection::Parse(text));
+    }
+    return selections;
+}
+}  // namespace
+
+TEST(SelectionSetTest, MatchesIndividualEvaluation) {
+    const std::vector<OESelection> selections = parse_all({
+        "protein",
+        "ligand around 4",
+        "ligand around 6",
+        "ligand expand 4",
+        "byres (ligand around 5)",
+        "backbone and chain A",
+        "",
+        "protein and not (ligand around 4)",
+        "water beyond 6 or name CA",
+        "ligand around 4",
+    });
+    SelectionSet set(selections);
+    ASSERT_EQ(set.Size(), selections.size());
+
+    std::mt19937 rng(17);
+    std::vector<Bitset> masks;
+    for (const unsigned int size : {6U, 1U, 14U, 6U}) {
+        auto mol = make_complex(rng, size);
+        set.EvaluateMasks(*mol, masks);
+        ASSERT_EQ(masks.size(), selections.size());
+        const std::vector<unsigned int> counts = set.Count(*mol);
+        const auto indices = set.Select(*mol);
+        for (size_t i = 0; i < selections.size(); ++i) {
+            const Bitset expected = selections[i].EvaluateMask(*mol);
+            EXPECT_EQ(masks[i], expected) << "residues=" << size << " selection=" << i;
+            EXPECT_EQ(counts[i], expected.Count());
+            EXPECT_EQ(indices[i], expected.ToIndices());
+        }
+    }
+}
+
+TEST(SelectionSetTest, SharesSubexpressionsAcrossSelections) {
+    const std::vector<OESelection> selections = parse_all({
+        "ligand around 4",
+        "protein and (ligand around 4)",
+        "byres (ligand around 4)",
+    });
+    unsigned int separate = 0;
+    for (const OESelection& sele : selections) {
+        separate += sele.NumSlots();
+    }
+    SelectionSet set(selections);
+    const OESelection& merged = set.GetMergedSelection();
+    // "ligand", the distance query, and "protein" each appear once, plus the grouping root
+    EXPECT_LT(merged.NumSlots(), separate);
+    EXPECT_EQ(merged.Root().Children().size(), selections.size());
+
+    // The inputs keep their own numbering and results
+    std::mt19937 rng(2);
+    auto mol = make_complex(rng, 8);
+    const std::vector<Bitset> masks = set.EvaluateMasks(*mol);
+    for (size_t i = 0; i < selections.size(); ++i) {
+        EXPECT_EQ(masks[i], selections[i].EvaluateMask(*mol));
+        EXPECT_EQ(set.GetSelection(i).ToCanonical(), selections[i].ToCanonical());
+    }
+    EXPECT_THROW(static_cast<void>(set.GetSelection(selections.size())), SelectionError);
+}
+
+TEST(SelectionSetTest, CopiesShareTreeWithSeparateContexts) {
+    const SelectionSet original(parse_all({"ligand around 5", "not water"}));
+    SelectionSet copy(original);
+    EXPECT_EQ(&copy.GetMergedSelection().Root(), &original.GetMergedSelection().Root());
+
+    std::mt19937 rng(8);
+    auto first = make_complex(rng, 4);
+    auto second = make_complex(rng, 9);
+    SelectionSet other(original);
+    const std::vector<Bitset> a = copy.EvaluateMasks(*first);
+    const std::vector<Bitset> b = other.EvaluateMasks(*second);
+    EXPECT_EQ(a[0], OESelection::Parse("ligand around 5").EvaluateMask(*first));
+    EXPECT_EQ(b[1], OESelection::Parse("not water").EvaluateMask(*second));
+}
+
+TEST(SelectionSetTest, RepeatedMergesReuseTree) {
+    const std::vector<OESelection> selections = parse_all({"ligand around 4", "protein"});
+    const SelectionSet first(selections);
+    const SelectionSet second(parse_all({"ligand around 4", "protein"}));
+    EXPECT_EQ(&first.GetMergedSelection().Root(), &second.GetMergedSelection().Root());
+
+    // The same selections in another order are merged separately
+    const SelectionSet reordered(parse_all({"protein", "ligand around 4"}));
+    EXPECT_NE(&reordered.GetMergedSelection().Root(), &first.GetMergedSelection().Root());
+    EXPECT_EQ(reordered.GetMergedSelection().Root().Children()[0]->ToCanonical(), "protein");
+
+    OESelection::ClearParseCache();
+    const SelectionSet rebuilt(selections);
+    EXPECT_NE(&rebuilt.GetMergedSelection().Root(), &first.GetMergedSelection().Root());
+}
+
+TEST(SelectionSetTest, ExposesEvaluationContext) {
+    SelectionSet set(parse_all({"protein"}));
+    EXPECT_THROW(static_cast<void>(set.GetContext()), SelectionError);
+    std::mt19937 rng(2);
+    auto mol = make_complex(rng, 3);
+    static_cast<void>(set.EvaluateMasks(*mol));
+    EXPECT_EQ(&set.GetContext().Mol(), mol.get());
+}
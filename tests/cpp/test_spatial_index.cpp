@@ -1,11 +1,17 @@
 // tests/cpp/test_spatial_index.cpp
 #include <gtest/gtest.h>
 
+#include <oeselect/Bitset.h>
 #include <oeselect/SpatialIndex.h>
 #include <oechem.h>
 
 #include <algorithm>
+#include <array>
 #include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <utility>
 
 using namespace OESel;
 
@@ -248,3 +254,568 @@ TEST_F(SpatialIndexTest, ReturnsCorrectAtomIndices) {
     std::sort(expected_indices.begin(), expected_indices.end());
     EXPECT_EQ(result, expected_indices);
 }
+
+TEST_F(SpatialIndexTest, MarkWithinRadiusMatchesPerAtomQueries) {
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> dist(0.0f, 30.0f);
+    for (int i = 0; i < 1500; ++i) {
+        OEChem::OEAtomBase* atom = mol_->NewAtom(6);
+        float coords[3] = {dist(rng), dist(rng), dist(rng)};
+        mol_->SetCoords(atom, coords);
+    }
+    // A distant outlier forces the grid to coarsen its cells
+    OEChem::OEAtomBase* outlier = mol_->NewAtom(8);
+    float far_coords[3] = {5000.0f, -5000.0f, 5000.0f};
+    mol_->SetCoords(outlier, far_coords);
+
+    SpatialIndex index(*mol_);
+    Bitset refs(mol_->GetMaxAtomIdx());
+    for (unsigned int i = 0; i < refs.Size(); i += 37) {
+        refs.Set(i);
+    }
+    refs.Set(outlier->GetIdx());
+
+    for (const float radius : {0.0f, 0.5f, 3.0f, 4.5f, 8.0f, 40.0f}) {
+        Bitset expected(mol_->GetMaxAtomIdx());
+        for (OESystem::OEIter<OEChem::OEAtomBase> atom = mol_->GetAtoms(); atom; ++atom) {
+            if (refs.Test(atom->GetIdx())) {
+                for (const unsigned int idx : index.FindWithinRadius(*atom, radius)) {
+                    expected.Set(idx);
+                }
+            }
+        }
+
+        Bitset actual(mol_->GetMaxAtomIdx());
+        index.MarkWithinRadius(refs, radius, actual);
+        EXPECT_EQ(actual, expected) << "radius=" << radius;
+    }
+}
+
+TEST_F(SpatialIndexTest, MarkWithinRadiusKeepsExistingBits) {
+    OEChem::OEAtomBase* a1 = mol_->NewAtom(6);
+    OEChem::OEAtomBase* a2 = mol_->NewAtom(6);
+    OEChem::OEAtomBase* a3 = mol_->NewAtom(6);
+    float c1[3] = {0.0f, 0.0f, 0.0f};
+    float c2[3] = {1.0f, 0.0f, 0.0f};
+    float c3[3] = {20.0f, 0.0f, 0.0f};
+    mol_->SetCoords(a1, c1);
+    mol_->SetCoords(a2, c2);
+    mol_->SetCoords(a3, c3);
+
+    SpatialIndex index(*mol_);
+    Bitset refs(mol_->GetMaxAtomIdx());
+    refs.Set(a1->GetIdx());
+    Bitset out(mol_->GetMaxAtomIdx());
+    out.Set(a3->GetIdx());
+
+    index.MarkWithinRadius(refs, 2.0f, out);
+    EXPECT_EQ(out.ToIndices(), (std::vector<unsigned int>{a1->GetIdx(), a2->GetIdx(), a3->GetIdx()}));
+}
+
+TEST_F(SpatialIndexTest, ChooseBackend) {
+    EXPECT_EQ(SpatialIndex::ChooseBackend(100000, 4.0f), SpatialBackend::CELL_LIST);
+    EXPECT_EQ(SpatialIndex::ChooseBackend(100000, 0.0f), SpatialBackend::KD_TREE);
+    EXPECT_EQ(SpatialIndex::ChooseBackend(100000, 20.0f), SpatialBackend::KD_TREE);
+    EXPECT_EQ(SpatialIndex::ChooseBackend(50, 4.0f), SpatialBackend::KD_TREE);
+
+    EXPECT_EQ(SpatialIndex(*mol_).Backend(), SpatialBackend::KD_TREE);
+    EXPECT_EQ(SpatialIndex(*mol_, SpatialBackend::CELL_LIST, 4.0f).Backend(), SpatialBackend::CELL_LIST);
+    EXPECT_EQ(SpatialIndex(*mol_, SpatialBackend::AUTO, 4.0f).Backend(), SpatialBackend::KD_TREE);
+}
+
+TEST_F(SpatialIndexTest, CellListMatchesKdTree) {
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> dist(-20.0f, 20.0f);
+    for (int i = 0; i < 800; ++i) {
+        OEChem::OEAtomBase* atom = mol_->NewAtom(6);
+        float coords[3] = {dist(rng), dist(rng), dist(rng)};
+        mol_->SetCoords(atom, coords);
+    }
+
+    const SpatialIndex tree(*mol_, SpatialBackend::KD_TREE);
+    Bitset refs(mol_->GetMaxAtomIdx());
+    for (unsigned int i = 0; i < refs.Size(); i += 23) {
+        refs.Set(i);
+    }
+
+    // Cell sizes below, at, and above the query radii
+    for (const float cell : {2.0f, 4.0f, 9.0f}) {
+        const SpatialIndex grid(*mol_, SpatialBackend::CELL_LIST, cell);
+        ASSERT_EQ(grid.Size(), tree.Size());
+        for (const float radius : {0.0f, 1.5f, 4.0f, 7.5f, 60.0f}) {
+            for (const float q : {-25.0f, -3.3f, 0.0f, 12.7f}) {
+                auto expected = tree.FindWithinRadius(q, -q, q * 0.5f, radius);
+                auto actual = grid.FindWithinRadius(q, -q, q * 0.5f, radius);
+                std::sort(expected.begin(), expected.end());
+                std::sort(actual.begin(), actual.end());
+                EXPECT_EQ(actual, expected) << "cell=" << cell << " radius=" << radius << " q=" << q;
+            }
+
+            Bitset expected_mask(mol_->GetMaxAtomIdx());
+            Bitset actual_mask(mol_->GetMaxAtomIdx());
+            tree.MarkWithinRadius(refs, radius, expected_mask);
+            grid.MarkWithinRadius(refs, radius, actual_mask);
+            EXPECT_EQ(actual_mask, expected_mask) << "cell=" << cell << " radius=" << radius;
+        }
+    }
+}
+
+TEST_F(SpatialIndexTest, CellListEmptyMolecule) {
+    const SpatialIndex index(*mol_, SpatialBackend::CELL_LIST, 4.0f);
+    EXPECT_EQ(index.Size(), 0);
+    EXPECT_TRUE(index.FindWithinRadius(0.0f, 0.0f, 0.0f, 5.0f).empty());
+}
+
+TEST_F(SpatialIndexTest, CellListBoundsExtremeGrids) {
+    // A tiny cutoff over a huge extent would need more cells than size_t can count
+    const float positions[4][3] = {
+        {-3.0e38f, 0.0f, 0.0f}, {3.0e38f, 1.0e38f, -1.0e38f}, {0.0f, 0.0f, 0.0f}, {1.0e-7f, 0.0f, 0.0f}};
+    for (const auto& p : positions) {
+        mol_->SetCoords(mol_->NewAtom(6), p);
+    }
+    for (const float cutoff : {1.0e-6f, 0.0f, std::numeric_limits<float>::denorm_min()}) {
+        const SpatialIndex grid(*mol_, SpatialBackend::CELL_LIST, cutoff);
+        auto near = grid.FindWithinRadius(0.0f, 0.0f, 0.0f, 1.0e-6f);
+        std::sort(near.begin(), near.end());
+        EXPECT_EQ(near, (std::vector<unsigned int>{2, 3})) << cutoff;
+    }
+
+    // A periodic box much larger than the cutoff is tiled within the cell budget
+    OEChem::OEGraphMol boxed;
+    const float inside[3][3] = {{0.0f, 0.0f, 0.0f}, {1.0e-7f, 0.0f, 0.0f}, {5.0e29f, 5.0e29f, 0.0f}};
+    for (const auto& p : inside) {
+        boxed.SetCoords(boxed.NewAtom(6), p);
+    }
+    const UnitCell box = UnitCell::Orthorhombic(1.0e30f, 1.0e30f, 1.0e30f);
+    const SpatialIndex periodic(boxed, SpatialBackend::CELL_LIST, 1.0e-6f, box);
+    auto near = periodic.FindWithinRadius(0.0f, 0.0f, 0.0f, 1.0e-6f);
+    std::sort(near.begin(), near.end());
+    EXPECT_EQ(near, (std::vector<unsigned int>{0, 1}));
+}
+
+TEST_F(SpatialIndexTest, UpdateCoordinatesMatchesRebuild) {
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> dist(-15.0f, 15.0f);
+    for (int i = 0; i < 600; ++i) {
+        OEChem::OEAtomBase* atom = mol_->NewAtom(6);
+        float coords[3] = {dist(rng), dist(rng), dist(rng)};
+        mol_->SetCoords(atom, coords);
+    }
+    Bitset refs(mol_->GetMaxAtomIdx());
+    for (unsigned int i = 0; i < refs.Size(); i += 17) {
+        refs.Set(i);
+    }
+
+    for (const SpatialBackend backend : {SpatialBackend::KD_TREE, SpatialBackend::CELL_LIST}) {
+        SpatialIndex index(*mol_, backend, 4.0f);
+        std::vector<float> xyz(static_cast<size_t>(mol_->GetMaxAtomIdx()) * 3);
+        mol_->GetCoords(xyz.data());
+
+        // A small jitter keeps the grid geometry; a large shift forces a new one
+        for (const float shift : {0.0f, 40.0f}) {
+            std::uniform_real_distribution<float> jitter(-1.0f, 1.0f);
+            for (float& v : xyz) {
+                v += jitter(rng) + shift;
+            }
+            mol_->SetCoords(xyz.data());
+            index.UpdateCoordinates(xyz.data());
+
+            const SpatialIndex fresh(*mol_, backend, 4.0f);
+            for (const float radius : {2.5f, 4.0f, 9.0f}) {
+                auto expected = fresh.FindWithinRadius(shift, shift, shift, radius);
+                auto actual = index.FindWithinRadius(shift, shift, shift, radius);
+                std::sort(expected.begin(), expected.end());
+                std::sort(actual.begin(), actual.end());
+                EXPECT_EQ(actual, expected) << "shift=" << shift << " radius=" << radius;
+
+                Bitset expected_mask(mol_->GetMaxAtomIdx());
+                Bitset actual_mask(mol_->GetMaxAtomIdx());
+                fresh.MarkWithinRadius(refs, radius, expected_mask);
+                index.MarkWithinRadius(refs, radius, actual_mask);
+                EXPECT_EQ(actual_mask, expected_mask) << "shift=" << shift << " radius=" << radius;
+            }
+        }
+    }
+}
+
+TEST_F(SpatialIndexTest, FindPairsMatchesBruteForce) {
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> dist(0.0f, 20.0f);
+    std::vector<std::array<float, 3>> coords;
+    for (int i = 0; i < 800; ++i) {
+        OEChem::OEAtomBase* atom = mol_->NewAtom(6);
+        float xyz[3] = {dist(rng), dist(rng), dist(rng)};
+        mol_->SetCoords(atom, xyz);
+        coords.push_back({xyz[0], xyz[1], xyz[2]});
+    }
+
+    // Overlapping reference and target sets exercise self-pair exclusion
+    Bitset refs(mol_->GetMaxAtomIdx());
+    Bitset targets(mol_->GetMaxAtomIdx());
+    for (unsigned int i = 0; i < refs.Size(); ++i) {
+        if (i % 3 == 0) refs.Set(i);
+        if (i % 2 == 0) targets.Set(i);
+    }
+
+    for (const SpatialBackend backend : {SpatialBackend::KD_TREE, SpatialBackend::CELL_LIST}) {
+        SpatialIndex index(*mol_, backend, 4.0f);
+        for (const float radius : {0.0f, 1.5f, 4.0f, 7.0f}) {
+            std::vector<unsigned int> expected_first, expected_second;
+            std::vector<float> expected_d2;
+            for (unsigned int i = 0; i < coords.size(); ++i) {
+                if (!refs.Test(i)) continue;
+                for (unsigned int j = 0; j < coords.size(); ++j) {
+                    if (i == j || !targets.Test(j)) continue;
+                    const float dx = coords[i][0] - coords[j][0];
+                    const float dy = coords[i][1] - coords[j][1];
+                    const float dz = coords[i][2] - coords[j][2];
+                    const float d2 = dx * dx + dy * dy + dz * dz;
+                    if (d2 < radius * radius) {
+                        expected_first.push_back(i);
+                        expected_second.push_back(j);
+                        expected_d2.push_back(d2);
+                    }
+                }
+            }
+
+            std::vector<unsigned int> first, second;
+            std::vector<float> d2;
+            index.FindPairs(refs, targets, radius, first, second, d2);
+            EXPECT_EQ(first, expected_first) << "radius=" << radius;
+            EXPECT_EQ(second, expected_second) << "radius=" << radius;
+            ASSERT_EQ(d2.size(), expected_d2.size());
+            for (size_t k = 0; k < d2.size(); ++k) {
+                EXPECT_FLOAT_EQ(d2[k], expected_d2[k]);
+            }
+        }
+    }
+}
+
+TEST_F(SpatialIndexTest, PeriodicQueriesUseMinimumImage) {
+    // Coordinates on a 1/8 Angstrom lattice keep wrapping and distances exact
+    const float box[3] = {18.0f, 20.0f, 22.0f};
+    std::mt19937 rng(23);
+    std::uniform_int_distribution<int> step(-40, 199);
+    std::vector<std::array<float, 3>> coords;
+    for (int i = 0; i < 600; ++i) {
+        OEChem::OEAtomBase* atom = mol_->NewAtom(8);
+        float xyz[3] = {step(rng) / 8.0f, step(rng) / 8.0f, step(rng) / 8.0f};
+        mol_->SetCoords(atom, xyz);
+        coords.push_back({xyz[0], xyz[1], xyz[2]});
+    }
+    auto image_distance_sq = [&](const float* a, const float* b) {
+        float d2 = 0.0f;
+        for (int d = 0; d < 3; ++d) {
+            float delta = a[d] - b[d];
+            delta -= box[d] * std::round(delta / box[d]);
+            d2 += delta * delta;
+        }
+        return d2;
+    };
+
+    Bitset refs(mol_->GetMaxAtomIdx());
+    Bitset targets(mol_->GetMaxAtomIdx());
+    for (unsigned int i = 0; i < refs.Size(); ++i) {
+        if (i % 7 == 0) refs.Set(i);
+        if (i % 3 != 0) targets.Set(i);
+    }
+
+    const UnitCell cell = UnitCell::Orthorhombic(box[0], box[1], box[2]);
+    for (const SpatialBackend backend : {SpatialBackend::KD_TREE, SpatialBackend::CELL_LIST}) {
+        SpatialIndex index(*mol_, backend, 3.0f, cell);
+        EXPECT_EQ(index.GetUnitCell(), cell);
+        // Radii past half the box see several images of the same atom
+        for (const float radius : {2.95f, 4.45f, 9.7f, 13.1f, 25.3f}) {
+            for (const auto& query : {coords[0], coords[5], std::array<float, 3>{-30.0f, 41.125f, 0.5f}}) {
+                std::vector<unsigned int> expected;
+                for (unsigned int j = 0; j < coords.size(); ++j) {
+                    if (image_distance_sq(query.data(), coords[j].data()) < radius * radius) {
+                        expected.push_back(j);
+                    }
+                }
+                EXPECT_EQ(index.FindWithinRadius(query[0], query[1], query[2], radius), expected)
+                    << "radius=" << radius;
+            }
+
+            Bitset expected_mask(refs.Size());
+            std::vector<unsigned int> expected_first, expected_second;
+            std::vector<float> expected_d2;
+            for (unsigned int i = 0; i < coords.size(); ++i) {
+                if (!refs.Test(i)) continue;
+                for (unsigned int j = 0; j < coords.size(); ++j) {
+                    const float d2 = image_distance_sq(coords[i].data(), coords[j].data());
+                    if (!(d2 < radius * radius)) continue;
+                    expected_mask.Set(j);
+                    if (i != j && targets.Test(j)) {
+                        expected_first.push_back(i);
+                        expected_second.push_back(j);
+                        expected_d2.push_back(d2);
+                    }
+                }
+            }
+
+            Bitset mask(refs.Size());
+            index.MarkWithinRadius(refs, radius, mask);
+            EXPECT_EQ(mask, expected_mask) << "radius=" << radius;
+
+            std::vector<unsigned int> first, second;
+            std::vector<float> d2;
+            index.FindPairs(refs, targets, radius, first, second, d2);
+            EXPECT_EQ(first, expected_first) << "radius=" << radius;
+            EXPECT_EQ(second, expected_second) << "radius=" << radius;
+            EXPECT_EQ(d2, expected_d2) << "radius=" << radius;
+        }
+    }
+}
+
+TEST_F(SpatialIndexTest, FindNearestMatchesBruteForce) {
+    const float box[3] = {16.0f, 18.0f, 20.0f};
+    std::mt19937 rng(31);
+    std::uniform_real_distribution<float> dist(-2.0f, 22.0f);
+    std::vector<std::array<float, 3>> coords;
+    for (int i = 0; i < 700; ++i) {
+        OEChem::OEAtomBase* atom = mol_->NewAtom(6);
+        float xyz[3] = {dist(rng), dist(rng), dist(rng)};
+        mol_->SetCoords(atom, xyz);
+        coords.push_back({xyz[0], xyz[1], xyz[2]});
+    }
+
+    Bitset refs(mol_->GetMaxAtomIdx());
+    Bitset candidates(mol_->GetMaxAtomIdx());
+    for (unsigned int i = 0; i < refs.Size(); ++i) {
+        if (i % 50 == 3) refs.Set(i);
+        if (i % 4 != 0) candidates.Set(i);
+    }
+
+    for (const bool periodic : {false, true}) {
+        const UnitCell cell = periodic ? UnitCell::Orthorhombic(box[0], box[1], box[2]) : UnitCell();
+        auto distance_sq = [&](const std::array<float, 3>& a, const std::array<float, 3>& b) {
+            float d2 = 0.0f;
+            for (int d = 0; d < 3; ++d) {
+                float delta = a[d] - b[d];
+                if (periodic) {
+                    delta -= box[d] * std::round(delta / box[d]);
+                }
+                d2 += delta * delta;
+            }
+            return d2;
+        };
+
+        // Every candidate's distance to its closest reference atom, nearest first
+        std::vector<std::pair<float, unsigned int>> ranked;
+        for (unsigned int j = 0; j < coords.size(); ++j) {
+            if (!candidates.Test(j)) continue;
+            float best = std::numeric_limits<float>::infinity();
+            for (unsigned int i = 0; i < coords.size(); ++i) {
+                if (refs.Test(i)) best = std::min(best, distance_sq(coords[i], coords[j]));
+            }
+            ranked.emplace_back(best, j);
+        }
+        std::sort(ranked.begin(), ranked.end());
+
+        for (const SpatialBackend backend : {SpatialBackend::KD_TREE, SpatialBackend::CELL_LIST}) {
+            SpatialIndex index(*mol_, backend, 4.0f, cell);
+            for (const size_t k : {size_t{1}, size_t{7}, size_t{60}, size_t{2000}}) {
+                std::vector<unsigned int> nearest;
+                std::vector<float> d2;
+                index.FindNearest(refs, candidates, k, nearest, d2);
+                const size_t expected = std::min(k, ranked.size());
+                ASSERT_EQ(nearest.size(), expected) << "k=" << k;
+                ASSERT_EQ(d2.size(), expected);
+                for (size_t n = 0; n < expected; ++n) {
+                    EXPECT_EQ(nearest[n], ranked[n].second) << "k=" << k << " periodic=" << periodic;
+                    EXPECT_NEAR(d2[n], ranked[n].first, 1e-3f);
+                }
+            }
+        }
+    }
+
+    // Nothing to rank against, or nothing to rank
+    SpatialIndex index(*mol_);
+    std::vector<unsigned int> nearest;
+    std::vector<float> d2;
+    index.FindNearest(Bitset(refs.Size()), candidates, 5, nearest, d2);
+    index.FindNearest(refs, Bitset(refs.Size()), 5, nearest, d2);
+    index.FindNearest(refs, candidates, 0, nearest, d2);
+    EXPECT_TRUE(nearest.empty());
+    EXPECT_TRUE(d2.empty());
+}
+
+TEST_F(SpatialIndexTest, FindNearestBreaksTiesByAtomIndex) {
+    // One reference at the origin and candidates stacked on six points 3 A away, so every distance ties
+    OEChem::OEAtomBase* ref = mol_->NewAtom(6);
+    const float origin[3] = {0.0f, 0.0f, 0.0f};
+    mol_->SetCoords(ref, origin);
+    for (int i = 0; i < 60; ++i) {
+        OEChem::OEAtomBase* atom = mol_->NewAtom(6);
+        float xyz[3] = {0.0f, 0.0f, 0.0f};
+        xyz[i % 3] = (i / 3) % 2 ? 3.0f : -3.0f;
+        mol_->SetCoords(atom, xyz);
+    }
+    Bitset refs(mol_->GetMaxAtomIdx());
+    refs.Set(0);
+    Bitset candidates(mol_->GetMaxAtomIdx());
+    for (unsigned int i = 1; i < candidates.Size(); ++i) candidates.Set(i);
+
+    for (const SpatialBackend backend : {SpatialBackend::KD_TREE, SpatialBackend::CELL_LIST}) {
+        SpatialIndex index(*mol_, backend);
+        for (const size_t k : {size_t{1}, size_t{5}, size_t{17}}) {
+            std::vector<unsigned int> nearest;
+            std::vector<float> d2;
+            index.FindNearest(refs, candidates, k, nearest, d2);
+            ASSERT_EQ(nearest.size(), k);
+            for (size_t n = 0; n < k; ++n) {
+                EXPECT_EQ(nearest[n], n + 1) << "k=" << k;
+                EXPECT_FLOAT_EQ(d2[n], 9.0f);
+            }
+        }
+    }
+}
+
+TEST_F(SpatialIndexTest, FindNearestGroupsMatchesBruteForce) {
+    std::mt19937 rng(37);
+    std::uniform_real_distribution<float> dist(0.0f, 20.0f);
+    std::vector<std::array<float, 3>> coords;
+    std::vector<std::uint32_t> groups;
+    for (int i = 0; i < 600; ++i) {
+        OEChem::OEAtomBase* atom = mol_->NewAtom(6);
+        float xyz[3] = {dist(rng), dist(rng), dist(rng)};
+        mol_->SetCoords(atom, xyz);
+        coords.push_back({xyz[0], xyz[1], xyz[2]});
+        // Groups of eight scattered atoms, so a group's nearest atom sits deep in the atom ranking
+        groups.push_back(static_cast<std::uint32_t>(i % 75));
+    }
+
+    Bitset refs(mol_->GetMaxAtomIdx());
+    Bitset candidates(mol_->GetMaxAtomIdx());
+    for (unsigned int i = 0; i < refs.Size(); ++i) {
+        if (i % 40 == 7) refs.Set(i);
+        else candidates.Set(i);
+    }
+
+    // Candidate atoms ranked by distance to their closest reference, then the first atom of each group
+    std::vector<std::pair<float, unsigned int>> ranked;
+    for (unsigned int j = 0; j < coords.size(); ++j) {
+        if (!candidates.Test(j)) continue;
+        float best = std::numeric_limits<float>::infinity();
+        for (unsigned int i = 0; i < coords.size(); ++i) {
+            if (!refs.Test(i)) continue;
+            float d2 = 0.0f;
+            for (int d = 0; d < 3; ++d) d2 += (coords[i][d] - coords[j][d]) * (coords[i][d] - coords[j][d]);
+            best = std::min(best, d2);
+        }
+        ranked.emplace_back(best, j);
+    }
+    std::sort(ranked.begin(), ranked.end());
+    std::vector<unsigned int> group_order;
+    std::vector<bool> seen(75, false);
+    for (const auto& [d2, atom] : ranked) {
+        if (!seen[groups[atom]]) {
+            seen[groups[atom]] = true;
+            group_order.push_back(atom);
+        }
+    }
+
+    SpatialIndex index(*mol_);
+    for (const size_t count : {size_t{1}, size_t{6}, size_t{40}, size_t{75}, size_t{200}}) {
+        std::vector<unsigned int> nearest;
+        std::vector<float> d2;
+        index.FindNearestGroups(refs, candidates, groups, count, nearest, d2);
+        const size_t expected = std::min(count, group_order.size());
+        ASSERT_EQ(nearest.size(), expected) << "count=" << count;
+        ASSERT_EQ(d2.size(), expected);
+        for (size_t n = 0; n < expected; ++n) {
+            EXPECT_EQ(nearest[n], group_order[n]) << "count=" << count;
+        }
+    }
+}
+
+TEST_F(SpatialIndexTest, SubsetIndexMarksMatchBruteForce) {
+    const float box[3] = {15.0f, 17.0f, 19.0f};
+    std::mt19937 rng(43);
+    std::uniform_real_distribution<float> dist(-3.0f, 22.0f);
+    for (int i = 0; i < 800; ++i) {
+        OEChem::OEAtomBase* atom = mol_->NewAtom(6);
+        float xyz[3] = {dist(rng), dist(rng), dist(rng)};
+        mol_->SetCoords(atom, xyz);
+    }
+    // Points far outside the indexed atoms' bounds, and one without coordinates
+    float far[3] = {120.0f, -80.0f, 40.0f};
+    mol_->SetCoords(mol_->NewAtom(6), far);
+    float missing[3] = {std::numeric_limits<float>::quiet_NaN(), 0.0f, 0.0f};
+    mol_->SetCoords(mol_->NewAtom(6), missing);
+
+    const size_t size = mol_->GetMaxAtomIdx();
+    std::vector<float> xyz(size * 3);
+    mol_->GetCoords(xyz.data());
+    Bitset small(size);
+    Bitset large(size);
+    for (unsigned int i = 0; i < size; ++i) {
+        if (i % 37 == 5) small.Set(i);
+        if (i % 3 != 0 || i + 2 >= size) large.Set(i);
+    }
+
+    for (const bool periodic : {false, true}) {
+        const UnitCell cell = periodic ? UnitCell::Orthorhombic(box[0], box[1], box[2]) : UnitCell();
+        auto within = [&](const unsigned int a, const unsigned int b, const float radius) {
+            float d2 = 0.0f;
+            for (int d = 0; d < 3; ++d) {
+                float delta = xyz[a * 3 + d] - xyz[b * 3 + d];
+                if (periodic) {
+                    delta -= box[d] * std::round(delta / box[d]);
+                }
+                d2 += delta * delta;
+            }
+            return d2 < radius * radius;
+        };
+        // Members of @p side within radius of any member of @p other
+        auto brute = [&](const Bitset& side, const Bitset& other, const float radius) {
+            Bitset expected(size);
+            side.ForEachSet([&](const size_t a) {
+                other.ForEachSet([&](const size_t b) {
+                    if (within(static_cast<unsigned int>(a), static_cast<unsigned int>(b), radius)) {
+                        expected.Set(a);
+                    }
+                });
+            });
+            return expected;
+        };
+
+        for (const SpatialBackend backend : {SpatialBackend::KD_TREE, SpatialBackend::CELL_LIST}) {
+            for (const float radius : {1.5f, 4.0f, 9.0f}) {
+                // Index each side in turn and query from the other
+                for (const bool index_small : {true, false}) {
+                    const Bitset& indexed = index_small ? small : large;
+                    const Bitset& queries = index_small ? large : small;
+                    SpatialIndex index(*mol_, indexed, backend, 4.0f, cell);
+                    EXPECT_EQ(index.Size(), indexed.Count());
+
+                    Bitset near_queries(size);
+                    index.MarkIndexedNear(xyz.data(), queries, radius, near_queries);
+                    EXPECT_EQ(near_queries, brute(indexed, queries, radius))
+                        << "radius=" << radius << " periodic=" << periodic;
+
+                    Bitset near_indexed(size);
+                    index.MarkNearIndexed(xyz.data(), queries, radius, near_indexed);
+                    EXPECT_EQ(near_indexed, brute(queries, indexed, radius))
+                        << "radius=" << radius << " periodic=" << periodic;
+                }
+            }
+        }
+    }
+
+    // A zero radius or no query atoms marks nothing
+    SpatialIndex index(*mol_, small, SpatialBackend::CELL_LIST, 4.0f);
+    Bitset out(size);
+    index.MarkIndexedNear(xyz.data(), large, 0.0f, out);
+    index.MarkNearIndexed(xyz.data(), Bitset(size), 4.0f, out);
+    EXPECT_TRUE(out.None());
+}
+
+TEST_F(SpatialIndexTest, UnitCellRejectsInvalidLengths) {
+    EXPECT_FALSE(UnitCell().IsPeriodic());
+    EXPECT_TRUE(UnitCell::Orthorhombic(10.0f, 12.0f, 14.0f).IsPeriodic());
+    EXPECT_THROW(static_cast<void>(UnitCell::Orthorhombic(0.0f, 10.0f, 10.0f)), SelectionError);
+    EXPECT_THROW(static_cast<void>(UnitCell::Orthorhombic(10.0f, -1.0f, 10.0f)), SelectionError);
+    EXPECT_THROW(static_cast<void>(UnitCell::Orthorhombic(10.0f, 10.0f, INFINITY)), SelectionError);
+}
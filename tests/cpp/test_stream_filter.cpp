@@ -0,0 +1,126 @@
+// tests/cpp/test_stream_filter.cpp
+// Unit tests for the pipelined stream filter.
+
+#include <gtest/gtest.h>
+
+#include <oeselect/StreamFilter.h>
+#include <oechem.h>
+
+#include "test_molecules.h"
+
+#include <atomic>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace OESel;
+using namespace OESelTest;
+
+namespace {
+/// Fill a toy complex whose size and coordinates depend on its stream position
+void fill_complex(OEChem::OEMolBase& mol, const size_t index) {
+    std::mt19937 rng(static_cast<unsigned int>(index));
+    ComplexSpec spec;
+    spec.num_residues = 5 + static_cast<unsigned int>(index % 17);
+    spec.num_ligands = index % 3 != 0 ? 1 : 0;  // Every third molecule has no ligand
+    spec.num_waters = 0;
+    build_complex(mol, rng, spec);
+    mol.SetTitle(("complex" + std::to_string(index)).c_str());
+}
+
+/// Source producing @p count generated complexes
+StreamFilter::MoleculeSource make_source(const size_t count, std::atomic<size_t>& produced) {
+    return [count, &produced](OEChem::OEMolBase& mol) {
+        const size_t index = produced.load();
+        if (index == count) return false;
+        fill_complex(mol, index);
+        produced = index + 1;
+        return true;
+    };
+}
+}  // namespace
+
+TEST(StreamFilterTest, MatchesPerMoleculeEvaluationInOrder) {
+    const OESelection sele = OESelection::Parse("ligand or (protein and ligand around 4)");
+    for (const unsigned int threads : {1U, 4U}) {
+        StreamFilter filter(sele, threads, 3);
+        EXPECT_EQ(filter.NumThreads(), threads);
+        EXPECT_EQ(filter.QueueDepth(), 3U);
+
+        std::atomic<size_t> produced{0};
+        size_t next = 0;
+        size_t selected = 0;
+        const StreamFilterStats stats = filter.Run(
+            make_source(100, produced), [&](const size_t index, OEChem::OEMolBase& mol, const Bitset& mask) {
+                ASSERT_EQ(index, next++);
+                // Bounded queue: the reader never runs more than QueueDepth() molecules ahead
+                EXPECT_LE(produced.load(), index + filter.QueueDepth());
+                EXPECT_EQ(std::string(mol.GetTitle()), "complex" + std::to_string(index));
+
+                OEChem::OEGraphMol expected_mol;
+                fill_complex(expected_mol, index);
+                EXPECT_EQ(mask.ToIndices(), sele.EvaluateMask(expected_mol).ToIndices()) << index;
+                selected += mask.Count();
+            });
+        EXPECT_EQ(next, 100U);
+        EXPECT_EQ(stats.molecules_read, 100U);
+        EXPECT_EQ(stats.molecules_written, 100U);
+        EXPECT_EQ(stats.atoms_selected, selected);
+        EXPECT_GT(selected, 0U);
+    }
+}
+
+TEST(StreamFilterTest, ReusesFilterAcrossRuns) {
+    StreamFilter filter(OESelection::Parse("name CA"), 2);
+    EXPECT_EQ(filter.QueueDepth(), 8U);
+    for (const size_t count : {size_t{0}, size_t{1}, size_t{30}}) {
+        std::atomic<size_t> produced{0};
+        size_t calls = 0;
+        const StreamFilterStats stats = filter.Run(make_source(count, produced),
+                                                   [&](size_t, OEChem::OEMolBase&, const Bitset&) { ++calls; });
+        EXPECT_EQ(stats.molecules_read, count);
+        EXPECT_EQ(calls, count);
+    }
+}
+
+TEST(StreamFilterTest, RethrowsSourceAndCallbackErrors) {
+    for (const unsigned int threads : {1U, 3U}) {
+        StreamFilter filter(OESelection::Parse("protein"), threads, 2);
+        size_t produced = 0;
+        const auto failing_source = [&](OEChem::OEMolBase& mol) {
+            if (produced == 10) throw std::runtime_error("read failed");
+            fill_complex(mol, produced++);
+            return true;
+        };
+        EXPECT_THROW(filter.Run(failing_source, [](size_t, OEChem::OEMolBase&, const Bitset&) {}),
+                     std::runtime_error);
+
+        std::atomic<size_t> counter{0};
+        EXPECT_THROW(filter.Run(make_source(50, counter),
+                                [](const size_t index, OEChem::OEMolBase&, const Bitset&) {
+                                    if (index == 5) throw std::runtime_error("write failed");
+                                }),
+                     std::runtime_error);
+    }
+}
+
+TEST(StreamFilterTest, WritesTextRecords) {
+    OEChem::OEGraphMol mol;
+    fill_complex(mol, 1);
+    const Bitset mask = OESelection::Parse("ligand").EvaluateMask(mol);
+
+    std::ostringstream count;
+    StreamFilter::WriteRecord(count, FilterOutput::COUNT, 7, mol, mask);
+    EXPECT_EQ(count.str(), "7\tcomplex1\t3\n");
+
+    std::ostringstream indices;
+    StreamFilter::WriteRecord(indices, FilterOutput::INDICES, 7, mol, mask);
+    EXPECT_EQ(indices.str(), "7\tcomplex1\t30,31,32\n");
+
+    std::ostringstream empty;
+    StreamFilter::WriteRecord(empty, FilterOutput::INDICES, 0, mol, Bitset(mol.GetMaxAtomIdx()));
+    EXPECT_EQ(empty.str(), "0\tcomplex1\t\n");
+}
@@ -0,0 +1,243 @@
+// tests/cpp/test_table_cache.cpp
+// Unit tests for persisted atom tables.
+
+#include <gtest/gtest.h>
+
+#include <oeselect/oeselect.h>
+#include <oechem.h>
+
+#include "test_molecules.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace OESel;
+using namespace OESelTest;
+
+namespace {
+/// Bonded toy complex: ALA residues in two chains, one LIG residue, waters, and B-factors
+std::unique_ptr<OEChem::OEGraphMol> make_bonded_complex(std::mt19937& rng, const unsigned int num_residues) {
+    ComplexSpec spec;
+    spec.num_residues = num_residues;
+    spec.num_chains = 2;
+    spec.num_waters = num_residues / 2;
+    spec.bfactors = true;
+    spec.bonds = true;
+    return make_complex(rng, spec);
+}
+
+/// Fresh sidecar path in the test temporary directory
+std::string cache_path(const std::string& name) {
+    const std::string path = ::testing::TempDir() + "oeselect_" + name + ".oesel";
+    std::remove(path.c_str());
+    return path;
+}
+
+/// Mask of a selection evaluated through an existing context
+std::vector<unsigned int> evaluate(Context& ctx, const OESelection& sele) {
+    Bitset mask(ctx.Mol().GetMaxAtomIdx());
+    sele.Root().EvaluateAll(ctx, mask);
+    return mask.ToIndices();
+}
+
+std::vector<char> read_file(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+
+void write_file(const std::string& path, const std::vector<char>& bytes) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+}  // namespace
+
+TEST(TableCacheTest, RoundTripsTablesAndBonds) {
+    std::mt19937 rng(5);
+    auto mol = make_bonded_complex(rng, 40);
+    const OESelection sele = OESelection::Parse("all");
+    const std::string path = cache_path("roundtrip");
+
+    Context built(*mol, sele);
+    const std::uint64_t key = TableCache::Key(*mol);
+    TableCache::Save(built, path, key);
+
+    Context loaded(*mol, sele);
+    ASSERT_TRUE(TableCache::Load(loaded, path, key));
+
+    const AtomTable& a = built.GetAtomTable();
+    const AtomTable& b = loaded.GetAtomTable();
+    EXPECT_NE(&a, &b);
+    EXPECT_EQ(a.Size(), b.Size());
+    EXPECT_EQ(a.ResidueNames(), b.ResidueNames());
+    EXPECT_EQ(a.AtomNames(), b.AtomNames());
+    EXPECT_EQ(a.ResidueNameIds(), b.ResidueNameIds());
+    EXPECT_EQ(a.AtomNameIds(), b.AtomNameIds());
+    EXPECT_EQ(a.ResidueNumbers(), b.ResidueNumbers());
+    EXPECT_EQ(a.ChainIds(), b.ChainIds());
+    EXPECT_EQ(a.InsertCodes(), b.InsertCodes());
+    EXPECT_EQ(a.SerialNumbers(), b.SerialNumbers());
+    EXPECT_EQ(a.AltLocations(), b.AltLocations());
+    EXPECT_EQ(a.BFactors(), b.BFactors());
+    EXPECT_EQ(a.FragmentNumbers(), b.FragmentNumbers());
+    EXPECT_EQ(a.SecondaryStructure(), b.SecondaryStructure());
+    EXPECT_EQ(a.AtomicNumbers(), b.AtomicNumbers());
+    EXPECT_EQ(a.ComponentFlags(), b.ComponentFlags());
+    EXPECT_EQ(a.ResidueGroups(), b.ResidueGroups());
+    EXPECT_EQ(a.ChainGroups(), b.ChainGroups());
+    EXPECT_EQ(a.ResidueRuns().offsets, b.ResidueRuns().offsets);
+    EXPECT_EQ(a.ChainRuns().offsets, b.ChainRuns().offsets);
+    ASSERT_EQ(a.ResidueRuns().runs.size(), b.ResidueRuns().runs.size());
+    for (size_t i = 0; i < a.ResidueRuns().runs.size(); ++i) {
+        EXPECT_EQ(a.ResidueRuns().runs[i].begin, b.ResidueRuns().runs[i].begin);
+        EXPECT_EQ(a.ResidueRuns().runs[i].end, b.ResidueRuns().runs[i].end);
+    }
+
+    const BondGraph& g = built.GetBondGraph();
+    const BondGraph& h = loaded.GetBondGraph();
+    EXPECT_NE(&g, &h);
+    EXPECT_EQ(g.Offsets(), h.Offsets());
+    EXPECT_EQ(g.Neighbors(), h.Neighbors());
+    EXPECT_EQ(g.NeighborAtomicNumbers(), h.NeighborAtomicNumbers());
+    EXPECT_EQ(g.AtomicNumbers(), h.AtomicNumbers());
+    std::remove(path.c_str());
+}
+
+TEST(TableCacheTest, LoadedTablesEvaluateLikeBuiltOnes) {
+    std::mt19937 rng(9);
+    auto mol = make_bonded_complex(rng, 30);
+    // Deleted atoms leave holes that the stored columns must keep
+    for (OESystem::OEIter<OEChem::OEAtomBase> atom = mol->GetAtoms(); atom; ++atom) {
+        if (atom->GetIdx() == 12) {
+            mol->DeleteAtom(&*atom);
+            break;
+        }
+    }
+    const std::string path = cache_path("evaluate");
+    const std::uint64_t key = TableCache::Key(*mol);
+    {
+        Context ctx(*mol, OESelection::Parse("all"));
+        TableCache::Save(ctx, path, key);
+    }
+
+    for (const char* text : {"protein and chain B", "name CA or resn HOH", "byres (ligand around 4)",
+                             "polarh or bound_to elem O", "bfactor > 12 and not water", "resi 3 extend 1"}) {
+        const OESelection sele = OESelection::Parse(text);
+        Context built(*mol, sele);
+        Context loaded(*mol, sele);
+        ASSERT_TRUE(TableCache::Load(loaded, path, key));
+        EXPECT_EQ(evaluate(loaded, sele), evaluate(built, sele)) << text;
+    }
+    std::remove(path.c_str());
+}
+
+TEST(TableCacheTest, KeyTracksTableInputs) {
+    std::mt19937 rng(1);
+    auto mol = make_bonded_complex(rng, 10);
+    const std::uint64_t key = TableCache::Key(*mol);
+
+    std::mt19937 same_rng(1);
+    EXPECT_EQ(TableCache::Key(*make_bonded_complex(same_rng, 10)), key);
+
+    OESystem::OEIter<OEChem::OEAtomBase> atoms = mol->GetAtoms();
+    OEChem::OEAtomBase* first = &*atoms;
+    first->SetName("NX");
+    EXPECT_NE(TableCache::Key(*mol), key);
+    first->SetName("N");
+    EXPECT_EQ(TableCache::Key(*mol), key);
+
+    // Coordinates are not part of the tables
+    float coords[3] = {100.0f, 100.0f, 100.0f};
+    mol->SetCoords(first, coords);
+    EXPECT_EQ(TableCache::Key(*mol), key);
+}
+
+TEST(TableCacheTest, RejectsStaleOrDamagedFiles) {
+    std::mt19937 rng(3);
+    auto mol = make_bonded_complex(rng, 20);
+    const OESelection sele = OESelection::Parse("protein");
+    const std::string path = cache_path("reject");
+    const std::uint64_t key = TableCache::Key(*mol);
+
+    Context ctx(*mol, sele);
+    EXPECT_FALSE(TableCache::Load(ctx, path, key));  // missing
+    TableCache::Save(ctx, path, key);
+    EXPECT_FALSE(TableCache::Load(ctx, path, key + 1));
+
+    const std::vector<char> good = read_file(path);
+    ASSERT_GT(good.size(), 64u);
+
+    std::vector<char> truncated(good.begin(), good.end() - 24);
+    write_file(path, truncated);
+    EXPECT_FALSE(TableCache::Load(ctx, path, key));
+
+    std::vector<char> bad_version = good;
+    bad_version[8] = static_cast<char>(TableCache::kVersion + 1);
+    write_file(path, bad_version);
+    EXPECT_FALSE(TableCache::Load(ctx, path, key));
+
+    // Overwrite the first section's element size
+    std::vector<char> bad_section = good;
+    bad_section[40 + 8] = 3;
+    write_file(path, bad_section);
+    EXPECT_FALSE(TableCache::Load(ctx, path, key));
+
+    // A file saved for a smaller molecule with the same key is rejected by size
+    std::mt19937 other_rng(3);
+    auto smaller = make_bonded_complex(other_rng, 10);
+    Context small_ctx(*smaller, sele);
+    TableCache::Save(small_ctx, path, key);
+    EXPECT_FALSE(TableCache::Load(ctx, path, key));
+
+    // The context still builds its own tables after every rejection
+    Context fresh(*mol, sele);
+    EXPECT_EQ(evaluate(ctx, sele), evaluate(fresh, sele));
+    std::remove(path.c_str());
+}
+
+TEST(TableCacheTest, RejectsFilesSavedUnderOtherResidueClasses) {
+    std::mt19937 rng(4);
+    auto mol = make_bonded_complex(rng, 10);
+    const OESelection sele = OESelection::Parse("protein");
+    const std::string path = cache_path("classes");
+    const std::uint64_t key = TableCache::Key(*mol);
+    {
+        Context ctx(*mol, sele);
+        TableCache::Save(ctx, path, key);
+    }
+
+    // Registering a class changes the component flags the file would install
+    Tagger::RegisterResidueClass("LIG", ComponentFlag::PROTEIN);
+    EXPECT_NE(Tagger::ResidueClassDigest(), 0u);
+    Context registered(*mol, sele);
+    EXPECT_FALSE(TableCache::Load(registered, path, key));
+
+    // Clearing the registrations makes the file valid again
+    Tagger::ClearResidueClasses();
+    EXPECT_EQ(Tagger::ResidueClassDigest(), 0u);
+    Context cleared(*mol, sele);
+    EXPECT_TRUE(TableCache::Load(cleared, path, key));
+    std::remove(path.c_str());
+}
+
+TEST(TableCacheTest, FileKeyHashesFileContents) {
+    const std::string path = ::testing::TempDir() + "oeselect_filekey.pdb";
+    write_file(path, {'A', 'T', 'O', 'M'});
+    const std::uint64_t key = TableCache::FileKey(path);
+    EXPECT_EQ(TableCache::FileKey(path), key);
+    write_file(path, {'A', 'T', 'O', 'X'});
+    EXPECT_NE(TableCache::FileKey(path), key);
+    std::remove(path.c_str());
+    EXPECT_THROW((void)TableCache::FileKey(path), SelectionError);
+}
+
+TEST(TableCacheTest, SaveReportsUnwritablePath) {
+    std::mt19937 rng(2);
+    auto mol = make_bonded_complex(rng, 4);
+    Context ctx(*mol, OESelection::Parse("all"));
+    EXPECT_THROW(TableCache::Save(ctx, ::testing::TempDir() + "missing_dir/x/table.oesel", 1), SelectionError);
+}
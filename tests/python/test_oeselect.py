@@ -253,6 +253,23 @@ class TestOESelect:
         pred = OESelect(simple_mol, "elem C")
         assert "OESelect" in repr(pred)
 
+    def test_oeselect_profile(self, protein_mol):
+        """OESelect should report per-node statistics when profiling."""
+        from oeselect import OESelect
+
+        pred = OESelect(protein_mol, "resn ALA and name CA")
+        assert len(pred.GetProfile()) == 0
+
+        pred.SetProfiling(True)
+        expected = sum(1 for atom in protein_mol.GetAtoms() if pred(atom))
+        profile = pred.GetProfile()
+        nodes = list(profile)
+        assert nodes[0].depth == 0
+        assert nodes[0].evaluations == 1
+        assert nodes[0].atoms_matched == expected
+        assert {node.label for node in nodes[1:]} == {"resn ALA", "name CA"}
+        assert "evals=1" in str(profile)
+
 
 class TestCount:
     """Tests for count() function."""
@@ -286,6 +303,188 @@ class TestCount:
         assert num_gly == protein_mol.NumAtoms() - 5
 
 
+class TestNumpyOutput:
+    """Tests for select_array() and select_mask()."""
+
+    def test_select_array_matches_select(self, protein_mol):
+        """Index arrays should hold the same indices as select()."""
+        np = pytest.importorskip("numpy")
+        from oeselect import parse, select, select_array
+
+        indices = select_array(protein_mol, "resn GLY")
+        assert indices.dtype == np.uint32
+        assert indices.tolist() == select(protein_mol, "resn GLY")
+
+        parsed = select_array(protein_mol, parse("resn GLY"))
+        assert parsed.tolist() == indices.tolist()
+
+    def test_select_mask_matches_select(self, protein_mol):
+        """Boolean masks should be set exactly at the selected indices."""
+        np = pytest.importorskip("numpy")
+        from oeselect import select, select_mask
+
+        mask = select_mask(protein_mol, "resn ALA")
+        assert mask.dtype == np.bool_
+        assert mask.shape == (protein_mol.GetMaxAtomIdx(),)
+        assert np.flatnonzero(mask).tolist() == select(protein_mol, "resn ALA")
+
+    def test_select_array_empty_and_invalid(self, protein_mol):
+        """Empty results give empty arrays and bad selections raise."""
+        pytest.importorskip("numpy")
+        from oeselect import select_array
+
+        assert select_array(protein_mol, "resn XYZ").size == 0
+        with pytest.raises(ValueError):
+            select_array(protein_mol, "resn (")
+
+    def test_find_contacts(self, protein_mol):
+        """Contact arrays pair every atom of one residue with the other."""
+        np = pytest.importorskip("numpy")
+        from oeselect import find_contacts, select
+
+        # SMILES input leaves every atom at the origin, so all pairs are in contact
+        i, j, d2 = find_contacts(protein_mol, "resn ALA", "resn GLY", 1.0)
+        assert (i.dtype, j.dtype, d2.dtype) == (np.uint32, np.uint32, np.float32)
+        ala = select(protein_mol, "resn ALA")
+        gly = select(protein_mol, "resn GLY")
+        assert list(zip(i.tolist(), j.tolist())) == [(a, g) for a in ala for g in gly]
+        assert not d2.any()
+
+        i, j, d2 = find_contacts(protein_mol, "resn ALA", "resn GLY", 1.0, per_residue=True)
+        assert len(i) == len(j) == len(d2) == 1
+        with pytest.raises(ValueError):
+            find_contacts(protein_mol, "resn ALA", "resn GLY", -1.0)
+
+
+class TestUnitCell:
+    """Tests for periodic boundaries on OESelect."""
+
+    def test_around_wraps_across_box_faces(self):
+        """Atoms near a box face are found from the opposite face."""
+        from openeye import oechem
+        from oeselect import OESelect, UnitCell
+
+        mol = oechem.OEGraphMol()
+        for name, x in (("REF", 0.5), ("NEAR", 2.0), ("MID", 5.0), ("FAR", 9.5)):
+            atom = mol.NewAtom(oechem.OEElemNo_C)
+            atom.SetName(name)
+            mol.SetCoords(atom, (x, 0.0, 0.0))
+
+        pred = OESelect(mol, "name REF around 2")
+        assert [a.GetName() for a in mol.GetAtoms(pred)] == ["NEAR"]
+
+        pred.SetUnitCell((10.0, 10.0, 10.0))
+        assert pred.GetUnitCell() == UnitCell.Orthorhombic(10.0, 10.0, 10.0)
+        assert [a.GetName() for a in mol.GetAtoms(pred)] == ["NEAR", "FAR"]
+
+        pred.SetUnitCell(None)
+        assert not pred.GetUnitCell().IsPeriodic()
+        assert [a.GetName() for a in mol.GetAtoms(pred)] == ["NEAR"]
+
+    def test_copies_keep_settings_and_results(self, protein_mol):
+        """CreateCopy shares the evaluated mask and keeps the cell and threads."""
+        from oeselect import OESelect, UnitCell
+
+        pred = OESelect(protein_mol, "resn ALA around 4")
+        pred.SetUnitCell((30.0, 30.0, 30.0))
+        pred.SetNumThreads(2)
+        expected = [a.GetIdx() for a in protein_mol.GetAtoms(pred)]
+
+        copy = pred.CreateCopy()
+        assert copy.GetUnitCell() == UnitCell.Orthorhombic(30.0, 30.0, 30.0)
+        assert copy.GetNumThreads() == 2
+        assert [a.GetIdx() for a in protein_mol.GetAtoms(copy)] == expected
+
+    def test_invalid_lengths_raise(self):
+        """Box lengths must be positive."""
+        from oeselect import UnitCell
+
+        with pytest.raises(ValueError):
+            UnitCell.Orthorhombic(10.0, 0.0, 10.0)
+
+
+class TestSelectionResult:
+    """Tests for stored selection results and named sets."""
+
+    def test_set_algebra_and_numpy_export(self, protein_mol):
+        """Results combine with operators and export to NumPy."""
+        from oeselect import OESelect
+
+        ala = OESelect(protein_mol, "resn ALA").GetResult()
+        ca = OESelect(protein_mol, "name CA").GetResult()
+
+        assert len(ala) == 5
+        assert list((ala & ca).ToArray()) == [1]
+        assert len(ala | ca) == 6
+        assert list((ca - ala).ToArray()) == [6]
+        assert len(ala ^ ca) == 5
+        assert 1 in ca
+        assert 0 not in ca
+        mask = ala.ToMask()
+        assert mask.dtype.name == "bool"
+        assert mask.sum() == 5
+
+    def test_named_set_and_predicate(self, protein_mol):
+        """A stored result feeds %name selections and OpenEye predicates."""
+        from openeye import oechem
+        from oeselect import OEInSelectionResult, OESelect
+
+        site = OESelect(protein_mol, "resi 2").GetResult()
+        pred = OESelect(protein_mol, "%site and name CA")
+        pred.SetNamedSet("site", site)
+        assert [a.GetIdx() for a in protein_mol.GetAtoms(pred)] == [6]
+        assert oechem.OECount(protein_mol, OEInSelectionResult(site)) == 5
+        # OENotAtom holds a CreateCopy() of the predicate, which shares the result
+        outside = oechem.OENotAtom(OEInSelectionResult(site))
+        assert oechem.OECount(protein_mol, outside) == protein_mol.NumAtoms() - 5
+
+
+class TestBatchEvaluator:
+    """Tests for parallel BatchEvaluator."""
+
+    def test_matches_count_and_select(self, simple_mol, protein_mol):
+        """Batch results match per-molecule count() and select()."""
+        from oeselect import BatchEvaluator, count, select
+
+        selections = ["elem C", "resn ALA", "name CA+N"]
+        mols = [simple_mol, protein_mol, simple_mol.CreateCopy(), protein_mol.CreateCopy()]
+        batch = BatchEvaluator(selections, num_threads=2)
+        assert batch.NumSelections() == 3
+        assert batch.NumThreads() == 2
+
+        counts = batch.Count(mols)
+        indices = batch.Select(mols)
+        for m, mol in enumerate(mols):
+            for s, sele in enumerate(selections):
+                assert counts[m][s] == count(mol, sele)
+                assert indices[m][s] == sorted(select(mol, sele))
+
+    def test_rejects_non_molecules(self):
+        """Non-molecule items are rejected."""
+        from oeselect import BatchEvaluator
+
+        with pytest.raises(TypeError):
+            BatchEvaluator(["all"]).Count(["CCO"])
+
+
+class TestSelectionSet:
+    """Tests for fused multi-selection SelectionSet."""
+
+    def test_matches_count_and_select(self, protein_mol):
+        """Set results match per-selection count() and select()."""
+        from oeselect import SelectionSet, count, select
+
+        selections = ["resn ALA", "name CA+N", "resn ALA and name CA", "not resn ALA"]
+        features = SelectionSet(selections)
+        assert len(features) == 4
+
+        counts = features.Count(protein_mol)
+        indices = features.Select(protein_mol)
+        for i, sele in enumerate(selections):
+            assert counts[i] == count(protein_mol, sele)
+            assert indices[i] == sorted(select(protein_mol, sele))
+
+
 class TestMultiValueSyntax:
     """Tests for multi-value syntax (name CA+CB+N)."""
 
@@ -478,6 +677,14 @@ class TestOEResidueSelector:
 
         assert atoms == [ala]
 
+    def test_residue_selector_evaluate_mask(self, protein_mol):
+        """EvaluateMask should agree with per-atom matching."""
+        from oeselect import OEResidueSelector
+
+        sel = OEResidueSelector("GLY:2: :A")
+        expected = [atom.GetIdx() for atom in protein_mol.GetAtoms(sel)]
+        assert list(sel.EvaluateMask(protein_mol).ToIndices()) == expected
+
 
 class TestCustomPredicates:
     """Tests for custom predicate classes."""
@@ -599,6 +806,17 @@ class TestSelectorUtilities:
 class TestPredicateType:
     """Tests for PredicateType enum."""
 
+    def test_values_keep_their_numbers(self):
+        """Released values keep their numbers; later types are appended."""
+        from oeselect import PredicateType
+
+        assert PredicateType.Name == 4
+        assert PredicateType.Around == 29
+        assert PredicateType.True_ == 36
+        assert PredicateType.False_ == 37
+        assert PredicateType.Lipid == 38
+        assert PredicateType.Nearest == 43
+
     def test_contains_predicate(self):
         """ContainsPredicate should work."""
         from oeselect import parse, PredicateType
@@ -612,6 +830,83 @@ class TestPredicateType:
         assert sele2.ContainsPredicate(PredicateType.Chain)
         assert sele2.ContainsPredicate(PredicateType.And)
 
+    def test_bond_graph_operators(self):
+        """bound_to and extend should parse to their predicate types."""
+        from oeselect import parse, PredicateType
+
+        assert parse("bound_to metal").ContainsPredicate(PredicateType.BoundTo)
+        sele = parse("ligand extend 2")
+        assert sele.ContainsPredicate(PredicateType.Extend)
+        assert sele.ToCanonical() == "ligand extend 2"
+
+    def test_nearest_operator(self):
+        """nearest should parse to its predicate type."""
+        from oeselect import parse, PredicateType
+
+        sele = parse("nearest 20 byres water to ligand")
+        assert sele.ContainsPredicate(PredicateType.Nearest)
+        assert sele.ToCanonical() == "nearest 20 byres water to ligand"
+
+
+class TestResidueClasses:
+    """Tests for the Tagger residue class registry."""
+
+    @pytest.fixture(autouse=True)
+    def clear_registry(self):
+        """Restore the built-in tables after each test."""
+        from oeselect import Tagger
+
+        yield
+        Tagger.ClearResidueClasses()
+
+    def test_register_overrides_and_clears(self):
+        """Registrations override built-in names until cleared."""
+        from oeselect import ComponentFlag, Tagger
+
+        assert Tagger.ResidueClassDigest() == 0
+        assert Tagger.ClassifyResidueName("XCP") == ComponentFlag.Ligand
+        Tagger.RegisterResidueClass("XCP", ComponentFlag.Protein)
+        Tagger.RegisterResidueClass("HEM", ComponentFlag.Ligand)
+        assert Tagger.ClassifyResidueName("XCP") == ComponentFlag.Protein
+        assert Tagger.ClassifyResidueName("HEM") == ComponentFlag.Ligand
+        assert Tagger.ResidueClassDigest() != 0
+
+        Tagger.ClearResidueClasses()
+        assert Tagger.ClassifyResidueName("XCP") == ComponentFlag.Ligand
+        assert Tagger.ClassifyResidueName("HEM") == ComponentFlag.Cofactor
+        assert Tagger.ResidueClassDigest() == 0
+
+    def test_registered_class_is_selectable(self, protein_mol):
+        """Selections see registered classes."""
+        from oeselect import ComponentFlag, Tagger, count
+
+        Tagger.RegisterResidueClass("GLY", ComponentFlag.Lipid)
+        assert count(protein_mol, "lipid") == 4
+
+    def test_load_residue_classes(self, tmp_path):
+        """Residue class files register every line or nothing."""
+        from oeselect import ComponentFlag, Tagger
+
+        path = tmp_path / "classes.txt"
+        path.write_text("# In-house residues\nPOPX  lipid\nSUGA  glycan  # sugar\n")
+        Tagger.LoadResidueClasses(str(path))
+        assert Tagger.ClassifyResidueName("POPX") == ComponentFlag.Lipid
+        assert Tagger.ClassifyResidueName("SUGA") == ComponentFlag.Glycan
+
+        path.write_text("GOOD lipid\nBAD wax\n")
+        with pytest.raises(ValueError):
+            Tagger.LoadResidueClasses(str(path))
+        assert Tagger.ClassifyResidueName("GOOD") == ComponentFlag.Ligand
+
+    def test_rejects_invalid_registrations(self):
+        """Invalid names and flags raise ValueError."""
+        from oeselect import ComponentFlag, Tagger
+
+        with pytest.raises(ValueError):
+            Tagger.RegisterResidueClass("TOOLONG", ComponentFlag.Lipid)
+        with pytest.raises(ValueError):
+            Tagger.RegisterResidueClass("ABC", ComponentFlag.None_)
+
 
 # Import oechem at module level for fixtures
 try:
@@ -1,6 +1,7 @@
 """Package import behavior tests."""
 
 import importlib
+import os
 import shutil
 import sys
 
@@ -197,3 +198,76 @@ def test_import_ignores_static_openeye_link_libraries(monkeypatch, tmp_path):
     importlib.invalidate_caches()
 
     importlib.import_module(package)
+
+
+def test_warm_import_replays_recorded_state_until_openeye_changes(
+    monkeypatch,
+    tmp_path,
+):
+    """A second import reuses the recorded scan until the runtime directory changes."""
+    package = "oeselect"
+    source_dir = tmp_path / package
+    expected_name = "liboechem-4.3.0.1.so"
+    runtime_name = "liboechem-4.3.0.3.so"
+    _write_stub_oeselect_package(source_dir, [expected_name])
+    _marker, fake_runtime = _write_fake_openeye_package(tmp_path, [runtime_name])
+    cache_home = tmp_path / "cache"
+    monkeypatch.syspath_prepend(str(tmp_path))
+    monkeypatch.setenv("XDG_CACHE_HOME", str(cache_home))
+    monkeypatch.delenv("OESELECT_IMPORT_CACHE", raising=False)
+
+    def fresh_import():
+        _clear_import_modules(monkeypatch, package)
+        importlib.invalidate_caches()
+        return importlib.import_module(package)
+
+    cold = fresh_import()
+    assert cold.import_timings()["mode"] == "cold"
+    assert "compat" in cold.import_timings()
+    assert len(list(cache_home.glob("oeselect/import-state/*.json"))) == 1
+
+    warm = fresh_import()
+    timings = warm.import_timings()
+    assert timings["mode"] == "warm"
+    assert "compat" not in timings
+    assert timings["total"] >= timings["preload"]
+
+    # Installing another runtime library invalidates the recorded scan
+    (fake_runtime / "liboebio-4.3.0.3.so").write_text("not a real library")
+    os.utime(fake_runtime, ns=(1, 1))
+    assert fresh_import().import_timings()["mode"] == "cold"
+    assert fresh_import().import_timings()["mode"] == "warm"
+
+    # A removed compatibility alias is detected without scanning
+    for alias in cache_home.glob(f"oeselect/openeye-libs/**/{expected_name}"):
+        alias.unlink()
+    assert fresh_import().import_timings()["mode"] == "cold"
+    assert len(list(cache_home.glob(f"oeselect/openeye-libs/**/{expected_name}"))) == 1
+
+
+def test_import_cache_environment_override(monkeypatch, tmp_path):
+    """OESELECT_IMPORT_CACHE disables or refreshes the recorded import state."""
+    package = "oeselect"
+    source_dir = tmp_path / package
+    shared_name = "liboechem-4.3.0.1.so"
+    _write_stub_oeselect_package(source_dir, [shared_name])
+    _write_fake_openeye_package(tmp_path, [shared_name])
+    cache_home = tmp_path / "cache"
+    monkeypatch.syspath_prepend(str(tmp_path))
+    monkeypatch.setenv("XDG_CACHE_HOME", str(cache_home))
+
+    def fresh_import():
+        _clear_import_modules(monkeypatch, package)
+        importlib.invalidate_caches()
+        return importlib.import_module(package)
+
+    monkeypatch.setenv("OESELECT_IMPORT_CACHE", "0")
+    assert fresh_import().import_timings()["mode"] == "off"
+    assert not (cache_home / "oeselect" / "import-state").exists()
+
+    monkeypatch.setenv("OESELECT_IMPORT_CACHE", "1")
+    assert fresh_import().import_timings()["mode"] == "cold"
+    assert fresh_import().import_timings()["mode"] == "warm"
+
+    monkeypatch.setenv("OESELECT_IMPORT_CACHE", "refresh")
+    assert fresh_import().import_timings()["mode"] == "cold"
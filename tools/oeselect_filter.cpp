@@ -0,0 +1,130 @@
+/**
+ * @file oeselect_filter.cpp
+ * @brief oeselect-filter: apply a selection to every molecule of a stream.
+ *
+ * Usage:
+ * @code
+ * oeselect-filter [options] <selection> <input> [output]
+ * @endcode
+ *
+ * By default the selected atoms of each molecule are written to the output
+ * structure file. With --count or --indices one text line per molecule is
+ * written instead, to the output path or to standard output.
+ */
+
+#include <oeselect/oeselect.h>
+#include <oechem.h>
+
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+void print_usage(std::ostream& out) {
+    out << "Usage: oeselect-filter [options] <selection> <input> [output]\n"
+           "\n"
+           "Write the atoms of each input molecule that match <selection> to <output>.\n"
+           "\n"
+           "Options:\n"
+           "  --count         Write \"index<TAB>title<TAB>count\" lines instead of structures\n"
+           "  --indices       Write \"index<TAB>title<TAB>i,j,k\" lines instead of structures\n"
+           "  --keep-empty    Also write molecules with no selected atoms\n"
+           "  --threads N     Evaluation threads (default 0: all hardware threads)\n"
+           "  --queue N       Molecules in flight (default: 4 per thread)\n"
+           "  -h, --help      Show this message\n"
+           "\n"
+           "Text output goes to standard output when <output> is omitted or \"-\".\n";
+}
+
+/// Parse a non-negative integer option value, or exit with a usage error
+unsigned long parse_count(const std::string& option, const char* value) {
+    char* end = nullptr;
+    const unsigned long parsed = value ? std::strtoul(value, &end, 10) : 0;
+    if (!value || *value == '\0' || *value == '-' || *end != '\0') {
+        std::cerr << "oeselect-filter: " << option << " expects a non-negative integer\n";
+        std::exit(2);
+    }
+    return parsed;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    bool text = false;
+    OESel::FilterOutput output = OESel::FilterOutput::COUNT;
+    bool keep_empty = false;
+    unsigned int num_threads = 0;
+    size_t queue_depth = 0;
+    std::vector<std::string> positional;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            print_usage(std::cout);
+            return 0;
+        } else if (arg == "--count") {
+            text = true;
+            output = OESel::FilterOutput::COUNT;
+        } else if (arg == "--indices") {
+            text = true;
+            output = OESel::FilterOutput::INDICES;
+        } else if (arg == "--keep-empty") {
+            keep_empty = true;
+        } else if (arg == "--threads") {
+            num_threads = static_cast<unsigned int>(parse_count(arg, i + 1 < argc ? argv[++i] : nullptr));
+        } else if (arg == "--queue") {
+            queue_depth = parse_count(arg, i + 1 < argc ? argv[++i] : nullptr);
+        } else if (arg.size() > 1 && arg[0] == '-' && arg != "-") {
+            std::cerr << "oeselect-filter: unknown option " << arg << "\n";
+            print_usage(std::cerr);
+            return 2;
+        } else {
+            positional.push_back(arg);
+        }
+    }
+    if (positional.size() < 2 || positional.size() > 3 || (!text && positional.size() != 3)) {
+        print_usage(std::cerr);
+        return 2;
+    }
+
+    try {
+        OESel::StreamFilter filter(OESel::OESelection::Parse(positional[0]), num_threads, queue_depth);
+
+        OEChem::oemolistream ifs;
+        if (!ifs.open(positional[1])) {
+            std::cerr << "oeselect-filter: unable to open " << positional[1] << "\n";
+            return 1;
+        }
+
+        OESel::StreamFilterStats stats;
+        if (text) {
+            if (positional.size() == 2 || positional[2] == "-") {
+                stats = filter.Run(ifs, output, std::cout);
+            } else {
+                std::ofstream out(positional[2]);
+                if (!out) {
+                    std::cerr << "oeselect-filter: unable to create " << positional[2] << "\n";
+                    return 1;
+                }
+                stats = filter.Run(ifs, output, out);
+            }
+        } else {
+            OEChem::oemolostream ofs;
+            if (!ofs.open(positional[2])) {
+                std::cerr << "oeselect-filter: unable to create " << positional[2] << "\n";
+                return 1;
+            }
+            stats = filter.Run(ifs, ofs, keep_empty);
+        }
+        std::cerr << "oeselect-filter: " << stats.molecules_read << " molecules read, " << stats.molecules_written
+                  << " written, " << stats.atoms_selected << " atoms selected\n";
+    } catch (const std::exception& e) {
+        std::cerr << "oeselect-filter: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}